@@ -1,12 +1,17 @@
 #include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <memory>
+#include <string_view>
 
 #include <glm/glm.hpp>
 
 #include "Core/WindowManager.h"
 #include "Core/EventManager.h"
 #include "Core/Timestep.h"
+#include "GameLogic/Chess/Engine/Benchmark.h"
+#include "GameLogic/Chess/Engine/Zobrist.h"
 #include "GameLogic/Chess/Game.h"
 #include "Rendering/DebugOverlayManager.h"
 #include "Rendering/Renderer.h"
@@ -44,7 +49,7 @@ namespace yk
 
     void Update(Timestep timestep)
     {
-      
+      m_ChessGame->Update(timestep);
     }
 
     void OnWindowClose() final
@@ -74,8 +79,30 @@ namespace yk
   };
 }
 
-int main() 
+namespace
 {
+  // "bench [depth]" searches the benchmark positions without opening a window, the node count identifies the search behaviour
+  int RunBench(int argc, char** argv)
+  {
+    yk::Chess::Bitboards::Init();
+    yk::Chess::Zobrist::Init();
+
+    const int32_t depth = (argc > 2) ? std::max(std::atoi(argv[2]), 1) : yk::Chess::Benchmark::DefaultBenchDepth;
+    const yk::Chess::BenchResult result = yk::Chess::Benchmark::Run(depth);
+
+    std::printf("Depth          : %d\n", depth);
+    std::printf("Total time (ms): %lld\n", static_cast<long long>(result.Time));
+    std::printf("Nodes searched : %llu\n", static_cast<unsigned long long>(result.Nodes));
+    std::printf("Nodes/second   : %.0f\n", result.NodesPerSecond);
+    return 0;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 1 && std::string_view(argv[1]) == "bench")
+    return RunBench(argc, argv);
+
   yk::WindowManager::InitWindow(1280, 720, "YK Chess");
   yk::WindowManager::SetWindowIcon
     ({ 
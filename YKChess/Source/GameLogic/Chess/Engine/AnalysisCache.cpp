@@ -0,0 +1,598 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/AnalysisCache.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      constexpr uint32_t LogMagic = 0x43414B59; // "YKAC"
+      constexpr uint32_t IndexMagic = 0x49414B59; // "YKAI"
+      constexpr uint32_t FileVersion = 1;
+      constexpr uint64_t LogHeaderSize = 8;
+
+      constexpr size_t MinSlotCount = 4096;
+      // Slots used out of every ten before the index is rebuilt twice as large, probing stays short below that
+      constexpr size_t MaxLoadTenths = 7;
+      // Logs smaller than this are never compacted, and larger ones only once less than half of them is live
+      constexpr size_t MinCompactionSize = 1 << 20;
+
+      uint64_t LoadAcquire(uint64_t& value)
+      {
+        return std::atomic_ref<uint64_t>(value).load(std::memory_order_acquire);
+      }
+
+      void StoreRelease(uint64_t& value, uint64_t stored)
+      {
+        std::atomic_ref<uint64_t>(value).store(stored, std::memory_order_release);
+      }
+
+      size_t RecordSize(uint8_t pv_length)
+      {
+        return 24 + 2 * static_cast<size_t>(pv_length);
+      }
+    }
+
+    AnalysisCache::~AnalysisCache()
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_QueueMutex);
+        m_Quit = true;
+      }
+      m_QueueSignal.notify_all();
+      if (m_Writer.joinable())
+        m_Writer.join();
+    }
+
+    std::shared_ptr<AnalysisCache> AnalysisCache::Open(const std::filesystem::path& path)
+    {
+      std::shared_ptr<AnalysisCache> cache(new AnalysisCache());
+      cache->m_Path = path;
+      cache->m_IndexPath = path.string() + ".index";
+
+      std::error_code error;
+      if (const uintmax_t size = std::filesystem::file_size(path, error); error || size < LogHeaderSize)
+      {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        const uint32_t header[2] = { LogMagic, FileVersion };
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        if (!file)
+        {
+          YK_ERROR("[ENGINE] Cannot create the analysis cache '{}'", path.string());
+          return nullptr;
+        }
+      }
+
+      {
+        std::shared_ptr<MappedFile> log = MappedFile::Open(path);
+        uint32_t header[2] = {};
+        if (log)
+          std::memcpy(header, log->GetData(), sizeof(header));
+        if (!log || header[0] != LogMagic || header[1] != FileVersion)
+        {
+          YK_ERROR("[ENGINE] '{}' is not an analysis cache", path.string());
+          return nullptr;
+        }
+      }
+
+      if (!cache->MapFiles())
+      {
+        YK_INFO("[ENGINE] Rebuilding the index of the analysis cache '{}'", path.string());
+        if (!cache->RebuildIndex())
+          return nullptr;
+      }
+
+      cache->m_Log.open(path, std::ios::binary | std::ios::app);
+      if (!cache->m_Log)
+      {
+        YK_ERROR("[ENGINE] Cannot write to the analysis cache '{}'", path.string());
+        return nullptr;
+      }
+
+      cache->m_Stats = { cache->m_Entries, cache->m_LogSize, cache->m_LiveSize, 0 };
+      cache->m_Writer = std::thread([cache = cache.get()]() { cache->WriterLoop(); });
+      YK_INFO("[ENGINE] Analysis cache '{}' of {} positions", path.string(), cache->m_Entries);
+      return cache;
+    }
+
+    bool AnalysisCache::Probe(uint64_t key, CachedAnalysis& analysis) const
+    {
+      std::shared_lock<std::shared_mutex> lock(m_SnapshotMutex);
+      if (!m_Snapshot.Index)
+        return false;
+
+      IndexSlot* slot = AnalysisCache::FindSlot(*m_Snapshot.Index, key);
+      const uint64_t offset = LoadAcquire(slot->Offset);
+      if (!offset)
+        return false;
+
+      RecordHeader header;
+      const std::byte* pv = AnalysisCache::ReadRecord(*m_Snapshot.Log, offset, key, header);
+      if (!pv)
+        return false;
+
+      analysis.Depth = header.Depth;
+      analysis.Score = header.Score;
+      analysis.Bound = static_cast<Chess::Bound>(header.Bound);
+      analysis.PV.resize(header.PVLength);
+      for (uint8_t i = 0; i < header.PVLength; i++)
+      {
+        uint16_t data = 0;
+        std::memcpy(&data, pv + 2 * i, sizeof(data));
+        analysis.PV[i] = Move(data);
+      }
+      return true;
+    }
+
+    void AnalysisCache::Store(uint64_t key, const CachedAnalysis& analysis)
+    {
+      if (analysis.PV.empty())
+        return;
+
+      {
+        std::lock_guard<std::mutex> lock(m_QueueMutex);
+        m_Pending.push_back({ key, analysis });
+      }
+      m_QueueSignal.notify_one();
+    }
+
+    void AnalysisCache::Flush()
+    {
+      std::unique_lock<std::mutex> lock(m_QueueMutex);
+      m_IdleSignal.wait(lock, [this]() { return m_Pending.empty() && !m_CompactRequested && !m_Writing; });
+    }
+
+    void AnalysisCache::Compact()
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_QueueMutex);
+        m_CompactRequested = true;
+      }
+      m_QueueSignal.notify_one();
+    }
+
+    AnalysisCacheStats AnalysisCache::GetStats() const
+    {
+      std::lock_guard<std::mutex> lock(m_QueueMutex);
+      return m_Stats;
+    }
+
+    uint32_t AnalysisCache::Checksum(const RecordHeader& header, const uint16_t* pv)
+    {
+      // FNV-1a, enough to tell a torn write at the end of the log from a record
+      RecordHeader copy = header;
+      copy.Checksum = 0;
+      uint32_t hash = 0x811C9DC5;
+      auto mix = [&hash](const void* data, size_t size)
+        {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+          hash = (hash ^ bytes[i]) * 0x01000193;
+        };
+      mix(&copy, sizeof(copy));
+      mix(pv, 2 * static_cast<size_t>(header.PVLength));
+      return hash;
+    }
+
+    const std::byte* AnalysisCache::ReadRecord(const MappedFile& log, uint64_t offset, uint64_t key, RecordHeader& header)
+    {
+      if (offset < LogHeaderSize || offset + sizeof(RecordHeader) > log.GetSize())
+        return nullptr;
+
+      std::memcpy(&header, log.GetData() + offset, sizeof(RecordHeader));
+      if (header.Key != key || offset + RecordSize(header.PVLength) > log.GetSize())
+        return nullptr;
+      return log.GetData() + offset + sizeof(RecordHeader);
+    }
+
+    AnalysisCache::IndexSlot* AnalysisCache::GetSlots(const MappedFile& index)
+    {
+      return reinterpret_cast<IndexSlot*>(index.GetWritableData() + sizeof(IndexHeader));
+    }
+
+    size_t AnalysisCache::GetSlotCount(const MappedFile& index)
+    {
+      return (index.GetSize() - sizeof(IndexHeader)) / sizeof(IndexSlot);
+    }
+
+    AnalysisCache::IndexSlot* AnalysisCache::FindSlot(const MappedFile& index, uint64_t key)
+    {
+      IndexSlot* slots = AnalysisCache::GetSlots(index);
+      const size_t mask = AnalysisCache::GetSlotCount(index) - 1;
+
+      // The offset is published last, so once it is seen the key next to it is the one it was written for
+      for (size_t i = key & mask;; i = (i + 1) & mask)
+      {
+        if (!LoadAcquire(slots[i].Offset) || std::atomic_ref<uint64_t>(slots[i].Key).load(std::memory_order_relaxed) == key)
+          return &slots[i];
+      }
+    }
+
+    std::shared_ptr<MappedFile> AnalysisCache::CreateIndex(const std::filesystem::path& path, size_t slot_count) const
+    {
+      std::error_code error;
+      std::filesystem::remove(path, error);
+      std::shared_ptr<MappedFile> index = MappedFile::OpenWritable(path, sizeof(IndexHeader) + slot_count * sizeof(IndexSlot));
+      if (!index)
+      {
+        YK_ERROR("[ENGINE] Cannot create the index of the analysis cache '{}'", m_Path.string());
+        return nullptr;
+      }
+
+      IndexHeader header;
+      header.Magic = IndexMagic;
+      header.Version = FileVersion;
+      header.SlotCount = slot_count;
+      header.Used = m_Entries;
+      header.LiveSize = m_LiveSize;
+      header.LogSize = m_LogSize;
+      std::memcpy(index->GetWritableData(), &header, sizeof(IndexHeader));
+      return index;
+    }
+
+    bool AnalysisCache::MapFiles()
+    {
+      std::shared_ptr<MappedFile> log = MappedFile::Open(m_Path);
+      std::shared_ptr<MappedFile> index = MappedFile::OpenWritable(m_IndexPath);
+      IndexHeader header;
+      if (index && index->GetSize() >= sizeof(IndexHeader))
+        std::memcpy(&header, index->GetData(), sizeof(IndexHeader));
+      if (!log || header.Magic != IndexMagic || header.Version != FileVersion || header.LogSize != log->GetSize() ||
+        !std::has_single_bit(header.SlotCount) || index->GetSize() != sizeof(IndexHeader) + header.SlotCount * sizeof(IndexSlot))
+        return false;
+
+      m_LogSize = log->GetSize();
+      m_LiveSize = header.LiveSize;
+      m_Entries = header.Used;
+      m_Snapshot = { std::move(log), std::move(index) };
+      return true;
+    }
+
+    bool AnalysisCache::ReplaceFiles(const std::filesystem::path& log_path, const std::filesystem::path& index_path)
+    {
+      // Readers wait for the new mappings, a mapped file cannot be renamed over on Windows
+      std::unique_lock<std::shared_mutex> lock(m_SnapshotMutex);
+      m_Snapshot = Snapshot();
+
+      std::error_code error;
+      if (!log_path.empty())
+        std::filesystem::rename(log_path, m_Path, error);
+      const bool logReplaced = !log_path.empty() && !error;
+      if (!error)
+        std::filesystem::rename(index_path, m_IndexPath, error);
+
+      if (error)
+      {
+        YK_ERROR("[ENGINE] Cannot replace the files of the analysis cache '{}': {}", m_Path.string(), error.message());
+        std::error_code ignored;
+        std::filesystem::remove(log_path, ignored);
+        std::filesystem::remove(index_path, ignored);
+        m_Replaceable = false;
+        // The old index would point into the new log, it is rebuilt on the next open instead
+        if (logReplaced)
+        {
+          std::filesystem::remove(m_IndexPath, ignored);
+          YK_ERROR("[ENGINE] The analysis cache '{}' is left unused until it is opened again", m_Path.string());
+          return false;
+        }
+      }
+
+      if (!AnalysisCache::MapFiles())
+      {
+        YK_ERROR("[ENGINE] Cannot map the analysis cache '{}', it is left unused until it is opened again", m_Path.string());
+        return false;
+      }
+      return !error;
+    }
+
+    bool AnalysisCache::RebuildIndex()
+    {
+      std::shared_ptr<MappedFile> log = MappedFile::Open(m_Path);
+      if (!log)
+      {
+        YK_ERROR("[ENGINE] Cannot map the analysis cache '{}'", m_Path.string());
+        return false;
+      }
+
+      // Whole records up to the first one that is not, a crash while appending leaves at most one torn at the end
+      std::vector<std::pair<uint64_t, uint64_t>> records;
+      uint64_t offset = LogHeaderSize;
+      RecordHeader header;
+      while (offset + sizeof(RecordHeader) <= log->GetSize())
+      {
+        std::memcpy(&header, log->GetData() + offset, sizeof(RecordHeader));
+        const size_t size = RecordSize(header.PVLength);
+        if (offset + size > log->GetSize())
+          break;
+
+        std::vector<uint16_t> pv(header.PVLength);
+        std::memcpy(pv.data(), log->GetData() + offset + sizeof(RecordHeader), 2 * pv.size());
+        if (AnalysisCache::Checksum(header, pv.data()) != header.Checksum)
+          break;
+
+        records.emplace_back(header.Key, offset);
+        offset += size;
+      }
+
+      if (offset != log->GetSize())
+      {
+        YK_WARN("[ENGINE] Dropping {} bytes of an unfinished record from the analysis cache '{}'", log->GetSize() - offset, m_Path.string());
+        log.reset();
+        std::error_code error;
+        std::filesystem::resize_file(m_Path, offset, error);
+        log = MappedFile::Open(m_Path);
+        if (error || !log)
+        {
+          YK_ERROR("[ENGINE] Cannot truncate the analysis cache '{}'", m_Path.string());
+          return false;
+        }
+      }
+
+      m_LogSize = log->GetSize();
+      m_LiveSize = 0;
+      m_Entries = 0;
+      const size_t slotCount = std::max(std::bit_ceil(records.size() * 10 / MaxLoadTenths + 1), MinSlotCount);
+      const std::filesystem::path building = m_IndexPath.string() + ".building";
+      std::shared_ptr<MappedFile> index = AnalysisCache::CreateIndex(building, slotCount);
+      if (!index)
+        return false;
+
+      // Later records of a position supersede earlier ones, the writer only appends results at least as deep
+      for (const auto& [key, recordOffset] : records)
+      {
+        IndexSlot* slot = AnalysisCache::FindSlot(*index, key);
+        std::memcpy(&header, log->GetData() + recordOffset, sizeof(RecordHeader));
+        if (slot->Offset)
+        {
+          RecordHeader previous;
+          std::memcpy(&previous, log->GetData() + slot->Offset, sizeof(RecordHeader));
+          m_LiveSize -= RecordSize(previous.PVLength);
+        }
+        else
+        {
+          slot->Key = key;
+          m_Entries++;
+        }
+        slot->Offset = recordOffset;
+        m_LiveSize += RecordSize(header.PVLength);
+      }
+
+      IndexHeader indexHeader;
+      std::memcpy(&indexHeader, index->GetData(), sizeof(IndexHeader));
+      indexHeader.Used = m_Entries;
+      indexHeader.LiveSize = m_LiveSize;
+      std::memcpy(index->GetWritableData(), &indexHeader, sizeof(IndexHeader));
+
+      index.reset();
+      log.reset();
+      return AnalysisCache::ReplaceFiles({}, building);
+    }
+
+    bool AnalysisCache::GrowIndex(size_t slot_count)
+    {
+      const std::filesystem::path building = m_IndexPath.string() + ".building";
+      std::shared_ptr<MappedFile> index = AnalysisCache::CreateIndex(building, slot_count);
+      if (!index)
+      {
+        m_Replaceable = false;
+        return false;
+      }
+
+      // Nothing but the writer changes the slots, they are copied without the log
+      const IndexSlot* slots = AnalysisCache::GetSlots(*m_Snapshot.Index);
+      for (size_t i = 0; i < AnalysisCache::GetSlotCount(*m_Snapshot.Index); i++)
+      {
+        if (slots[i].Offset)
+          *AnalysisCache::FindSlot(*index, slots[i].Key) = slots[i];
+      }
+
+      index.reset();
+      return AnalysisCache::ReplaceFiles({}, building);
+    }
+
+    void AnalysisCache::WriterLoop()
+    {
+      std::vector<PendingStore> batch;
+      while (true)
+      {
+        bool compact = false;
+        {
+          std::unique_lock<std::mutex> lock(m_QueueMutex);
+          m_QueueSignal.wait(lock, [this]() { return m_Quit || !m_Pending.empty() || m_CompactRequested; });
+          if (m_Quit && m_Pending.empty())
+            break;
+
+          batch.swap(m_Pending);
+          compact = m_CompactRequested;
+          m_CompactRequested = false;
+          m_Writing = true;
+        }
+
+        if (!batch.empty())
+          AnalysisCache::WriteBatch(batch);
+        batch.clear();
+
+        // Once most of the log is superseded records it is rewritten without them
+        if (compact || (m_LogSize >= MinCompactionSize && 2 * m_LiveSize < m_LogSize))
+          AnalysisCache::CompactLog();
+
+        {
+          std::lock_guard<std::mutex> lock(m_QueueMutex);
+          m_Writing = false;
+          m_Stats = { m_Entries, m_LogSize, m_LiveSize, m_Compactions };
+        }
+        m_IdleSignal.notify_all();
+      }
+    }
+
+    void AnalysisCache::WriteBatch(std::vector<PendingStore>& batch)
+    {
+      if (!m_Snapshot.Index)
+        return;
+
+      // Grown before appending, every record written gets its slot
+      size_t newKeys = 0;
+      for (const PendingStore& store : batch)
+        newKeys += !AnalysisCache::FindSlot(*m_Snapshot.Index, store.Key)->Offset;
+      if (m_Replaceable && (m_Entries + newKeys) * 10 > AnalysisCache::GetSlotCount(*m_Snapshot.Index) * MaxLoadTenths)
+      {
+        const size_t slotCount = std::bit_ceil((m_Entries + newKeys) * 10 / MaxLoadTenths + 1);
+        if (!AnalysisCache::GrowIndex(std::max(slotCount, 2 * AnalysisCache::GetSlotCount(*m_Snapshot.Index))) && !m_Snapshot.Index)
+          return;
+      }
+
+      struct Appended
+      {
+        uint64_t Key;
+        uint64_t Offset;
+      };
+      std::vector<Appended> appended;
+      const size_t slotCount = AnalysisCache::GetSlotCount(*m_Snapshot.Index);
+      size_t newSlots = 0;
+
+      for (const PendingStore& store : batch)
+      {
+        IndexSlot* slot = AnalysisCache::FindSlot(*m_Snapshot.Index, store.Key);
+        RecordHeader header;
+        if (slot->Offset && AnalysisCache::ReadRecord(*m_Snapshot.Log, slot->Offset, store.Key, header) && header.Depth > store.Analysis.Depth)
+          continue;
+        // Only when the index could not grow, new positions are dropped before probing gets long
+        if (!slot->Offset && (m_Entries + newSlots + 1) * 10 > slotCount * MaxLoadTenths)
+          continue;
+        newSlots += !slot->Offset;
+
+        const CachedAnalysis& analysis = store.Analysis;
+        std::vector<uint16_t> pv;
+        for (size_t i = 0; i < std::min<size_t>(analysis.PV.size(), MaxPVLength); i++)
+          pv.push_back(analysis.PV[i].Data);
+
+        header = RecordHeader();
+        header.Key = store.Key;
+        header.Score = static_cast<int16_t>(analysis.Score);
+        header.Move = pv[0];
+        header.Depth = static_cast<uint8_t>(std::clamp(analysis.Depth, 0, 255));
+        header.Bound = static_cast<uint8_t>(analysis.Bound);
+        header.PVLength = static_cast<uint8_t>(pv.size());
+        header.Checksum = AnalysisCache::Checksum(header, pv.data());
+
+        m_Log.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        m_Log.write(reinterpret_cast<const char*>(pv.data()), 2 * pv.size());
+        appended.push_back({ store.Key, m_LogSize });
+        m_LogSize += RecordSize(header.PVLength);
+      }
+
+      if (appended.empty())
+        return;
+
+      m_Log.flush();
+      if (!m_Log)
+      {
+        YK_ERROR("[ENGINE] Cannot write to the analysis cache '{}'", m_Path.string());
+        return;
+      }
+
+      // Readers only see the new records through a mapping of the grown log
+      std::shared_ptr<MappedFile> log = MappedFile::Open(m_Path);
+      if (!log)
+        return;
+      {
+        std::unique_lock<std::shared_mutex> lock(m_SnapshotMutex);
+        m_Snapshot.Log = log;
+      }
+
+      const MappedFile& index = *m_Snapshot.Index;
+      for (const Appended& record : appended)
+      {
+        IndexSlot* slot = AnalysisCache::FindSlot(index, record.Key);
+        RecordHeader header;
+        if (slot->Offset && AnalysisCache::ReadRecord(*log, slot->Offset, record.Key, header))
+          m_LiveSize -= RecordSize(header.PVLength);
+        else
+        {
+          std::atomic_ref<uint64_t>(slot->Key).store(record.Key, std::memory_order_relaxed);
+          m_Entries++;
+        }
+        AnalysisCache::ReadRecord(*log, record.Offset, record.Key, header);
+        m_LiveSize += RecordSize(header.PVLength);
+        StoreRelease(slot->Offset, record.Offset);
+      }
+
+      IndexHeader indexHeader;
+      std::memcpy(&indexHeader, index.GetData(), sizeof(IndexHeader));
+      indexHeader.Used = m_Entries;
+      indexHeader.LiveSize = m_LiveSize;
+      indexHeader.LogSize = m_LogSize;
+      std::memcpy(index.GetWritableData(), &indexHeader, sizeof(IndexHeader));
+    }
+
+    void AnalysisCache::CompactLog()
+    {
+      if (!m_Snapshot.Index || !m_Replaceable)
+        return;
+
+      const std::filesystem::path compacted = m_Path.string() + ".compacting";
+      const std::filesystem::path compactedIndex = m_IndexPath.string() + ".compacting";
+      const size_t slotCount = AnalysisCache::GetSlotCount(*m_Snapshot.Index);
+      const size_t before = m_LogSize;
+
+      {
+        std::shared_ptr<MappedFile> index = AnalysisCache::CreateIndex(compactedIndex, slotCount);
+        if (!index)
+          return;
+
+        std::ofstream file(compacted, std::ios::binary | std::ios::trunc);
+        const uint32_t header[2] = { LogMagic, FileVersion };
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+        // In index order, which groups nothing but costs nothing either. The new index is filled on the way
+        const IndexSlot* slots = AnalysisCache::GetSlots(*m_Snapshot.Index);
+        uint64_t offset = LogHeaderSize;
+        size_t used = 0;
+        for (size_t i = 0; i < slotCount; i++)
+        {
+          RecordHeader record;
+          if (!slots[i].Offset || !AnalysisCache::ReadRecord(*m_Snapshot.Log, slots[i].Offset, slots[i].Key, record))
+            continue;
+
+          file.write(reinterpret_cast<const char*>(m_Snapshot.Log->GetData() + slots[i].Offset), RecordSize(record.PVLength));
+          *AnalysisCache::FindSlot(*index, slots[i].Key) = { slots[i].Key, offset };
+          offset += RecordSize(record.PVLength);
+          used++;
+        }
+
+        file.close();
+        if (!file)
+        {
+          YK_ERROR("[ENGINE] Cannot compact the analysis cache '{}'", m_Path.string());
+          index.reset();
+          std::error_code error;
+          std::filesystem::remove(compacted, error);
+          std::filesystem::remove(compactedIndex, error);
+          return;
+        }
+
+        IndexHeader indexHeader;
+        std::memcpy(&indexHeader, index->GetData(), sizeof(IndexHeader));
+        indexHeader.Used = used;
+        indexHeader.LiveSize = offset - LogHeaderSize;
+        indexHeader.LogSize = offset;
+        std::memcpy(index->GetWritableData(), &indexHeader, sizeof(IndexHeader));
+      }
+
+      m_Log.close();
+      if (AnalysisCache::ReplaceFiles(compacted, compactedIndex))
+      {
+        m_Compactions++;
+        YK_INFO("[ENGINE] Compacted the analysis cache '{}' from {} to {} bytes", m_Path.string(), before, m_LogSize);
+      }
+      m_Log.open(m_Path, std::ios::binary | std::ios::app);
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "GameLogic/Chess/Engine/MappedFile.h"
+#include "GameLogic/Chess/Engine/TranspositionTable.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    struct CachedAnalysis
+    {
+      int32_t Depth = 0;
+      int32_t Score = 0; // From the side to move's point of view, mates counted from this position
+      Chess::Bound Bound = Chess::Bound::Exact;
+      std::vector<Move> PV; // Starts with the best move
+    };
+
+    struct AnalysisCacheStats
+    {
+      size_t Entries = 0;
+      size_t LogSize = 0;   // Bytes
+      size_t LiveSize = 0;  // Bytes of the log still reached from the index
+      size_t Compactions = 0;
+    };
+
+    // Search results kept across sessions. Records are only ever appended to a log file, a second file holds an open
+    // addressing index from position key to the newest record, and both are mapped. A slot's offset is published after
+    // its record is in the log, and readers only follow offsets inside the log they mapped, so appending needs no lock.
+    // A single background thread does all the writing, growing the index and compacting the log once most of it is
+    // superseded records. Both build their files aside and rename them over the old ones, which needs every mapping of
+    // those released first on Windows, so lookups share a lock with these rare swaps
+    class AnalysisCache
+    {
+    public:
+      static constexpr int32_t MaxPVLength = 32;
+
+      ~AnalysisCache();
+
+      // The log at the path and its index next to it, both created when missing. An index not matching the log, as
+      // after a crash, is rebuilt from the log. Only one process may have the same cache open at a time.
+      // Returns nullptr when the files cannot be opened
+      static std::shared_ptr<AnalysisCache> Open(const std::filesystem::path& path);
+
+      bool Probe(uint64_t key, CachedAnalysis& analysis) const;
+      // Queued for the writer, a result shallower than the one already stored is dropped
+      void Store(uint64_t key, const CachedAnalysis& analysis);
+      // Waits until everything stored so far is written
+      void Flush();
+      // Rewrites the log with only the newest record of every position, in the background
+      void Compact();
+
+      AnalysisCacheStats GetStats() const;
+      const std::filesystem::path& GetPath() const { return m_Path; }
+
+    private:
+      struct RecordHeader
+      {
+        uint64_t Key = 0ULL;
+        uint32_t Checksum = 0;
+        int16_t Score = 0;
+        uint16_t Move = 0;
+        uint8_t Depth = 0;
+        uint8_t Bound = 0;
+        uint8_t PVLength = 0;
+        uint8_t Padding[5] = {};
+      };
+      static_assert(sizeof(RecordHeader) == 24, "Records are read and written as raw bytes");
+
+      struct IndexHeader
+      {
+        uint32_t Magic = 0;
+        uint32_t Version = 0;
+        uint64_t SlotCount = 0ULL;
+        uint64_t Used = 0ULL;
+        uint64_t LiveSize = 0ULL;
+        uint64_t LogSize = 0ULL; // The log the index was last brought up to date with
+      };
+
+      // An offset of 0 marks a free slot, the log header is there so no record ever is
+      struct IndexSlot
+      {
+        uint64_t Key;
+        uint64_t Offset;
+      };
+
+      // A log mapping and the index into it, both empty once the files could not be replaced and mapped again
+      struct Snapshot
+      {
+        std::shared_ptr<MappedFile> Log;
+        std::shared_ptr<MappedFile> Index;
+      };
+
+      struct PendingStore
+      {
+        uint64_t Key;
+        CachedAnalysis Analysis;
+      };
+
+      static uint32_t Checksum(const RecordHeader& header, const uint16_t* pv);
+      // Record at the offset when it is whole and belongs to the key, nullptr otherwise
+      static const std::byte* ReadRecord(const MappedFile& log, uint64_t offset, uint64_t key, RecordHeader& header);
+      static IndexSlot* GetSlots(const MappedFile& index);
+      static size_t GetSlotCount(const MappedFile& index);
+      static IndexSlot* FindSlot(const MappedFile& index, uint64_t key);
+      // Every slot free, the header holds the counts of the current log
+      std::shared_ptr<MappedFile> CreateIndex(const std::filesystem::path& path, size_t slot_count) const;
+
+      // Maps the log and the index when the index was last written for exactly this log
+      bool MapFiles();
+      // Unmaps both files, renames the ones given over them and maps them again. An empty log path keeps the log.
+      // On failure the files built aside are removed and no swap is tried again
+      bool ReplaceFiles(const std::filesystem::path& log_path, const std::filesystem::path& index_path);
+      // Truncates the log to its last whole record and indexes it, for an index that does not match it
+      bool RebuildIndex();
+      bool GrowIndex(size_t slot_count);
+      void WriterLoop();
+      void WriteBatch(std::vector<PendingStore>& batch);
+      void CompactLog();
+
+    private:
+      AnalysisCache() = default;
+      AnalysisCache(const AnalysisCache&) = delete;
+      AnalysisCache& operator=(const AnalysisCache&) = delete;
+      AnalysisCache(AnalysisCache&&) = delete;
+      AnalysisCache& operator=(AnalysisCache&&) = delete;
+
+    private:
+      std::filesystem::path m_Path;
+      std::filesystem::path m_IndexPath;
+
+      // Only changed by the writer thread, which reads it without the lock
+      mutable std::shared_mutex m_SnapshotMutex;
+      Snapshot m_Snapshot;
+
+      // Only touched by the writer thread once it runs
+      std::ofstream m_Log;
+      bool m_Replaceable = true; // Cleared once the index could not grow or a swap failed, neither is tried again
+      size_t m_LogSize = 0;
+      size_t m_LiveSize = 0;
+      size_t m_Entries = 0;
+      size_t m_Compactions = 0;
+
+      mutable std::mutex m_QueueMutex;
+      std::condition_variable m_QueueSignal;
+      std::condition_variable m_IdleSignal;
+      std::vector<PendingStore> m_Pending;
+      bool m_Writing = false;
+      bool m_CompactRequested = false;
+      bool m_Quit = false;
+      AnalysisCacheStats m_Stats; // Copied out by the writer after every batch
+      std::thread m_Writer;
+    };
+  }
+}
\ No newline at end of file
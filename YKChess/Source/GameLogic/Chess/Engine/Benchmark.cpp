@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <random>
+#include <string_view>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/Benchmark.h"
+#include "GameLogic/Chess/Engine/MoveGen.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      // Openings, middlegames, endgames down to bare kings and a few stalemates and long fifty move counters
+      constexpr std::string_view BenchFENs[] =
+      {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+        "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+        "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+        "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+        "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+        "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+        "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+        "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+        "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+        "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+        "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+        "r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+        "4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+        "3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+        "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+        "3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+        "2K5/p7/7P/5pR1/8/5k2/r7/8 w - - 0 1",
+        "8/6pk/1p6/8/PP3p1p/5P2/4KP1q/3Q4 w - - 0 1",
+        "7k/3p2pp/4q3/8/4Q3/5Kp1/P6b/8 w - - 0 1",
+        "8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1",
+        "8/1p3pp1/7p/5P1P/2k3P1/8/2K2P2/8 w - - 0 1",
+        "8/pp2r1k1/2p1p3/3pP2p/1P1P1P1P/P5KR/8/8 w - - 0 1",
+        "8/3p4/p1bk3p/Pp6/1Kp1PpPp/2P2P1P/2P5/5B2 b - - 0 1",
+        "5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1",
+        "6k1/6p1/P6p/r1N5/5p2/7P/1b3PP1/4R1K1 w - - 0 1",
+        "1r3k2/4q3/2Pp3b/3Bp3/2Q2p2/1p1P2P1/1P2KP2/3N4 w - - 0 1",
+        "6k1/4pp1p/3p2p1/P1pPb3/R7/1r2P1PP/3B1P2/6K1 w - - 0 1",
+        "8/3p3B/5p2/5P2/p7/PP5b/k7/6K1 w - - 0 1",
+        "5rk1/q6p/2p3bR/1pPp1rP1/1P1Pp3/P3B1Q1/1K3P2/R7 w - - 93 90",
+        "4rrk1/1p1nq3/p7/2p1P1pp/3P2bp/3Q1Bn1/PPPB4/1K2R1NR w - - 40 21",
+        "r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16",
+        "3Qb1k1/1r2ppb1/pN1n2q1/Pp1Pp1Pr/4P2p/4BP2/4B1R1/1R5K b - - 11 40",
+        "4k3/3q1r2/1N2r1b1/3ppN2/2nPP3/1B1R2n1/2R1Q3/3K4 w - - 5 1",
+        "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+        "8/8/8/5N2/8/p7/8/2NK3k w - - 0 1",
+        "8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+        "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+        "8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+        "8/8/3P3k/8/1p6/8/1P6/1K3n2 b - - 0 1",
+        "8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124",
+        "6k1/3b3r/1p1p4/p1n2p2/1PPNpP1q/P3Q1p1/1R1RB1P1/5K2 b - - 0 1",
+        "r2r1n2/pp2bk2/2p1p2p/3q4/3PN1QP/2P3R1/P4PP1/5RK1 w - - 0 1",
+        "8/8/8/8/8/6k1/6p1/6K1 w - - 0 1",
+        "7k/7P/6K1/8/3B4/8/8/8 b - - 0 1",
+        "8/8/8/8/8/5k2/4q3/2K5 w - - 0 1",
+        "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+        "rnbqkb1r/pp1p1ppp/4pn2/2p5/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 0 4",
+        "r1bqk2r/pppp1ppp/2n2n2/2b1p3/2B1P3/3P1N2/PPP2PPP/RNBQK2R w KQkq - 1 5"
+      };
+
+      // Middlegames with plenty of pieces, where the search spreads widest over the table
+      constexpr std::string_view HashBenchmarkFENs[] =
+      {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "r1bq1rk1/pp2nppp/2n1p3/3pP3/2pP4/P1P2N2/2P2PPP/R1BQKB1R w KQ - 1 9"
+      };
+    }
+
+    BenchResult Benchmark::Run(int32_t depth, size_t hash_mb, std::shared_ptr<const NNUE::Network> network)
+    {
+      BenchResult result;
+
+      std::shared_ptr<Search> search = Search::Create(TranspositionTable::Create(hash_mb), 1);
+      search->SetNetwork(std::move(network));
+
+      for (const std::string_view fen : BenchFENs)
+      {
+        Position position;
+        position.SetFEN(fen);
+
+        SearchLimits limits;
+        limits.Depth = depth;
+        search->NewGame();
+        search->Start(position, limits);
+        search->Wait();
+
+        const SearchResult searchResult = search->GetResult();
+        result.PositionNodes.push_back(searchResult.Nodes);
+        result.Nodes += searchResult.Nodes;
+        result.Time += searchResult.Time;
+      }
+
+      result.NodesPerSecond = static_cast<double>(result.Nodes) * 1000.0 / static_cast<double>(std::max<int64_t>(result.Time, 1));
+      YK_INFO("[ENGINE] Bench depth {}: {} nodes in {}ms, {:.0f} nps", depth, result.Nodes, result.Time, result.NodesPerSecond);
+      return result;
+    }
+
+    std::vector<HashBenchmarkResult> Benchmark::RunHash(const std::vector<size_t>& sizes_mb, int64_t move_time, int32_t threads, HugePagePolicy policy)
+    {
+      const HugePagePolicy previousPolicy = LargePages::GetPolicy();
+      const size_t physicalMB = LargePages::GetPhysicalMemory() >> 20;
+      std::vector<HashBenchmarkResult> results;
+
+      for (const size_t sizeMB : sizes_mb)
+      {
+        // Leave a quarter of the memory to everything else, the table is touched in full when cleared
+        if (physicalMB && sizeMB > physicalMB / 4 * 3)
+        {
+          YK_WARN("[ENGINE] Skipping the {}MB hash benchmark, only {}MB of physical memory", sizeMB, physicalMB);
+          continue;
+        }
+
+        for (const HugePagePolicy run : { HugePagePolicy::Off, policy })
+        {
+          LargePages::SetPolicy(run);
+
+          HashBenchmarkResult result;
+          result.SizeMB = sizeMB;
+          result.Policy = run;
+
+          std::shared_ptr<TranspositionTable> table = TranspositionTable::Create(sizeMB);
+          result.Kind = table->GetAllocation().Kind;
+          result.HugeMB = LargePages::GetHugeBytes(table->GetAllocation()) >> 20;
+
+          std::shared_ptr<Search> search = Search::Create(table, threads);
+          for (const std::string_view fen : HashBenchmarkFENs)
+          {
+            Position position;
+            position.SetFEN(fen);
+
+            SearchLimits limits;
+            limits.MoveTime = move_time;
+            search->Start(position, limits);
+            search->Wait();
+
+            const SearchResult searchResult = search->GetResult();
+            result.Nodes += searchResult.Nodes;
+            result.Time += searchResult.Time;
+          }
+
+          result.NodesPerSecond = static_cast<double>(result.Nodes) * 1000.0 / static_cast<double>(std::max<int64_t>(result.Time, 1));
+          results.push_back(result);
+
+          YK_INFO("[ENGINE] Hash {}MB on {} pages ({}MB huge): {:.0f} nps", sizeMB, LargePages::GetKindName(result.Kind), result.HugeMB, result.NodesPerSecond);
+        }
+      }
+
+      LargePages::SetPolicy(previousPolicy);
+      return results;
+    }
+  
+    ServingBenchmarkResult Benchmark::RunServing(int32_t games, int32_t threads, const ScheduledLimits& limits, int32_t max_plies)
+    {
+      ServingBenchmarkResult result;
+      result.Games = std::max(games, 1);
+      result.Threads = std::max(threads, 1);
+
+      struct ServedGame
+      {
+        Position Board = Position::StartPosition();
+        std::mt19937 Random;
+        int32_t Plies = 0;
+      };
+
+      std::vector<ServedGame> served(result.Games);
+      std::atomic<int32_t> finished = 0;
+      std::atomic<uint64_t> moves = 0;
+      std::mutex doneMutex;
+      std::condition_variable done;
+      // The scheduler goes first, its threads may still be returning from the last callback
+      std::function<void(int32_t)> advance;
+      std::shared_ptr<SearchScheduler> scheduler = SearchScheduler::Create(result.Threads, 16);
+
+      // White plays a random reply at once and hands the move to the scheduler, until the game is over
+      advance = [&](int32_t index)
+        {
+        ServedGame& game = served[index];
+        while (true)
+        {
+          MoveList legal;
+          MoveGen::GenerateLegal(game.Board, legal);
+          if (legal.empty() || game.Board.IsDraw(0) || game.Plies >= max_plies)
+          {
+            if (++finished == result.Games)
+            {
+              std::lock_guard<std::mutex> lock(doneMutex);
+              done.notify_all();
+            }
+            return;
+          }
+
+          if (game.Board.SideToMove() == White)
+          {
+            game.Board.MakeMove(legal[game.Random() % legal.size()]);
+            game.Plies++;
+            continue;
+          }
+
+          scheduler->Submit(game.Board, limits, [&, index](const ScheduledResult& answer)
+            {
+            served[index].Board.MakeMove(answer.BestMove);
+            served[index].Plies++;
+            moves++;
+            advance(index);
+            });
+          return;
+        }
+        };
+
+      const auto start = std::chrono::steady_clock::now();
+      for (int32_t index = 0; index < result.Games; index++)
+      {
+        served[index].Random.seed(static_cast<uint32_t>(index));
+        advance(index);
+      }
+      {
+        std::unique_lock<std::mutex> lock(doneMutex);
+        done.wait(lock, [&]() { return finished == result.Games; });
+      }
+
+      result.Time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+      const SchedulerStats stats = scheduler->GetStats();
+      const double coreSeconds = static_cast<double>(result.Threads) * static_cast<double>(std::max<int64_t>(result.Time, 1)) / 1000.0;
+      result.Moves = moves;
+      result.GamesPerCoreMinute = result.Games * 60.0 / coreSeconds;
+      result.MovesPerCoreSecond = static_cast<double>(result.Moves) / coreSeconds;
+      result.WorstLatency = stats.WorstLatency;
+      result.MeanLatency = stats.MeanLatency;
+      result.MissedDeadlines = stats.MissedDeadlines;
+
+      YK_INFO("[ENGINE] Served {} games on {} threads in {}ms: {:.1f} games per core minute, {:.0f} moves per core second, latency {:.0f}us mean {}us worst, {} deadlines missed",
+        result.Games, result.Threads, result.Time, result.GamesPerCoreMinute, result.MovesPerCoreSecond, result.MeanLatency, result.WorstLatency, result.MissedDeadlines);
+      return result;
+    }
+
+    std::vector<PrefetchBenchmarkResult> Benchmark::RunPrefetch(int32_t depth, size_t hash_mb, int32_t rounds)
+    {
+      std::vector<PrefetchBenchmarkResult> results(2);
+      results[1].Prefetch = true;
+
+      std::shared_ptr<Search> search = Search::Create(TranspositionTable::Create(hash_mb), 1);
+      for (int32_t round = 0; round < std::max(rounds, 1); round++)
+      {
+        for (PrefetchBenchmarkResult& result : results)
+        {
+          SearchOptions options = search->GetOptions();
+          options.Prefetch = result.Prefetch;
+          search->SetOptions(options);
+
+          for (const std::string_view fen : BenchFENs)
+          {
+            Position position;
+            position.SetFEN(fen);
+
+            SearchLimits limits;
+            limits.Depth = depth;
+            search->NewGame();
+            search->Start(position, limits);
+            search->Wait();
+
+            const SearchResult searchResult = search->GetResult();
+            result.Nodes += searchResult.Nodes;
+            result.Time += searchResult.Time;
+          }
+        }
+      }
+
+      for (PrefetchBenchmarkResult& result : results)
+      {
+        result.NodesPerSecond = static_cast<double>(result.Nodes) * 1000.0 / static_cast<double>(std::max<int64_t>(result.Time, 1));
+        YK_INFO("[ENGINE] Prefetch {} on {}MB: {} nodes in {}ms, {:.0f} nps", result.Prefetch ? "on" : "off", hash_mb, result.Nodes, result.Time,
+          result.NodesPerSecond);
+      }
+      return results;
+    }
+
+    std::vector<ClusterBenchmarkResult> Benchmark::RunCluster(const std::vector<int32_t>& workers, int32_t depth, const ClusterSettings& settings)
+    {
+      SearchLimits limits;
+      limits.Depth = depth;
+
+      // Keeping its table from one position to the next, as every worker does
+      int64_t baseline = 0;
+      std::shared_ptr<Search> search = Search::Create(TranspositionTable::Create(settings.HashMB), 1);
+      for (const std::string_view fen : HashBenchmarkFENs)
+      {
+        Position position;
+        position.SetFEN(fen);
+        search->Start(position, limits);
+        search->Wait();
+        baseline += search->GetResult().Time;
+      }
+      YK_INFO("[ENGINE] Cluster baseline depth {}: {}ms on one thread", depth, baseline);
+
+      std::vector<ClusterBenchmarkResult> results;
+      for (const int32_t count : workers)
+      {
+        ClusterSettings clusterSettings = settings;
+        clusterSettings.Workers = count;
+        std::shared_ptr<Cluster> cluster = Cluster::Create(clusterSettings);
+        if (!cluster)
+        {
+          YK_WARN("[ENGINE] Skipping the cluster benchmark with {} workers", count);
+          continue;
+        }
+
+        ClusterBenchmarkResult result;
+        result.Workers = cluster->GetWorkerCount();
+        for (const std::string_view fen : HashBenchmarkFENs)
+        {
+          Position position;
+          position.SetFEN(fen);
+
+          const SearchResult searchResult = cluster->Search(position, limits);
+          result.Nodes += searchResult.Nodes;
+          result.Time += searchResult.Time;
+        }
+
+        const ClusterStats stats = cluster->GetStats();
+        result.Speedup = static_cast<double>(baseline) / static_cast<double>(std::max<int64_t>(result.Time, 1));
+        result.EntriesShared = stats.EntriesShared;
+        result.BoundsShared = stats.BoundsShared;
+        result.Releases = stats.Releases;
+        result.BytesSent = stats.BytesSent;
+        result.BytesReceived = stats.BytesReceived;
+        results.push_back(result);
+
+        YK_INFO("[ENGINE] Cluster of {} workers: {} nodes in {}ms, speedup {:.2f}, {} entries and {} bounds shared", result.Workers, result.Nodes,
+          result.Time, result.Speedup, result.EntriesShared, result.BoundsShared);
+      }
+      return results;
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+
+#include "GameLogic/Chess/Engine/Cluster.h"
+#include "GameLogic/Chess/Engine/LargePages.h"
+#include "GameLogic/Chess/Engine/Search.h"
+#include "GameLogic/Chess/Engine/SearchScheduler.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    struct HashBenchmarkResult
+    {
+      size_t SizeMB = 0;
+      HugePagePolicy Policy = HugePagePolicy::Off;
+      PageKind Kind = PageKind::Normal;
+      size_t HugeMB = 0;
+      uint64_t Nodes = 0;
+      int64_t Time = 0;
+      double NodesPerSecond = 0.0;
+    };
+
+    struct BenchResult
+    {
+      uint64_t Nodes = 0; // The signature, only a change in search behaviour changes it
+      int64_t Time = 0;
+      double NodesPerSecond = 0.0;
+      std::vector<uint64_t> PositionNodes;
+    };
+
+    struct ServingBenchmarkResult
+    {
+      int32_t Games = 0;
+      int32_t Threads = 0;
+      uint64_t Moves = 0; // Answered by the scheduled searches
+      int64_t Time = 0;
+      double GamesPerCoreMinute = 0.0;
+      double MovesPerCoreSecond = 0.0;
+      int64_t WorstLatency = 0; // Microseconds
+      double MeanLatency = 0.0;
+      uint64_t MissedDeadlines = 0;
+    };
+
+    struct PrefetchBenchmarkResult
+    {
+      bool Prefetch = false;
+      uint64_t Nodes = 0; // The same either way, prefetching does not change the search
+      int64_t Time = 0;
+      double NodesPerSecond = 0.0;
+    };
+
+    struct ClusterBenchmarkResult
+    {
+      int32_t Workers = 0;
+      uint64_t Nodes = 0;
+      int64_t Time = 0;
+      double Speedup = 0.0; // Over one search on one thread in this process, to the same depth
+      uint64_t EntriesShared = 0;
+      uint64_t BoundsShared = 0;
+      uint64_t Releases = 0;
+      uint64_t BytesSent = 0;
+      uint64_t BytesReceived = 0;
+    };
+
+    class Benchmark
+    {
+    public:
+      static constexpr int32_t DefaultBenchDepth = 13;
+
+      // Searches a fixed set of positions to a fixed depth on one thread, each from a cleared hash table, so the node count is
+      // the same on every host and compiler. Probes any loaded endgame tables, which then become part of the signature
+      static BenchResult Run(int32_t depth = DefaultBenchDepth, size_t hash_mb = 16, std::shared_ptr<const NNUE::Network> network = nullptr);
+
+      // Searches the same positions for a fixed time at every hash size, once on normal pages and once with the given huge page policy.
+      // Sizes that would not fit in physical memory are skipped.
+      static std::vector<HashBenchmarkResult> RunHash(const std::vector<size_t>& sizes_mb, int64_t move_time, int32_t threads,
+        HugePagePolicy policy = HugePagePolicy::Transparent);
+
+      // Hosts that many games at once against scheduled searches on a few threads, the other side answering instantly with
+      // random moves, and measures how many games a core serves and how long the slowest answer took
+      static ServingBenchmarkResult RunServing(int32_t games, int32_t threads, const ScheduledLimits& limits, int32_t max_plies = 200);
+
+      // Runs the bench positions with make-move prefetching off and on, alternating for the given rounds so that both see the same
+      // load on the host. A table far larger than the caches shows the most difference. Returns the off totals first
+      static std::vector<PrefetchBenchmarkResult> RunPrefetch(int32_t depth, size_t hash_mb, int32_t rounds);
+
+      // Searches the middlegames to a fixed depth on a cluster of each size, started fresh every time with the given settings,
+      // and compares the time with one thread searching them in this process. Sizes whose workers cannot be started are skipped
+      static std::vector<ClusterBenchmarkResult> RunCluster(const std::vector<int32_t>& workers, int32_t depth, const ClusterSettings& settings);
+
+    private:
+      Benchmark() = delete;
+      Benchmark(const Benchmark&) = delete;
+      Benchmark& operator=(const Benchmark&) = delete;
+      Benchmark(Benchmark&&) = delete;
+      Benchmark& operator=(Benchmark&&) = delete;
+    };
+  }
+}
\ No newline at end of file
@@ -0,0 +1,573 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/Bitbases.h"
+#include "GameLogic/Chess/Engine/MappedFile.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      constexpr uint32_t BitbaseMagic = 0x4242594B; // "YKBB"
+      constexpr uint32_t BitbaseVersion = 1;
+
+      struct FileHeader
+      {
+        uint32_t Magic = BitbaseMagic;
+        uint32_t Version = BitbaseVersion;
+        char Name[8] = {};
+        uint32_t BitsPerPosition = 0;
+        uint32_t Reserved = 0;
+        uint64_t Positions = 0;
+        uint64_t DataOffset = 0;
+        uint8_t Padding[24] = {};
+      };
+      static_assert(sizeof(FileHeader) == 64);
+
+      // In generation order, every capture or promotion leads to an endgame listed before it or to a dead draw
+      constexpr std::string_view Endgames[] = { "KQK", "KRK", "KPK", "KRKN", "KRKB", "KRKR", "KRKQ", "KRKP" };
+
+      constexpr const char* Extension = ".ykbb";
+
+      // Generation values, the first four match BitbaseResult
+      constexpr uint8_t ValueInvalid = 4;
+
+      constexpr uint64_t GenerationChunk = 4096;
+
+      // The two kings first, then white's pieces and black's, strongest first
+      struct PieceList
+      {
+        Piece Pieces[Bitbases::MaxPieces] = {};
+        Square Squares[Bitbases::MaxPieces] = {};
+        int32_t Count = 0;
+        Color SideToMove = White;
+      };
+
+      void Normalize(PieceList& list)
+      {
+        for (int32_t i = 3; i < list.Count; i++)
+          for (int32_t j = i; j > 2 && (ColorOf(list.Pieces[j]) < ColorOf(list.Pieces[j - 1])
+            || (ColorOf(list.Pieces[j]) == ColorOf(list.Pieces[j - 1]) && TypeOf(list.Pieces[j]) > TypeOf(list.Pieces[j - 1]))); j--)
+          {
+            std::swap(list.Pieces[j], list.Pieces[j - 1]);
+            std::swap(list.Squares[j], list.Squares[j - 1]);
+          }
+      }
+
+      // Black's material seen as white's, board mirrored top to bottom
+      void FlipColors(PieceList& list)
+      {
+        for (int32_t i = 0; i < list.Count; i++)
+        {
+          list.Pieces[i] = MakePiece(~ColorOf(list.Pieces[i]), TypeOf(list.Pieces[i]));
+          list.Squares[i] = FlipRank(list.Squares[i]);
+        }
+        std::swap(list.Pieces[0], list.Pieces[1]);
+        std::swap(list.Squares[0], list.Squares[1]);
+        list.SideToMove = ~list.SideToMove;
+        Normalize(list);
+      }
+
+      // The pieces besides the kings, in normalized order
+      uint32_t MaterialKey(const PieceList& list)
+      {
+        return ((list.Count > 2) ? (list.Pieces[2] << 4) : 0) | ((list.Count > 3) ? list.Pieces[3] : 0);
+      }
+
+      constexpr Square Transpose(Square square) { return ((square >> 3) | (square << 3)) & 63; }
+
+      // The a1-d1-d4 triangle, where the white king of a pawnless endgame is always brought
+      const std::array<int8_t, 64> TriangleIndex = []()
+        {
+        std::array<int8_t, 64> table;
+        table.fill(-1);
+        int8_t index = 0;
+        for (int32_t rank = 0; rank < 4; rank++)
+          for (int32_t file = rank; file < 4; file++)
+            table[MakeSquare(file, rank)] = index++;
+        return table;
+        }();
+
+      const std::array<Square, 10> TriangleSquares = []()
+        {
+        std::array<Square, 10> squares = {};
+        for (Square square = 0; square < 64; square++)
+          if (TriangleIndex[square] >= 0)
+            squares[TriangleIndex[square]] = square;
+        return squares;
+        }();
+
+      // Index = side to move, white king, black king, then each other piece. The white king goes to the a-d files,
+      // and without pawns into the triangle. Pawns only take the 48 squares of ranks 2 to 7
+      struct Layout
+      {
+        std::string Name;
+        PieceList Material;
+        bool HasPawns = false;
+        uint64_t KingSquares = 0;
+        uint64_t Size = 0;
+
+        bool Parse(std::string_view name)
+        {
+          const size_t second = name.find('K', 1);
+          if (name.empty() || name[0] != 'K' || second == std::string_view::npos || name.size() > Bitbases::MaxPieces)
+            return false;
+
+          Name = name;
+          Material = PieceList();
+          Material.Pieces[0] = WhiteKing;
+          Material.Pieces[1] = BlackKing;
+          Material.Count = 2;
+          for (size_t i = 1; i < name.size(); i++)
+          {
+            if (i == second)
+              continue;
+            const size_t type = std::string_view("PNBRQ").find(name[i]);
+            if (type == std::string_view::npos)
+              return false;
+            Material.Pieces[Material.Count++] = MakePiece((i < second) ? White : Black, static_cast<PieceType>(Pawn + type));
+          }
+          Normalize(Material);
+
+          HasPawns = false;
+          for (int32_t i = 2; i < Material.Count; i++)
+            HasPawns |= TypeOf(Material.Pieces[i]) == Pawn;
+
+          KingSquares = HasPawns ? 32 : 10;
+          Size = 2 * KingSquares * 64;
+          for (int32_t i = 2; i < Material.Count; i++)
+            Size *= Layout::SquareCount(i);
+          return true;
+        }
+
+        uint64_t SquareCount(int32_t piece) const { return (TypeOf(Material.Pieces[piece]) == Pawn) ? 48 : 64; }
+
+        // The list must hold this material in normalized order
+        uint64_t Index(const PieceList& list) const
+        {
+          Square squares[Bitbases::MaxPieces];
+          std::copy(list.Squares, list.Squares + list.Count, squares);
+
+          if (FileOf(squares[0]) > 3)
+            for (int32_t i = 0; i < list.Count; i++)
+              squares[i] ^= 7;
+
+          if (!HasPawns)
+          {
+            if (RankOf(squares[0]) > 3)
+              for (int32_t i = 0; i < list.Count; i++)
+                squares[i] ^= 56;
+            if (RankOf(squares[0]) > FileOf(squares[0]))
+              for (int32_t i = 0; i < list.Count; i++)
+                squares[i] = Transpose(squares[i]);
+          }
+
+          uint64_t index = list.SideToMove;
+          index = index * KingSquares + (HasPawns ? RankOf(squares[0]) * 4 + FileOf(squares[0]) : TriangleIndex[squares[0]]);
+          index = index * 64 + squares[1];
+          for (int32_t i = 2; i < list.Count; i++)
+            index = index * Layout::SquareCount(i) + ((TypeOf(list.Pieces[i]) == Pawn) ? squares[i] - 8 : squares[i]);
+          return index;
+        }
+
+        void Decode(uint64_t index, PieceList& list) const
+        {
+          list = Material;
+          for (int32_t i = list.Count - 1; i >= 2; i--)
+          {
+            const uint64_t count = Layout::SquareCount(i);
+            list.Squares[i] = static_cast<Square>(index % count) + ((count == 48) ? 8 : 0);
+            index /= count;
+          }
+          list.Squares[1] = static_cast<Square>(index % 64);
+          index /= 64;
+          const int32_t king = static_cast<int32_t>(index % KingSquares);
+          list.Squares[0] = HasPawns ? MakeSquare(king % 4, king / 4) : TriangleSquares[king];
+          list.SideToMove = static_cast<Color>(index / KingSquares);
+        }
+      };
+
+      struct Table
+      {
+        Layout Shape;
+        int32_t BitsPerPosition = 0;
+        const uint8_t* Data = nullptr;
+        std::shared_ptr<MappedFile> File;
+
+        BitbaseResult Get(uint64_t index) const
+        {
+          if (BitsPerPosition == 2)
+            return static_cast<BitbaseResult>(((Data[index >> 2] >> ((index & 3) * 2)) & 3) + 1);
+
+          // One bit, set where white wins
+          if (!((Data[index >> 3] >> (index & 7)) & 1))
+            return BitbaseResult::Draw;
+          return (index < Shape.Size / 2) ? BitbaseResult::Win : BitbaseResult::Loss;
+        }
+      };
+
+      // Written once per material before readers can see it, tables are never freed while the engine runs
+      std::array<std::atomic<const Table*>, 256> s_Registry = {};
+      std::vector<std::unique_ptr<Table>> s_Tables;
+      std::mutex s_TablesMutex;
+
+      void Register(std::unique_ptr<Table> table)
+      {
+        std::lock_guard<std::mutex> lock(s_TablesMutex);
+        s_Registry[MaterialKey(table->Shape.Material)].store(table.get(), std::memory_order_release);
+        s_Tables.push_back(std::move(table));
+      }
+
+      std::unique_ptr<Table> LoadTable(const std::filesystem::path& path)
+      {
+        std::unique_ptr<Table> table = std::make_unique<Table>();
+        table->File = MappedFile::Open(path);
+        if (!table->File)
+          return nullptr;
+
+        FileHeader header;
+        if (table->File->GetSize() < sizeof(FileHeader))
+          return nullptr;
+        std::memcpy(&header, table->File->GetData(), sizeof(FileHeader));
+
+        const std::string name(header.Name, strnlen(header.Name, sizeof(header.Name)));
+        if (header.Magic != BitbaseMagic || header.Version != BitbaseVersion || !table->Shape.Parse(name) || header.Positions != table->Shape.Size
+          || (header.BitsPerPosition != 1 && header.BitsPerPosition != 2)
+          || table->File->GetSize() < header.DataOffset + (header.Positions * header.BitsPerPosition + 7) / 8)
+        {
+          YK_WARN("[ENGINE] '{}' is not a bitbase for this engine version", path.string());
+          return nullptr;
+        }
+
+        table->BitsPerPosition = static_cast<int32_t>(header.BitsPerPosition);
+        table->Data = reinterpret_cast<const uint8_t*>(table->File->GetData()) + header.DataOffset;
+        return table;
+      }
+
+      BitbaseResult ProbeList(PieceList list)
+      {
+        // Dead draws have no table
+        if (list.Count == 2 || (list.Count == 3 && (TypeOf(list.Pieces[2]) == Knight || TypeOf(list.Pieces[2]) == Bishop)))
+          return BitbaseResult::Draw;
+
+        Normalize(list);
+        const Table* table = s_Registry[MaterialKey(list)].load(std::memory_order_acquire);
+        if (!table)
+        {
+          FlipColors(list);
+          table = s_Registry[MaterialKey(list)].load(std::memory_order_acquire);
+          if (!table)
+            return BitbaseResult::Unknown;
+        }
+        return table->Get(table->Shape.Index(list));
+      }
+
+      bool IsAttacked(const PieceList& list, Bitboard occupied, Square square, Color by)
+      {
+        for (int32_t i = 0; i < list.Count; i++)
+        {
+          if (ColorOf(list.Pieces[i]) != by)
+            continue;
+          const PieceType type = TypeOf(list.Pieces[i]);
+          const Bitboard attacks = (type == Pawn) ? Bitboards::PawnAttacks(by, list.Squares[i]) : Bitboards::Attacks(type, list.Squares[i], occupied);
+          if (attacks & SquareBB(square))
+            return true;
+        }
+        return false;
+      }
+
+      // Calls visit(child, changed) for every legal move, changed when the material is not the same anymore.
+      // Stops as soon as visit returns true
+      template<typename Visit>
+      void ForEachChild(const PieceList& list, Bitboard occupied, Visit&& visit)
+      {
+        const Color us = list.SideToMove;
+        Bitboard own = 0ULL;
+        for (int32_t i = 0; i < list.Count; i++)
+          if (ColorOf(list.Pieces[i]) == us)
+            own |= SquareBB(list.Squares[i]);
+
+        for (int32_t i = 0; i < list.Count; i++)
+        {
+          if (ColorOf(list.Pieces[i]) != us)
+            continue;
+
+          const PieceType type = TypeOf(list.Pieces[i]);
+          const Square from = list.Squares[i];
+          Bitboard targets;
+          if (type == Pawn)
+          {
+            const Square push = from + PawnPush(us);
+            targets = Bitboards::PawnAttacks(us, from) & occupied & ~own;
+            if (!(occupied & SquareBB(push)))
+            {
+              targets |= SquareBB(push);
+              if (RelativeRank(us, from) == 1 && !(occupied & SquareBB(push + PawnPush(us))))
+                targets |= SquareBB(push + PawnPush(us));
+            }
+          }
+          else
+            targets = Bitboards::Attacks(type, from, occupied) & ~own;
+
+          while (targets)
+          {
+            const Square to = PopLSB(targets);
+
+            PieceList child = list;
+            child.Squares[i] = to;
+            int32_t moved = i;
+            bool changed = false;
+            for (int32_t j = 2; j < child.Count; j++)
+            {
+              if (j != i && child.Squares[j] == to)
+              {
+                std::copy(child.Pieces + j + 1, child.Pieces + child.Count, child.Pieces + j);
+                std::copy(child.Squares + j + 1, child.Squares + child.Count, child.Squares + j);
+                child.Count--;
+                moved -= (j < i);
+                changed = true;
+                break;
+              }
+            }
+
+            // Kings sit at the front in color order
+            const Bitboard childOccupied = (occupied ^ SquareBB(from)) | SquareBB(to);
+            if (IsAttacked(child, childOccupied, child.Squares[us], ~us))
+              continue;
+
+            child.SideToMove = ~us;
+            if (type == Pawn && RelativeRank(us, to) == 7)
+            {
+              for (const PieceType promotion : { Queen, Rook, Bishop, Knight })
+              {
+                child.Pieces[moved] = MakePiece(us, promotion);
+                if (visit(child, true))
+                  return;
+              }
+            }
+            else if (visit(child, changed))
+              return;
+          }
+        }
+      }
+
+      uint8_t Classify(const Layout& layout, std::vector<uint8_t>& values, uint64_t index)
+      {
+        PieceList list;
+        layout.Decode(index, list);
+
+        Bitboard occupied = 0ULL;
+        for (int32_t i = 0; i < list.Count; i++)
+        {
+          if (occupied & SquareBB(list.Squares[i]))
+            return ValueInvalid;
+          occupied |= SquareBB(list.Squares[i]);
+        }
+
+        // The side that just moved cannot be in check, this also rules out touching kings
+        const Color us = list.SideToMove;
+        if (IsAttacked(list, occupied, list.Squares[~us], us))
+          return ValueInvalid;
+
+        bool anyMove = false;
+        bool allWon = true;
+        bool won = false;
+        ForEachChild(list, occupied, [&](const PieceList& child, bool changed)
+          {
+          anyMove = true;
+          const BitbaseResult result = changed ? ProbeList(child)
+            : static_cast<BitbaseResult>(std::atomic_ref<uint8_t>(values[layout.Index(child)]).load(std::memory_order_relaxed));
+          won = result == BitbaseResult::Loss;
+          allWon &= result == BitbaseResult::Win;
+          return won;
+          });
+
+        if (won)
+          return static_cast<uint8_t>(BitbaseResult::Win);
+        if (!anyMove)
+          return static_cast<uint8_t>(IsAttacked(list, occupied, list.Squares[us], ~us) ? BitbaseResult::Loss : BitbaseResult::Draw);
+        return static_cast<uint8_t>(allWon ? BitbaseResult::Loss : BitbaseResult::Unknown);
+      }
+    }
+
+    size_t Bitbases::Load(const std::filesystem::path& directory)
+    {
+      size_t loaded = 0;
+      for (const std::string_view name : Endgames)
+      {
+        const std::filesystem::path path = directory / (std::string(name) + Extension);
+        std::error_code error;
+        if (!std::filesystem::exists(path, error))
+          continue;
+
+        std::unique_ptr<Table> table = LoadTable(path);
+        if (!table)
+          continue;
+        Register(std::move(table));
+        loaded++;
+      }
+
+      if (loaded)
+        YK_INFO("[ENGINE] Loaded {} bitbases from '{}'", loaded, directory.string());
+      return loaded;
+    }
+
+    std::vector<BitbaseReport> Bitbases::Generate(const std::filesystem::path& directory, int32_t threads)
+    {
+      std::vector<BitbaseReport> reports;
+      std::error_code error;
+      std::filesystem::create_directories(directory, error);
+
+      for (const std::string_view name : Endgames)
+      {
+        const auto start = std::chrono::steady_clock::now();
+
+        Layout layout;
+        layout.Parse(name);
+        std::vector<uint8_t> values(layout.Size, static_cast<uint8_t>(BitbaseResult::Unknown));
+
+        BitbaseReport report;
+        report.Name = name;
+        report.Positions = layout.Size;
+
+        // Every pass settles the positions one more ply away from a mate or a conversion. Values only ever go from
+        // unknown to final, so workers can share the array and see each other's results early
+        bool progress = true;
+        while (progress)
+        {
+          std::atomic<uint64_t> next = 0;
+          std::atomic<bool> anyChange = false;
+          const auto work = [&]()
+            {
+            bool changed = false;
+            for (uint64_t begin; (begin = next.fetch_add(GenerationChunk, std::memory_order_relaxed)) < layout.Size;)
+            {
+              const uint64_t end = std::min(begin + GenerationChunk, layout.Size);
+              for (uint64_t index = begin; index < end; index++)
+              {
+                if (std::atomic_ref<uint8_t>(values[index]).load(std::memory_order_relaxed) != static_cast<uint8_t>(BitbaseResult::Unknown))
+                  continue;
+
+                const uint8_t value = Classify(layout, values, index);
+                if (value != static_cast<uint8_t>(BitbaseResult::Unknown))
+                {
+                  std::atomic_ref<uint8_t>(values[index]).store(value, std::memory_order_relaxed);
+                  changed = true;
+                }
+              }
+            }
+            if (changed)
+              anyChange.store(true, std::memory_order_relaxed);
+            };
+
+          std::vector<std::thread> workers;
+          for (int32_t i = 1; i < threads; i++)
+            workers.emplace_back(work);
+          work();
+          for (std::thread& worker : workers)
+            worker.join();
+
+          report.Passes++;
+          progress = anyChange.load(std::memory_order_relaxed);
+        }
+
+        // One bit is enough when the side with the first pieces never loses
+        bool secondSideWins = false;
+        for (uint64_t index = 0; index < layout.Size; index++)
+        {
+          const BitbaseResult result = static_cast<BitbaseResult>(values[index]);
+          const bool whiteToMove = index < layout.Size / 2;
+          if (values[index] == ValueInvalid)
+            continue;
+
+          report.Legal++;
+          report.Wins += (whiteToMove ? result == BitbaseResult::Win : result == BitbaseResult::Loss);
+          secondSideWins |= (whiteToMove ? result == BitbaseResult::Loss : result == BitbaseResult::Win);
+        }
+
+        report.BitsPerPosition = secondSideWins ? 2 : 1;
+        std::vector<uint8_t> packed((layout.Size * report.BitsPerPosition + 7) / 8, 0);
+        for (uint64_t index = 0; index < layout.Size; index++)
+        {
+          const BitbaseResult result = static_cast<BitbaseResult>(values[index]);
+          if (report.BitsPerPosition == 2)
+          {
+            // Unknown positions are draws, invalid ones are never probed
+            const uint8_t code = (result == BitbaseResult::Win) ? 1 : ((result == BitbaseResult::Loss) ? 2 : 0);
+            packed[index >> 2] |= static_cast<uint8_t>(code << ((index & 3) * 2));
+          }
+          else if ((index < layout.Size / 2) ? result == BitbaseResult::Win : result == BitbaseResult::Loss)
+            packed[index >> 3] |= static_cast<uint8_t>(1 << (index & 7));
+        }
+
+        FileHeader header;
+        std::memcpy(header.Name, name.data(), name.size());
+        header.BitsPerPosition = static_cast<uint32_t>(report.BitsPerPosition);
+        header.Positions = layout.Size;
+        header.DataOffset = sizeof(FileHeader);
+
+        const std::filesystem::path path = directory / (std::string(name) + Extension);
+        {
+          std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+          stream.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+          stream.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(packed.size()));
+          if (!stream)
+          {
+            YK_ERROR("[ENGINE] Could not write bitbase '{}'", path.string());
+            return reports;
+          }
+        }
+
+        // The larger endgames probe this one through the registry, the same way the search will
+        std::unique_ptr<Table> table = LoadTable(path);
+        if (!table)
+          return reports;
+        Register(std::move(table));
+
+        report.Bytes = sizeof(FileHeader) + packed.size();
+        report.Time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        YK_INFO("[ENGINE] Bitbase {}: {} positions ({} legal, {:.1f}% won), {} bit(s) each, {}KB, {} passes in {}ms", report.Name, report.Positions,
+          report.Legal, 100.0 * static_cast<double>(report.Wins) / static_cast<double>(std::max<uint64_t>(report.Legal, 1)), report.BitsPerPosition,
+          report.Bytes >> 10, report.Passes, report.Time);
+        reports.push_back(report);
+      }
+
+      return reports;
+    }
+
+    BitbaseResult Bitbases::Probe(const Position& position)
+    {
+      const Bitboard occupied = position.Pieces();
+      if (PopCount(occupied) > MaxPieces)
+        return BitbaseResult::Unknown;
+
+      PieceList list;
+      list.Pieces[0] = WhiteKing;
+      list.Squares[0] = position.KingSquare(White);
+      list.Pieces[1] = BlackKing;
+      list.Squares[1] = position.KingSquare(Black);
+      list.Count = 2;
+      for (Bitboard others = occupied & ~position.Pieces(King); others;)
+      {
+        const Square square = PopLSB(others);
+        list.Pieces[list.Count] = position.PieceOn(square);
+        list.Squares[list.Count++] = square;
+      }
+      list.SideToMove = position.SideToMove();
+
+      return ProbeList(list);
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "GameLogic/Chess/Engine/Position.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    // From the side to move's point of view
+    enum class BitbaseResult : uint8_t
+    {
+      Unknown, // No bitbase for the material
+      Draw,
+      Win,
+      Loss
+    };
+
+    struct BitbaseReport
+    {
+      std::string Name;
+      uint64_t Positions = 0;
+      uint64_t Wins = 0; // Legal positions won by the side with the first pieces, either side to move
+      uint64_t Legal = 0;
+      int32_t BitsPerPosition = 0;
+      size_t Bytes = 0;
+      int32_t Passes = 0;
+      int64_t Time = 0; // Milliseconds
+    };
+
+    // Exact win/draw/loss tables of the endgames with up to four pieces, built in project by retrograde analysis.
+    // One bit per position when only one side can ever win, two otherwise
+    class Bitbases
+    {
+    public:
+      static constexpr int32_t MaxPieces = 4;
+
+      // Maps every bitbase file found in the directory. Returns how many were loaded
+      static size_t Load(const std::filesystem::path& directory);
+
+      // Builds every endgame, each one after the smaller ones its captures and promotions lead to, writes the files
+      // and loads them. Probing from other threads stays safe while it runs
+      static std::vector<BitbaseReport> Generate(const std::filesystem::path& directory, int32_t threads);
+
+      static BitbaseResult Probe(const Position& position);
+
+    private:
+      Bitbases() = delete;
+      Bitbases(const Bitbases&) = delete;
+      Bitbases& operator=(const Bitbases&) = delete;
+      Bitbases(Bitbases&&) = delete;
+      Bitbases& operator=(Bitbases&&) = delete;
+    };
+  }
+}
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/Bitboards.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    Bitboard Bitboards::s_PawnAttacks[ColorCount][64];
+    Bitboard Bitboards::s_KnightAttacks[64];
+    Bitboard Bitboards::s_KingAttacks[64];
+    Bitboard Bitboards::s_Between[64][64];
+    Bitboard Bitboards::s_Line[64][64];
+    uint8_t Bitboards::s_Distance[64][64];
+
+    Bitboards::Magic Bitboards::s_BishopMagics[64];
+    Bitboards::Magic Bitboards::s_RookMagics[64];
+    Bitboard Bitboards::s_BishopTable[0x1480];
+    Bitboard Bitboards::s_RookTable[0x19000];
+
+    namespace
+    {
+      Bitboard SlidingAttacks(PieceType type, Square square, Bitboard occupied)
+      {
+        const std::array<std::array<int32_t, 2>, 4> rookDirections = { {{1, 0}, {-1, 0}, {0, 1}, {0, -1}} };
+        const std::array<std::array<int32_t, 2>, 4> bishopDirections = { {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}} };
+
+        Bitboard attacks = 0ULL;
+        for (const auto& [df, dr] : (type == Rook) ? rookDirections : bishopDirections)
+        {
+          int32_t file = FileOf(square) + df;
+          int32_t rank = RankOf(square) + dr;
+          while (file >= 0 && file < 8 && rank >= 0 && rank < 8)
+          {
+            Bitboard target = SquareBB(MakeSquare(file, rank));
+            attacks |= target;
+            if (occupied & target)
+              break;
+            file += df;
+            rank += dr;
+          }
+        }
+        return attacks;
+      }
+
+      Bitboard StepAttacks(Square square, const std::array<std::array<int32_t, 2>, 8>& steps)
+      {
+        Bitboard attacks = 0ULL;
+        for (const auto& [df, dr] : steps)
+        {
+          int32_t file = FileOf(square) + df;
+          int32_t rank = RankOf(square) + dr;
+          if (file >= 0 && file < 8 && rank >= 0 && rank < 8)
+            attacks |= SquareBB(MakeSquare(file, rank));
+        }
+        return attacks;
+      }
+
+      // Xorshift64* generator, seeded so that magic numbers are found deterministically and fast
+      class MagicRNG
+      {
+      public:
+        explicit MagicRNG(uint64_t seed) : m_State(seed) {}
+
+        uint64_t Next()
+        {
+          m_State ^= m_State >> 12;
+          m_State ^= m_State << 25;
+          m_State ^= m_State >> 27;
+          return m_State * 2685821657736338717ULL;
+        }
+
+        uint64_t Sparse() { return Next() & Next() & Next(); }
+
+      private:
+        uint64_t m_State;
+      };
+    }
+
+    void Bitboards::Init()
+    {
+      const std::array<std::array<int32_t, 2>, 8> knightSteps = { {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}} };
+      const std::array<std::array<int32_t, 2>, 8> kingSteps = { {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}} };
+
+      for (Square square = 0; square < 64; square++)
+      {
+        s_PawnAttacks[White][square] = PawnAttacksBB<White>(SquareBB(square));
+        s_PawnAttacks[Black][square] = PawnAttacksBB<Black>(SquareBB(square));
+        s_KnightAttacks[square] = StepAttacks(square, knightSteps);
+        s_KingAttacks[square] = StepAttacks(square, kingSteps);
+
+        for (Square other = 0; other < 64; other++)
+          s_Distance[square][other] = static_cast<uint8_t>(std::max(std::abs(FileOf(square) - FileOf(other)), std::abs(RankOf(square) - RankOf(other))));
+      }
+
+      Bitboards::InitMagics(Bishop, s_BishopTable, s_BishopMagics);
+      Bitboards::InitMagics(Rook, s_RookTable, s_RookMagics);
+
+      for (Square from = 0; from < 64; from++)
+      {
+        for (Square to = 0; to < 64; to++)
+        {
+          s_Between[from][to] = 0ULL;
+          s_Line[from][to] = 0ULL;
+
+          for (PieceType type : { Bishop, Rook })
+          {
+            if (SlidingAttacks(type, from, 0ULL) & SquareBB(to))
+            {
+              s_Line[from][to] = (SlidingAttacks(type, from, 0ULL) & SlidingAttacks(type, to, 0ULL)) | SquareBB(from) | SquareBB(to);
+              s_Between[from][to] = SlidingAttacks(type, from, SquareBB(to)) & SlidingAttacks(type, to, SquareBB(from));
+            }
+          }
+        }
+      }
+    }
+
+    Bitboard Bitboards::Attacks(PieceType type, Square square, Bitboard occupied)
+    {
+      switch (type)
+      {
+      case Knight: return s_KnightAttacks[square];
+      case Bishop: return Bitboards::BishopAttacks(square, occupied);
+      case Rook:   return Bitboards::RookAttacks(square, occupied);
+      case Queen:  return Bitboards::QueenAttacks(square, occupied);
+      case King:   return s_KingAttacks[square];
+      default:
+        YK_ASSERT(false, "Attacks() is not defined for pawns, use PawnAttacks()");
+        return 0ULL;
+      }
+    }
+
+    void Bitboards::InitMagics(PieceType type, Bitboard* table, Magic* magics)
+    {
+      const std::array<uint64_t, 8> seeds = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+
+      std::array<Bitboard, 4096> occupancy;
+      std::array<Bitboard, 4096> reference;
+      std::array<int32_t, 4096> epoch = {};
+      int32_t attempt = 0;
+
+      for (Square square = 0; square < 64; square++)
+      {
+        Magic& magic = magics[square];
+
+        Bitboard edges = ((Rank1BB | Rank8BB) & ~RankBB(RankOf(square))) | ((FileABB | FileHBB) & ~FileBB(FileOf(square)));
+        magic.Mask = SlidingAttacks(type, square, 0ULL) & ~edges;
+        magic.Shift = 64 - PopCount(magic.Mask);
+        magic.Attacks = (square == 0) ? table : magics[square - 1].Attacks + (1ULL << (64 - magics[square - 1].Shift));
+
+        // Carry-Rippler enumeration of every subset of the mask
+        int32_t size = 0;
+        Bitboard subset = 0ULL;
+        do
+        {
+          occupancy[size] = subset;
+          reference[size] = SlidingAttacks(type, square, subset);
+          size++;
+          subset = (subset - magic.Mask) & magic.Mask;
+        } while (subset);
+
+        MagicRNG rng(seeds[RankOf(square)]);
+        for (int32_t i = 0; i < size;)
+        {
+          do
+          {
+            magic.Number = rng.Sparse();
+          } while (PopCount((magic.Mask * magic.Number) >> 56) < 6);
+
+          attempt++;
+          for (i = 0; i < size; i++)
+          {
+            uint32_t index = magic.Index(occupancy[i]);
+            if (epoch[index] < attempt)
+            {
+              epoch[index] = attempt;
+              magic.Attacks[index] = reference[i];
+            }
+            else if (magic.Attacks[index] != reference[i])
+              break;
+          }
+        }
+      }
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <bit>
+
+#include "GameLogic/Chess/Engine/Types.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    constexpr Bitboard FileABB = 0x0101010101010101ULL;
+    constexpr Bitboard FileHBB = FileABB << 7;
+    constexpr Bitboard Rank1BB = 0xFFULL;
+    constexpr Bitboard Rank2BB = Rank1BB << 8;
+    constexpr Bitboard Rank3BB = Rank1BB << 16;
+    constexpr Bitboard Rank4BB = Rank1BB << 24;
+    constexpr Bitboard Rank5BB = Rank1BB << 32;
+    constexpr Bitboard Rank6BB = Rank1BB << 40;
+    constexpr Bitboard Rank7BB = Rank1BB << 48;
+    constexpr Bitboard Rank8BB = Rank1BB << 56;
+
+    constexpr Bitboard SquareBB(Square square) { return 1ULL << square; }
+    constexpr Bitboard FileBB(int32_t file) { return FileABB << file; }
+    constexpr Bitboard RankBB(int32_t rank) { return Rank1BB << (8 * rank); }
+
+    inline int32_t PopCount(Bitboard board) { return std::popcount(board); }
+    inline Square LSB(Bitboard board) { return static_cast<Square>(std::countr_zero(board)); }
+    inline Square MSB(Bitboard board) { return static_cast<Square>(63 - std::countl_zero(board)); }
+    inline Square PopLSB(Bitboard& board) { Square square = LSB(board); board &= board - 1; return square; }
+    inline bool MoreThanOne(Bitboard board) { return board & (board - 1); }
+
+    template<int32_t Direction>
+    constexpr Bitboard Shift(Bitboard board)
+    {
+      if constexpr (Direction == 8)  return board << 8;
+      if constexpr (Direction == -8) return board >> 8;
+      if constexpr (Direction == 1)  return (board & ~FileHBB) << 1;
+      if constexpr (Direction == -1) return (board & ~FileABB) >> 1;
+      if constexpr (Direction == 9)  return (board & ~FileHBB) << 9;
+      if constexpr (Direction == 7)  return (board & ~FileABB) << 7;
+      if constexpr (Direction == -7) return (board & ~FileHBB) >> 7;
+      if constexpr (Direction == -9) return (board & ~FileABB) >> 9;
+      return 0ULL;
+    }
+
+    template<Color Us>
+    constexpr Bitboard PawnAttacksBB(Bitboard pawns)
+    {
+      return Us == White ? Shift<7>(pawns) | Shift<9>(pawns) : Shift<-7>(pawns) | Shift<-9>(pawns);
+    }
+
+    class Bitboards
+    {
+    public:
+      static void Init();
+
+      static Bitboard PawnAttacks(Color color, Square square) { return s_PawnAttacks[color][square]; }
+      static Bitboard KnightAttacks(Square square) { return s_KnightAttacks[square]; }
+      static Bitboard KingAttacks(Square square) { return s_KingAttacks[square]; }
+      static Bitboard BishopAttacks(Square square, Bitboard occupied) { return s_BishopMagics[square].Attacks[s_BishopMagics[square].Index(occupied)]; }
+      static Bitboard RookAttacks(Square square, Bitboard occupied) { return s_RookMagics[square].Attacks[s_RookMagics[square].Index(occupied)]; }
+      static Bitboard QueenAttacks(Square square, Bitboard occupied) { return BishopAttacks(square, occupied) | RookAttacks(square, occupied); }
+      static Bitboard Attacks(PieceType type, Square square, Bitboard occupied);
+
+      // Squares strictly between two aligned squares, and the full line through them
+      static Bitboard Between(Square from, Square to) { return s_Between[from][to]; }
+      static Bitboard Line(Square from, Square to) { return s_Line[from][to]; }
+      static bool Aligned(Square a, Square b, Square c) { return s_Line[a][b] & SquareBB(c); }
+
+      static int32_t Distance(Square a, Square b) { return s_Distance[a][b]; }
+
+    private:
+      struct Magic
+      {
+        Bitboard Mask = 0ULL;
+        Bitboard Number = 0ULL;
+        Bitboard* Attacks = nullptr;
+        uint32_t Shift = 0;
+
+        uint32_t Index(Bitboard occupied) const { return static_cast<uint32_t>(((occupied & Mask) * Number) >> Shift); }
+      };
+
+      static void InitMagics(PieceType type, Bitboard* table, Magic* magics);
+
+    private:
+      Bitboards() = delete;
+      Bitboards(const Bitboards&) = delete;
+      Bitboards& operator=(const Bitboards&) = delete;
+      Bitboards(Bitboards&&) = delete;
+      Bitboards& operator=(Bitboards&&) = delete;
+
+    private:
+      static Bitboard s_PawnAttacks[ColorCount][64];
+      static Bitboard s_KnightAttacks[64];
+      static Bitboard s_KingAttacks[64];
+      static Bitboard s_Between[64][64];
+      static Bitboard s_Line[64][64];
+      static uint8_t s_Distance[64][64];
+
+      static Magic s_BishopMagics[64];
+      static Magic s_RookMagics[64];
+      static Bitboard s_BishopTable[0x1480];
+      static Bitboard s_RookTable[0x19000];
+    };
+  }
+}
\ No newline at end of file
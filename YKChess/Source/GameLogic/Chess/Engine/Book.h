@@ -0,0 +1,56 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "GameLogic/Chess/Engine/MappedFile.h"
+#include "GameLogic/Chess/Engine/Position.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    struct BookMove
+    {
+      Chess::Move Move;
+      uint16_t Weight = 0;
+      uint32_t Learn = 0;
+    };
+
+    // Polyglot opening book. The file is mapped, never read, and probed by binary search over its sorted 16 byte entries,
+    // so a book of any size opens at once and a lookup only touches the few pages on the search path
+    class Book
+    {
+    public:
+      static constexpr size_t RandomCount = 781;
+
+      // Returns nullptr when the file is missing or is not a book
+      static std::shared_ptr<Book> Open(const std::filesystem::path& path);
+
+      static uint64_t Key(const Position& position);
+      // Castling is written as the king taking its own rook
+      static uint16_t EncodeMove(Move move);
+
+      size_t GetEntryCount() const { return m_Count; }
+
+      // Legal moves only, best weighted first
+      std::vector<BookMove> GetMoves(const Position& position) const;
+
+      // Picks a move with a probability proportional to its weight from any uniformly random value.
+      // Returns Move::None() when the position is not in the book
+      Move PickMove(const Position& position, uint64_t random) const;
+
+    private:
+      Book() = default;
+      Book(const Book&) = delete;
+      Book& operator=(const Book&) = delete;
+      Book(Book&&) = delete;
+      Book& operator=(Book&&) = delete;
+
+    private:
+      std::shared_ptr<MappedFile> m_File;
+      size_t m_Count = 0;
+    };
+  }
+}
\ No newline at end of file
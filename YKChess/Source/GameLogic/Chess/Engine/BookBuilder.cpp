@@ -0,0 +1,493 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/Book.h"
+#include "GameLogic/Chess/Engine/BookBuilder.h"
+#include "GameLogic/Chess/Engine/MappedFile.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      constexpr size_t ShardCount = 64;
+      constexpr size_t FlushSize = 256;     // Moves a worker gathers for a shard before taking its lock
+      constexpr size_t ChunkSize = 4 << 20; // Bytes of PGN per work item
+      constexpr size_t BytesPerEntry = 64;  // Rough hash map cost of one counted move
+      constexpr size_t RunBufferSize = 4096;
+
+      constexpr std::string_view GameStart = "[Event ";
+
+      struct EntryKey
+      {
+        uint64_t Key = 0;
+        uint16_t Move = 0;
+
+        bool operator==(const EntryKey& other) const { return Key == other.Key && Move == other.Move; }
+        bool operator<(const EntryKey& other) const { return (Key != other.Key) ? Key < other.Key : Move < other.Move; }
+      };
+
+      struct EntryKeyHash
+      {
+        size_t operator()(const EntryKey& entry) const { return static_cast<size_t>(entry.Key ^ (entry.Move * 0x9E3779B97F4A7C15ULL)); }
+      };
+
+      struct EntryStats
+      {
+        uint32_t Count = 0;
+        uint32_t Score = 0;
+      };
+
+      // Also the layout of the spilled runs, which never leave the machine that wrote them
+      struct Record
+      {
+        EntryKey Entry;
+        EntryStats Stats;
+      };
+
+      struct alignas(64) Shard
+      {
+        std::mutex Mutex;
+        std::unordered_map<EntryKey, EntryStats, EntryKeyHash> Map;
+      };
+
+      struct Chunk
+      {
+        std::string_view Text;
+      };
+
+      void WriteBig(std::ofstream& file, uint64_t value, size_t bytes)
+      {
+        for (size_t i = bytes; i-- > 0;)
+          file.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+      }
+
+      std::vector<Record> SortedRecords(Shard& shard)
+      {
+        std::vector<Record> records;
+        records.reserve(shard.Map.size());
+        for (const auto& [entry, stats] : shard.Map)
+          records.push_back({ entry, stats });
+        std::sort(records.begin(), records.end(), [](const Record& first, const Record& second) { return first.Entry < second.Entry; });
+
+        shard.Map = {};
+        return records;
+      }
+
+      // A sorted source for the merge, either a spilled file read through a small buffer or a shard kept in memory
+      class RunReader
+      {
+      public:
+        explicit RunReader(std::vector<Record>&& records) : m_Buffer(std::move(records)) {}
+        explicit RunReader(const std::filesystem::path& path) : m_File(path, std::ios::binary) {}
+
+        bool Next(Record& record)
+        {
+          if (m_Index == m_Buffer.size())
+          {
+            if (!m_File.is_open())
+              return false;
+
+            m_Buffer.resize(RunBufferSize);
+            m_File.read(reinterpret_cast<char*>(m_Buffer.data()), RunBufferSize * sizeof(Record));
+            m_Buffer.resize(static_cast<size_t>(m_File.gcount()) / sizeof(Record));
+            m_Index = 0;
+            if (m_Buffer.empty())
+              return false;
+          }
+
+          record = m_Buffer[m_Index++];
+          return true;
+        }
+
+      private:
+        std::ifstream m_File;
+        std::vector<Record> m_Buffer;
+        size_t m_Index = 0;
+      };
+
+      class BuildContext
+      {
+      public:
+        BuildContext(const BookBuildOptions& options, const std::filesystem::path& temporary_directory)
+          : m_Options(options), m_TemporaryDirectory(temporary_directory), m_ShardLimit(std::max<size_t>(options.MemoryBudget / BytesPerEntry / ShardCount, FlushSize))
+        {
+        }
+
+        ~BuildContext()
+        {
+          for (const std::filesystem::path& run : m_Runs)
+          {
+            std::error_code error;
+            std::filesystem::remove(run, error);
+          }
+        }
+
+        void AddChunk(std::string_view text) { m_Chunks.push_back({ text }); }
+
+        void Run(int32_t threads)
+        {
+          std::vector<std::thread> workers;
+          for (int32_t i = 0; i < threads; i++)
+            workers.emplace_back([this]() { BuildContext::Work(); });
+          for (std::thread& worker : workers)
+            worker.join();
+        }
+
+        // Merges the spilled runs and what is still in memory, all sorted by key then move, into the book
+        bool Write(const std::filesystem::path& output, BookBuildReport& report)
+        {
+          std::vector<RunReader> readers;
+          for (const std::filesystem::path& run : m_Runs)
+            readers.emplace_back(run);
+          for (Shard& shard : m_Shards)
+            readers.emplace_back(SortedRecords(shard));
+
+          std::ofstream file(output, std::ios::binary | std::ios::trunc);
+          if (!file)
+          {
+            YK_ERROR("[ENGINE] Cannot write book file '{}'", output.string());
+            return false;
+          }
+
+          using Head = std::pair<Record, size_t>;
+          auto greater = [](const Head& first, const Head& second) { return second.first.Entry < first.first.Entry; };
+          std::priority_queue<Head, std::vector<Head>, decltype(greater)> heads(greater);
+          for (size_t i = 0; i < readers.size(); i++)
+          {
+            Record record;
+            if (readers[i].Next(record))
+              heads.push({ record, i });
+          }
+
+          // Moves of one position arrive together, their weights are scaled down together when one would overflow
+          std::vector<Record> position;
+          auto flush = [&]()
+            {
+            uint32_t best = 0;
+            for (const Record& record : position)
+              best = std::max(best, record.Stats.Score);
+
+            for (const Record& record : position)
+            {
+              const uint64_t weight = (best > 0xFFFF) ? static_cast<uint64_t>(record.Stats.Score) * 0xFFFF / best : record.Stats.Score;
+              if (weight == 0)
+                continue;
+
+              WriteBig(file, record.Entry.Key, 8);
+              WriteBig(file, record.Entry.Move, 2);
+              WriteBig(file, weight, 2);
+              WriteBig(file, 0, 4);
+              report.Entries++;
+            }
+            position.clear();
+            };
+
+          // Only frequent enough moves are kept, counts are final once the next key comes out of the merge
+          auto keep = [&](const Record& record)
+            {
+            if (record.Stats.Count < m_Options.MinCount)
+              return;
+            if (!position.empty() && position.back().Entry.Key != record.Entry.Key)
+              flush();
+            position.push_back(record);
+            };
+
+          Record current;
+          bool hasCurrent = false;
+          while (!heads.empty())
+          {
+            const auto [record, index] = heads.top();
+            heads.pop();
+
+            Record next;
+            if (readers[index].Next(next))
+              heads.push({ next, index });
+
+            if (hasCurrent && current.Entry == record.Entry)
+            {
+              current.Stats.Count += record.Stats.Count;
+              current.Stats.Score += record.Stats.Score;
+              continue;
+            }
+
+            if (hasCurrent)
+              keep(current);
+            current = record;
+            hasCurrent = true;
+          }
+
+          if (hasCurrent)
+            keep(current);
+          flush();
+
+          return static_cast<bool>(file);
+        }
+
+        std::atomic<uint64_t> Games = 0;
+        std::atomic<uint64_t> SkippedGames = 0;
+        std::atomic<uint64_t> Moves = 0;
+
+        size_t GetRunCount() const { return m_Runs.size(); }
+        bool HasFailed() const { return m_Failed; }
+
+      private:
+        void Work()
+        {
+          std::vector<Record> pending[ShardCount];
+          for (size_t index = m_NextChunk++; index < m_Chunks.size() && !m_Failed; index = m_NextChunk++)
+          {
+            std::string_view text = m_Chunks[index].Text;
+            while (!text.empty())
+            {
+              size_t end = text.find(GameStart, 1);
+              while (end != std::string_view::npos && text[end - 1] != '\n')
+                end = text.find(GameStart, end + 1);
+              if (end == std::string_view::npos)
+                end = text.size();
+
+              BuildContext::ParseGame(text.substr(0, end), pending);
+              text.remove_prefix(end);
+            }
+          }
+
+          for (size_t shard = 0; shard < ShardCount; shard++)
+            BuildContext::Flush(shard, pending[shard]);
+        }
+
+        void ParseGame(std::string_view text, std::vector<Record>* pending)
+        {
+          Position position = Position::StartPosition();
+          uint32_t whiteScore = 1;
+          bool hasResult = false;
+          size_t cursor = 0;
+
+          // Tag pairs, only the result and a starting position matter
+          while (cursor < text.size())
+          {
+            while (cursor < text.size() && std::isspace(static_cast<unsigned char>(text[cursor])))
+              cursor++;
+            if (cursor == text.size() || text[cursor] != '[')
+              break;
+
+            const size_t lineEnd = std::min(text.find('\n', cursor), text.size());
+            const std::string_view tag = text.substr(cursor, lineEnd - cursor);
+            cursor = lineEnd;
+
+            const size_t open = tag.find('"');
+            const size_t close = tag.rfind('"');
+            if (open == std::string_view::npos || close <= open)
+              continue;
+            const std::string_view value = tag.substr(open + 1, close - open - 1);
+
+            if (tag.starts_with("[Result "))
+            {
+              hasResult = value == "1-0" || value == "0-1" || value == "1/2-1/2";
+              whiteScore = (value == "1-0") ? 2 : (value == "0-1") ? 0 : 1;
+            }
+            else if (tag.starts_with("[FEN ") && !position.SetFEN(value))
+            {
+              SkippedGames++;
+              return;
+            }
+          }
+
+          // Unfinished games say nothing about the moves played
+          if (!hasResult)
+          {
+            SkippedGames++;
+            return;
+          }
+
+          int32_t depth = 0;
+          int32_t ply = 0;
+          while (cursor < text.size() && ply < m_Options.MaxPly)
+          {
+            const char c = text[cursor];
+            if (std::isspace(static_cast<unsigned char>(c)))
+            {
+              cursor++;
+              continue;
+            }
+
+            // Comments and variations are skipped whole, variations may nest
+            if (c == '{')
+            {
+              cursor = std::min(text.find('}', cursor), text.size());
+              cursor++;
+              continue;
+            }
+            if (c == ';')
+            {
+              cursor = std::min(text.find('\n', cursor), text.size());
+              continue;
+            }
+            if (c == '(' || c == ')')
+            {
+              depth += (c == '(') ? 1 : -1;
+              cursor++;
+              continue;
+            }
+
+            size_t end = cursor;
+            while (end < text.size() && !std::isspace(static_cast<unsigned char>(text[end])) && std::string_view("{();").find(text[end]) == std::string_view::npos)
+              end++;
+            std::string_view token = text.substr(cursor, end - cursor);
+            cursor = end;
+
+            if (depth > 0 || token.front() == '$')
+              continue;
+
+            // Move numbers may be glued to the move, "12.e4" or "12...e5"
+            while (!token.empty() && (std::isdigit(static_cast<unsigned char>(token.front())) || token.front() == '.'))
+            {
+              if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token.starts_with("0-0"))
+                break;
+              token.remove_prefix(1);
+            }
+            if (token.empty())
+              continue;
+            if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*")
+              break;
+
+            const Move move = position.ParseSANMove(token);
+            if (!move)
+              break;
+
+            const uint32_t score = (position.SideToMove() == White) ? whiteScore : 2 - whiteScore;
+            const Record record = { { Book::Key(position), Book::EncodeMove(move) }, { 1, score } };
+            const size_t shard = (record.Entry.Key >> 58) % ShardCount;
+            pending[shard].push_back(record);
+            if (pending[shard].size() >= FlushSize)
+              BuildContext::Flush(shard, pending[shard]);
+
+            Moves++;
+            position.MakeMove(move);
+            ply++;
+          }
+
+          Games++;
+        }
+
+        void Flush(size_t index, std::vector<Record>& pending)
+        {
+          Shard& shard = m_Shards[index];
+          std::lock_guard<std::mutex> lock(shard.Mutex);
+
+          for (const Record& record : pending)
+          {
+            EntryStats& stats = shard.Map[record.Entry];
+            stats.Count += record.Stats.Count;
+            stats.Score += record.Stats.Score;
+          }
+          pending.clear();
+
+          if (shard.Map.size() >= m_ShardLimit && !BuildContext::Spill(shard))
+            m_Failed = true;
+        }
+
+        // The caller holds the shard lock, other shards keep counting meanwhile. The records are lost when the run
+        // cannot be written, the build is then failed rather than finished with a book missing them
+        bool Spill(Shard& shard)
+        {
+          const std::vector<Record> records = SortedRecords(shard);
+
+          std::filesystem::path path;
+          {
+            std::lock_guard<std::mutex> lock(m_RunsMutex);
+            path = m_TemporaryDirectory / ("ykbook_run_" + std::to_string(m_Runs.size()) + ".tmp");
+            m_Runs.push_back(path);
+          }
+
+          std::ofstream file(path, std::ios::binary | std::ios::trunc);
+          file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+          file.close();
+          if (!file)
+          {
+            YK_ERROR("[ENGINE] Cannot write book run '{}'", path.string());
+            return false;
+          }
+          return true;
+        }
+
+      private:
+        const BookBuildOptions& m_Options;
+        std::filesystem::path m_TemporaryDirectory;
+        size_t m_ShardLimit;
+
+        std::vector<Chunk> m_Chunks;
+        std::atomic<size_t> m_NextChunk = 0;
+        Shard m_Shards[ShardCount];
+
+        std::mutex m_RunsMutex;
+        std::vector<std::filesystem::path> m_Runs;
+        std::atomic<bool> m_Failed = false;
+      };
+    }
+
+    BookBuildReport BookBuilder::Build(const std::vector<std::filesystem::path>& pgn_files, const std::filesystem::path& output, const BookBuildOptions& options)
+    {
+      BookBuildReport report;
+      const auto start = std::chrono::steady_clock::now();
+      const std::filesystem::path temporary = options.TemporaryDirectory.empty() ? output.parent_path() : options.TemporaryDirectory;
+      std::unique_ptr<BuildContext> context = std::make_unique<BuildContext>(options, temporary.empty() ? "." : temporary);
+
+      // Chunks end on a game boundary, so no game is ever split between two workers
+      std::vector<std::shared_ptr<MappedFile>> files;
+      for (const std::filesystem::path& path : pgn_files)
+      {
+        std::shared_ptr<MappedFile> file = MappedFile::Open(path);
+        if (!file)
+        {
+          YK_WARN("[ENGINE] Game collection '{}' not found", path.string());
+          continue;
+        }
+
+        const std::string_view text(reinterpret_cast<const char*>(file->GetData()), file->GetSize());
+        size_t begin = std::min(text.find(GameStart), text.size());
+        while (begin < text.size())
+        {
+          size_t end = text.find(GameStart, std::min(begin + ChunkSize, text.size()));
+          while (end != std::string_view::npos && text[end - 1] != '\n')
+            end = text.find(GameStart, end + 1);
+          if (end == std::string_view::npos)
+            end = text.size();
+
+          context->AddChunk(text.substr(begin, end - begin));
+          begin = end;
+        }
+        files.push_back(std::move(file));
+      }
+
+      // A failed spill leaves the previous book in place, a book missing some of the games would look complete
+      context->Run(std::max(options.Threads, 1));
+      const bool written = !context->HasFailed() && context->Write(output, report);
+
+      report.Games = context->Games;
+      report.SkippedGames = context->SkippedGames;
+      report.Moves = context->Moves;
+      report.Runs = context->GetRunCount();
+      report.Time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+      report.GamesPerSecond = report.Games * 1000.0 / std::max<int64_t>(report.Time, 1);
+      report.Written = written;
+
+      if (written)
+        YK_INFO("[ENGINE] Built book '{}' from {} games ({} skipped) in {}ms, {:.0f} games/s, {} entries, {} runs spilled", output.string(),
+          report.Games, report.SkippedGames, report.Time, report.GamesPerSecond, report.Entries, report.Runs);
+      return report;
+    }
+  }
+}
\ No newline at end of file
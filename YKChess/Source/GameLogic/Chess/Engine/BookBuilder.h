@@ -0,0 +1,48 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+namespace yk
+{
+  namespace Chess
+  {
+    struct BookBuildOptions
+    {
+      int32_t Threads = 1;
+      int32_t MaxPly = 24;   // Moves after this many plies of a game are not recorded
+      uint32_t MinCount = 3; // Moves played fewer times are pruned
+      size_t MemoryBudget = 512ULL << 20; // Above it counted moves are spilled to sorted runs on disk
+      std::filesystem::path TemporaryDirectory; // Next to the output when empty
+    };
+
+    struct BookBuildReport
+    {
+      uint64_t Games = 0;
+      uint64_t SkippedGames = 0; // Unfinished or with a starting position that cannot be read
+      uint64_t Moves = 0;        // Recorded moves, repeated ones included
+      uint64_t Entries = 0;      // Written to the book
+      size_t Runs = 0;           // Spilled to disk
+      int64_t Time = 0;          // Milliseconds
+      double GamesPerSecond = 0.0;
+      bool Written = false;      // False when a spilled run or the book could not be written
+    };
+
+    // Builds a Polyglot book from PGN collections. Files are mapped and cut at game boundaries into chunks parsed in
+    // parallel, every move counted in sharded hash maps and the book written by merging their sorted contents.
+    // Moves weigh two points per win and one per draw for the side playing them, moves that never scored are left out.
+    // A move that cannot be read ends its game, the moves before it still count
+    class BookBuilder
+    {
+    public:
+      static BookBuildReport Build(const std::vector<std::filesystem::path>& pgn_files, const std::filesystem::path& output, const BookBuildOptions& options);
+
+    private:
+      BookBuilder() = delete;
+      BookBuilder(const BookBuilder&) = delete;
+      BookBuilder& operator=(const BookBuilder&) = delete;
+      BookBuilder(BookBuilder&&) = delete;
+      BookBuilder& operator=(BookBuilder&&) = delete;
+    };
+  }
+}
\ No newline at end of file
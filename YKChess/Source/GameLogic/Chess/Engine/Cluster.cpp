@@ -0,0 +1,724 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/Bitboards.h"
+#include "GameLogic/Chess/Engine/Cluster.h"
+#include "GameLogic/Chess/Engine/MoveGen.h"
+#include "GameLogic/Chess/Engine/Zobrist.h"
+
+#if defined(PLATFORM_WINDOWS)
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#else
+  #include <signal.h>
+  #include <spawn.h>
+  #include <sys/wait.h>
+  #include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      constexpr int64_t ConnectTimeout = 10000; // Milliseconds, per worker
+      // Root bounds pass through the coordinator, a waiting worker is held up by every millisecond on the way
+      constexpr int64_t PollInterval = 1;
+      // Key, score, move, depth and bound, packed
+      constexpr size_t EntrySize = 14;
+
+      // Native byte order throughout, every process of a cluster runs the same build
+      class MessageWriter
+      {
+      public:
+        template<typename T>
+        void Write(const T& value)
+        {
+          const std::byte* bytes = reinterpret_cast<const std::byte*>(&value);
+          m_Bytes.insert(m_Bytes.end(), bytes, bytes + sizeof(T));
+        }
+
+        void WriteMoves(const std::vector<Move>& moves)
+        {
+          MessageWriter::Write(static_cast<uint16_t>(moves.size()));
+          for (const Move move : moves)
+            MessageWriter::Write(move.Data);
+        }
+
+        void WriteString(std::string_view text)
+        {
+          MessageWriter::Write(static_cast<uint16_t>(text.size()));
+          const std::byte* bytes = reinterpret_cast<const std::byte*>(text.data());
+          m_Bytes.insert(m_Bytes.end(), bytes, bytes + text.size());
+        }
+
+        const std::vector<std::byte>& GetBytes() const { return m_Bytes; }
+
+      private:
+        std::vector<std::byte> m_Bytes;
+      };
+
+      // Reads past the end give zeroes and mark the message as failed
+      class MessageReader
+      {
+      public:
+        explicit MessageReader(const std::vector<std::byte>& bytes) : m_Bytes(bytes) {}
+
+        template<typename T>
+        T Read()
+        {
+          T value = {};
+          if (m_Offset + sizeof(T) > m_Bytes.size())
+          {
+            m_Failed = true;
+            return value;
+          }
+          std::memcpy(&value, m_Bytes.data() + m_Offset, sizeof(T));
+          m_Offset += sizeof(T);
+          return value;
+        }
+
+        std::vector<Move> ReadMoves()
+        {
+          std::vector<Move> moves(MessageReader::Read<uint16_t>());
+          for (Move& move : moves)
+            move = Move(MessageReader::Read<uint16_t>());
+          return moves;
+        }
+
+        std::string ReadString()
+        {
+          const size_t size = MessageReader::Read<uint16_t>();
+          if (m_Offset + size > m_Bytes.size())
+          {
+            m_Failed = true;
+            return std::string();
+          }
+          std::string text(reinterpret_cast<const char*>(m_Bytes.data() + m_Offset), size);
+          m_Offset += size;
+          return text;
+        }
+
+        bool HasFailed() const { return m_Failed; }
+
+      private:
+        const std::vector<std::byte>& m_Bytes;
+        size_t m_Offset = 0;
+        bool m_Failed = false;
+      };
+
+      std::filesystem::path GetExecutablePath()
+      {
+#if defined(PLATFORM_WINDOWS)
+        wchar_t path[MAX_PATH] = {};
+        GetModuleFileNameW(nullptr, path, MAX_PATH);
+        return std::filesystem::path(path);
+#else
+        std::error_code error;
+        return std::filesystem::read_symlink("/proc/self/exe", error);
+#endif
+      }
+
+      intptr_t StartProcess(const std::filesystem::path& executable, const std::vector<std::string>& arguments)
+      {
+#if defined(PLATFORM_WINDOWS)
+        std::wstring commandLine = L"\"" + executable.wstring() + L"\"";
+        for (const std::string& argument : arguments)
+          commandLine += L" \"" + std::filesystem::path(argument).wstring() + L"\"";
+
+        STARTUPINFOW startup = {};
+        startup.cb = sizeof(startup);
+        PROCESS_INFORMATION process = {};
+        if (!CreateProcessW(executable.c_str(), commandLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &process))
+          return 0;
+        CloseHandle(process.hThread);
+        return reinterpret_cast<intptr_t>(process.hProcess);
+#else
+        const std::string path = executable.string();
+        std::vector<char*> argv = { const_cast<char*>(path.c_str()) };
+        for (const std::string& argument : arguments)
+          argv.push_back(const_cast<char*>(argument.c_str()));
+        argv.push_back(nullptr);
+
+        pid_t pid = 0;
+        if (posix_spawn(&pid, path.c_str(), nullptr, nullptr, argv.data(), environ) != 0)
+          return 0;
+        return static_cast<intptr_t>(pid);
+#endif
+      }
+
+      void EndProcess(intptr_t process, bool terminate)
+      {
+#if defined(PLATFORM_WINDOWS)
+        HANDLE handle = reinterpret_cast<HANDLE>(process);
+        if (terminate)
+          TerminateProcess(handle, 1);
+        WaitForSingleObject(handle, INFINITE);
+        CloseHandle(handle);
+#else
+        if (terminate)
+          kill(static_cast<pid_t>(process), SIGKILL);
+        waitpid(static_cast<pid_t>(process), nullptr, 0);
+#endif
+      }
+
+      std::string GetDefaultAddress()
+      {
+#if defined(PLATFORM_WINDOWS)
+        return "tcp:127.0.0.1:0";
+#else
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / ("ykchess-" + std::to_string(getpid()) + ".sock");
+        return "unix:" + path.string();
+#endif
+      }
+
+      MessageWriter WriteLine(int32_t depth, int32_t score, uint64_t nodes, const std::vector<Move>& pv, bool exact)
+      {
+        MessageWriter writer;
+        writer.Write(depth);
+        writer.Write(score);
+        writer.Write(nodes);
+        writer.WriteMoves(pv);
+        writer.Write(static_cast<uint8_t>(exact));
+        return writer;
+      }
+
+      MessageWriter WriteBound(int32_t depth, int32_t score)
+      {
+        MessageWriter writer;
+        writer.Write(depth);
+        writer.Write(score);
+        return writer;
+      }
+    }
+
+    Cluster::~Cluster()
+    {
+      for (Worker& worker : m_Workers)
+        if (worker.Socket)
+          worker.Socket->Send(ClusterMessage::Quit, {});
+
+      // A worker that never connected cannot be asked to quit
+      for (Worker& worker : m_Workers)
+        if (worker.Process)
+          EndProcess(worker.Process, !worker.Socket || !worker.Socket->IsOpen());
+    }
+
+    std::shared_ptr<Cluster> Cluster::Create(const ClusterSettings& settings)
+    {
+      std::shared_ptr<Cluster> cluster(new Cluster());
+      cluster->m_Settings = settings;
+      cluster->m_Settings.Workers = std::clamp(settings.Workers, 1, MaxWorkers);
+
+      cluster->m_Listener = ClusterSocket::Listen(settings.Address.empty() ? GetDefaultAddress() : settings.Address);
+      if (!cluster->m_Listener)
+        return nullptr;
+
+      const std::filesystem::path executable = settings.Executable.empty() ? GetExecutablePath() : settings.Executable;
+      const std::vector<std::string> arguments = { "worker", cluster->m_Listener->GetAddress(), std::to_string(settings.HashMB) };
+      cluster->m_Workers.resize(cluster->m_Settings.Workers);
+      for (Worker& worker : cluster->m_Workers)
+      {
+        worker.Process = StartProcess(executable, arguments);
+        if (!worker.Process)
+        {
+          YK_ERROR("[ENGINE] Cannot start the cluster worker '{}'", executable.string());
+          return nullptr;
+        }
+      }
+
+      // Workers are all the same, whichever connects first takes the first slot
+      for (Worker& worker : cluster->m_Workers)
+      {
+        worker.Socket = cluster->m_Listener->Accept(ConnectTimeout);
+        if (!worker.Socket)
+        {
+          YK_ERROR("[ENGINE] A cluster worker did not connect to '{}'", cluster->m_Listener->GetAddress());
+          return nullptr;
+        }
+      }
+
+      YK_INFO("[ENGINE] Cluster of {} workers on '{}'", cluster->m_Workers.size(), cluster->m_Listener->GetAddress());
+      return cluster;
+    }
+
+    SearchResult Cluster::Search(const Position& position, const SearchLimits& limits)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      m_Stop = false;
+
+      MoveList legal;
+      MoveGen::GenerateLegal(position, legal);
+      std::vector<Move> moves;
+      for (const ScoredMove& move : legal)
+        if (limits.SearchMoves.empty() || std::find(limits.SearchMoves.begin(), limits.SearchMoves.end(), move) != limits.SearchMoves.end())
+          moves.push_back(move);
+      if (moves.empty())
+        moves.assign(legal.begin(), legal.end());
+
+      m_RootBounds.fill(-ScoreInfinite);
+
+      SearchResult result;
+      if (moves.empty())
+      {
+        result.Score = position.InCheck() ? MatedIn(0) : 0;
+        return result;
+      }
+
+      // The workers replay the game from its first position, so they see its repetitions
+      Position first = position;
+      while (first.StateIndex() > 0)
+        first.UnmakeMove();
+      std::vector<Move> game;
+      for (int32_t i = 1; i <= position.StateIndex(); i++)
+        game.push_back(position.StateAt(i).LastMove);
+
+      // Dealt out in turn, so every worker gets some of the moves generated early, captures and promotions first
+      const size_t active = std::min(m_Workers.size(), moves.size());
+      for (size_t i = 0; i < m_Workers.size(); i++)
+      {
+        Worker& worker = m_Workers[i];
+        worker.Active = i < active && worker.Socket->IsOpen();
+        worker.Done = !worker.Active;
+        worker.CompletedDepth = 0;
+        worker.WaitingDepth = 0;
+        worker.Nodes = 0;
+        worker.Iterations.clear();
+        worker.Outgoing.clear();
+        worker.OutgoingCount = 0;
+        if (!worker.Active)
+          continue;
+
+        std::vector<Move> share;
+        for (size_t j = i; j < moves.size(); j += active)
+          share.push_back(moves[j]);
+
+        MessageWriter writer;
+        writer.WriteString(first.GetFEN());
+        writer.WriteMoves(game);
+        writer.Write(limits.Depth);
+        writer.Write(limits.Nodes);
+        writer.Write(limits.MoveTime);
+        writer.Write(limits.Time);
+        writer.Write(limits.Increment);
+        writer.Write(limits.MovesToGo);
+        writer.WriteMoves(share);
+        writer.Write(m_Settings.ShareDepth);
+        worker.Done = !worker.Socket->Send(ClusterMessage::Search, writer.GetBytes());
+      }
+
+      std::vector<ClusterSocket*> sockets;
+      for (const Worker& worker : m_Workers)
+        sockets.push_back(worker.Socket.get());
+
+      auto nextBroadcast = start + std::chrono::milliseconds(m_Settings.BroadcastInterval);
+      bool stopSent = false;
+      while (std::any_of(m_Workers.begin(), m_Workers.end(), [](const Worker& worker) { return !worker.Done; }))
+      {
+        ClusterSocket::Wait(sockets, std::min(PollInterval, m_Settings.BroadcastInterval));
+
+        ClusterMessage type;
+        std::vector<std::byte> payload;
+        for (size_t i = 0; i < m_Workers.size(); i++)
+        {
+          Worker& worker = m_Workers[i];
+          if (worker.Done)
+            continue;
+
+          const bool open = worker.Socket->Receive();
+          while (worker.Socket->Next(type, payload))
+            Cluster::HandleMessage(i, type, payload);
+          if (!open && !worker.Done)
+          {
+            YK_WARN("[ENGINE] Cluster worker {} went away", i);
+            worker.Done = true;
+          }
+        }
+
+        if (m_Stop && !stopSent)
+        {
+          for (Worker& worker : m_Workers)
+            if (!worker.Done)
+              worker.Socket->Send(ClusterMessage::Stop, {});
+          stopSent = true;
+        }
+        else if (!stopSent)
+          Cluster::ReleaseWaiting();
+
+        if (std::chrono::steady_clock::now() >= nextBroadcast)
+        {
+          Cluster::Broadcast();
+          nextBroadcast += std::chrono::milliseconds(m_Settings.BroadcastInterval);
+        }
+      }
+
+      // Scores of different moves are only comparable at the same depth, the deepest every worker reached.
+      // A worker that lost to a bound there has no line worth playing, the one who set the bound has
+      int32_t commonDepth = MaxPly;
+      for (const Worker& worker : m_Workers)
+      {
+        result.Nodes += worker.Nodes;
+        if (worker.Active && worker.CompletedDepth > 0)
+          commonDepth = std::min(commonDepth, worker.CompletedDepth);
+      }
+
+      const Iteration* best = nullptr;
+      for (int32_t depth = commonDepth; depth > 0 && !best; depth--)
+      {
+        for (const bool exactOnly : { true, false })
+        {
+          for (const Worker& worker : m_Workers)
+          {
+            const auto iteration = worker.Iterations.find(depth);
+            if (iteration == worker.Iterations.end() || (exactOnly && !iteration->second.Exact))
+              continue;
+            if (!best || iteration->second.Score > best->Score)
+            {
+              best = &iteration->second;
+              result.Depth = depth;
+            }
+          }
+          if (best)
+            break;
+        }
+      }
+
+      if (best)
+      {
+        result.BestMove = best->PV[0];
+        result.Score = best->Score;
+        result.PV = best->PV;
+        if (result.PV.size() > 1)
+          result.PonderMove = result.PV[1];
+      }
+      else
+        result.BestMove = moves[0];
+
+      result.Time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+      return result;
+    }
+
+    ClusterStats Cluster::GetStats() const
+    {
+      ClusterStats stats;
+      stats.EntriesShared = m_EntriesShared;
+      stats.BoundsShared = m_BoundsShared;
+      stats.Releases = m_Releases;
+      for (const Worker& worker : m_Workers)
+      {
+        if (!worker.Socket)
+          continue;
+        stats.BytesSent += worker.Socket->GetBytesSent();
+        stats.BytesReceived += worker.Socket->GetBytesReceived();
+      }
+      return stats;
+    }
+
+    void Cluster::HandleMessage(size_t index, ClusterMessage type, const std::vector<std::byte>& payload)
+    {
+      Worker& worker = m_Workers[index];
+      MessageReader reader(payload);
+
+      switch (type)
+      {
+        case ClusterMessage::Iteration:
+        case ClusterMessage::Done:
+        {
+          const int32_t depth = reader.Read<int32_t>();
+          Iteration iteration;
+          iteration.Score = reader.Read<int32_t>();
+          iteration.Nodes = reader.Read<uint64_t>();
+          iteration.PV = reader.ReadMoves();
+          iteration.Exact = reader.Read<uint8_t>();
+          if (reader.HasFailed())
+            break;
+
+          worker.Nodes = iteration.Nodes;
+          if (type == ClusterMessage::Done)
+          {
+            worker.Done = true;
+            worker.CompletedDepth = depth;
+          }
+          // The final result repeats the last iteration, which may have been streamed already
+          if (depth > 0 && !iteration.PV.empty() && (type == ClusterMessage::Iteration || !worker.Iterations.contains(depth)))
+            worker.Iterations[depth] = std::move(iteration);
+          break;
+        }
+        case ClusterMessage::RootBound:
+        {
+          const int32_t depth = reader.Read<int32_t>();
+          const int32_t score = reader.Read<int32_t>();
+          if (reader.HasFailed() || depth < 1 || depth >= MaxPly || score <= m_RootBounds[depth])
+            break;
+
+          // Sent on at once, a worker may be waiting for exactly this
+          m_RootBounds[depth] = score;
+          m_BoundsShared++;
+          for (size_t i = 0; i < m_Workers.size(); i++)
+          {
+            Worker& other = m_Workers[i];
+            if (i == index || other.Done)
+              continue;
+            other.Socket->Send(ClusterMessage::RootBound, payload);
+            if (other.WaitingDepth == depth)
+              other.WaitingDepth = 0;
+          }
+          break;
+        }
+        case ClusterMessage::Waiting:
+        {
+          // A bound sent meanwhile is already on its way
+          const int32_t depth = reader.Read<int32_t>();
+          if (!reader.HasFailed() && depth > 0 && depth < MaxPly && m_RootBounds[depth] == -ScoreInfinite)
+            worker.WaitingDepth = depth;
+          break;
+        }
+        case ClusterMessage::Entries:
+        {
+          // Passed on as they are, the count goes in front of every batch again
+          const uint32_t count = reader.Read<uint32_t>();
+          if (reader.HasFailed() || payload.size() != sizeof(uint32_t) + count * EntrySize)
+            break;
+
+          m_EntriesShared += count;
+          for (size_t i = 0; i < m_Workers.size(); i++)
+          {
+            Worker& other = m_Workers[i];
+            if (i == index || other.Done)
+              continue;
+            other.Outgoing.insert(other.Outgoing.end(), payload.begin() + sizeof(uint32_t), payload.end());
+            other.OutgoingCount += count;
+          }
+          break;
+        }
+        default:
+          YK_WARN("[ENGINE] Unexpected cluster message {} from worker {}", static_cast<int32_t>(type), index);
+          break;
+      }
+    }
+
+    void Cluster::Broadcast()
+    {
+      for (Worker& worker : m_Workers)
+      {
+        if (worker.Done || !worker.OutgoingCount)
+          continue;
+
+        MessageWriter writer;
+        writer.Write(worker.OutgoingCount);
+        std::vector<std::byte> payload = writer.GetBytes();
+        payload.insert(payload.end(), worker.Outgoing.begin(), worker.Outgoing.end());
+        worker.Socket->Send(ClusterMessage::Entries, payload);
+        worker.Outgoing.clear();
+        worker.OutgoingCount = 0;
+      }
+    }
+
+    void Cluster::ReleaseWaiting()
+    {
+      // Deepest first, then an exact score over one that lost to a bound, then the higher score
+      auto rank = [](const Worker& worker)
+        {
+        if (worker.Iterations.empty())
+          return std::make_tuple(0, false, -ScoreInfinite);
+        const auto& [depth, iteration] = *worker.Iterations.rbegin();
+        return std::make_tuple(depth, iteration.Exact, iteration.Score);
+        };
+
+      Worker* chosen = nullptr;
+      for (Worker& worker : m_Workers)
+      {
+        if (worker.Done)
+          continue;
+        if (!worker.WaitingDepth)
+          return;
+        if (!chosen || rank(worker) > rank(*chosen))
+          chosen = &worker;
+      }
+      if (!chosen)
+        return;
+
+      MessageWriter writer;
+      writer.Write(chosen->WaitingDepth);
+      chosen->Socket->Send(ClusterMessage::Release, writer.GetBytes());
+      chosen->WaitingDepth = 0;
+      m_Releases++;
+    }
+
+    int32_t Cluster::RunWorker(const std::string& address, size_t hash_mb)
+    {
+      Bitboards::Init();
+      Zobrist::Init();
+
+      std::shared_ptr<ClusterSocket> socket = ClusterSocket::Connect(address);
+      if (!socket)
+        return 1;
+
+      std::shared_ptr<Chess::Search> search = Search::Create(TranspositionTable::Create(hash_mb), 1);
+      bool searching = false;
+      std::vector<SharedEntry> shared;
+      std::vector<RootBound> bounds;
+      int32_t waiting = 0;
+      bool lastExact = false;
+
+      // Every completed depth goes to the coordinator as soon as it is seen
+      auto sendIterations = [&]()
+        {
+        AnalysisUpdate update;
+        while (search->PollAnalysis(update))
+        {
+          if (update.Lines.empty())
+            continue;
+          lastExact = update.Lines[0].Bound == Bound::Exact;
+          socket->Send(ClusterMessage::Iteration, WriteLine(update.Depth, update.Lines[0].Score, update.Nodes, update.Lines[0].PV, lastExact).GetBytes());
+        }
+        };
+
+      ClusterMessage type;
+      std::vector<std::byte> payload;
+      while (true)
+      {
+        ClusterSocket::Wait({ socket.get() }, PollInterval);
+        const bool open = socket->Receive();
+
+        while (socket->Next(type, payload))
+        {
+          MessageReader reader(payload);
+          if (type == ClusterMessage::Search)
+          {
+            Position position;
+            const bool valid = position.SetFEN(reader.ReadString());
+            for (const Move move : reader.ReadMoves())
+              position.MakeMove(move);
+
+            SearchLimits limits;
+            limits.Depth = reader.Read<int32_t>();
+            limits.Nodes = reader.Read<uint64_t>();
+            limits.MoveTime = reader.Read<int64_t>();
+            for (int64_t& time : limits.Time)
+              time = reader.Read<int64_t>();
+            for (int64_t& increment : limits.Increment)
+              increment = reader.Read<int64_t>();
+            limits.MovesToGo = reader.Read<int32_t>();
+            limits.SearchMoves = reader.ReadMoves();
+
+            SearchOptions options = search->GetOptions();
+            options.ShareDepth = reader.Read<int32_t>();
+            options.RootBounds = true;
+            if (!valid || reader.HasFailed())
+            {
+              YK_ERROR("[ENGINE] Malformed search from the cluster coordinator");
+              socket->Send(ClusterMessage::Done, WriteLine(0, 0, 0, {}, false).GetBytes());
+              continue;
+            }
+
+            search->SetOptions(options);
+            search->Start(position, limits);
+            searching = true;
+            waiting = 0;
+            lastExact = false;
+          }
+          else if (type == ClusterMessage::Stop)
+            search->Stop();
+          else if (type == ClusterMessage::Release)
+          {
+            const int32_t depth = reader.Read<int32_t>();
+            if (!reader.HasFailed())
+              search->OpenRootGate(depth);
+          }
+          else if (type == ClusterMessage::RootBound)
+          {
+            RootBound bound;
+            bound.Depth = reader.Read<int32_t>();
+            bound.Score = reader.Read<int32_t>();
+            if (!reader.HasFailed())
+              search->SetRootBound(bound);
+          }
+          else if (type == ClusterMessage::Entries)
+          {
+            std::vector<SharedEntry> entries(reader.Read<uint32_t>());
+            for (SharedEntry& entry : entries)
+            {
+              entry.Key = reader.Read<uint64_t>();
+              entry.Score = reader.Read<int16_t>();
+              entry.Move = reader.Read<uint16_t>();
+              entry.Depth = reader.Read<uint8_t>();
+              entry.Bound = static_cast<Bound>(reader.Read<uint8_t>());
+            }
+            if (!reader.HasFailed())
+              search->ImportEntries(entries);
+          }
+          else if (type == ClusterMessage::Quit)
+          {
+            search->Stop();
+            search->Wait();
+            return 0;
+          }
+        }
+
+        if (!open)
+        {
+          // The coordinator is gone, nobody is left to report to
+          search->Stop();
+          search->Wait();
+          return 0;
+        }
+
+        if (!searching)
+          continue;
+
+        // Bounds first, another worker may be waiting for one
+        bounds.clear();
+        search->TakeRootBounds(bounds);
+        for (const RootBound& bound : bounds)
+          socket->Send(ClusterMessage::RootBound, WriteBound(bound.Depth, bound.Score).GetBytes());
+
+        if (search->GetRootGateWait() != waiting)
+        {
+          waiting = search->GetRootGateWait();
+          if (waiting)
+          {
+            MessageWriter writer;
+            writer.Write(waiting);
+            socket->Send(ClusterMessage::Waiting, writer.GetBytes());
+          }
+        }
+
+        sendIterations();
+        shared.clear();
+        search->TakeSharedEntries(shared);
+        if (!shared.empty())
+        {
+          MessageWriter writer;
+          writer.Write(static_cast<uint32_t>(shared.size()));
+          for (const SharedEntry& entry : shared)
+          {
+            writer.Write(entry.Key);
+            writer.Write(entry.Score);
+            writer.Write(entry.Move);
+            writer.Write(entry.Depth);
+            writer.Write(static_cast<uint8_t>(entry.Bound));
+          }
+          socket->Send(ClusterMessage::Entries, writer.GetBytes());
+        }
+
+        if (!search->IsSearching())
+        {
+          search->Wait();
+          sendIterations();
+          const SearchResult result = search->GetResult();
+          socket->Send(ClusterMessage::Done, WriteLine(result.Depth, result.Score, result.Nodes, result.PV, lastExact).GetBytes());
+          searching = false;
+        }
+      }
+    }
+  }
+}
\ No newline at end of file
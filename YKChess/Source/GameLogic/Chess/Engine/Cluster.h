@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GameLogic/Chess/Engine/ClusterSocket.h"
+#include "GameLogic/Chess/Engine/Search.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    struct ClusterSettings
+    {
+      int32_t Workers = 2;
+      // Where the workers connect to, a Unix domain socket in the temporary directory when empty, loopback TCP on Windows
+      std::string Address;
+      // Started once per worker as "<executable> worker <address> <hash MB>", this executable when empty
+      std::filesystem::path Executable;
+      size_t HashMB = 16; // Per worker
+      int32_t ShareDepth = 6;
+      int64_t BroadcastInterval = 10; // Milliseconds
+    };
+
+    struct ClusterStats
+    {
+      uint64_t EntriesShared = 0; // Received from the workers, each sent on to all the others
+      uint64_t BoundsShared = 0;  // Root bounds that raised the best known one, each sent on to all the others
+      uint64_t Releases = 0;      // Depths started without a bound because every worker was waiting for one
+      uint64_t BytesSent = 0;
+      uint64_t BytesReceived = 0;
+    };
+
+    // Searches on worker processes, on this host or any other reaching the address. The coordinator deals the root
+    // moves out to the workers, each searching its share to the same limits with a table of its own, relays the deep
+    // entries every worker stores to all the others in batches, and picks the best move of the deepest iteration all
+    // of them completed. The coordinator itself only relays.
+    // Every root score a worker finds is a lower bound on the best move at that depth, relayed at once to the others
+    // who search their share against it, so only the worker holding the best move searches a full window. A worker
+    // whose last depth lost to a bound waits for one before starting the next, while the worker that set it runs
+    // ahead and sends one as soon as its first move is searched. Should every worker end up waiting, the one with
+    // the best last score is let go
+    class Cluster
+    {
+    public:
+      static constexpr int32_t MaxWorkers = 64;
+
+      ~Cluster();
+
+      // Starts the workers and waits for all of them to connect, returns nullptr when one does not
+      static std::shared_ptr<Cluster> Create(const ClusterSettings& settings);
+
+      // Blocks until every worker is done
+      SearchResult Search(const Position& position, const SearchLimits& limits);
+      // From another thread, the search returns with what the workers completed so far
+      void Stop() { m_Stop = true; }
+
+      ClusterStats GetStats() const;
+      int32_t GetWorkerCount() const { return static_cast<int32_t>(m_Workers.size()); }
+
+      // The worker side, run by the started processes until the coordinator quits or goes away. Returns the exit code
+      static int32_t RunWorker(const std::string& address, size_t hash_mb);
+
+    private:
+      struct Iteration
+      {
+        int32_t Score = 0;
+        uint64_t Nodes = 0;
+        std::vector<Move> PV;
+        bool Exact = true; // False when all the moves of the worker lost to a bound
+      };
+
+      struct Worker
+      {
+        std::shared_ptr<ClusterSocket> Socket;
+        intptr_t Process = 0;
+
+        // Of the current search
+        bool Active = false;
+        bool Done = false;
+        int32_t CompletedDepth = 0;
+        int32_t WaitingDepth = 0; // For a bound, 0 while searching
+        uint64_t Nodes = 0;
+        std::map<int32_t, Iteration> Iterations; // By depth
+        std::vector<std::byte> Outgoing;         // Entries of the other workers, waiting for the next broadcast
+        uint32_t OutgoingCount = 0;
+      };
+
+      void HandleMessage(size_t index, ClusterMessage type, const std::vector<std::byte>& payload);
+      void Broadcast();
+      // Lets the best placed worker go when nobody is left searching to find a bound
+      void ReleaseWaiting();
+
+    private:
+      Cluster() = default;
+      Cluster(const Cluster&) = delete;
+      Cluster& operator=(const Cluster&) = delete;
+      Cluster(Cluster&&) = delete;
+      Cluster& operator=(Cluster&&) = delete;
+
+    private:
+      ClusterSettings m_Settings;
+      std::shared_ptr<ClusterSocket> m_Listener;
+      std::vector<Worker> m_Workers;
+      std::atomic<bool> m_Stop = false;
+      std::array<int32_t, MaxPly> m_RootBounds; // Best known by depth, for the current search
+      uint64_t m_EntriesShared = 0;
+      uint64_t m_BoundsShared = 0;
+      uint64_t m_Releases = 0;
+    };
+  }
+}
\ No newline at end of file
@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/ClusterSocket.h"
+
+#if defined(PLATFORM_WINDOWS)
+  #define WIN32_LEAN_AND_MEAN
+  #include <winsock2.h>
+  #include <ws2tcpip.h>
+  #pragma comment(lib, "Ws2_32.lib")
+#else
+  #include <arpa/inet.h>
+  #include <fcntl.h>
+  #include <netinet/in.h>
+  #include <netinet/tcp.h>
+  #include <poll.h>
+  #include <sys/socket.h>
+  #include <sys/un.h>
+  #include <unistd.h>
+#endif
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+#if defined(PLATFORM_WINDOWS)
+      using NativeHandle = SOCKET;
+      using PollEntry = WSAPOLLFD;
+
+      int PollSockets(PollEntry* entries, size_t count, int timeout) { return WSAPoll(entries, static_cast<ULONG>(count), timeout); }
+      void CloseNative(NativeHandle handle) { closesocket(handle); }
+      bool WouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+      void SetNonBlocking(NativeHandle handle)
+      {
+        u_long enabled = 1;
+        ioctlsocket(handle, FIONBIO, &enabled);
+      }
+#else
+      using NativeHandle = int;
+      using PollEntry = pollfd;
+
+      int PollSockets(PollEntry* entries, size_t count, int timeout) { return poll(entries, static_cast<nfds_t>(count), timeout); }
+      void CloseNative(NativeHandle handle) { close(handle); }
+      bool WouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+      void SetNonBlocking(NativeHandle handle) { fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK); }
+#endif
+
+      // A worker gone away must show up as a failed send, not as a signal ending the coordinator
+#if defined(MSG_NOSIGNAL)
+      constexpr int SendFlags = MSG_NOSIGNAL;
+#else
+      constexpr int SendFlags = 0;
+#endif
+
+      constexpr size_t ReceiveChunk = 64 * 1024;
+      constexpr uint32_t MaxMessageLength = 64 << 20;
+
+      NativeHandle ToNative(intptr_t handle) { return static_cast<NativeHandle>(handle); }
+
+      // Messages are small and answered at once, waiting to fill a packet only adds latency
+      void SetNoDelay(NativeHandle handle)
+      {
+        int enabled = 1;
+        setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&enabled), sizeof(enabled));
+      }
+
+      struct Endpoint
+      {
+        bool Unix = false;
+        std::string Path;
+        sockaddr_in Inet = {};
+      };
+
+      bool ParseAddress(const std::string& address, Endpoint& endpoint)
+      {
+        if (address.starts_with("unix:"))
+        {
+#if defined(PLATFORM_WINDOWS)
+          YK_ERROR("[ENGINE] Unix domain sockets are not supported here, use a tcp: address instead of '{}'", address);
+          return false;
+#else
+          endpoint.Unix = true;
+          endpoint.Path = address.substr(5);
+          return !endpoint.Path.empty() && endpoint.Path.size() < sizeof(sockaddr_un::sun_path);
+#endif
+        }
+
+        if (!address.starts_with("tcp:"))
+          return false;
+        const size_t colon = address.rfind(':');
+        const std::string host = (colon > 4) ? address.substr(4, colon - 4) : "127.0.0.1";
+        endpoint.Inet.sin_family = AF_INET;
+        endpoint.Inet.sin_port = htons(static_cast<uint16_t>(std::atoi(address.c_str() + colon + 1)));
+        return inet_pton(AF_INET, host.c_str(), &endpoint.Inet.sin_addr) == 1;
+      }
+    }
+
+    ClusterSocket::~ClusterSocket()
+    {
+      ClusterSocket::Close();
+    }
+
+    bool ClusterSocket::Startup()
+    {
+#if defined(PLATFORM_WINDOWS)
+      static const bool s_Started = []()
+        {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+      return s_Started;
+#else
+      return true;
+#endif
+    }
+
+    std::shared_ptr<ClusterSocket> ClusterSocket::Listen(const std::string& address)
+    {
+      Endpoint endpoint;
+      if (!ClusterSocket::Startup() || !ParseAddress(address, endpoint))
+      {
+        YK_ERROR("[ENGINE] Invalid cluster address '{}'", address);
+        return nullptr;
+      }
+
+      std::shared_ptr<ClusterSocket> socket(new ClusterSocket());
+      socket->m_Listening = true;
+#if !defined(PLATFORM_WINDOWS)
+      if (endpoint.Unix)
+      {
+        const NativeHandle handle = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        socket->m_Handle = handle;
+        sockaddr_un local = {};
+        local.sun_family = AF_UNIX;
+        std::strncpy(local.sun_path, endpoint.Path.c_str(), sizeof(local.sun_path) - 1);
+        // A socket file left behind by a crashed coordinator would fail the bind
+        unlink(endpoint.Path.c_str());
+        if (handle < 0 || bind(handle, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0 || listen(handle, SOMAXCONN) != 0)
+        {
+          YK_ERROR("[ENGINE] Cannot listen on '{}'", address);
+          return nullptr;
+        }
+        socket->m_Address = address;
+        return socket;
+      }
+#endif
+
+      const NativeHandle handle = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+      socket->m_Handle = static_cast<intptr_t>(handle);
+      int reuse = 1;
+      setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+      sockaddr_in bound = {};
+      socklen_t length = sizeof(bound);
+      if (!socket->IsOpen() || bind(handle, reinterpret_cast<const sockaddr*>(&endpoint.Inet), sizeof(endpoint.Inet)) != 0 ||
+        listen(handle, SOMAXCONN) != 0 || getsockname(handle, reinterpret_cast<sockaddr*>(&bound), &length) != 0)
+      {
+        YK_ERROR("[ENGINE] Cannot listen on '{}'", address);
+        return nullptr;
+      }
+
+      char host[INET_ADDRSTRLEN] = {};
+      inet_ntop(AF_INET, &bound.sin_addr, host, sizeof(host));
+      socket->m_Address = std::string("tcp:") + host + ":" + std::to_string(ntohs(bound.sin_port));
+      return socket;
+    }
+
+    std::shared_ptr<ClusterSocket> ClusterSocket::Connect(const std::string& address)
+    {
+      Endpoint endpoint;
+      if (!ClusterSocket::Startup() || !ParseAddress(address, endpoint))
+      {
+        YK_ERROR("[ENGINE] Invalid cluster address '{}'", address);
+        return nullptr;
+      }
+
+      std::shared_ptr<ClusterSocket> socket(new ClusterSocket());
+      socket->m_Address = address;
+#if !defined(PLATFORM_WINDOWS)
+      if (endpoint.Unix)
+      {
+        const NativeHandle handle = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        socket->m_Handle = handle;
+        sockaddr_un remote = {};
+        remote.sun_family = AF_UNIX;
+        std::strncpy(remote.sun_path, endpoint.Path.c_str(), sizeof(remote.sun_path) - 1);
+        if (handle < 0 || connect(handle, reinterpret_cast<const sockaddr*>(&remote), sizeof(remote)) != 0)
+        {
+          YK_ERROR("[ENGINE] Cannot connect to '{}'", address);
+          return nullptr;
+        }
+        SetNonBlocking(handle);
+        return socket;
+      }
+#endif
+
+      const NativeHandle handle = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+      socket->m_Handle = static_cast<intptr_t>(handle);
+      if (!socket->IsOpen() || connect(handle, reinterpret_cast<const sockaddr*>(&endpoint.Inet), sizeof(endpoint.Inet)) != 0)
+      {
+        YK_ERROR("[ENGINE] Cannot connect to '{}'", address);
+        return nullptr;
+      }
+      SetNoDelay(handle);
+      SetNonBlocking(handle);
+      return socket;
+    }
+
+    std::shared_ptr<ClusterSocket> ClusterSocket::Accept(int64_t timeout)
+    {
+      PollEntry entry = {};
+      entry.fd = ToNative(m_Handle);
+      entry.events = POLLIN;
+      if (PollSockets(&entry, 1, static_cast<int>(timeout)) <= 0)
+        return nullptr;
+
+      const NativeHandle handle = accept(ToNative(m_Handle), nullptr, nullptr);
+      std::shared_ptr<ClusterSocket> socket(new ClusterSocket());
+      socket->m_Handle = static_cast<intptr_t>(handle);
+      socket->m_Address = m_Address;
+      if (!socket->IsOpen())
+        return nullptr;
+
+      if (!m_Address.starts_with("unix:"))
+        SetNoDelay(handle);
+      SetNonBlocking(handle);
+      return socket;
+    }
+
+    bool ClusterSocket::Send(ClusterMessage type, const std::vector<std::byte>& payload)
+    {
+      MessageHeader header;
+      header.Length = static_cast<uint32_t>(payload.size());
+      header.Type = type;
+      return ClusterSocket::SendBytes(reinterpret_cast<const std::byte*>(&header), sizeof(header)) &&
+        ClusterSocket::SendBytes(payload.data(), payload.size());
+    }
+
+    bool ClusterSocket::SendBytes(const std::byte* data, size_t size)
+    {
+      while (size && IsOpen())
+      {
+        const auto sent = send(ToNative(m_Handle), reinterpret_cast<const char*>(data), static_cast<int>(std::min<size_t>(size, 1 << 30)), SendFlags);
+        if (sent > 0)
+        {
+          data += sent;
+          size -= static_cast<size_t>(sent);
+          m_BytesSent += static_cast<uint64_t>(sent);
+          continue;
+        }
+        if (sent < 0 && !WouldBlock())
+        {
+          ClusterSocket::Close();
+          return false;
+        }
+
+        // The other side may be stuck sending to us in turn, reading here keeps both moving
+        PollEntry entry = {};
+        entry.fd = ToNative(m_Handle);
+        entry.events = POLLIN | POLLOUT;
+        PollSockets(&entry, 1, 100);
+        if ((entry.revents & POLLIN) && !ClusterSocket::Receive())
+          return false;
+      }
+      return IsOpen();
+    }
+
+    bool ClusterSocket::Receive()
+    {
+      while (IsOpen())
+      {
+        const size_t used = m_Buffer.size();
+        m_Buffer.resize(used + ReceiveChunk);
+        const auto received = recv(ToNative(m_Handle), reinterpret_cast<char*>(m_Buffer.data() + used), static_cast<int>(ReceiveChunk), 0);
+        m_Buffer.resize(used + static_cast<size_t>(std::max<decltype(received)>(received, 0)));
+
+        if (received > 0)
+        {
+          m_BytesReceived += static_cast<uint64_t>(received);
+          continue;
+        }
+        if (received < 0 && WouldBlock())
+          return true;
+        ClusterSocket::Close();
+      }
+      return false;
+    }
+
+    bool ClusterSocket::Next(ClusterMessage& type, std::vector<std::byte>& payload)
+    {
+      MessageHeader header;
+      if (m_Buffer.size() - m_BufferStart < sizeof(header))
+        return false;
+      std::memcpy(&header, m_Buffer.data() + m_BufferStart, sizeof(header));
+      if (header.Length > MaxMessageLength)
+      {
+        YK_ERROR("[ENGINE] Cluster message of {} bytes from '{}', closing the connection", header.Length, m_Address);
+        ClusterSocket::Close();
+        return false;
+      }
+      if (m_Buffer.size() - m_BufferStart < sizeof(header) + header.Length)
+        return false;
+
+      type = header.Type;
+      const std::byte* data = m_Buffer.data() + m_BufferStart + sizeof(header);
+      payload.assign(data, data + header.Length);
+      m_BufferStart += sizeof(header) + header.Length;
+
+      // Consumed bytes are dropped once they are most of the buffer, so the copy stays cheap
+      if (m_BufferStart * 2 >= m_Buffer.size())
+      {
+        m_Buffer.erase(m_Buffer.begin(), m_Buffer.begin() + static_cast<ptrdiff_t>(m_BufferStart));
+        m_BufferStart = 0;
+      }
+      return true;
+    }
+
+    void ClusterSocket::Wait(const std::vector<ClusterSocket*>& sockets, int64_t timeout)
+    {
+      std::vector<PollEntry> entries;
+      for (const ClusterSocket* socket : sockets)
+      {
+        if (!socket->IsOpen())
+          continue;
+        PollEntry entry = {};
+        entry.fd = ToNative(socket->m_Handle);
+        entry.events = POLLIN;
+        entries.push_back(entry);
+      }
+
+      if (entries.empty())
+        return;
+      PollSockets(entries.data(), entries.size(), static_cast<int>(timeout));
+    }
+
+    void ClusterSocket::Close()
+    {
+      if (!IsOpen())
+        return;
+
+      CloseNative(ToNative(m_Handle));
+      m_Handle = InvalidHandle;
+      if (m_Listening && m_Address.starts_with("unix:"))
+      {
+        std::error_code error;
+        std::filesystem::remove(m_Address.substr(5), error);
+      }
+    }
+  }
+}
\ No newline at end of file
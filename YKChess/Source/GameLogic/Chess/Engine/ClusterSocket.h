@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace yk
+{
+  namespace Chess
+  {
+    enum class ClusterMessage : uint8_t
+    {
+      Search,    // Coordinator to worker: the game, the limits and the root moves to search
+      Stop,      // Coordinator to worker: finish the search now
+      Release,   // Coordinator to worker: search the depth without waiting for a bound
+      Entries,   // Both ways: deep table entries, batched
+      RootBound, // Both ways: the best root move scores at least this at the depth
+      Iteration, // Worker to coordinator: the best line of a completed depth
+      Waiting,   // Worker to coordinator: no bound yet for the depth it is about to search
+      Done,      // Worker to coordinator: the final result
+      Quit       // Coordinator to worker: exit the process
+    };
+
+    // Stream socket between the processes of a cluster carrying length prefixed messages. Addresses are either
+    // "unix:path" for a Unix domain socket or "tcp:host:port" for TCP, where port 0 listens on any free port.
+    // Sockets never block on reading; while a send has to wait, whatever arrives meanwhile is read into the buffer,
+    // so two processes sending to each other at once cannot deadlock
+    class ClusterSocket
+    {
+    public:
+      ~ClusterSocket();
+
+      // The address the socket ended up on is available from GetAddress, for TCP with the port filled in
+      static std::shared_ptr<ClusterSocket> Listen(const std::string& address);
+      static std::shared_ptr<ClusterSocket> Connect(const std::string& address);
+      // Returns nullptr when nobody connected within the time, in milliseconds
+      std::shared_ptr<ClusterSocket> Accept(int64_t timeout);
+
+      bool Send(ClusterMessage type, const std::vector<std::byte>& payload);
+      // The next whole message read so far, false when there is none yet
+      bool Next(ClusterMessage& type, std::vector<std::byte>& payload);
+      // Reads what has arrived, false once the other side has closed the connection
+      bool Receive();
+      bool IsOpen() const { return m_Handle != InvalidHandle; }
+
+      // Until one of the sockets has something to read, at most the given milliseconds
+      static void Wait(const std::vector<ClusterSocket*>& sockets, int64_t timeout);
+
+      const std::string& GetAddress() const { return m_Address; }
+      uint64_t GetBytesSent() const { return m_BytesSent; }
+      uint64_t GetBytesReceived() const { return m_BytesReceived; }
+
+    private:
+      static constexpr intptr_t InvalidHandle = -1;
+
+      struct MessageHeader
+      {
+        uint32_t Length = 0;
+        ClusterMessage Type = ClusterMessage::Quit;
+        uint8_t Padding[3] = {};
+      };
+
+      static bool Startup();
+      bool SendBytes(const std::byte* data, size_t size);
+      void Close();
+
+    private:
+      ClusterSocket() = default;
+      ClusterSocket(const ClusterSocket&) = delete;
+      ClusterSocket& operator=(const ClusterSocket&) = delete;
+      ClusterSocket(ClusterSocket&&) = delete;
+      ClusterSocket& operator=(ClusterSocket&&) = delete;
+
+    private:
+      intptr_t m_Handle = InvalidHandle;
+      std::string m_Address;
+      bool m_Listening = false;
+
+      std::vector<std::byte> m_Buffer; // Received, not yet taken by Next
+      size_t m_BufferStart = 0;
+      uint64_t m_BytesSent = 0;
+      uint64_t m_BytesReceived = 0;
+    };
+  }
+}
\ No newline at end of file
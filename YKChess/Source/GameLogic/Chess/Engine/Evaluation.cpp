@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <string>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/Evaluation.h"
+#include "GameLogic/Chess/Engine/PSQT.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      constexpr int32_t Tempo = 10;
+
+      constexpr Score Isolated = MakeScore(-5, -15);
+      constexpr Score Doubled = MakeScore(-11, -28);
+      constexpr Score Backward = MakeScore(-9, -14);
+      constexpr Score ShelterMissing = MakeScore(-18, 0);
+      constexpr Score ShelterAdvanced = MakeScore(-7, 0);
+      constexpr Score KnightOutpost = MakeScore(22, 12);
+
+      // Indexed by relative rank
+      constexpr std::array<Score, 8> Connected = { 0, MakeScore(3, 2), MakeScore(7, 5), MakeScore(10, 8), MakeScore(18, 14), MakeScore(32, 26), MakeScore(55, 45), 0 };
+      constexpr std::array<Score, 8> Passed = { 0, MakeScore(2, 8), MakeScore(5, 12), MakeScore(6, 18), MakeScore(22, 36), MakeScore(48, 74), MakeScore(80, 120), 0 };
+      constexpr std::array<Score, 8> FreePasser = { 0, 0, MakeScore(0, 4), MakeScore(0, 8), MakeScore(4, 16), MakeScore(8, 30), MakeScore(14, 50), 0 };
+
+      constexpr Bitboard FillNorth(Bitboard board)
+      {
+        board |= board << 8;
+        board |= board << 16;
+        return board | (board << 32);
+      }
+
+      constexpr Bitboard FillSouth(Bitboard board)
+      {
+        board |= board >> 8;
+        board |= board >> 16;
+        return board | (board >> 32);
+      }
+
+      template<Color Us>
+      constexpr Bitboard FillForward(Bitboard board) { return (Us == White) ? FillNorth(board) : FillSouth(board); }
+
+      constexpr Bitboard AdjacentFiles(int32_t file)
+      {
+        return ((file > 0) ? FileBB(file - 1) : 0ULL) | ((file < 7) ? FileBB(file + 1) : 0ULL);
+      }
+
+      // Every term also counts itself into the trace when there is one, the search never passes it
+      template<Color Us>
+      void Count(EvalTrace* trace, int32_t parameter, int32_t count = 1)
+      {
+        if (trace)
+          trace->Coefficients[parameter] += static_cast<int16_t>((Us == White) ? count : -count);
+      }
+
+      template<Color Us>
+      Score EvaluatePawns(const Position& position, PawnEntry& entry, EvalTrace* trace = nullptr)
+      {
+        constexpr Color Them = (Us == White) ? Black : White;
+        const Bitboard ours = position.Pieces(Us, Pawn);
+        const Bitboard theirs = position.Pieces(Them, Pawn);
+
+        entry.AttackSpan[Us] = FillForward<Us>(PawnAttacksBB<Us>(ours));
+        entry.PassedPawns[Us] = 0ULL;
+
+        Score score = 0;
+        for (Bitboard pawns = ours; pawns;)
+        {
+          const Square square = PopLSB(pawns);
+          const int32_t rank = RelativeRank(Us, square);
+          const Bitboard adjacent = AdjacentFiles(FileOf(square));
+
+          const Bitboard ahead = FillForward<Us>(SquareBB(square + PawnPush(Us)));
+          const Bitboard frontSpan = ahead | Shift<1>(ahead) | Shift<-1>(ahead);
+          const Bitboard behindOrLevel = FillForward<Them>(RankBB(RankOf(square)));
+
+          const bool supported = ours & Bitboards::PawnAttacks(Them, square);
+          const bool phalanx = ours & adjacent & RankBB(RankOf(square));
+          const bool stopAttacked = theirs & Bitboards::PawnAttacks(Us, square + PawnPush(Us));
+
+          if (!(theirs & frontSpan))
+          {
+            entry.PassedPawns[Us] |= SquareBB(square);
+            score += Passed[rank];
+            Count<Us>(trace, ParamPassed + rank);
+          }
+
+          if (supported || phalanx)
+          {
+            score += Connected[rank] * (phalanx ? 2 : 1);
+            Count<Us>(trace, ParamConnected + rank, phalanx ? 2 : 1);
+          }
+          else if (!(ours & adjacent))
+          {
+            score += Isolated;
+            Count<Us>(trace, ParamIsolated);
+          }
+          else if (!(ours & adjacent & behindOrLevel) && stopAttacked)
+          {
+            score += Backward;
+            Count<Us>(trace, ParamBackward);
+          }
+
+          if (ours & ahead)
+          {
+            score += Doubled;
+            Count<Us>(trace, ParamDoubled);
+          }
+        }
+
+        return score;
+      }
+
+      // Own pawns in front of the king on its file and the two next to it
+      template<Color Us>
+      Score EvaluateShelter(const Position& position, Square king, EvalTrace* trace = nullptr)
+      {
+        const Bitboard ours = position.Pieces(Us, Pawn);
+        const int32_t kingFile = std::clamp(FileOf(king), 1, 6);
+
+        Score score = 0;
+        for (int32_t file = kingFile - 1; file <= kingFile + 1; file++)
+        {
+          const Bitboard shelter = ours & FileBB(file) & FillForward<Us>(RankBB(RankOf(king))) & ~RankBB(RankOf(king));
+          if (!shelter)
+          {
+            score += ShelterMissing;
+            Count<Us>(trace, ParamShelterMissing);
+          }
+          else if (std::abs(RankOf((Us == White) ? LSB(shelter) : MSB(shelter)) - RankOf(king)) > 2)
+          {
+            score += ShelterAdvanced;
+            Count<Us>(trace, ParamShelterAdvanced);
+          }
+        }
+        return score;
+      }
+
+      // Terms that depend on more than the pawns, never cached
+      template<Color Us>
+      Score EvaluatePieces(const Position& position, const PawnEntry& entry, EvalTrace* trace = nullptr)
+      {
+        constexpr Color Them = (Us == White) ? Black : White;
+        const Bitboard empty = ~position.Pieces();
+
+        Score score = 0;
+        for (Bitboard passers = entry.PassedPawns[Us]; passers;)
+        {
+          const Square square = PopLSB(passers);
+          if (empty & SquareBB(square + PawnPush(Us)))
+          {
+            score += FreePasser[RelativeRank(Us, square)];
+            Count<Us>(trace, ParamFreePasser + RelativeRank(Us, square));
+          }
+        }
+
+        // Knights on the far half that no enemy pawn can ever chase away, backed by a pawn
+        const Bitboard farHalf = (Us == White) ? (Rank4BB | Rank5BB | Rank6BB) : (Rank5BB | Rank4BB | Rank3BB);
+        const Bitboard outposts = farHalf & ~entry.AttackSpan[Them] & PawnAttacksBB<Us>(position.Pieces(Us, Pawn));
+        const int32_t outpostKnights = PopCount(position.Pieces(Us, Knight) & outposts);
+        score += KnightOutpost * outpostKnights;
+        Count<Us>(trace, ParamKnightOutpost, outpostKnights);
+
+        return score;
+      }
+
+      int32_t Blend(Score score, int32_t phase)
+      {
+        return (MidgameValue(score) * phase + EndgameValue(score) * (PSQT::MaxPhase - phase)) / PSQT::MaxPhase;
+      }
+    }
+
+    int32_t Evaluation::Evaluate(const Position& position, PawnTable& pawns)
+    {
+#if defined(CONFIG_DEBUG)
+      YK_ASSERT(position.PSQT() == Evaluation::ComputePSQT(position), "[ENGINE] Incremental piece-square score differs from a full recompute");
+      YK_ASSERT(position.Phase() == Evaluation::ComputePhase(position), "[ENGINE] Incremental game phase differs from a full recompute");
+#endif
+
+      const PawnEntry& entry = Evaluation::ProbePawns(position, pawns);
+
+      Score total = position.PSQT() + entry.PawnScore;
+      total += entry.KingShelter[White] - entry.KingShelter[Black];
+      total += EvaluatePieces<White>(position, entry) - EvaluatePieces<Black>(position, entry);
+
+      const int32_t score = Blend(total, std::min(position.Phase(), PSQT::MaxPhase));
+
+      return ((position.SideToMove() == White) ? score : -score) + Tempo;
+    }
+
+    const PawnEntry& Evaluation::ProbePawns(const Position& position, PawnTable& pawns)
+    {
+      bool found = false;
+      PawnEntry* entry = pawns.Probe(position.PawnKey(), found);
+
+      if (!found)
+      {
+        entry->Key = position.PawnKey();
+        entry->PawnScore = EvaluatePawns<White>(position, *entry) - EvaluatePawns<Black>(position, *entry);
+        entry->KingSquare[White] = entry->KingSquare[Black] = NoSquare;
+      }
+
+      // Kings move far less often than the search revisits a structure, so shelter is cached per king square
+      if (entry->KingSquare[White] != position.KingSquare(White))
+      {
+        entry->KingSquare[White] = static_cast<uint8_t>(position.KingSquare(White));
+        entry->KingShelter[White] = EvaluateShelter<White>(position, position.KingSquare(White));
+      }
+      if (entry->KingSquare[Black] != position.KingSquare(Black))
+      {
+        entry->KingSquare[Black] = static_cast<uint8_t>(position.KingSquare(Black));
+        entry->KingShelter[Black] = EvaluateShelter<Black>(position, position.KingSquare(Black));
+      }
+
+      return *entry;
+    }
+
+    Score Evaluation::ComputePSQT(const Position& position)
+    {
+      Score score = 0;
+      for (Square square = 0; square < 64; square++)
+        if (position.PieceOn(square) != NoPiece)
+          score += PSQT::PieceSquare[position.PieceOn(square)][square];
+      return score;
+    }
+
+    int32_t Evaluation::ComputePhase(const Position& position)
+    {
+      int32_t phase = 0;
+      for (PieceType type : { Knight, Bishop, Rook, Queen })
+        phase += PSQT::PhaseWeight[type] * PopCount(position.Pieces(type));
+      return phase;
+    }
+  
+    std::vector<EvalParameter> Evaluation::GetParameters()
+    {
+      std::vector<EvalParameter> parameters(EvalParameterCount);
+      auto set = [&](int32_t index, std::string name, Score value)
+        {
+        parameters[index] = { std::move(name), value };
+        };
+
+      constexpr const char* TypeNames[PieceTypeCount] = { "None", "Pawn", "Knight", "Bishop", "Rook", "Queen", "King" };
+      for (int32_t type = 0; type < PieceTypeCount; type++)
+      {
+        set(ParamMaterial + type, std::string("Material[") + TypeNames[type] + "]", MakeScore(PSQT::MidgameValue[type], PSQT::EndgameValue[type]));
+        for (int32_t square = 0; square < 64; square++)
+          set(ParamPieceSquare + type * 64 + square, std::string("PieceSquare[") + TypeNames[type] + "][" + std::to_string(square) + "]", MakeScore(PSQT::Midgame[type][square], PSQT::Endgame[type][square]));
+      }
+
+      set(ParamIsolated, "Isolated", Isolated);
+      set(ParamDoubled, "Doubled", Doubled);
+      set(ParamBackward, "Backward", Backward);
+      set(ParamShelterMissing, "ShelterMissing", ShelterMissing);
+      set(ParamShelterAdvanced, "ShelterAdvanced", ShelterAdvanced);
+      set(ParamKnightOutpost, "KnightOutpost", KnightOutpost);
+      for (int32_t rank = 0; rank < 8; rank++)
+      {
+        set(ParamConnected + rank, "Connected[" + std::to_string(rank) + "]", Connected[rank]);
+        set(ParamPassed + rank, "Passed[" + std::to_string(rank) + "]", Passed[rank]);
+        set(ParamFreePasser + rank, "FreePasser[" + std::to_string(rank) + "]", FreePasser[rank]);
+      }
+
+      return parameters;
+    }
+
+    EvalTrace Evaluation::Trace(const Position& position)
+    {
+      EvalTrace trace;
+
+      // Piece-square values are material plus the table entry, White reads the tables rank-flipped
+      for (Square square = 0; square < 64; square++)
+      {
+        const Piece piece = position.PieceOn(square);
+        if (piece == NoPiece)
+          continue;
+
+        const int32_t type = TypeOf(piece);
+        const int32_t sign = (ColorOf(piece) == White) ? 1 : -1;
+        trace.Coefficients[ParamMaterial + type] += static_cast<int16_t>(sign);
+        trace.Coefficients[ParamPieceSquare + type * 64 + ((sign > 0) ? FlipRank(square) : square)] += static_cast<int16_t>(sign);
+      }
+
+      // A fresh pawn entry, the cached one has no trace of how it was scored
+      PawnEntry entry;
+      EvaluatePawns<White>(position, entry, &trace);
+      EvaluatePawns<Black>(position, entry, &trace);
+      EvaluateShelter<White>(position, position.KingSquare(White), &trace);
+      EvaluateShelter<Black>(position, position.KingSquare(Black), &trace);
+      EvaluatePieces<White>(position, entry, &trace);
+      EvaluatePieces<Black>(position, entry, &trace);
+
+      trace.Phase = std::min(position.Phase(), PSQT::MaxPhase);
+      return trace;
+    }
+
+    int32_t Evaluation::GetTempo()
+    {
+      return Tempo;
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "GameLogic/Chess/Engine/PawnTable.h"
+#include "GameLogic/Chess/Engine/Position.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    // Every weight of the hand written evaluation, in the order the tuner sees them
+    enum EvalParameterIndex : int32_t
+    {
+      ParamMaterial = 0,                                   // One per piece type
+      ParamPieceSquare = ParamMaterial + PieceTypeCount,   // 64 per piece type, laid out as the PSQT tables
+      ParamIsolated = ParamPieceSquare + PieceTypeCount * 64,
+      ParamDoubled,
+      ParamBackward,
+      ParamShelterMissing,
+      ParamShelterAdvanced,
+      ParamKnightOutpost,
+      ParamConnected,                                      // 8 each, by relative rank
+      ParamPassed = ParamConnected + 8,
+      ParamFreePasser = ParamPassed + 8,
+      EvalParameterCount = ParamFreePasser + 8
+    };
+
+    struct EvalParameter
+    {
+      std::string Name;
+      Score Value = 0;
+    };
+
+    // How many times each weight counts in a position, White's count minus Black's. The evaluation is the phase blend of
+    // their sum plus the tempo bonus, the exact score up to rounding
+    struct EvalTrace
+    {
+      std::array<int16_t, EvalParameterCount> Coefficients = {};
+      int32_t Phase = 0;
+    };
+
+    class Evaluation
+    {
+    public:
+      // Static score of the position from the side to move's point of view
+      static int32_t Evaluate(const Position& position, PawnTable& pawns);
+
+      // Pawn structure of the position, computed and stored on a miss
+      static const PawnEntry& ProbePawns(const Position& position, PawnTable& pawns);
+
+      // Full recomputes of what Position keeps incrementally, for debug checks
+      static Score ComputePSQT(const Position& position);
+      static int32_t ComputePhase(const Position& position);
+
+      // For tuning, the current weights and what a position makes of them
+      static std::vector<EvalParameter> GetParameters();
+      static EvalTrace Trace(const Position& position);
+      static int32_t GetTempo();
+
+    private:
+      Evaluation() = delete;
+      Evaluation(const Evaluation&) = delete;
+      Evaluation& operator=(const Evaluation&) = delete;
+      Evaluation(Evaluation&&) = delete;
+      Evaluation& operator=(Evaluation&&) = delete;
+    };
+  }
+}
\ No newline at end of file
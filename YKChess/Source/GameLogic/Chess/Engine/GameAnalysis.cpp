@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/GameAnalysis.h"
+#include "GameLogic/Chess/Engine/MoveGen.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      // Mate scores count as this much, otherwise missing a mate in five for a mate in six would be a blunder
+      constexpr int32_t LossScoreCap = 1000;
+
+      constexpr int32_t GoodLoss = 10;
+      constexpr int32_t InaccuracyLoss = 50;
+      constexpr int32_t MistakeLoss = 100;
+      constexpr int32_t BlunderLoss = 300;
+
+      int32_t CapScore(int32_t score)
+      {
+        return std::clamp(score, -LossScoreCap, LossScoreCap);
+      }
+
+      MoveClassification Classify(int32_t loss)
+      {
+        if (loss >= BlunderLoss)
+          return MoveClassification::Blunder;
+        if (loss >= MistakeLoss)
+          return MoveClassification::Mistake;
+        if (loss >= InaccuracyLoss)
+          return MoveClassification::Inaccuracy;
+        if (loss > GoodLoss)
+          return MoveClassification::Good;
+        return MoveClassification::Best;
+      }
+
+      // Positions the game ended in are scored by the rules, a search would find no move to play
+      bool ScoreTerminal(const Position& position, PositionAnalysis& analysis)
+      {
+        MoveList moves;
+        MoveGen::GenerateLegal(position, moves);
+        if (moves.size() == 0)
+        {
+          analysis.Score = position.InCheck() ? MatedIn(0) : 0;
+          return true;
+        }
+        if (position.IsDraw(0))
+        {
+          analysis.Score = 0;
+          return true;
+        }
+        return false;
+      }
+
+      // Searches the positions in the order given, every thread taking the next one as soon as it is done with its own
+      void AnalyzePositions(const std::vector<Position>& positions, const std::vector<int32_t>& order, const GameAnalysisOptions& options,
+        std::shared_ptr<TranspositionTable> table, int32_t threads, std::vector<PositionAnalysis>& results)
+      {
+        std::atomic<size_t> next = 0;
+
+        auto work = [&]()
+          {
+          // One search per thread on the shared table. NewGame is never called, it would clear the table for everyone,
+          // and the table is not aged either, the entries of the later positions are what the earlier ones reuse
+          std::shared_ptr<Search> search = Search::Create(table, 1);
+          SearchOptions searchOptions;
+          searchOptions.AgeTable = false;
+          search->SetOptions(searchOptions);
+          search->SetNetwork(options.Network);
+
+          for (size_t i = next.fetch_add(1); i < order.size(); i = next.fetch_add(1))
+          {
+            const Position& position = positions[order[i]];
+            PositionAnalysis& analysis = results[order[i]];
+            if (ScoreTerminal(position, analysis))
+              continue;
+
+            search->Start(position, options.Limits);
+            search->Wait();
+            const SearchResult result = search->GetResult();
+            analysis.Score = result.Score;
+            analysis.BestMove = result.BestMove;
+            analysis.Depth = result.Depth;
+            analysis.Nodes = result.Nodes;
+          }
+          };
+
+        std::vector<std::thread> pool;
+        for (int32_t i = 1; i < threads; i++)
+          pool.emplace_back(work);
+        work();
+        for (std::thread& thread : pool)
+          thread.join();
+      }
+    }
+
+    GameAnalysisReport GameAnalysis::Analyze(const Position& game, const GameAnalysisOptions& options)
+    {
+      GameAnalysisReport report;
+      report.Threads = std::max(options.Threads, 1);
+
+      // Every position of the game keeps the history before it, so the searches see the repetitions the game had
+      const int32_t moveCount = game.StateIndex();
+      std::vector<Position> positions(moveCount + 1);
+      positions[moveCount] = game;
+      for (int32_t i = moveCount - 1; i >= 0; i--)
+      {
+        positions[i] = positions[i + 1];
+        positions[i].UnmakeMove();
+      }
+
+      // The end of the game first, its searches fill the table with the lines the earlier positions lead into
+      std::vector<int32_t> order(moveCount + 1);
+      for (int32_t i = 0; i <= moveCount; i++)
+        order[i] = moveCount - i;
+
+      std::shared_ptr<TranspositionTable> table = TranspositionTable::Create(options.HashMB);
+      table->NewSearch();
+      report.Positions.resize(moveCount + 1);
+      const auto start = std::chrono::steady_clock::now();
+      AnalyzePositions(positions, order, options, table, report.Threads, report.Positions);
+      report.Time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+      if (options.CompareSequential)
+      {
+        std::reverse(order.begin(), order.end());
+        std::vector<PositionAnalysis> sequential(moveCount + 1);
+        table = TranspositionTable::Create(options.HashMB);
+        table->NewSearch();
+        const auto sequentialStart = std::chrono::steady_clock::now();
+        AnalyzePositions(positions, order, options, table, 1, sequential);
+        report.SequentialTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - sequentialStart).count();
+      }
+
+      double totalLoss[ColorCount] = { 0.0, 0.0 };
+      int32_t moves[ColorCount] = { 0, 0 };
+      for (const PositionAnalysis& analysis : report.Positions)
+        report.Nodes += analysis.Nodes;
+
+      for (int32_t i = 0; i < moveCount; i++)
+      {
+        const PositionAnalysis& before = report.Positions[i];
+        const PositionAnalysis& after = report.Positions[i + 1];
+
+        MoveAnnotation annotation;
+        annotation.Played = positions[i + 1].StateAt(i + 1).LastMove;
+        annotation.Side = positions[i].SideToMove();
+        // What the mover could have had, against what the position they left is worth to them
+        annotation.Loss = (annotation.Played == before.BestMove) ? 0 : std::max(0, CapScore(before.Score) - CapScore(-after.Score));
+        annotation.Classification = Classify(annotation.Loss);
+
+        totalLoss[annotation.Side] += annotation.Loss;
+        moves[annotation.Side]++;
+        report.Counts[annotation.Side][static_cast<size_t>(annotation.Classification)]++;
+        report.Moves.push_back(annotation);
+      }
+
+      for (Color color : { White, Black })
+        report.AverageLoss[color] = moves[color] ? totalLoss[color] / moves[color] : 0.0;
+
+      YK_INFO("[ENGINE] Analyzed {} moves on {} threads in {}ms", moveCount, report.Threads, report.Time);
+      return report;
+    }
+
+    const char* GameAnalysis::GetClassificationName(MoveClassification classification)
+    {
+      switch (classification)
+      {
+        case MoveClassification::Best: return "best";
+        case MoveClassification::Good: return "good";
+        case MoveClassification::Inaccuracy: return "inaccuracy";
+        case MoveClassification::Mistake: return "mistake";
+        default: return "blunder";
+      }
+    }
+
+    const char* GameAnalysis::GetClassificationSymbol(MoveClassification classification)
+    {
+      switch (classification)
+      {
+        case MoveClassification::Inaccuracy: return "?!";
+        case MoveClassification::Mistake: return "?";
+        case MoveClassification::Blunder: return "??";
+        default: return "";
+      }
+    }
+  }
+}
\ No newline at end of file
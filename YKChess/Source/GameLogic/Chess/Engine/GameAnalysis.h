@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "GameLogic/Chess/Engine/Search.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    enum class MoveClassification : uint8_t
+    {
+      Best,
+      Good,
+      Inaccuracy,
+      Mistake,
+      Blunder
+    };
+
+    struct GameAnalysisOptions
+    {
+      int32_t Threads = 1;
+      SearchLimits Limits;      // Per position, a fixed depth unless set otherwise
+      size_t HashMB = 64;
+      bool CompareSequential = false; // Also analyses the game on one thread from the first move, for the timing only
+      std::shared_ptr<const NNUE::Network> Network;
+    };
+
+    struct PositionAnalysis
+    {
+      int32_t Score = 0; // From the side to move's point of view
+      Move BestMove;     // None when the game is over in this position
+      int32_t Depth = 0;
+      uint64_t Nodes = 0;
+    };
+
+    // The move played from a position, judged by how much of that position's score it gave away
+    struct MoveAnnotation
+    {
+      Move Played;
+      Color Side = White;
+      int32_t Loss = 0; // Centipawns, mate scores capped
+      MoveClassification Classification = MoveClassification::Best;
+    };
+
+    struct GameAnalysisReport
+    {
+      std::vector<PositionAnalysis> Positions; // One more than there are moves, the first is the game's starting position
+      std::vector<MoveAnnotation> Moves;
+      int32_t Threads = 0;
+      uint64_t Nodes = 0;
+      int64_t Time = 0;
+      int64_t SequentialTime = 0; // Only with CompareSequential
+      double AverageLoss[ColorCount] = { 0.0, 0.0 };
+      int32_t Counts[ColorCount][5] = {}; // By classification
+    };
+
+    // Annotates every move of a game. The positions are searched on every thread at once from the last one backwards,
+    // all sharing one transposition table, so each search finds the table warmed by the deeper lines of the positions
+    // that follow it in the game
+    class GameAnalysis
+    {
+    public:
+      // The game is the history of the position, every move played since its FEN was set
+      static GameAnalysisReport Analyze(const Position& game, const GameAnalysisOptions& options);
+
+      static const char* GetClassificationName(MoveClassification classification);
+      static const char* GetClassificationSymbol(MoveClassification classification);
+
+    private:
+      GameAnalysis() = delete;
+      GameAnalysis(const GameAnalysis&) = delete;
+      GameAnalysis& operator=(const GameAnalysis&) = delete;
+      GameAnalysis(GameAnalysis&&) = delete;
+      GameAnalysis& operator=(GameAnalysis&&) = delete;
+    };
+  }
+}
\ No newline at end of file
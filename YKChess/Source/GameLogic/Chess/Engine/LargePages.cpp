@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include "GameLogic/Chess/Engine/LargePages.h"
+
+#if defined(PLATFORM_WINDOWS)
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace yk
+{
+  namespace Chess
+  {
+    std::atomic<HugePagePolicy> LargePages::s_Policy = HugePagePolicy::Transparent;
+
+    namespace
+    {
+      constexpr size_t RoundUp(size_t size, size_t alignment) { return (size + alignment - 1) / alignment * alignment; }
+
+#if defined(PLATFORM_WINDOWS)
+      // Large pages need the lock memory privilege, which has to be granted to the user and then enabled per process
+      bool EnableLockMemoryPrivilege()
+      {
+        static const bool s_Enabled = []()
+          {
+          HANDLE token;
+          if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+            return false;
+
+          TOKEN_PRIVILEGES privileges = {};
+          privileges.PrivilegeCount = 1;
+          privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+          const bool enabled = LookupPrivilegeValueW(nullptr, L"SeLockMemoryPrivilege", &privileges.Privileges[0].Luid) &&
+            AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) && GetLastError() == ERROR_SUCCESS;
+          CloseHandle(token);
+          return enabled;
+          }();
+        return s_Enabled;
+      }
+#endif
+    }
+
+    PageAllocation LargePages::Allocate(size_t size)
+    {
+      const HugePagePolicy policy = LargePages::GetPolicy();
+      PageAllocation allocation;
+
+#if defined(PLATFORM_WINDOWS)
+      // Windows has no transparent huge pages, both policies ask for large pages and fall back silently
+      if (policy != HugePagePolicy::Off && EnableLockMemoryPrivilege())
+      {
+        const size_t largePageSize = GetLargePageMinimum();
+        if (largePageSize)
+        {
+          allocation.Size = RoundUp(size, largePageSize);
+          allocation.Memory = VirtualAlloc(nullptr, allocation.Size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+          if (allocation.Memory)
+          {
+            allocation.Kind = PageKind::Huge;
+            return allocation;
+          }
+        }
+      }
+
+      allocation.Size = RoundUp(size, 4096);
+      allocation.Memory = VirtualAlloc(nullptr, allocation.Size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+      allocation.Kind = PageKind::Normal;
+#else
+      allocation.Size = RoundUp(size, HugePageSize);
+
+  #if defined(MAP_HUGETLB)
+      if (policy == HugePagePolicy::Explicit)
+      {
+        void* memory = mmap(nullptr, allocation.Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED)
+        {
+          allocation.Memory = memory;
+          allocation.Kind = PageKind::Huge;
+          return allocation;
+        }
+      }
+  #endif
+
+      // Aligned to the huge page size so that the kernel can map whole 2MB pages from the first byte
+      allocation.Memory = std::aligned_alloc(HugePageSize, allocation.Size);
+      allocation.Kind = PageKind::Normal;
+
+  #if defined(MADV_HUGEPAGE)
+      if (allocation.Memory && policy != HugePagePolicy::Off && madvise(allocation.Memory, allocation.Size, MADV_HUGEPAGE) == 0)
+        allocation.Kind = PageKind::Transparent;
+  #endif
+#endif
+
+      if (!allocation.Memory)
+        allocation.Size = 0;
+      return allocation;
+    }
+
+    void LargePages::Free(PageAllocation& allocation)
+    {
+      if (!allocation.Memory)
+        return;
+
+#if defined(PLATFORM_WINDOWS)
+      VirtualFree(allocation.Memory, 0, MEM_RELEASE);
+#else
+      if (allocation.Kind == PageKind::Huge)
+        munmap(allocation.Memory, allocation.Size);
+      else
+        std::free(allocation.Memory);
+#endif
+
+      allocation = PageAllocation();
+    }
+
+    size_t LargePages::GetHugeBytes(const PageAllocation& allocation)
+    {
+      if (allocation.Kind != PageKind::Transparent)
+        return (allocation.Kind == PageKind::Huge) ? allocation.Size : 0;
+
+#if defined(__linux__)
+      // Sums AnonHugePages over the mappings overlapping the allocation, neighbours merged into the same mapping count too
+      const uintptr_t begin = reinterpret_cast<uintptr_t>(allocation.Memory);
+      const uintptr_t end = begin + allocation.Size;
+
+      std::ifstream smaps("/proc/self/smaps");
+      std::string line;
+      bool inside = false;
+      size_t hugeBytes = 0;
+      while (std::getline(smaps, line))
+      {
+        const size_t dash = line.find('-');
+        const size_t space = line.find(' ');
+        if (dash != std::string::npos && space != std::string::npos && dash < space && line.find(':') > space)
+        {
+          const uintptr_t mappingBegin = std::stoull(line.substr(0, dash), nullptr, 16);
+          const uintptr_t mappingEnd = std::stoull(line.substr(dash + 1, space - dash - 1), nullptr, 16);
+          inside = mappingBegin < end && begin < mappingEnd;
+        }
+        else if (inside && line.rfind("AnonHugePages:", 0) == 0)
+          hugeBytes += std::stoull(line.substr(14)) * 1024;
+      }
+      return std::min(hugeBytes, allocation.Size);
+#else
+      return 0;
+#endif
+    }
+
+    size_t LargePages::GetPhysicalMemory()
+    {
+#if defined(PLATFORM_WINDOWS)
+      MEMORYSTATUSEX status = {};
+      status.dwLength = sizeof(status);
+      return GlobalMemoryStatusEx(&status) ? static_cast<size_t>(status.ullTotalPhys) : 0;
+#else
+      return static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<size_t>(sysconf(_SC_PAGE_SIZE));
+#endif
+    }
+
+    const char* LargePages::GetKindName(PageKind kind)
+    {
+      switch (kind)
+      {
+        case PageKind::Transparent: return "transparent 2MB";
+        case PageKind::Huge: return "huge";
+        default: return "normal 4KB";
+      }
+    }
+
+    const char* LargePages::GetPolicyName(HugePagePolicy policy)
+    {
+      switch (policy)
+      {
+        case HugePagePolicy::Off: return "Off";
+        case HugePagePolicy::Explicit: return "Explicit";
+        default: return "Transparent";
+      }
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace yk
+{
+  namespace Chess
+  {
+    enum class HugePagePolicy : uint8_t
+    {
+      Off,         // Normal pages only
+      Transparent, // Ask the kernel to back the memory with 2MB pages when it can, default
+      Explicit     // Reserved huge pages first (MAP_HUGETLB, large pages on Windows), transparent ones as fallback
+    };
+
+    enum class PageKind : uint8_t
+    {
+      Normal,
+      Transparent,
+      Huge
+    };
+
+    struct PageAllocation
+    {
+      void* Memory = nullptr;
+      size_t Size = 0; // Rounded up to whole pages
+      PageKind Kind = PageKind::Normal;
+    };
+
+    // Memory for the big engine tables, where TLB misses cost more than the lookups themselves
+    class LargePages
+    {
+    public:
+      static constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+      // Uninitialized memory, Memory is nullptr when even normal pages could not be had
+      static PageAllocation Allocate(size_t size);
+      static void Free(PageAllocation& allocation);
+
+      // Applies to later allocations only
+      static void SetPolicy(HugePagePolicy policy) { s_Policy.store(policy, std::memory_order_relaxed); }
+      static HugePagePolicy GetPolicy() { return s_Policy.load(std::memory_order_relaxed); }
+
+      // Bytes of the allocation the kernel currently backs with huge pages, read from /proc on Linux
+      static size_t GetHugeBytes(const PageAllocation& allocation);
+      static size_t GetPhysicalMemory();
+
+      static const char* GetKindName(PageKind kind);
+      // Also the names of the LargePages UCI option
+      static const char* GetPolicyName(HugePagePolicy policy);
+
+    private:
+      LargePages() = delete;
+      LargePages(const LargePages&) = delete;
+      LargePages& operator=(const LargePages&) = delete;
+      LargePages(LargePages&&) = delete;
+      LargePages& operator=(LargePages&&) = delete;
+
+    private:
+      static std::atomic<HugePagePolicy> s_Policy;
+    };
+  }
+}
\ No newline at end of file
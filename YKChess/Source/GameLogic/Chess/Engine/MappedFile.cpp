@@ -0,0 +1,143 @@
+#include "GameLogic/Chess/Engine/MappedFile.h"
+
+#if defined(PLATFORM_WINDOWS)
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace yk
+{
+  namespace Chess
+  {
+    MappedFile::~MappedFile()
+    {
+      if (!m_Data)
+        return;
+
+#if defined(PLATFORM_WINDOWS)
+      UnmapViewOfFile(m_Data);
+#else
+      munmap(const_cast<std::byte*>(m_Data), m_Size);
+#endif
+    }
+
+    std::shared_ptr<MappedFile> MappedFile::Open(const std::filesystem::path& path)
+    {
+      std::shared_ptr<MappedFile> file(new MappedFile());
+
+#if defined(PLATFORM_WINDOWS)
+      HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (handle == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+      LARGE_INTEGER size;
+      if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0)
+      {
+        CloseHandle(handle);
+        return nullptr;
+      }
+
+      // The view keeps the mapping alive, both handles can go right away
+      HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      CloseHandle(handle);
+      if (!mapping)
+        return nullptr;
+
+      const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+      if (!data)
+        return nullptr;
+
+      file->m_Data = static_cast<const std::byte*>(data);
+      file->m_Size = static_cast<size_t>(size.QuadPart);
+#else
+      const int descriptor = open(path.c_str(), O_RDONLY);
+      if (descriptor < 0)
+        return nullptr;
+
+      struct stat info;
+      if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+      {
+        close(descriptor);
+        return nullptr;
+      }
+
+      void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+      close(descriptor);
+      if (data == MAP_FAILED)
+        return nullptr;
+
+      file->m_Data = static_cast<const std::byte*>(data);
+      file->m_Size = static_cast<size_t>(info.st_size);
+#endif
+
+      return file;
+    }
+
+    std::shared_ptr<MappedFile> MappedFile::OpenWritable(const std::filesystem::path& path, size_t size)
+    {
+      std::shared_ptr<MappedFile> file(new MappedFile());
+
+#if defined(PLATFORM_WINDOWS)
+      HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (handle == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+      LARGE_INTEGER current;
+      if (!GetFileSizeEx(handle, &current) || (size == 0 && current.QuadPart == 0))
+      {
+        CloseHandle(handle);
+        return nullptr;
+      }
+      if (size == 0)
+        size = static_cast<size_t>(current.QuadPart);
+
+      // Mapping past the end grows the file
+      HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+        static_cast<DWORD>(size), nullptr);
+      CloseHandle(handle);
+      if (!mapping)
+        return nullptr;
+
+      void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+      CloseHandle(mapping);
+      if (!data)
+        return nullptr;
+#else
+      const int descriptor = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+      if (descriptor < 0)
+        return nullptr;
+
+      struct stat info;
+      if (fstat(descriptor, &info) != 0 || (size == 0 && info.st_size == 0))
+      {
+        close(descriptor);
+        return nullptr;
+      }
+      if (size == 0)
+        size = static_cast<size_t>(info.st_size);
+      else if (static_cast<size_t>(info.st_size) != size && ftruncate(descriptor, static_cast<off_t>(size)) != 0)
+      {
+        close(descriptor);
+        return nullptr;
+      }
+
+      void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+      close(descriptor);
+      if (data == MAP_FAILED)
+        return nullptr;
+#endif
+
+      file->m_Data = static_cast<const std::byte*>(data);
+      file->m_Size = size;
+      file->m_Writable = true;
+      return file;
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+
+namespace yk
+{
+  namespace Chess
+  {
+    // View of a whole file, pages are loaded on first touch and shared with every process mapping the same file
+    class MappedFile
+    {
+    public:
+      ~MappedFile();
+
+      // Returns nullptr when the file cannot be opened or is empty
+      static std::shared_ptr<MappedFile> Open(const std::filesystem::path& path);
+      // Read and write view, the file is created when missing and resized to the given size unless that is 0.
+      // Returns nullptr when the file cannot be opened, or would be empty
+      static std::shared_ptr<MappedFile> OpenWritable(const std::filesystem::path& path, size_t size = 0);
+
+      // Page aligned
+      const std::byte* GetData() const { return m_Data; }
+      size_t GetSize() const { return m_Size; }
+      // Only for files opened writable
+      std::byte* GetWritableData() const { return m_Writable ? const_cast<std::byte*>(m_Data) : nullptr; }
+
+    private:
+      MappedFile() = default;
+      MappedFile(const MappedFile&) = delete;
+      MappedFile& operator=(const MappedFile&) = delete;
+      MappedFile(MappedFile&&) = delete;
+      MappedFile& operator=(MappedFile&&) = delete;
+
+    private:
+      const std::byte* m_Data = nullptr;
+      size_t m_Size = 0;
+      bool m_Writable = false;
+    };
+  }
+}
\ No newline at end of file
@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/Bitbases.h"
+#include "GameLogic/Chess/Engine/Match.h"
+#include "GameLogic/Chess/Engine/MoveGen.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      constexpr int32_t ResultLoss = 0;
+      constexpr int32_t ResultDraw = 1;
+      constexpr int32_t ResultWin = 2;
+      constexpr int32_t ResultAborted = -1;
+
+      double ExpectedScore(double elo)
+      {
+        return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+      }
+
+      // White's result when the endgame tables know the position, ResultAborted otherwise
+      int32_t ProbeTables(const Position& position)
+      {
+        const Color us = position.SideToMove();
+
+        if (PopCount(position.Pieces()) <= Bitbases::MaxPieces)
+        {
+          const BitbaseResult result = Bitbases::Probe(position);
+          if (result == BitbaseResult::Draw)
+            return ResultDraw;
+          if (result != BitbaseResult::Unknown)
+            return ((result == BitbaseResult::Win) == (us == White)) ? ResultWin : ResultLoss;
+        }
+
+        if (PopCount(position.Pieces()) <= Tablebases::GetMaxPieces() && !position.CastlingRights())
+        {
+          // Cursed wins and blessed losses are draws, the fifty move rule applies to these games too
+          Position probe = position;
+          ProbeState state;
+          const WDLScore wdl = Tablebases::ProbeWDL(probe, state);
+          if (state != ProbeState::Fail)
+          {
+            if (wdl >= WDLBlessedLoss && wdl <= WDLCursedWin)
+              return ResultDraw;
+            return ((wdl > 0) == (us == White)) ? ResultWin : ResultLoss;
+          }
+        }
+
+        return ResultAborted;
+      }
+    }
+
+    Match::~Match()
+    {
+      Match::Stop();
+      Match::Wait();
+    }
+
+    std::shared_ptr<Match> Match::Create(const MatchEngine& first, const MatchEngine& second, const MatchSettings& settings)
+    {
+      std::shared_ptr<Match> match(new Match());
+      match->m_Engines[0] = first;
+      match->m_Engines[1] = second;
+      match->m_Settings = settings;
+      match->m_Settings.Concurrency = std::max(settings.Concurrency, 1);
+      match->m_Settings.Games = std::max((settings.Games + 1) / 2 * 2, 2);
+      if (match->m_Settings.Openings.empty())
+        match->m_Settings.Openings.push_back(Position::StartPosition().GetFEN());
+
+      match->m_Status.LowerBound = std::log(settings.Beta / (1.0 - settings.Alpha));
+      match->m_Status.UpperBound = std::log((1.0 - settings.Beta) / settings.Alpha);
+      return match;
+    }
+
+    std::vector<std::string> Match::LoadOpenings(const std::filesystem::path& path)
+    {
+      std::vector<std::string> openings;
+      std::ifstream file(path);
+      if (!file)
+      {
+        YK_WARN("[ENGINE] Opening file '{}' not found", path.string());
+        return openings;
+      }
+
+      const bool pgn = path.extension() == ".pgn";
+      Position position = Position::StartPosition();
+      bool inGame = false;
+      std::string line;
+
+      while (std::getline(file, line))
+      {
+        if (!line.empty() && line.back() == '\r')
+          line.pop_back();
+
+        if (!pgn)
+        {
+          // The first four fields are the position, counters are not part of EPD
+          std::istringstream fields(line);
+          std::string board, side, castling, enPassant;
+          if (!(fields >> board >> side >> castling >> enPassant))
+            continue;
+
+          Position opening;
+          if (opening.SetFEN(board + " " + side + " " + castling + " " + enPassant + " 0 1"))
+            openings.push_back(opening.GetFEN());
+          continue;
+        }
+
+        if (line.starts_with("["))
+        {
+          if (inGame)
+            openings.push_back(position.GetFEN());
+          position = Position::StartPosition();
+          inGame = false;
+          if (line.starts_with("[FEN \"") && line.size() > 8)
+            position.SetFEN(line.substr(6, line.rfind('"') - 6));
+          continue;
+        }
+
+        // Move numbers, results and annotations are simply not moves, comments and variations are not expected in an opening set
+        std::istringstream tokens(line);
+        std::string token;
+        while (tokens >> token)
+        {
+          const size_t dot = token.rfind('.');
+          if (dot != std::string::npos)
+            token.erase(0, dot + 1);
+          if (token.empty())
+            continue;
+
+          if (const Move move = position.ParseSANMove(token))
+          {
+            position.MakeMove(move);
+            inGame = true;
+          }
+        }
+      }
+
+      if (pgn && inGame)
+        openings.push_back(position.GetFEN());
+
+      YK_INFO("[ENGINE] Loaded {} openings from '{}'", openings.size(), path.string());
+      return openings;
+    }
+
+    void Match::Start()
+    {
+      Match::Stop();
+      Match::Wait();
+
+      m_NextGame = 0;
+      m_Stop = false;
+      m_Running = true;
+      {
+        std::lock_guard<std::mutex> lock(m_StatusMutex);
+        const double lower = m_Status.LowerBound;
+        const double upper = m_Status.UpperBound;
+        m_Status = MatchStatus();
+        m_Status.LowerBound = lower;
+        m_Status.UpperBound = upper;
+      }
+
+      m_ActiveWorkers = m_Settings.Concurrency;
+      for (int32_t i = 0; i < m_Settings.Concurrency; i++)
+        m_Workers.emplace_back([this]() { Match::Work(); });
+    }
+
+    void Match::Stop()
+    {
+      m_Stop = true;
+    }
+
+    void Match::Wait()
+    {
+      for (std::thread& worker : m_Workers)
+        worker.join();
+      m_Workers.clear();
+    }
+
+    MatchStatus Match::GetStatus() const
+    {
+      std::lock_guard<std::mutex> lock(m_StatusMutex);
+      return m_Status;
+    }
+
+    void Match::Work()
+    {
+      // Each game has its own pair of searches on one thread each, the hash tables are cleared between games
+      std::shared_ptr<Search> searches[2];
+      for (int32_t i = 0; i < 2; i++)
+      {
+        searches[i] = Search::Create(TranspositionTable::Create(m_Engines[i].HashMB), 1);
+        searches[i]->SetOptions(m_Engines[i].Options);
+        searches[i]->SetNetwork(m_Engines[i].Network);
+      }
+
+      for (int32_t game = m_NextGame++; game < m_Settings.Games && !m_Stop; game = m_NextGame++)
+        Match::PlayGame(game, *searches[0], *searches[1]);
+
+      // The last worker out marks the match finished, whether it ran to the end or was stopped
+      if (--m_ActiveWorkers == 0)
+      {
+        std::lock_guard<std::mutex> lock(m_StatusMutex);
+        m_Status.Finished = true;
+        m_Running = false;
+      }
+    }
+
+    int32_t Match::PlayGame(int32_t game, Search& first, Search& second)
+    {
+      // Both games of a pair start from the same opening, the first engine has white in the first one
+      Position position;
+      position.SetFEN(m_Settings.Openings[static_cast<size_t>(game / 2) % m_Settings.Openings.size()]);
+      const Color firstColor = (game % 2 == 0) ? White : Black;
+
+      Search* engines[ColorCount];
+      engines[firstColor] = &first;
+      engines[~firstColor] = &second;
+      first.NewGame();
+      second.NewGame();
+
+      int64_t clock[ColorCount] = { m_Settings.Time, m_Settings.Time };
+      int32_t resignCount[ColorCount] = { 0, 0 };
+      int32_t drawCount = 0;
+      int32_t whiteResult = ResultAborted;
+      bool timeLoss = false;
+
+      for (int32_t ply = 0; ply < m_Settings.MaxPlies && !m_Stop; ply++)
+      {
+        MoveList moves;
+        MoveGen::GenerateLegal(position, moves);
+        if (moves.empty())
+        {
+          whiteResult = !position.InCheck() ? ResultDraw : (position.SideToMove() == White) ? ResultLoss : ResultWin;
+          break;
+        }
+        if (position.IsDraw(0))
+        {
+          whiteResult = ResultDraw;
+          break;
+        }
+        if ((whiteResult = ProbeTables(position)) != ResultAborted)
+          break;
+
+        const Color us = position.SideToMove();
+        SearchLimits limits;
+        limits.Time[White] = clock[White];
+        limits.Time[Black] = clock[Black];
+        limits.Increment[White] = limits.Increment[Black] = m_Settings.Increment;
+
+        engines[us]->Start(position, limits);
+        engines[us]->Wait();
+        const SearchResult result = engines[us]->GetResult();
+
+        clock[us] -= result.Time;
+        if (clock[us] < 0)
+        {
+          whiteResult = (us == White) ? ResultLoss : ResultWin;
+          timeLoss = true;
+          break;
+        }
+        clock[us] += m_Settings.Increment;
+
+        // Resigning takes both engines seeing it, a losing score from the side to move and a winning one from the other side
+        const int32_t whiteScore = (us == White) ? result.Score : -result.Score;
+        for (const Color side : { White, Black })
+        {
+          const int32_t sideScore = (side == White) ? whiteScore : -whiteScore;
+          resignCount[side] = (sideScore <= -m_Settings.ResignScore) ? resignCount[side] + 1 : 0;
+        }
+        drawCount = (ply >= m_Settings.DrawPly && std::abs(result.Score) <= m_Settings.DrawScore) ? drawCount + 1 : 0;
+
+        position.MakeMove(result.BestMove);
+
+        if (resignCount[White] >= 2 * m_Settings.ResignMoves)
+        {
+          whiteResult = ResultLoss;
+          break;
+        }
+        if (resignCount[Black] >= 2 * m_Settings.ResignMoves)
+        {
+          whiteResult = ResultWin;
+          break;
+        }
+        if (drawCount >= 2 * m_Settings.DrawMoves)
+        {
+          whiteResult = ResultDraw;
+          break;
+        }
+      }
+
+      // Too long a game is a draw, a stopped one is not counted
+      if (whiteResult == ResultAborted)
+      {
+        if (m_Stop)
+          return ResultAborted;
+        whiteResult = ResultDraw;
+      }
+
+      const int32_t result = (firstColor == White) ? whiteResult : ResultWin - whiteResult;
+      Match::Record(result, timeLoss);
+      return result;
+    }
+
+    void Match::Record(int32_t result, bool time_loss)
+    {
+      std::lock_guard<std::mutex> lock(m_StatusMutex);
+      MatchStatus& status = m_Status;
+
+      status.Wins += result == ResultWin;
+      status.Draws += result == ResultDraw;
+      status.Losses += result == ResultLoss;
+      status.TimeLosses += time_loss;
+
+      const double games = static_cast<double>(status.GetGames());
+      const double score = (status.Wins + 0.5 * status.Draws) / games;
+      const double variance = (status.Wins * (1.0 - score) * (1.0 - score) + status.Draws * (0.5 - score) * (0.5 - score)
+        + status.Losses * score * score) / games;
+
+      // Logistic Elo with its 95% interval, meaningless until both a win and a loss or a draw keep the score off 0 and 1
+      if (score > 0.0 && score < 1.0)
+      {
+        auto toElo = [](double value) { return -400.0 * std::log10(1.0 / std::clamp(value, 1e-6, 1.0 - 1e-6) - 1.0); };
+        const double margin = 1.96 * std::sqrt(variance / games);
+        status.Elo = toElo(score);
+        status.EloError = (toElo(score + margin) - toElo(score - margin)) / 2.0;
+      }
+
+      // Generalized SPRT on the score with its observed variance, the usual normal approximation of the trinomial test
+      if (variance > 0.0)
+      {
+        const double score0 = ExpectedScore(m_Settings.Elo0);
+        const double score1 = ExpectedScore(m_Settings.Elo1);
+        status.LLR = games * (score1 - score0) * (2.0 * score - score0 - score1) / (2.0 * variance);
+      }
+
+      if (status.LLR >= status.UpperBound)
+        status.SPRT = SPRTResult::AcceptH1;
+      else if (status.LLR <= status.LowerBound)
+        status.SPRT = SPRTResult::AcceptH0;
+
+      if (status.SPRT != SPRTResult::Running && !m_Stop)
+      {
+        YK_INFO("[ENGINE] SPRT accepted {} after {} games, LLR {:.2f}", (status.SPRT == SPRTResult::AcceptH1) ? "H1" : "H0", status.GetGames(), status.LLR);
+        m_Stop = true;
+      }
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GameLogic/Chess/Engine/Search.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    struct MatchEngine
+    {
+      std::string Name;
+      SearchOptions Options;
+      std::shared_ptr<const NNUE::Network> Network;
+      size_t HashMB = 16;
+    };
+
+    struct MatchSettings
+    {
+      int32_t Concurrency = 1; // Games played at once, each one on its own core
+      int32_t Games = 1000;    // Rounded up to whole pairs, the same opening is played with both colours in turn
+      std::vector<std::string> Openings; // FENs, the start position when empty
+
+      // Per side, the clock is charged with the time each search reports
+      int64_t Time = 10000;
+      int64_t Increment = 100;
+
+      // Adjudication, a game is also decided as soon as the endgame tables know its result
+      int32_t MaxPlies = 400;
+      int32_t ResignScore = 1000; // Both engines agree for this many moves each
+      int32_t ResignMoves = 3;
+      int32_t DrawScore = 10;     // Both engines within it for this many moves each, not before the draw ply
+      int32_t DrawMoves = 8;
+      int32_t DrawPly = 80;
+
+      // Sequential probability ratio test of the first engine being Elo1 rather than Elo0 stronger
+      double Elo0 = 0.0;
+      double Elo1 = 5.0;
+      double Alpha = 0.05;
+      double Beta = 0.05;
+    };
+
+    enum class SPRTResult : uint8_t
+    {
+      Running,
+      AcceptH0, // The first engine is not the stronger one
+      AcceptH1
+    };
+
+    // From the first engine's point of view
+    struct MatchStatus
+    {
+      int32_t Wins = 0;
+      int32_t Losses = 0;
+      int32_t Draws = 0;
+      int32_t TimeLosses = 0; // Either side
+
+      double Elo = 0.0;
+      double EloError = 0.0; // 95% interval
+      double LLR = 0.0;
+      double LowerBound = 0.0;
+      double UpperBound = 0.0;
+      SPRTResult SPRT = SPRTResult::Running;
+      bool Finished = false;
+
+      int32_t GetGames() const { return Wins + Losses + Draws; }
+    };
+
+    // Plays one engine configuration against another, many games at once, and stops early once the SPRT decides
+    class Match
+    {
+    public:
+      ~Match();
+
+      static std::shared_ptr<Match> Create(const MatchEngine& first, const MatchEngine& second, const MatchSettings& settings);
+
+      // One FEN per line, extra EPD operations ignored, or games whose moves are played out to their last position
+      static std::vector<std::string> LoadOpenings(const std::filesystem::path& path);
+
+      void Start();
+      void Stop();
+      void Wait();
+      bool IsRunning() const { return m_Running.load(); }
+
+      MatchStatus GetStatus() const;
+
+    private:
+      void Work();
+      // Result of the game for the first engine, 2 for a win, 1 for a draw and 0 for a loss
+      int32_t PlayGame(int32_t game, Search& first, Search& second);
+      void Record(int32_t result, bool time_loss);
+
+    private:
+      Match() = default;
+      Match(const Match&) = delete;
+      Match& operator=(const Match&) = delete;
+      Match(Match&&) = delete;
+      Match& operator=(Match&&) = delete;
+
+    private:
+      MatchEngine m_Engines[2];
+      MatchSettings m_Settings;
+
+      std::vector<std::thread> m_Workers;
+      std::atomic<int32_t> m_NextGame = 0;
+      std::atomic<int32_t> m_ActiveWorkers = 0;
+      std::atomic<bool> m_Stop = false;
+      std::atomic<bool> m_Running = false;
+
+      mutable std::mutex m_StatusMutex;
+      MatchStatus m_Status;
+    };
+  }
+}
\ No newline at end of file
@@ -0,0 +1,415 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/MateSolver.h"
+#include "GameLogic/Chess/Engine/MoveGen.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      constexpr uint32_t Infinite = 1U << 30;
+
+      // Collection starts once the table is this full and goes on until it is down to the target
+      constexpr size_t CollectPermille = 900;
+      constexpr size_t TargetPermille = 600;
+
+      // Threshold of the best child is raised past the second best by this fraction, so the search does not flip
+      // between two siblings of nearly the same number on every iteration
+      constexpr uint32_t EpsilonDivisor = 4;
+
+      uint32_t Add(uint32_t a, uint32_t b)
+      {
+        if (a >= Infinite || b >= Infinite)
+          return Infinite;
+        return static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(a) + b, Infinite - 1));
+      }
+
+      struct Child
+      {
+        Chess::Move Move;
+        uint32_t Proof = 1;
+        uint32_t Disproof = 1;
+        uint8_t Distance = 0;
+      };
+    }
+
+    MateSolver::~MateSolver()
+    {
+      LargePages::Free(m_Allocation);
+    }
+
+    std::shared_ptr<MateSolver> MateSolver::Create(size_t table_mb)
+    {
+      std::shared_ptr<MateSolver> solver(new MateSolver());
+      const size_t clusters = std::max<size_t>((table_mb << 20) / (ClusterSize * sizeof(Entry)), 1);
+      solver->m_Allocation = LargePages::Allocate(clusters * ClusterSize * sizeof(Entry));
+      YK_ASSERT(solver->m_Allocation.Memory, "[SYSTEM] Failed to allocate the mate solver table");
+
+      solver->m_Entries = static_cast<Entry*>(solver->m_Allocation.Memory);
+      solver->m_ClusterCount = clusters;
+      std::fill(solver->m_Entries, solver->m_Entries + clusters * ClusterSize, Entry());
+      return solver;
+    }
+
+    MateResult MateSolver::Solve(const Position& position, int32_t max_mate, uint64_t max_nodes)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      MateResult result;
+      m_Position = position;
+      m_Nodes = 0;
+      m_MaxNodes = max_nodes;
+      m_Stop = false;
+      const size_t collections = m_Collections;
+
+      // Every proof gives a shorter limit to try, until one is disproven. What the longer limits proved and disproved
+      // stays valid for the shorter ones, so each round starts from most of the work of the one before
+      for (int32_t remaining = 2 * std::clamp(max_mate, 1, MaxMate) - 1; remaining >= 1 && !m_Stop;)
+      {
+        uint32_t proof = 1;
+        uint32_t disproof = 1;
+        uint8_t distance = 0;
+        MateSolver::Search(remaining, 0, true, Infinite, Infinite, proof, disproof, distance);
+
+        if (proof == 0)
+        {
+          result.Found = true;
+          result.MateIn = (distance + 1) / 2;
+          result.PV.clear();
+          MateSolver::ExtractPV(distance, true, result.PV);
+          remaining = distance - 2;
+        }
+        else
+        {
+          result.Disproven = disproof == 0 && !result.Found;
+          break;
+        }
+      }
+
+      result.Nodes = m_Nodes;
+      result.Collections = m_Collections - collections;
+      result.Time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+      return result;
+    }
+
+    void MateSolver::Search(int32_t remaining, int32_t ply, bool attacker, uint32_t proof_threshold, uint32_t disproof_threshold,
+      uint32_t& proof, uint32_t& disproof, uint8_t& distance)
+    {
+      const uint64_t nodesBefore = m_Nodes++;
+      if (m_Nodes >= m_MaxNodes)
+        m_Stop = true;
+
+      // Not stored, whether a repetition happens depends on the path
+      if (ply && m_Position.IsDraw(ply))
+      {
+        proof = Infinite;
+        disproof = 0;
+        return;
+      }
+
+      // Out of plies with the attacker to move, a mate had to be on the board by now
+      if (attacker && remaining == 0)
+      {
+        proof = Infinite;
+        disproof = 0;
+        MateSolver::Store(m_Position.Key(), remaining, proof, disproof, 0, 1);
+        return;
+      }
+
+      MoveList legal;
+      MoveGen::GenerateLegal(m_Position, legal);
+
+      // The defender out of plies, proven only when already mated
+      if (!attacker && (remaining == 0 || legal.empty()))
+      {
+        const bool mated = legal.empty() && m_Position.InCheck();
+        proof = mated ? 0 : Infinite;
+        disproof = mated ? Infinite : 0;
+        distance = 0;
+        MateSolver::Store(m_Position.Key(), remaining, proof, disproof, distance, 1);
+        return;
+      }
+
+      Child children[MaxMoves];
+      int32_t count = 0;
+      for (const ScoredMove& move : legal)
+      {
+        // With one ply left only a check can still mate
+        if (attacker && remaining == 1 && !m_Position.GivesCheck(move))
+          continue;
+
+        Child& child = children[count++];
+        child.Move = move;
+        m_Position.MakeMove(move);
+        MateSolver::Lookup(m_Position.Key(), remaining - 1, child.Proof, child.Disproof, child.Distance);
+        m_Position.UnmakeMove();
+      }
+
+      // The attacker mated, stalemated or without a check for the last ply
+      if (!count)
+      {
+        proof = Infinite;
+        disproof = 0;
+        MateSolver::Store(m_Position.Key(), remaining, proof, disproof, 0, 1);
+        return;
+      }
+
+      while (true)
+      {
+        // The attacker needs one child proven and all of them to disprove, the defender the other way round
+        int32_t best = 0;
+        uint32_t bestNumber = UINT32_MAX;
+        uint32_t second = Infinite;
+        proof = attacker ? Infinite : 0;
+        disproof = attacker ? 0 : Infinite;
+        for (int32_t i = 0; i < count; i++)
+        {
+          const Child& child = children[i];
+          const uint32_t number = attacker ? child.Proof : child.Disproof;
+          if (number < bestNumber)
+          {
+            second = std::min(second, bestNumber);
+            best = i;
+            bestNumber = number;
+          }
+          else
+            second = std::min(second, number);
+
+          if (attacker)
+          {
+            proof = std::min(proof, child.Proof);
+            disproof = Add(disproof, child.Disproof);
+          }
+          else
+          {
+            proof = Add(proof, child.Proof);
+            disproof = std::min(disproof, child.Disproof);
+          }
+        }
+
+        if (proof >= proof_threshold || disproof >= disproof_threshold || m_Stop)
+          break;
+
+        Child& child = children[best];
+        const uint32_t widened = std::min(Add(second, second / EpsilonDivisor), Infinite - 1) + 1;
+        uint32_t childProofThreshold;
+        uint32_t childDisproofThreshold;
+        if (attacker)
+        {
+          childProofThreshold = std::min(proof_threshold, widened);
+          childDisproofThreshold = Add(disproof_threshold - disproof, child.Disproof);
+        }
+        else
+        {
+          childDisproofThreshold = std::min(disproof_threshold, widened);
+          childProofThreshold = Add(proof_threshold - proof, child.Proof);
+        }
+
+        m_Position.MakeMove(child.Move);
+        MateSolver::Search(remaining - 1, ply + 1, !attacker, childProofThreshold, childDisproofThreshold, child.Proof, child.Disproof, child.Distance);
+        m_Position.UnmakeMove();
+      }
+
+      // The attacker takes the quickest mate it knows, the defender resists the longest
+      distance = 0;
+      if (proof == 0)
+      {
+        uint8_t chosen = attacker ? 255 : 0;
+        for (int32_t i = 0; i < count; i++)
+          if (children[i].Proof == 0)
+            chosen = attacker ? std::min(chosen, children[i].Distance) : std::max(chosen, children[i].Distance);
+        distance = static_cast<uint8_t>(chosen + 1);
+      }
+
+      MateSolver::Store(m_Position.Key(), remaining, proof, disproof, distance, m_Nodes - nodesBefore);
+    }
+
+    void MateSolver::Lookup(uint64_t key, int32_t remaining, uint32_t& proof, uint32_t& disproof, uint8_t& distance) const
+    {
+      proof = 1;
+      disproof = 1;
+      distance = 0;
+
+      const Entry* cluster = m_Entries + (key % m_ClusterCount) * ClusterSize;
+      for (size_t i = 0; i < ClusterSize; i++)
+      {
+        const Entry& entry = cluster[i];
+        if (!entry.Work || entry.Key != key)
+          continue;
+
+        // A mate stays a mate with more plies to spare, a failure stays one with fewer, anything else was for its own limit
+        const bool valid = (entry.Proof == 0) ? entry.Distance <= remaining
+          : (entry.Disproof == 0) ? entry.Remaining >= remaining : entry.Remaining == remaining;
+        if (valid)
+        {
+          proof = entry.Proof;
+          disproof = entry.Disproof;
+          distance = entry.Distance;
+        }
+        return;
+      }
+    }
+
+    void MateSolver::Store(uint64_t key, int32_t remaining, uint32_t proof, uint32_t disproof, uint8_t distance, uint64_t work)
+    {
+      if (m_Used * 1000 >= m_ClusterCount * ClusterSize * CollectPermille)
+        MateSolver::CollectGarbage();
+
+      // The same position, else a free slot, else whatever took the least work to find
+      Entry* cluster = m_Entries + (key % m_ClusterCount) * ClusterSize;
+      Entry* replace = cluster;
+      for (size_t i = 0; i < ClusterSize; i++)
+      {
+        Entry& entry = cluster[i];
+        if (entry.Work && entry.Key == key)
+        {
+          // A shorter limit must not throw away the longer one's proof or the other way round, nor a longer mate a shorter one
+          if ((entry.Proof == 0 && (proof != 0 || entry.Distance <= distance)) || (entry.Disproof == 0 && disproof != 0 && entry.Remaining >= remaining))
+            return;
+          replace = &entry;
+          break;
+        }
+        if (!entry.Work)
+        {
+          if (replace->Work)
+            replace = &entry;
+        }
+        else if (replace->Work && entry.Work < replace->Work)
+          replace = &entry;
+      }
+
+      // Searching the same position again adds to its work
+      if (!replace->Work)
+        m_Used++;
+      else if (replace->Key == key)
+        work += replace->Work;
+      replace->Key = key;
+      replace->Proof = proof;
+      replace->Disproof = disproof;
+      replace->Work = static_cast<uint32_t>(std::clamp<uint64_t>(work, 1, UINT32_MAX));
+      replace->Remaining = static_cast<uint8_t>(remaining);
+      replace->Distance = distance;
+    }
+
+    void MateSolver::CollectGarbage()
+    {
+      // Cheap entries go first, the bar doubles until enough of the table is free again
+      const size_t capacity = m_ClusterCount * ClusterSize;
+      for (uint32_t threshold = 2; m_Used * 1000 > capacity * TargetPermille && threshold; threshold <<= 1)
+      {
+        for (size_t i = 0; i < capacity; i++)
+        {
+          Entry& entry = m_Entries[i];
+          if (entry.Work && entry.Work < threshold)
+          {
+            entry = Entry();
+            m_Used--;
+          }
+        }
+      }
+      m_Collections++;
+    }
+
+    void MateSolver::ExtractPV(int32_t remaining, bool attacker, std::vector<Move>& pv)
+    {
+      if (remaining <= 0 || static_cast<int32_t>(pv.size()) >= 2 * MaxMate)
+        return;
+
+      MoveList legal;
+      MoveGen::GenerateLegal(m_Position, legal);
+
+      Move chosen = Move::None();
+      int32_t chosenDistance = attacker ? 256 : -1;
+      for (const ScoredMove& move : legal)
+      {
+        uint32_t proof = 0;
+        uint32_t disproof = 0;
+        uint8_t distance = 0;
+        m_Position.MakeMove(move);
+        MateSolver::Lookup(m_Position.Key(), remaining - 1, proof, disproof, distance);
+        m_Position.UnmakeMove();
+
+        if (proof == 0 && (attacker ? distance < chosenDistance : distance > chosenDistance))
+        {
+          chosen = move;
+          chosenDistance = distance;
+        }
+      }
+
+      if (!chosen)
+        return;
+      pv.push_back(chosen);
+      m_Position.MakeMove(chosen);
+      MateSolver::ExtractPV(remaining - 1, !attacker, pv);
+      m_Position.UnmakeMove();
+    }
+
+    MatePuzzleReport MateSolver::SolveFile(const std::filesystem::path& path, int32_t threads, size_t table_mb, uint64_t max_nodes)
+    {
+      MatePuzzleReport report;
+      std::ifstream file(path);
+      if (!file)
+      {
+        YK_WARN("[ENGINE] Puzzle file '{}' not found", path.string());
+        return report;
+      }
+
+      // The first four fields are the position, an EPD dm operation the expected mate
+      std::string line;
+      while (std::getline(file, line))
+      {
+        std::istringstream fields(line);
+        std::string board, side, castling, enPassant;
+        if (!(fields >> board >> side >> castling >> enPassant))
+          continue;
+        if (enPassant.back() == ';')
+          enPassant.pop_back();
+
+        MatePuzzle puzzle;
+        puzzle.FEN = board + " " + side + " " + castling + " " + enPassant + " 0 1";
+        const size_t dm = line.find(" dm ");
+        if (dm != std::string::npos)
+          puzzle.ExpectedMate = std::atoi(line.c_str() + dm + 4);
+        report.Puzzles.push_back(std::move(puzzle));
+      }
+
+      const auto start = std::chrono::steady_clock::now();
+      std::atomic<size_t> next = 0;
+      auto work = [&]()
+        {
+        std::shared_ptr<MateSolver> solver = MateSolver::Create(table_mb);
+        for (size_t index = next++; index < report.Puzzles.size(); index = next++)
+        {
+          MatePuzzle& puzzle = report.Puzzles[index];
+          Position position;
+          if (position.SetFEN(puzzle.FEN))
+            puzzle.Result = solver->Solve(position, puzzle.ExpectedMate ? puzzle.ExpectedMate : DefaultMaxMate, max_nodes);
+        }
+        };
+
+      std::vector<std::thread> workers;
+      for (int32_t i = 0; i < std::max(threads, 1); i++)
+        workers.emplace_back(work);
+      for (std::thread& worker : workers)
+        worker.join();
+
+      for (const MatePuzzle& puzzle : report.Puzzles)
+      {
+        report.Solved += puzzle.Result.Found && (!puzzle.ExpectedMate || puzzle.Result.MateIn <= puzzle.ExpectedMate);
+        report.Nodes += puzzle.Result.Nodes;
+      }
+      report.Time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+      YK_INFO("[ENGINE] Solved {} of {} mate puzzles in {}ms, {} nodes", report.Solved, report.Puzzles.size(), report.Time, report.Nodes);
+      return report;
+    }
+  }
+}
\ No newline at end of file
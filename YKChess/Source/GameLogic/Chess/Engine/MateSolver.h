@@ -0,0 +1,105 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GameLogic/Chess/Engine/LargePages.h"
+#include "GameLogic/Chess/Engine/Position.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    struct MateResult
+    {
+      bool Found = false;
+      bool Disproven = false; // No mate within the limit exists, both false when the node budget ran out first
+      int32_t MateIn = 0;     // Moves of the side to move
+      std::vector<Move> PV;   // As far as the table still knows it, the defence resisting longest
+      uint64_t Nodes = 0;
+      int64_t Time = 0;
+      size_t Collections = 0; // Garbage collections of the node table
+    };
+
+    struct MatePuzzle
+    {
+      std::string FEN;
+      int32_t ExpectedMate = 0; // From the dm operation, 0 when the file does not say
+      MateResult Result;
+    };
+
+    struct MatePuzzleReport
+    {
+      std::vector<MatePuzzle> Puzzles;
+      int32_t Solved = 0; // Mate found, and no longer than expected
+      uint64_t Nodes = 0;
+      int64_t Time = 0;
+    };
+
+    // Depth-first proof-number search for forced mates of the side to move. Proof and disproof numbers live in a table
+    // of their own, bounded in size, where the entries that took the least work are collected when it fills up.
+    // Proofs remember their distance to mate, so the shortest mate is found by proving again with fewer plies each time.
+    // Repetitions count as failures to mate and are never stored, the usual simplification of the path dependency
+    class MateSolver
+    {
+    public:
+      static constexpr int32_t DefaultMaxMate = 16;
+      static constexpr int32_t MaxMate = 32;
+      static constexpr uint64_t DefaultMaxNodes = 10000000;
+
+      ~MateSolver();
+
+      static std::shared_ptr<MateSolver> Create(size_t table_mb);
+
+      MateResult Solve(const Position& position, int32_t max_mate = DefaultMaxMate, uint64_t max_nodes = DefaultMaxNodes);
+
+      // One EPD or FEN position per line, a dm operation gives the expected mate and the limit of its search.
+      // Puzzles are shared out between the threads, each with a solver and a table of its own
+      static MatePuzzleReport SolveFile(const std::filesystem::path& path, int32_t threads, size_t table_mb, uint64_t max_nodes = DefaultMaxNodes);
+
+    private:
+      struct Entry
+      {
+        uint64_t Key = 0ULL;
+        uint32_t Proof = 0;
+        uint32_t Disproof = 0;
+        uint32_t Work = 0;      // Nodes spent below it, zero for a free slot
+        uint8_t Remaining = 0;  // Plies left when it was searched
+        uint8_t Distance = 0;   // Plies to mate once proven
+      };
+
+      static constexpr size_t ClusterSize = 4;
+
+      void Search(int32_t remaining, int32_t ply, bool attacker, uint32_t proof_threshold, uint32_t disproof_threshold,
+        uint32_t& proof, uint32_t& disproof, uint8_t& distance);
+
+      // Numbers of the position for that many plies left, one and one when nothing valid is known
+      void Lookup(uint64_t key, int32_t remaining, uint32_t& proof, uint32_t& disproof, uint8_t& distance) const;
+      void Store(uint64_t key, int32_t remaining, uint32_t proof, uint32_t disproof, uint8_t distance, uint64_t work);
+      void CollectGarbage();
+
+      void ExtractPV(int32_t remaining, bool attacker, std::vector<Move>& pv);
+
+    private:
+      MateSolver() = default;
+      MateSolver(const MateSolver&) = delete;
+      MateSolver& operator=(const MateSolver&) = delete;
+      MateSolver(MateSolver&&) = delete;
+      MateSolver& operator=(MateSolver&&) = delete;
+
+    private:
+      PageAllocation m_Allocation;
+      Entry* m_Entries = nullptr;
+      size_t m_ClusterCount = 0;
+      size_t m_Used = 0;
+      size_t m_Collections = 0;
+
+      Position m_Position;
+      uint64_t m_Nodes = 0;
+      uint64_t m_MaxNodes = 0;
+      bool m_Stop = false;
+    };
+  }
+}
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include "GameLogic/Chess/Engine/MoveGen.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      ScoredMove* AddPromotions(ScoredMove* list, Square from, Square to, bool capture)
+      {
+        const uint8_t base = static_cast<uint8_t>(capture ? MoveFlag::KnightPromotionCapture : MoveFlag::KnightPromotion);
+
+        // Queen first, it is the one worth trying early
+        for (int32_t offset = 3; offset >= 0; offset--)
+          *list++ = Move(from, to, static_cast<MoveFlag>(base + offset));
+        return list;
+      }
+
+      template<Color Us, GenType Type>
+      ScoredMove* GeneratePawnMoves(const Position& position, ScoredMove* list)
+      {
+        constexpr Color Them = ~Us;
+        constexpr int32_t Up = PawnPush(Us);
+        constexpr int32_t UpRight = (Us == White) ? 9 : -7;
+        constexpr int32_t UpLeft = (Us == White) ? 7 : -9;
+        constexpr Bitboard PromotionRank = (Us == White) ? Rank7BB : Rank2BB;
+        constexpr Bitboard DoublePushRank = (Us == White) ? Rank3BB : Rank6BB;
+
+        const Bitboard empty = ~position.Pieces();
+        const Bitboard enemies = position.Pieces(Them);
+        const Bitboard pawns = position.Pieces(Us, Pawn) & ~PromotionRank;
+        const Bitboard promoting = position.Pieces(Us, Pawn) & PromotionRank;
+
+        if constexpr (Type != GenType::Captures)
+        {
+          Bitboard single = Shift<Up>(pawns) & empty;
+          Bitboard twice = Shift<Up>(single & DoublePushRank) & empty;
+
+          while (single)
+          {
+            const Square to = PopLSB(single);
+            *list++ = Move(to - Up, to);
+          }
+          while (twice)
+          {
+            const Square to = PopLSB(twice);
+            *list++ = Move(to - 2 * Up, to, MoveFlag::DoublePawnPush);
+          }
+        }
+
+        if constexpr (Type != GenType::Quiets)
+        {
+          if (promoting)
+          {
+            Bitboard pushes = Shift<Up>(promoting) & empty;
+            Bitboard right = Shift<UpRight>(promoting) & enemies;
+            Bitboard left = Shift<UpLeft>(promoting) & enemies;
+
+            while (pushes)
+            {
+              const Square to = PopLSB(pushes);
+              list = AddPromotions(list, to - Up, to, false);
+            }
+            while (right)
+            {
+              const Square to = PopLSB(right);
+              list = AddPromotions(list, to - UpRight, to, true);
+            }
+            while (left)
+            {
+              const Square to = PopLSB(left);
+              list = AddPromotions(list, to - UpLeft, to, true);
+            }
+          }
+
+          Bitboard right = Shift<UpRight>(pawns) & enemies;
+          Bitboard left = Shift<UpLeft>(pawns) & enemies;
+
+          while (right)
+          {
+            const Square to = PopLSB(right);
+            *list++ = Move(to - UpRight, to, MoveFlag::Capture);
+          }
+          while (left)
+          {
+            const Square to = PopLSB(left);
+            *list++ = Move(to - UpLeft, to, MoveFlag::Capture);
+          }
+
+          if (position.EnPassantSquare() != NoSquare)
+          {
+            Bitboard attackers = pawns & Bitboards::PawnAttacks(Them, position.EnPassantSquare());
+            while (attackers)
+              *list++ = Move(PopLSB(attackers), position.EnPassantSquare(), MoveFlag::EnPassant);
+          }
+        }
+
+        return list;
+      }
+
+      template<Color Us, GenType Type>
+      ScoredMove* GeneratePieceMoves(const Position& position, ScoredMove* list)
+      {
+        const Bitboard occupied = position.Pieces();
+        const Bitboard enemies = position.Pieces(~Us);
+
+        Bitboard targets = ~position.Pieces(Us);
+        if constexpr (Type == GenType::Captures)
+          targets = enemies;
+        else if constexpr (Type == GenType::Quiets)
+          targets = ~occupied;
+
+        for (PieceType type : { Knight, Bishop, Rook, Queen, King })
+        {
+          Bitboard pieces = position.Pieces(Us, type);
+          while (pieces)
+          {
+            const Square from = PopLSB(pieces);
+            Bitboard attacks = Bitboards::Attacks(type, from, occupied) & targets;
+            while (attacks)
+            {
+              const Square to = PopLSB(attacks);
+              *list++ = Move(from, to, (enemies & SquareBB(to)) ? MoveFlag::Capture : MoveFlag::Quiet);
+            }
+          }
+        }
+
+        if constexpr (Type != GenType::Captures)
+        {
+          constexpr Square KingStart = RelativeSquare(Us, 4);
+          constexpr uint8_t KingSide = (Us == White) ? WhiteKingSide : BlackKingSide;
+          constexpr uint8_t QueenSide = (Us == White) ? WhiteQueenSide : BlackQueenSide;
+
+          if ((position.CastlingRights() & KingSide) && !(Bitboards::Between(KingStart, KingStart + 3) & occupied))
+            *list++ = Move(KingStart, KingStart + 2, MoveFlag::KingCastle);
+          if ((position.CastlingRights() & QueenSide) && !(Bitboards::Between(KingStart, KingStart - 4) & occupied))
+            *list++ = Move(KingStart, KingStart - 2, MoveFlag::QueenCastle);
+        }
+
+        return list;
+      }
+    }
+
+    namespace MoveGen
+    {
+      template<GenType Type>
+      ScoredMove* Generate(const Position& position, ScoredMove* list)
+      {
+        if (position.SideToMove() == White)
+        {
+          list = GeneratePawnMoves<White, Type>(position, list);
+          return GeneratePieceMoves<White, Type>(position, list);
+        }
+
+        list = GeneratePawnMoves<Black, Type>(position, list);
+        return GeneratePieceMoves<Black, Type>(position, list);
+      }
+
+      template ScoredMove* Generate<GenType::Captures>(const Position&, ScoredMove*);
+      template ScoredMove* Generate<GenType::Quiets>(const Position&, ScoredMove*);
+      template ScoredMove* Generate<GenType::All>(const Position&, ScoredMove*);
+
+      void GenerateLegal(const Position& position, MoveList& list)
+      {
+        ScoredMove* last = MoveGen::Generate<GenType::All>(position, list.begin());
+
+        ScoredMove* current = list.begin();
+        while (current != last)
+        {
+          if (position.IsLegal(*current))
+            current++;
+          else
+            *current = *--last;
+        }
+
+        list.SetEnd(last);
+      }
+
+      uint64_t Perft(Position& position, int32_t depth)
+      {
+        MoveList moves;
+        MoveGen::GenerateLegal(position, moves);
+
+        if (depth <= 1)
+          return depth == 1 ? moves.size() : 1;
+
+        uint64_t nodes = 0;
+        for (const ScoredMove& move : moves)
+        {
+          position.MakeMove(move);
+          nodes += MoveGen::Perft(position, depth - 1);
+          position.UnmakeMove();
+        }
+        return nodes;
+      }
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "GameLogic/Chess/Engine/Position.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    enum class GenType
+    {
+      Captures, // Captures and every promotion
+      Quiets,   // Everything else, castling included
+      All
+    };
+
+    class MoveList
+    {
+    public:
+      ScoredMove* begin() { return m_Moves; }
+      ScoredMove* end() { return m_Last; }
+      const ScoredMove* begin() const { return m_Moves; }
+      const ScoredMove* end() const { return m_Last; }
+
+      size_t size() const { return m_Last - m_Moves; }
+      bool empty() const { return m_Last == m_Moves; }
+      const ScoredMove& operator[](size_t index) const { return m_Moves[index]; }
+
+      bool Contains(Move move) const
+      {
+        for (const ScoredMove* it = m_Moves; it != m_Last; it++)
+          if (*it == move)
+            return true;
+        return false;
+      }
+
+      void SetEnd(ScoredMove* last) { m_Last = last; }
+
+    private:
+      ScoredMove m_Moves[MaxMoves];
+      ScoredMove* m_Last = m_Moves;
+    };
+
+    namespace MoveGen
+    {
+      // Pseudo-legal generation, legality is checked with Position::IsLegal()
+      template<GenType Type>
+      ScoredMove* Generate(const Position& position, ScoredMove* list);
+
+      void GenerateLegal(const Position& position, MoveList& list);
+
+      uint64_t Perft(Position& position, int32_t depth);
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include <cstring>
+
+#include "GameLogic/Chess/Engine/MoveOrdering.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    void MoveOrdering::Clear()
+    {
+      std::memset(static_cast<void*>(m_Killers.data()), 0, sizeof(m_Killers));
+      std::memset(static_cast<void*>(m_CounterMoves.data()), 0, sizeof(m_CounterMoves));
+      std::memset(m_MainHistory.data(), 0, sizeof(m_MainHistory));
+      std::memset(m_ContinuationHistory.data(), 0, sizeof(m_ContinuationHistory));
+    }
+
+    void MoveOrdering::ClearKillers()
+    {
+      std::memset(static_cast<void*>(m_Killers.data()), 0, sizeof(m_Killers));
+    }
+
+    void MoveOrdering::UpdateQuietStats(Color color, int32_t ply, int32_t depth, Piece piece, Move best_move, const Move* failed, const Piece* failed_pieces, int32_t failed_count, PieceToHistory* const* continuation, Piece previous_piece, Square previous_to)
+    {
+      const int32_t bonus = HistoryBonus(depth);
+
+      if (m_Killers[ply][0] != best_move)
+      {
+        m_Killers[ply][1] = m_Killers[ply][0];
+        m_Killers[ply][0] = best_move;
+      }
+
+      if (previous_piece != NoPiece)
+        m_CounterMoves[previous_piece][previous_to] = best_move;
+
+      UpdateHistory(m_MainHistory[color][best_move.FromTo()], bonus);
+      MoveOrdering::UpdateContinuation(continuation, piece, best_move.To(), bonus);
+
+      for (int32_t i = 0; i < failed_count; i++)
+      {
+        UpdateHistory(m_MainHistory[color][failed[i].FromTo()], -bonus);
+        MoveOrdering::UpdateContinuation(continuation, failed_pieces[i], failed[i].To(), -bonus);
+      }
+    }
+
+    void MoveOrdering::UpdateContinuation(PieceToHistory* const* continuation, Piece piece, Square to, int32_t bonus)
+    {
+      // The sentinel slice stays zero, it stands in for plies that have no previous move
+      for (int32_t i = 0; i < 2; i++)
+        if (continuation[i] != MoveOrdering::GetSentinelTable())
+          UpdateHistory((*continuation[i])[piece][to], bonus);
+    }
+  }
+}
\ No newline at end of file
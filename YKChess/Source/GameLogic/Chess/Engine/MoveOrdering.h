@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+
+#include "GameLogic/Chess/Engine/Types.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    constexpr int32_t HistoryMax = 16384;
+
+    // [piece][to] slice of the continuation history, the search stack keeps one pointer per ply
+    using PieceToHistory = std::array<std::array<int16_t, 64>, PieceCount>;
+
+    // Gravity update: the entry moves towards the bonus and can never leave [-HistoryMax, HistoryMax]
+    inline void UpdateHistory(int16_t& entry, int32_t bonus)
+    {
+      const int32_t clamped = std::clamp(bonus, -HistoryMax, HistoryMax);
+      entry += static_cast<int16_t>(clamped - entry * std::abs(clamped) / HistoryMax);
+    }
+
+    inline int32_t HistoryBonus(int32_t depth)
+    {
+      return std::min(16 * depth * depth + 32 * depth + 16, 1600);
+    }
+
+    // Per-thread quiet move ordering statistics. Every table is a flat array so that
+    // clearing between games is a single memset over a couple of megabytes.
+    class alignas(64) MoveOrdering
+    {
+    public:
+      MoveOrdering() { MoveOrdering::Clear(); }
+
+      void Clear();
+      void ClearKillers();
+
+      Move GetKiller(int32_t ply, int32_t slot) const { return m_Killers[ply][slot]; }
+      Move GetCounterMove(Piece previous_piece, Square previous_to) const { return m_CounterMoves[previous_piece][previous_to]; }
+      int32_t GetMainHistory(Color color, Move move) const { return m_MainHistory[color][move.FromTo()]; }
+
+      PieceToHistory* GetContinuationTable(Piece piece, Square to) { return &m_ContinuationHistory[piece][to]; }
+      PieceToHistory* GetSentinelTable() { return &m_ContinuationHistory[NoPiece][0]; }
+
+      // History score of a quiet move; continuation[0] is the table of the previous ply, continuation[1] two plies back
+      int32_t QuietScore(Color color, Piece piece, Move move, const PieceToHistory* const* continuation) const
+      {
+        return m_MainHistory[color][move.FromTo()]
+          + 2 * (*continuation[0])[piece][move.To()]
+          + (*continuation[1])[piece][move.To()];
+      }
+
+      // Called when a quiet move caused a beta cutoff, every quiet tried before it gets the malus
+      void UpdateQuietStats(Color color, int32_t ply, int32_t depth, Piece piece, Move best_move, const Move* failed, const Piece* failed_pieces, int32_t failed_count, PieceToHistory* const* continuation, Piece previous_piece, Square previous_to);
+
+    private:
+      void UpdateContinuation(PieceToHistory* const* continuation, Piece piece, Square to, int32_t bonus);
+
+    private:
+      std::array<std::array<Move, 2>, MaxPly + 2> m_Killers;
+      std::array<std::array<Move, 64>, PieceCount> m_CounterMoves;
+      alignas(64) std::array<std::array<int16_t, 64 * 64>, ColorCount> m_MainHistory;
+      alignas(64) std::array<std::array<PieceToHistory, 64>, PieceCount> m_ContinuationHistory;
+    };
+  }
+}
\ No newline at end of file
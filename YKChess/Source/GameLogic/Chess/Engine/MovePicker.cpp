@@ -0,0 +1,203 @@
+#include <algorithm>
+
+#include "GameLogic/Chess/Engine/MovePicker.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    MovePicker::MovePicker(const Position& position, const MoveOrdering& ordering, Move tt_move, int32_t ply, const PieceToHistory* const* continuation, Move counter_move)
+      : m_Position(position), m_Ordering(ordering), m_Continuation(continuation)
+    {
+      m_TTMove = (tt_move && position.IsPseudoLegal(tt_move)) ? tt_move : Move::None();
+      m_Refutations[0] = ordering.GetKiller(ply, 0);
+      m_Refutations[1] = ordering.GetKiller(ply, 1);
+      m_Refutations[2] = counter_move;
+
+      m_Stage = position.InCheck() ? Stage::EvasionTT : Stage::MainTT;
+      if (!m_TTMove)
+        m_Stage = static_cast<Stage>(static_cast<uint8_t>(m_Stage) + 1);
+    }
+
+    MovePicker::MovePicker(const Position& position, const MoveOrdering& ordering, Move tt_move, const PieceToHistory* const* continuation)
+      : m_Position(position), m_Ordering(ordering), m_Continuation(continuation)
+    {
+      m_TTMove = (tt_move && position.IsPseudoLegal(tt_move) && (position.InCheck() || !tt_move.IsQuiet())) ? tt_move : Move::None();
+
+      m_Stage = position.InCheck() ? Stage::EvasionTT : Stage::QSearchTT;
+      if (!m_TTMove)
+        m_Stage = static_cast<Stage>(static_cast<uint8_t>(m_Stage) + 1);
+    }
+
+    Move MovePicker::Next(bool skip_quiets)
+    {
+      switch (m_Stage)
+      {
+      case Stage::MainTT:
+      case Stage::EvasionTT:
+      case Stage::QSearchTT:
+      {
+        m_Stage = static_cast<Stage>(static_cast<uint8_t>(m_Stage) + 1);
+        m_LastSource = MoveSource::TTMove;
+        return m_TTMove;
+      }
+      case Stage::CaptureInit:
+      case Stage::QCaptureInit:
+      {
+        m_Current = m_BadCapturesEnd = m_Moves;
+        m_End = MoveGen::Generate<GenType::Captures>(m_Position, m_Moves);
+        MovePicker::ScoreCaptures();
+        m_Stage = static_cast<Stage>(static_cast<uint8_t>(m_Stage) + 1);
+        return MovePicker::Next(skip_quiets);
+      }
+      case Stage::GoodCaptures:
+      {
+        while (m_Current < m_End)
+        {
+          const Move move = *MovePicker::PickBest(m_Current++, m_End);
+          if (move == m_TTMove)
+            continue;
+
+          // Losing captures wait until the quiet moves have been tried
+          if (m_Position.SEEGreaterEqual(move, 0))
+          {
+            m_LastSource = MoveSource::GoodCapture;
+            return move;
+          }
+          *m_BadCapturesEnd++ = move;
+        }
+
+        m_Stage = Stage::FirstKiller;
+        return MovePicker::Next(skip_quiets);
+      }
+      case Stage::FirstKiller:
+      case Stage::SecondKiller:
+      case Stage::CounterMove:
+      {
+        const int32_t index = static_cast<uint8_t>(m_Stage) - static_cast<uint8_t>(Stage::FirstKiller);
+        const Move move = m_Refutations[index];
+        m_Stage = static_cast<Stage>(static_cast<uint8_t>(m_Stage) + 1);
+
+        const bool duplicate = (index >= 1 && move == m_Refutations[0]) || (index == 2 && move == m_Refutations[1]);
+        if (move && move != m_TTMove && !duplicate && move.IsQuiet() && m_Position.IsPseudoLegal(move))
+        {
+          m_LastSource = (index == 2) ? MoveSource::CounterMove : MoveSource::Killer;
+          return move;
+        }
+        return MovePicker::Next(skip_quiets);
+      }
+      case Stage::QuietInit:
+      {
+        if (!skip_quiets)
+        {
+          m_Current = m_End;
+          m_End = MoveGen::Generate<GenType::Quiets>(m_Position, m_Current);
+          MovePicker::ScoreQuiets();
+          std::stable_sort(m_Current, m_End, [](const ScoredMove& a, const ScoredMove& b) { return a.Score > b.Score; });
+        }
+        m_Stage = Stage::Quiets;
+        return MovePicker::Next(skip_quiets);
+      }
+      case Stage::Quiets:
+      {
+        while (!skip_quiets && m_Current < m_End)
+        {
+          const Move move = *m_Current++;
+          if (move != m_TTMove && !MovePicker::IsRefutation(move))
+          {
+            m_LastSource = MoveSource::Quiet;
+            return move;
+          }
+        }
+
+        m_Stage = Stage::BadCaptures;
+        m_Current = m_Moves;
+        return MovePicker::Next(skip_quiets);
+      }
+      case Stage::BadCaptures:
+      {
+        if (m_Current < m_BadCapturesEnd)
+        {
+          m_LastSource = MoveSource::BadCapture;
+          return *m_Current++;
+        }
+        m_Stage = Stage::Done;
+        return Move::None();
+      }
+      case Stage::EvasionInit:
+      {
+        m_Current = m_Moves;
+        m_End = MoveGen::Generate<GenType::All>(m_Position, m_Moves);
+        MovePicker::ScoreEvasions();
+        m_Stage = Stage::Evasions;
+        return MovePicker::Next(skip_quiets);
+      }
+      case Stage::Evasions:
+      case Stage::QCaptures:
+      {
+        while (m_Current < m_End)
+        {
+          const Move move = *MovePicker::PickBest(m_Current++, m_End);
+          if (move != m_TTMove)
+          {
+            m_LastSource = (m_Stage == Stage::Evasions) ? MoveSource::Evasion : MoveSource::GoodCapture;
+            return move;
+          }
+        }
+        m_Stage = Stage::Done;
+        return Move::None();
+      }
+      case Stage::Done:
+        return Move::None();
+      }
+
+      return Move::None();
+    }
+
+    void MovePicker::ScoreCaptures()
+    {
+      // MVV-LVA, promotions count as capturing the promoted piece
+      for (ScoredMove* move = m_Current; move < m_End; move++)
+      {
+        const PieceType victim = move->IsEnPassant() ? Pawn : TypeOf(m_Position.PieceOn(move->To()));
+        const PieceType attacker = TypeOf(m_Position.MovedPiece(*move));
+        move->Score = 16 * SEEValue[victim] - SEEValue[attacker] / 100;
+        if (move->IsPromotion())
+          move->Score += 16 * SEEValue[move->PromotionType()];
+      }
+    }
+
+    void MovePicker::ScoreQuiets()
+    {
+      const Color us = m_Position.SideToMove();
+      for (ScoredMove* move = m_Current; move < m_End; move++)
+        move->Score = m_Ordering.QuietScore(us, m_Position.MovedPiece(*move), *move, m_Continuation);
+    }
+
+    void MovePicker::ScoreEvasions()
+    {
+      const Color us = m_Position.SideToMove();
+      for (ScoredMove* move = m_Current; move < m_End; move++)
+      {
+        if (move->IsCapture() || move->IsPromotion())
+        {
+          const PieceType victim = move->IsEnPassant() ? Pawn : TypeOf(m_Position.PieceOn(move->To()));
+          move->Score = (1 << 28) + 16 * SEEValue[victim] - SEEValue[TypeOf(m_Position.MovedPiece(*move))] / 100;
+        }
+        else
+          move->Score = m_Ordering.QuietScore(us, m_Position.MovedPiece(*move), *move, m_Continuation);
+      }
+    }
+
+    ScoredMove* MovePicker::PickBest(ScoredMove* begin, ScoredMove* end)
+    {
+      std::swap(*begin, *std::max_element(begin, end, [](const ScoredMove& a, const ScoredMove& b) { return a.Score < b.Score; }));
+      return begin;
+    }
+
+    bool MovePicker::IsRefutation(Move move) const
+    {
+      return move == m_Refutations[0] || move == m_Refutations[1] || move == m_Refutations[2];
+    }
+  }
+}
\ No newline at end of file
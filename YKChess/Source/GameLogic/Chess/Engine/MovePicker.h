@@ -0,0 +1,68 @@
+#pragma once
+
+#include "GameLogic/Chess/Engine/MoveGen.h"
+#include "GameLogic/Chess/Engine/MoveOrdering.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    // Where a move handed out by the picker came from, used to attribute beta cutoffs
+    enum class MoveSource : uint8_t
+    {
+      TTMove,
+      GoodCapture,
+      Killer,
+      CounterMove,
+      Quiet,
+      BadCapture,
+      Evasion,
+      Count
+    };
+
+    // Hands out moves one at a time, generating captures and quiets lazily so that
+    // an early cutoff never pays for generating and scoring the rest
+    class MovePicker
+    {
+    public:
+      // Main search
+      MovePicker(const Position& position, const MoveOrdering& ordering, Move tt_move, int32_t ply, const PieceToHistory* const* continuation, Move counter_move);
+      // Quiescence search, captures only unless in check
+      MovePicker(const Position& position, const MoveOrdering& ordering, Move tt_move, const PieceToHistory* const* continuation);
+
+      Move Next(bool skip_quiets = false);
+      MoveSource GetLastSource() const { return m_LastSource; }
+
+    private:
+      enum class Stage : uint8_t
+      {
+        MainTT, CaptureInit, GoodCaptures, FirstKiller, SecondKiller, CounterMove, QuietInit, Quiets, BadCaptures,
+        EvasionTT, EvasionInit, Evasions,
+        QSearchTT, QCaptureInit, QCaptures,
+        Done
+      };
+
+      void ScoreCaptures();
+      void ScoreQuiets();
+      void ScoreEvasions();
+      ScoredMove* PickBest(ScoredMove* begin, ScoredMove* end);
+      bool IsRefutation(Move move) const;
+
+    private:
+      const Position& m_Position;
+      const MoveOrdering& m_Ordering;
+      const PieceToHistory* const* m_Continuation;
+
+      Move m_TTMove;
+      Move m_Refutations[3];
+
+      Stage m_Stage;
+      MoveSource m_LastSource = MoveSource::TTMove;
+
+      ScoredMove* m_Current = m_Moves;
+      ScoredMove* m_End = m_Moves;
+      ScoredMove* m_BadCapturesEnd = m_Moves;
+      ScoredMove m_Moves[MaxMoves];
+    };
+  }
+}
\ No newline at end of file
@@ -0,0 +1,490 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/MoveGen.h"
+#include "GameLogic/Chess/Engine/NNUE.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace NNUE
+    {
+      namespace
+      {
+        // Widest SIMD load, every parameter array starts on such a boundary both in the file and in memory
+        constexpr size_t StorageAlignment = 64;
+
+        // Distinguishes files written for other layer sizes
+        constexpr uint32_t ArchitectureHash = static_cast<uint32_t>(FeatureCount) ^ (HalfDimensions << 8) ^ (Hidden1Dimensions << 16) ^ (Hidden2Dimensions << 24);
+
+        // Rows one update may apply, beyond this a refresh is cheaper anyway
+        constexpr int32_t MaxUpdateRows = 2 * (MaxActiveFeatures + 4);
+
+        constexpr size_t AlignUp(size_t size) { return (size + StorageAlignment - 1) & ~(StorageAlignment - 1); }
+
+        // Byte offsets of each array inside the parameter block, in the order the layers use them
+        constexpr size_t FeatureBiasesOffset = 0;
+        constexpr size_t FeatureWeightsOffset = FeatureBiasesOffset + AlignUp(HalfDimensions * sizeof(int16_t));
+        constexpr size_t Hidden1BiasesOffset = FeatureWeightsOffset + AlignUp(static_cast<size_t>(FeatureCount) * HalfDimensions * sizeof(int16_t));
+        constexpr size_t Hidden1WeightsOffset = Hidden1BiasesOffset + AlignUp(Hidden1Dimensions * sizeof(int32_t));
+        constexpr size_t Hidden2BiasesOffset = Hidden1WeightsOffset + AlignUp(Hidden1Dimensions * 2 * HalfDimensions * sizeof(int8_t));
+        constexpr size_t Hidden2WeightsOffset = Hidden2BiasesOffset + AlignUp(Hidden2Dimensions * sizeof(int32_t));
+        constexpr size_t OutputBiasOffset = Hidden2WeightsOffset + AlignUp(Hidden2Dimensions * Hidden1Dimensions * sizeof(int8_t));
+        constexpr size_t OutputWeightsOffset = OutputBiasOffset + AlignUp(sizeof(int32_t));
+        constexpr size_t ParametersSize = OutputWeightsOffset + AlignUp(Hidden2Dimensions * sizeof(int8_t));
+
+        // Little endian, followed by the parameter block exactly as it is laid out in memory
+        struct FileHeader
+        {
+          uint32_t Magic = FileMagic;
+          uint32_t Version = FileVersion;
+          uint32_t Architecture = ArchitectureHash;
+          uint32_t Reserved = 0;
+          uint64_t ParametersOffset = StorageAlignment;
+          uint64_t ParametersSize = NNUE::ParametersSize;
+          uint64_t Checksum = 0;
+          uint8_t Padding[24] = {};
+        };
+        static_assert(sizeof(FileHeader) == StorageAlignment, "The header must keep the parameters aligned");
+
+        bool IsValidHeader(const FileHeader& header)
+        {
+          return header.Magic == FileMagic && header.Version == FileVersion && header.Architecture == ArchitectureHash &&
+            header.ParametersSize == ParametersSize && header.ParametersOffset % StorageAlignment == 0 && header.ParametersOffset >= sizeof(FileHeader);
+        }
+
+        // Multiply-xor over 64 bit words, the parameter block size is a multiple of the alignment
+        uint64_t Checksum(const std::byte* data, size_t size)
+        {
+          uint64_t hash = 0xCBF29CE484222325ULL;
+          for (size_t i = 0; i < size; i += sizeof(uint64_t))
+          {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(uint64_t));
+            hash = (hash ^ word) * 0x100000001B3ULL;
+            hash ^= hash >> 29;
+          }
+          return hash;
+        }
+
+        bool MovesKing(const DirtyPieces& dirty, Color color)
+        {
+          for (int32_t i = 0; i < dirty.Count; i++)
+            if (dirty.Pieces[i] == MakePiece(color, King))
+              return true;
+          return false;
+        }
+
+        uint64_t SplitMix64(uint64_t& state)
+        {
+          uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+          z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+          z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+          return z ^ (z >> 31);
+        }
+
+        template<typename T>
+        void FillRandom(T* data, size_t count, int32_t low, int32_t high, uint64_t& state)
+        {
+          for (size_t i = 0; i < count; i++)
+            data[i] = static_cast<T>(low + static_cast<int32_t>(SplitMix64(state) % static_cast<uint64_t>(high - low + 1)));
+        }
+      }
+
+      int32_t FeatureIndex(Color perspective, Square king, Piece piece, Square square)
+      {
+        const int32_t pieceIndex = (TypeOf(piece) - Pawn) * 2 + (ColorOf(piece) != perspective);
+        return (RelativeSquare(perspective, king) * 10 + pieceIndex) * 64 + RelativeSquare(perspective, square);
+      }
+
+      const Accumulator& AccumulatorStack::Update(const Network& network, const Position& position, const Kernels& kernels)
+      {
+        const int32_t current = position.StateIndex();
+        Accumulator& accumulator = AccumulatorStack::At(current);
+
+        for (const Color perspective : { White, Black })
+        {
+          if (accumulator.Key[perspective] == position.Key())
+            continue;
+
+          // Walk back to the closest state whose half is still valid, stopping at a king move or once a refresh gets cheaper
+          const int32_t budget = PopCount(position.Pieces()) - 2;
+          int32_t changes = 0;
+          int32_t index = current;
+          bool found = false;
+          while (index > 0)
+          {
+            const DirtyPieces& dirty = position.StateAt(index).Dirty;
+            changes += dirty.Count;
+            if (MovesKing(dirty, perspective) || changes > budget)
+              break;
+
+            index--;
+            if (m_Stack[index].Key[perspective] == position.StateAt(index).Key)
+            {
+              found = true;
+              break;
+            }
+          }
+
+          if (!found)
+          {
+            AccumulatorStack::Refresh(network, position, perspective, kernels);
+            continue;
+          }
+
+          const Square king = position.KingSquare(perspective);
+          const int16_t* added[MaxUpdateRows];
+          const int16_t* removed[MaxUpdateRows];
+          int32_t addedCount = 0;
+          int32_t removedCount = 0;
+
+          for (int32_t i = index + 1; i <= current; i++)
+          {
+            const DirtyPieces& dirty = position.StateAt(i).Dirty;
+            for (int32_t j = 0; j < dirty.Count; j++)
+            {
+              if (TypeOf(dirty.Pieces[j]) == King)
+                continue;
+
+              if (dirty.From[j] != NoSquare)
+                removed[removedCount++] = network.GetFeatureWeights(FeatureIndex(perspective, king, dirty.Pieces[j], dirty.From[j]));
+              if (dirty.To[j] != NoSquare)
+                added[addedCount++] = network.GetFeatureWeights(FeatureIndex(perspective, king, dirty.Pieces[j], dirty.To[j]));
+            }
+          }
+
+          kernels.UpdateAccumulator(m_Stack[index].Values[perspective], accumulator.Values[perspective], HalfDimensions, added, addedCount, removed, removedCount);
+          accumulator.Key[perspective] = position.Key();
+          m_Updates++;
+        }
+
+        return accumulator;
+      }
+
+      void AccumulatorStack::Refresh(const Network& network, const Position& position, Color perspective, const Kernels& kernels)
+      {
+        Accumulator& accumulator = AccumulatorStack::At(position.StateIndex());
+        const Square king = position.KingSquare(perspective);
+
+        const Bitboard pieces = position.Pieces() & ~position.Pieces(King);
+        YK_ASSERT(PopCount(pieces) <= MaxActiveFeatures, "[ENGINE] More pieces on the board than the network has room for");
+
+        const int16_t* added[MaxActiveFeatures];
+        int32_t count = 0;
+        for (Bitboard remaining = pieces; remaining;)
+        {
+          const Square square = PopLSB(remaining);
+          added[count++] = network.GetFeatureWeights(FeatureIndex(perspective, king, position.PieceOn(square), square));
+        }
+
+        kernels.UpdateAccumulator(network.GetFeatureBiases(), accumulator.Values[perspective], HalfDimensions, added, count, nullptr, 0);
+        accumulator.Key[perspective] = position.Key();
+        m_Refreshes++;
+      }
+
+      void AccumulatorStack::Invalidate(const Position& position)
+      {
+        Accumulator& accumulator = AccumulatorStack::At(position.StateIndex());
+        accumulator.Key[White] = accumulator.Key[Black] = 0ULL;
+      }
+
+      void AccumulatorStack::Clear()
+      {
+        for (Accumulator& accumulator : m_Stack)
+          accumulator.Key[White] = accumulator.Key[Black] = 0ULL;
+        m_Updates = m_Refreshes = 0;
+      }
+
+      Accumulator& AccumulatorStack::At(int32_t index)
+      {
+        if (static_cast<size_t>(index) >= m_Stack.size())
+          m_Stack.resize(static_cast<size_t>(index) + MaxPly);
+        return m_Stack[index];
+      }
+
+      Network::~Network()
+      {
+        LargePages::Free(m_Storage);
+      }
+
+      std::byte* Network::Allocate()
+      {
+        m_Storage = LargePages::Allocate(ParametersSize);
+        YK_ASSERT(m_Storage.Memory, "[SYSTEM] Failed to allocate {}MB for the network", ParametersSize >> 20);
+        return static_cast<std::byte*>(m_Storage.Memory);
+      }
+
+      void Network::Bind(const std::byte* parameters)
+      {
+        m_Parameters = parameters;
+        m_FeatureBiases = reinterpret_cast<const int16_t*>(parameters + FeatureBiasesOffset);
+        m_FeatureWeights = reinterpret_cast<const int16_t*>(parameters + FeatureWeightsOffset);
+        m_Hidden1Biases = reinterpret_cast<const int32_t*>(parameters + Hidden1BiasesOffset);
+        m_Hidden1Weights = reinterpret_cast<const int8_t*>(parameters + Hidden1WeightsOffset);
+        m_Hidden2Biases = reinterpret_cast<const int32_t*>(parameters + Hidden2BiasesOffset);
+        m_Hidden2Weights = reinterpret_cast<const int8_t*>(parameters + Hidden2WeightsOffset);
+        m_OutputBias = reinterpret_cast<const int32_t*>(parameters + OutputBiasOffset);
+        m_OutputWeights = reinterpret_cast<const int8_t*>(parameters + OutputWeightsOffset);
+      }
+
+      std::shared_ptr<Network> Network::Load(const std::filesystem::path& path, LoadMode mode)
+      {
+        const auto start = std::chrono::steady_clock::now();
+        std::shared_ptr<Network> network(new Network());
+        FileHeader header;
+
+        if (mode == LoadMode::Map)
+        {
+          network->m_File = MappedFile::Open(path);
+          if (!network->m_File)
+          {
+            YK_WARN("[ENGINE] Network file '{}' not found", path.string());
+            return nullptr;
+          }
+
+          const size_t fileSize = network->m_File->GetSize();
+          if (fileSize >= sizeof(FileHeader))
+            std::memcpy(&header, network->m_File->GetData(), sizeof(FileHeader));
+          if (fileSize < sizeof(FileHeader) || !IsValidHeader(header) || fileSize != header.ParametersOffset + header.ParametersSize)
+          {
+            YK_WARN("[ENGINE] '{}' is not a network for this engine version", path.string());
+            return nullptr;
+          }
+
+          // The mapping starts on a page boundary, so aligned file offsets stay aligned in memory
+          network->Bind(network->m_File->GetData() + header.ParametersOffset);
+        }
+        else
+        {
+          std::ifstream stream(path, std::ios::binary);
+          if (!stream)
+          {
+            YK_WARN("[ENGINE] Network file '{}' not found", path.string());
+            return nullptr;
+          }
+
+          if (!stream.read(reinterpret_cast<char*>(&header), sizeof(FileHeader)) || !IsValidHeader(header))
+          {
+            YK_WARN("[ENGINE] '{}' is not a network for this engine version", path.string());
+            return nullptr;
+          }
+
+          std::byte* storage = network->Allocate();
+          stream.seekg(static_cast<std::streamoff>(header.ParametersOffset));
+          if (!stream.read(reinterpret_cast<char*>(storage), static_cast<std::streamsize>(ParametersSize)) || stream.peek() != std::ifstream::traits_type::eof())
+          {
+            YK_WARN("[ENGINE] Network file '{}' has the wrong size", path.string());
+            return nullptr;
+          }
+
+          network->Bind(storage);
+        }
+
+        network->m_Checksum = header.Checksum;
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        YK_INFO("[ENGINE] Loaded network '{}' in {}us ({})", path.string(), elapsed,
+          (mode == LoadMode::Map) ? "mapped from the page cache" : LargePages::GetKindName(network->m_Storage.Kind));
+        return network;
+      }
+
+      std::shared_ptr<Network> Network::CreateRandom(uint64_t seed)
+      {
+        std::shared_ptr<Network> network(new Network());
+        std::byte* storage = network->Allocate();
+        std::memset(storage, 0, ParametersSize);
+
+        // Ranges keep the accumulator well inside int16 and spread over the clipped range
+        uint64_t state = seed;
+        FillRandom(reinterpret_cast<int16_t*>(storage + FeatureBiasesOffset), HalfDimensions, 0, 64, state);
+        FillRandom(reinterpret_cast<int16_t*>(storage + FeatureWeightsOffset), static_cast<size_t>(FeatureCount) * HalfDimensions, -16, 16, state);
+        FillRandom(reinterpret_cast<int32_t*>(storage + Hidden1BiasesOffset), Hidden1Dimensions, -2048, 2048, state);
+        FillRandom(reinterpret_cast<int8_t*>(storage + Hidden1WeightsOffset), Hidden1Dimensions * 2 * HalfDimensions, -8, 8, state);
+        FillRandom(reinterpret_cast<int32_t*>(storage + Hidden2BiasesOffset), Hidden2Dimensions, -2048, 2048, state);
+        FillRandom(reinterpret_cast<int8_t*>(storage + Hidden2WeightsOffset), Hidden2Dimensions * Hidden1Dimensions, -32, 32, state);
+        FillRandom(reinterpret_cast<int32_t*>(storage + OutputBiasOffset), 1, -256, 256, state);
+        FillRandom(reinterpret_cast<int8_t*>(storage + OutputWeightsOffset), Hidden2Dimensions, -64, 64, state);
+
+        network->Bind(storage);
+        network->m_Checksum = Checksum(storage, ParametersSize);
+        return network;
+      }
+
+      bool Network::Save(const std::filesystem::path& path) const
+      {
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        if (!stream)
+        {
+          YK_ERROR("[ENGINE] Cannot write network file '{}'", path.string());
+          return false;
+        }
+
+        FileHeader header;
+        header.Checksum = Checksum(m_Parameters, ParametersSize);
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+        stream.write(reinterpret_cast<const char*>(m_Parameters), static_cast<std::streamsize>(ParametersSize));
+        return static_cast<bool>(stream);
+      }
+
+      bool Network::Verify() const
+      {
+        std::call_once(m_VerifyFlag, [this]()
+          {
+          m_Verified = Checksum(m_Parameters, ParametersSize) == m_Checksum;
+          if (!m_Verified)
+            YK_ERROR("[ENGINE] Network checksum mismatch, the file is corrupted");
+          });
+        return m_Verified;
+      }
+
+      int32_t Network::Evaluate(const Position& position, AccumulatorStack& accumulators, const Kernels& kernels) const
+      {
+        const Accumulator& accumulator = accumulators.Update(*this, position, kernels);
+        return Network::Propagate(accumulator, position.SideToMove(), kernels);
+      }
+
+      int32_t Network::Propagate(const Accumulator& accumulator, Color side_to_move, const Kernels& kernels) const
+      {
+        alignas(64) uint8_t transformed[2 * HalfDimensions];
+        alignas(64) int32_t hidden1[Hidden1Dimensions];
+        alignas(64) uint8_t hidden1Output[Hidden1Dimensions];
+        alignas(64) int32_t hidden2[Hidden2Dimensions];
+        alignas(64) uint8_t hidden2Output[Hidden2Dimensions];
+        alignas(64) int32_t output[1];
+
+        kernels.Transform(accumulator.Values[side_to_move], transformed, HalfDimensions);
+        kernels.Transform(accumulator.Values[~side_to_move], transformed + HalfDimensions, HalfDimensions);
+
+        kernels.Affine(transformed, m_Hidden1Weights, m_Hidden1Biases, hidden1, 2 * HalfDimensions, Hidden1Dimensions);
+        kernels.ClippedReLU(hidden1, hidden1Output, Hidden1Dimensions);
+        kernels.Affine(hidden1Output, m_Hidden2Weights, m_Hidden2Biases, hidden2, Hidden1Dimensions, Hidden2Dimensions);
+        kernels.ClippedReLU(hidden2, hidden2Output, Hidden2Dimensions);
+        kernels.Affine(hidden2Output, m_OutputWeights, m_OutputBias, output, Hidden2Dimensions, 1);
+
+        return std::clamp(output[0] / OutputScale, -ScoreTablebaseWinInMaxPly + 1, ScoreTablebaseWinInMaxPly - 1);
+      }
+
+      namespace
+      {
+        constexpr std::string_view BenchmarkFENs[] =
+        {
+          StartFEN,
+          "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+          "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+          "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+          "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1"
+        };
+
+        constexpr int32_t RefreshRepetitions = 5000;
+        constexpr int32_t UpdateRepetitions = 500;
+        constexpr int32_t PropagateRepetitions = 5000;
+
+        using Clock = std::chrono::steady_clock;
+
+        double NanosecondsSince(Clock::time_point start)
+        {
+          return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        }
+
+        void WalkTree(Position& position, int32_t depth, const Network& network, AccumulatorStack& accumulators, const Kernels& kernels, BenchmarkResult& result, uint64_t& evaluations)
+        {
+          result.Checksum += static_cast<uint64_t>(static_cast<int64_t>(network.Evaluate(position, accumulators, kernels)));
+          evaluations++;
+          if (depth == 0)
+            return;
+
+          MoveList moves;
+          MoveGen::GenerateLegal(position, moves);
+          for (const Move move : moves)
+          {
+            position.MakeMove(move);
+            WalkTree(position, depth - 1, network, accumulators, kernels, result, evaluations);
+            position.UnmakeMove();
+          }
+        }
+      }
+
+      std::vector<BenchmarkResult> RunBenchmark(const Network& network, int32_t depth)
+      {
+        std::vector<BenchmarkResult> results;
+
+        for (int32_t type = 0; type < static_cast<int32_t>(KernelType::Count); type++)
+        {
+          if (!IsSupported(static_cast<KernelType>(type)))
+            continue;
+
+          const Kernels& kernels = GetKernels(static_cast<KernelType>(type));
+          BenchmarkResult result;
+          result.Kernel = kernels.Name;
+
+          AccumulatorStack accumulators;
+          uint64_t evaluations = 0, updates = 0, refreshes = 0, propagations = 0;
+          double walkTime = 0.0, updateTime = 0.0, refreshTime = 0.0, propagateTime = 0.0;
+
+          for (const std::string_view fen : BenchmarkFENs)
+          {
+            Position position;
+            position.SetFEN(fen);
+
+            Clock::time_point start = Clock::now();
+            WalkTree(position, depth, network, accumulators, kernels, result, evaluations);
+            walkTime += NanosecondsSince(start);
+
+            start = Clock::now();
+            for (int32_t i = 0; i < RefreshRepetitions; i++)
+            {
+              accumulators.Refresh(network, position, White, kernels);
+              accumulators.Refresh(network, position, Black, kernels);
+            }
+            refreshTime += NanosecondsSince(start);
+            refreshes += RefreshRepetitions;
+
+            const Accumulator& root = accumulators.Update(network, position, kernels);
+            start = Clock::now();
+            for (int32_t i = 0; i < PropagateRepetitions; i++)
+              result.Checksum += static_cast<uint64_t>(static_cast<int64_t>(network.Propagate(root, position.SideToMove(), kernels)));
+            propagateTime += NanosecondsSince(start);
+            propagations += PropagateRepetitions;
+
+            // Children whose parent is already computed, the common case inside the search
+            MoveList moves;
+            MoveGen::GenerateLegal(position, moves);
+            for (const Move move : moves)
+            {
+              if (TypeOf(position.MovedPiece(move)) == King)
+                continue;
+
+              position.MakeMove(move);
+              start = Clock::now();
+              for (int32_t i = 0; i < UpdateRepetitions; i++)
+              {
+                accumulators.Invalidate(position);
+                accumulators.Update(network, position, kernels);
+              }
+              updateTime += NanosecondsSince(start);
+              updates += UpdateRepetitions;
+              position.UnmakeMove();
+            }
+          }
+
+          result.EvaluationsPerSecond = static_cast<double>(evaluations) * 1e9 / std::max(walkTime, 1.0);
+          result.UpdateNanoseconds = updateTime / static_cast<double>(std::max<uint64_t>(updates, 1));
+          result.RefreshNanoseconds = refreshTime / static_cast<double>(std::max<uint64_t>(refreshes, 1));
+          result.PropagateNanoseconds = propagateTime / static_cast<double>(std::max<uint64_t>(propagations, 1));
+          results.push_back(result);
+
+          YK_INFO("[ENGINE] {} kernels: {:.0f} evals/s, update {:.0f}ns, refresh {:.0f}ns, layers {:.0f}ns", result.Kernel, result.EvaluationsPerSecond,
+            result.UpdateNanoseconds, result.RefreshNanoseconds, result.PropagateNanoseconds);
+        }
+
+        return results;
+      }
+    }
+  }
+}
\ No newline at end of file
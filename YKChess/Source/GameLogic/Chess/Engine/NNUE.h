@@ -0,0 +1,150 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "GameLogic/Chess/Engine/LargePages.h"
+#include "GameLogic/Chess/Engine/MappedFile.h"
+#include "GameLogic/Chess/Engine/NNUEKernels.h"
+#include "GameLogic/Chess/Engine/Position.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace NNUE
+    {
+      // HalfKP: every piece but the kings is a feature relative to the square of one king, each side sees the board from its own king.
+      // Both halves are concatenated side to move first and go through two small hidden layers.
+      constexpr int32_t FeatureCount = 64 * 10 * 64;
+      constexpr int32_t HalfDimensions = 256;
+      constexpr int32_t Hidden1Dimensions = 32;
+      constexpr int32_t Hidden2Dimensions = 32;
+      constexpr int32_t MaxActiveFeatures = 30;
+
+      // Network output units per centipawn
+      constexpr int32_t OutputScale = 16;
+
+      constexpr uint32_t FileMagic = 0x4E4E4B59; // "YKNN"
+      constexpr uint32_t FileVersion = 2;
+
+      int32_t FeatureIndex(Color perspective, Square king, Piece piece, Square square);
+
+      // First layer output of one position, each half is tagged with the key of the position it was computed for
+      struct alignas(64) Accumulator
+      {
+        int16_t Values[ColorCount][HalfDimensions];
+        uint64_t Key[ColorCount] = { 0ULL, 0ULL };
+      };
+
+      class Network;
+
+      // Per-thread, one accumulator per Position state so that a child is updated from its parent's feature deltas
+      class AccumulatorStack
+      {
+      public:
+        // Brings the current position's accumulator up to date, from the closest computed ancestor when no king of that half moved since
+        const Accumulator& Update(const Network& network, const Position& position, const Kernels& kernels);
+
+        // Recomputes one half from every piece on the board
+        void Refresh(const Network& network, const Position& position, Color perspective, const Kernels& kernels);
+
+        // Forgets both halves of the current position, the next Update recomputes them
+        void Invalidate(const Position& position);
+
+        void Clear();
+
+        uint64_t GetUpdates() const { return m_Updates; }
+        uint64_t GetRefreshes() const { return m_Refreshes; }
+
+      private:
+        Accumulator& At(int32_t index);
+
+      private:
+        std::vector<Accumulator> m_Stack;
+        uint64_t m_Updates = 0;
+        uint64_t m_Refreshes = 0;
+      };
+
+      enum class LoadMode : uint8_t
+      {
+        Map,  // Used in place from the page cache, nothing is read until a page is touched
+        Read  // Copied into memory owned by the network, which can sit on huge pages
+      };
+
+      class Network
+      {
+      public:
+        ~Network();
+
+        // Returns nullptr when the file is missing or was written for another architecture or version
+        static std::shared_ptr<Network> Load(const std::filesystem::path& path, LoadMode mode = LoadMode::Map);
+
+        // Untrained weights, only good for measuring speed
+        static std::shared_ptr<Network> CreateRandom(uint64_t seed);
+
+        bool Save(const std::filesystem::path& path) const;
+
+        // Compares the parameters against the checksum in the file, computed on the first call only since it touches every page
+        bool Verify() const;
+
+        // Score of the position from the side to move's point of view
+        int32_t Evaluate(const Position& position, AccumulatorStack& accumulators) const { return Network::Evaluate(position, accumulators, GetBestKernels()); }
+        int32_t Evaluate(const Position& position, AccumulatorStack& accumulators, const Kernels& kernels) const;
+
+        // Runs the layers after the accumulator
+        int32_t Propagate(const Accumulator& accumulator, Color side_to_move, const Kernels& kernels) const;
+
+        const int16_t* GetFeatureBiases() const { return m_FeatureBiases; }
+        const int16_t* GetFeatureWeights(int32_t feature) const { return m_FeatureWeights + static_cast<size_t>(feature) * HalfDimensions; }
+
+        bool IsMapped() const { return m_File != nullptr; }
+
+      private:
+        std::byte* Allocate();
+        void Bind(const std::byte* parameters);
+
+      private:
+        Network() = default;
+        Network(const Network&) = delete;
+        Network& operator=(const Network&) = delete;
+        Network(Network&&) = delete;
+        Network& operator=(Network&&) = delete;
+
+      private:
+        // Parameters live either in the mapped file or in an owned block on huge pages, with the same layout in both
+        std::shared_ptr<MappedFile> m_File;
+        PageAllocation m_Storage;
+        const std::byte* m_Parameters = nullptr;
+
+        uint64_t m_Checksum = 0;
+        mutable std::once_flag m_VerifyFlag;
+        mutable bool m_Verified = false;
+
+        const int16_t* m_FeatureBiases = nullptr;
+        const int16_t* m_FeatureWeights = nullptr;
+        const int32_t* m_Hidden1Biases = nullptr;
+        const int8_t* m_Hidden1Weights = nullptr;
+        const int32_t* m_Hidden2Biases = nullptr;
+        const int8_t* m_Hidden2Weights = nullptr;
+        const int32_t* m_OutputBias = nullptr;
+        const int8_t* m_OutputWeights = nullptr;
+      };
+
+      struct BenchmarkResult
+      {
+        const char* Kernel = "";
+        double EvaluationsPerSecond = 0.0; // Incremental evaluations over a fixed depth tree walk
+        double UpdateNanoseconds = 0.0;    // One accumulator update after a move that keeps both kings in place
+        double RefreshNanoseconds = 0.0;   // Both halves recomputed from scratch
+        double PropagateNanoseconds = 0.0; // The layers after the accumulator
+        uint64_t Checksum = 0;             // Sum of every evaluation, identical across kernels when they agree
+      };
+
+      // One result per kernel the CPU supports
+      std::vector<BenchmarkResult> RunBenchmark(const Network& network, int32_t depth = 3);
+    }
+  }
+}
\ No newline at end of file
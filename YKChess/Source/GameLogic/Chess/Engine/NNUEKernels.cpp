@@ -0,0 +1,266 @@
+#include <algorithm>
+
+#include "GameLogic/Chess/Engine/NNUEKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define YK_NNUE_X86
+  #include <immintrin.h>
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+  #endif
+#endif
+
+// MSVC compiles any intrinsic without flags, GCC and Clang need the instruction set enabled per function
+#if defined(__GNUC__) || defined(__clang__)
+  #define YK_TARGET_SSE41 __attribute__((target("sse4.1")))
+  #define YK_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+  #define YK_TARGET_SSE41
+  #define YK_TARGET_AVX2
+#endif
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace NNUE
+    {
+      namespace
+      {
+        void UpdateAccumulatorScalar(const int16_t* input, int16_t* output, int32_t dims, const int16_t* const* added, int32_t added_count, const int16_t* const* removed, int32_t removed_count)
+        {
+          for (int32_t i = 0; i < dims; i++)
+          {
+            int16_t value = input[i];
+            for (int32_t j = 0; j < added_count; j++)
+              value = static_cast<int16_t>(value + added[j][i]);
+            for (int32_t j = 0; j < removed_count; j++)
+              value = static_cast<int16_t>(value - removed[j][i]);
+            output[i] = value;
+          }
+        }
+
+        void TransformScalar(const int16_t* input, uint8_t* output, int32_t dims)
+        {
+          for (int32_t i = 0; i < dims; i++)
+            output[i] = static_cast<uint8_t>(std::clamp<int32_t>(input[i], 0, 127));
+        }
+
+        void AffineScalar(const uint8_t* input, const int8_t* weights, const int32_t* biases, int32_t* output, int32_t input_dims, int32_t output_dims)
+        {
+          for (int32_t i = 0; i < output_dims; i++)
+          {
+            const int8_t* row = weights + i * input_dims;
+            int32_t sum = biases[i];
+            for (int32_t j = 0; j < input_dims; j++)
+              sum += static_cast<int32_t>(input[j]) * row[j];
+            output[i] = sum;
+          }
+        }
+
+        void ClippedReLUScalar(const int32_t* input, uint8_t* output, int32_t dims)
+        {
+          for (int32_t i = 0; i < dims; i++)
+            output[i] = static_cast<uint8_t>(std::clamp<int32_t>(input[i] >> WeightScaleBits, 0, 127));
+        }
+
+#if defined(YK_NNUE_X86)
+        YK_TARGET_SSE41 void UpdateAccumulatorSSE41(const int16_t* input, int16_t* output, int32_t dims, const int16_t* const* added, int32_t added_count, const int16_t* const* removed, int32_t removed_count)
+        {
+          for (int32_t i = 0; i < dims; i += 8)
+          {
+            __m128i value = _mm_load_si128(reinterpret_cast<const __m128i*>(input + i));
+            for (int32_t j = 0; j < added_count; j++)
+              value = _mm_add_epi16(value, _mm_load_si128(reinterpret_cast<const __m128i*>(added[j] + i)));
+            for (int32_t j = 0; j < removed_count; j++)
+              value = _mm_sub_epi16(value, _mm_load_si128(reinterpret_cast<const __m128i*>(removed[j] + i)));
+            _mm_store_si128(reinterpret_cast<__m128i*>(output + i), value);
+          }
+        }
+
+        YK_TARGET_SSE41 void TransformSSE41(const int16_t* input, uint8_t* output, int32_t dims)
+        {
+          for (int32_t i = 0; i < dims; i += 16)
+          {
+            const __m128i low = _mm_load_si128(reinterpret_cast<const __m128i*>(input + i));
+            const __m128i high = _mm_load_si128(reinterpret_cast<const __m128i*>(input + i + 8));
+
+            // Packing saturates to [-128, 127], the max against zero finishes the clamp
+            const __m128i packed = _mm_packs_epi16(low, high);
+            _mm_store_si128(reinterpret_cast<__m128i*>(output + i), _mm_max_epi8(packed, _mm_setzero_si128()));
+          }
+        }
+
+        YK_TARGET_SSE41 int32_t HorizontalSum(__m128i sum)
+        {
+          sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+          sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+          return _mm_cvtsi128_si32(sum);
+        }
+
+        YK_TARGET_SSE41 void AffineSSE41(const uint8_t* input, const int8_t* weights, const int32_t* biases, int32_t* output, int32_t input_dims, int32_t output_dims)
+        {
+          const __m128i ones = _mm_set1_epi16(1);
+          for (int32_t i = 0; i < output_dims; i++)
+          {
+            const int8_t* row = weights + i * input_dims;
+            __m128i sum = _mm_setzero_si128();
+            for (int32_t j = 0; j < input_dims; j += 16)
+            {
+              // Inputs never exceed 127, so the pairwise products cannot saturate the 16 bit lanes
+              const __m128i products = _mm_maddubs_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(input + j)), _mm_load_si128(reinterpret_cast<const __m128i*>(row + j)));
+              sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+            }
+            output[i] = HorizontalSum(sum) + biases[i];
+          }
+        }
+
+        YK_TARGET_SSE41 void ClippedReLUSSE41(const int32_t* input, uint8_t* output, int32_t dims)
+        {
+          for (int32_t i = 0; i < dims; i += 16)
+          {
+            const __m128i* in = reinterpret_cast<const __m128i*>(input + i);
+            const __m128i low = _mm_packs_epi32(_mm_srai_epi32(_mm_load_si128(in + 0), WeightScaleBits), _mm_srai_epi32(_mm_load_si128(in + 1), WeightScaleBits));
+            const __m128i high = _mm_packs_epi32(_mm_srai_epi32(_mm_load_si128(in + 2), WeightScaleBits), _mm_srai_epi32(_mm_load_si128(in + 3), WeightScaleBits));
+            _mm_store_si128(reinterpret_cast<__m128i*>(output + i), _mm_max_epi8(_mm_packs_epi16(low, high), _mm_setzero_si128()));
+          }
+        }
+
+        YK_TARGET_AVX2 void UpdateAccumulatorAVX2(const int16_t* input, int16_t* output, int32_t dims, const int16_t* const* added, int32_t added_count, const int16_t* const* removed, int32_t removed_count)
+        {
+          for (int32_t i = 0; i < dims; i += 16)
+          {
+            __m256i value = _mm256_load_si256(reinterpret_cast<const __m256i*>(input + i));
+            for (int32_t j = 0; j < added_count; j++)
+              value = _mm256_add_epi16(value, _mm256_load_si256(reinterpret_cast<const __m256i*>(added[j] + i)));
+            for (int32_t j = 0; j < removed_count; j++)
+              value = _mm256_sub_epi16(value, _mm256_load_si256(reinterpret_cast<const __m256i*>(removed[j] + i)));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(output + i), value);
+          }
+        }
+
+        YK_TARGET_AVX2 void TransformAVX2(const int16_t* input, uint8_t* output, int32_t dims)
+        {
+          for (int32_t i = 0; i < dims; i += 32)
+          {
+            const __m256i low = _mm256_load_si256(reinterpret_cast<const __m256i*>(input + i));
+            const __m256i high = _mm256_load_si256(reinterpret_cast<const __m256i*>(input + i + 16));
+
+            // Packing works per 128 bit lane, the permute puts the quarters back in order
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(low, high), 0xD8);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(output + i), _mm256_max_epi8(packed, _mm256_setzero_si256()));
+          }
+        }
+
+        YK_TARGET_AVX2 void AffineAVX2(const uint8_t* input, const int8_t* weights, const int32_t* biases, int32_t* output, int32_t input_dims, int32_t output_dims)
+        {
+          const __m256i ones = _mm256_set1_epi16(1);
+          for (int32_t i = 0; i < output_dims; i++)
+          {
+            const int8_t* row = weights + i * input_dims;
+            __m256i sum = _mm256_setzero_si256();
+            for (int32_t j = 0; j < input_dims; j += 32)
+            {
+              const __m256i products = _mm256_maddubs_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(input + j)), _mm256_load_si256(reinterpret_cast<const __m256i*>(row + j)));
+              sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+            }
+
+            const __m128i folded = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+            output[i] = HorizontalSum(folded) + biases[i];
+          }
+        }
+
+        YK_TARGET_AVX2 void ClippedReLUAVX2(const int32_t* input, uint8_t* output, int32_t dims)
+        {
+          const __m256i order = _mm256_set_epi32(7, 3, 6, 2, 5, 1, 4, 0);
+          for (int32_t i = 0; i < dims; i += 32)
+          {
+            const __m256i* in = reinterpret_cast<const __m256i*>(input + i);
+            const __m256i low = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_load_si256(in + 0), WeightScaleBits), _mm256_srai_epi32(_mm256_load_si256(in + 1), WeightScaleBits));
+            const __m256i high = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_load_si256(in + 2), WeightScaleBits), _mm256_srai_epi32(_mm256_load_si256(in + 3), WeightScaleBits));
+            const __m256i packed = _mm256_permutevar8x32_epi32(_mm256_packs_epi16(low, high), order);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(output + i), _mm256_max_epi8(packed, _mm256_setzero_si256()));
+          }
+        }
+
+        bool DetectSSE41()
+        {
+#if defined(_MSC_VER)
+          int32_t info[4];
+          __cpuid(info, 1);
+          return info[2] & (1 << 19);
+#else
+          return __builtin_cpu_supports("sse4.1");
+#endif
+        }
+
+        bool DetectAVX2()
+        {
+#if defined(_MSC_VER)
+          int32_t info[4];
+          __cpuid(info, 0);
+          if (info[0] < 7)
+            return false;
+
+          // The OS must also save the upper halves of the registers on context switches
+          __cpuid(info, 1);
+          if (!(info[2] & (1 << 27)) || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+
+          __cpuidex(info, 7, 0);
+          return info[1] & (1 << 5);
+#else
+          return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+        const Kernels s_Kernels[static_cast<size_t>(KernelType::Count)] =
+        {
+          { KernelType::Scalar, "Scalar", UpdateAccumulatorScalar, TransformScalar, AffineScalar, ClippedReLUScalar },
+#if defined(YK_NNUE_X86)
+          { KernelType::SSE41, "SSE4.1", UpdateAccumulatorSSE41, TransformSSE41, AffineSSE41, ClippedReLUSSE41 },
+          { KernelType::AVX2, "AVX2", UpdateAccumulatorAVX2, TransformAVX2, AffineAVX2, ClippedReLUAVX2 }
+#else
+          { KernelType::SSE41, "SSE4.1", UpdateAccumulatorScalar, TransformScalar, AffineScalar, ClippedReLUScalar },
+          { KernelType::AVX2, "AVX2", UpdateAccumulatorScalar, TransformScalar, AffineScalar, ClippedReLUScalar }
+#endif
+        };
+      }
+
+      bool IsSupported(KernelType type)
+      {
+        static const bool s_Supported[static_cast<size_t>(KernelType::Count)] =
+        {
+          true,
+#if defined(YK_NNUE_X86)
+          DetectSSE41(),
+          DetectAVX2()
+#else
+          false,
+          false
+#endif
+        };
+        return s_Supported[static_cast<size_t>(type)];
+      }
+
+      const Kernels& GetKernels(KernelType type)
+      {
+        return s_Kernels[static_cast<size_t>(type)];
+      }
+
+      const Kernels& GetBestKernels()
+      {
+        static const KernelType s_Best = []()
+          {
+          if (IsSupported(KernelType::AVX2))
+            return KernelType::AVX2;
+          if (IsSupported(KernelType::SSE41))
+            return KernelType::SSE41;
+          return KernelType::Scalar;
+          }();
+        return GetKernels(s_Best);
+      }
+    }
+  }
+}
\ No newline at end of file
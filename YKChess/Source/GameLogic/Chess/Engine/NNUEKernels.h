@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace NNUE
+    {
+      enum class KernelType : uint8_t
+      {
+        Scalar,
+        SSE41,
+        AVX2,
+        Count
+      };
+
+      // One implementation of every integer routine the network needs, all of them give bit identical results.
+      // Pointers must be 64 byte aligned and dimensions multiples of 32.
+      struct Kernels
+      {
+        KernelType Type = KernelType::Scalar;
+        const char* Name = "";
+
+        // output = input + every added row - every removed row
+        void (*UpdateAccumulator)(const int16_t* input, int16_t* output, int32_t dims, const int16_t* const* added, int32_t added_count, const int16_t* const* removed, int32_t removed_count) = nullptr;
+
+        // Clamps the accumulator to [0, 127]
+        void (*Transform)(const int16_t* input, uint8_t* output, int32_t dims) = nullptr;
+
+        // output = weights * input + biases with int8 weights stored row major
+        void (*Affine)(const uint8_t* input, const int8_t* weights, const int32_t* biases, int32_t* output, int32_t input_dims, int32_t output_dims) = nullptr;
+
+        // Drops the weight scale and clamps to [0, 127]
+        void (*ClippedReLU)(const int32_t* input, uint8_t* output, int32_t dims) = nullptr;
+      };
+
+      constexpr int32_t WeightScaleBits = 6;
+
+      bool IsSupported(KernelType type);
+      const Kernels& GetKernels(KernelType type);
+
+      // Widest instruction set the running CPU supports, detected once
+      const Kernels& GetBestKernels();
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include <algorithm>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/PawnTable.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    PawnTable::PawnTable()
+    {
+      m_Allocation = LargePages::Allocate(EntryCount * sizeof(PawnEntry));
+      m_Entries = static_cast<PawnEntry*>(m_Allocation.Memory);
+      YK_ASSERT(m_Entries, "[SYSTEM] Failed to allocate the pawn hash table");
+
+      PawnTable::Clear();
+    }
+
+    PawnTable::~PawnTable()
+    {
+      LargePages::Free(m_Allocation);
+    }
+
+    void PawnTable::Clear()
+    {
+      std::fill_n(m_Entries, EntryCount, PawnEntry());
+      PawnTable::ClearStats();
+    }
+
+    PawnEntry* PawnTable::Probe(uint64_t key, bool& found)
+    {
+      PawnEntry* entry = &m_Entries[key & (EntryCount - 1)];
+
+      m_Probes++;
+      found = entry->Key == key;
+      m_Hits += found;
+      return entry;
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+
+#include "GameLogic/Chess/Engine/LargePages.h"
+#include "GameLogic/Chess/Engine/Types.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    // Pawn structure evaluation and the bitboards derived from it, valid for every position sharing the pawn key.
+    // King shelter also depends on the king square and is filled in lazily per side.
+    struct alignas(64) PawnEntry
+    {
+      uint64_t Key = 0ULL;
+      Bitboard PassedPawns[ColorCount] = { 0ULL, 0ULL };
+      Bitboard AttackSpan[ColorCount] = { 0ULL, 0ULL }; // Every square the pawns could attack as they advance
+
+      Score PawnScore = 0;
+      Score KingShelter[ColorCount] = { 0, 0 };
+      uint8_t KingSquare[ColorCount] = { NoSquare, NoSquare };
+    };
+
+    static_assert(sizeof(PawnEntry) == 64, "PawnEntry must fill exactly one cache line");
+
+    // Per-thread, pawn structures repeat so often that a small table catches nearly every probe
+    class PawnTable
+    {
+    public:
+      PawnTable();
+      ~PawnTable();
+
+      void Clear();
+
+      // Returns the entry for the key, found tells whether it already holds that structure
+      PawnEntry* Probe(uint64_t key, bool& found);
+      void Prefetch(uint64_t key) const { Chess::Prefetch(&m_Entries[key & (EntryCount - 1)]); }
+
+      uint64_t GetProbes() const { return m_Probes; }
+      uint64_t GetHits() const { return m_Hits; }
+      void ClearStats() { m_Probes = m_Hits = 0; }
+
+      const PageAllocation& GetAllocation() const { return m_Allocation; }
+
+    private:
+      static constexpr size_t EntryCount = 65536;
+
+      PawnTable(const PawnTable&) = delete;
+      PawnTable& operator=(const PawnTable&) = delete;
+      PawnTable(PawnTable&&) = delete;
+      PawnTable& operator=(PawnTable&&) = delete;
+
+    private:
+      PageAllocation m_Allocation;
+      PawnEntry* m_Entries = nullptr;
+      uint64_t m_Probes = 0;
+      uint64_t m_Hits = 0;
+    };
+  }
+}
\ No newline at end of file
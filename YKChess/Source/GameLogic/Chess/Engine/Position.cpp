@@ -0,0 +1,875 @@
+#include <algorithm>
+#include <sstream>
+#include <tuple>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/MoveGen.h"
+#include "GameLogic/Chess/Engine/Position.h"
+#include "GameLogic/Chess/Engine/PSQT.h"
+#include "GameLogic/Chess/Engine/Zobrist.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      constexpr std::string_view PieceChars = " PNBRQK  pnbrqk";
+
+      // Rights that survive a move touching the given square
+      constexpr std::array<uint8_t, 64> CastlingMask = []()
+        {
+        std::array<uint8_t, 64> mask = {};
+        for (uint8_t& rights : mask)
+          rights = AllCastling;
+
+        mask[MakeSquare(0, 0)] &= ~WhiteQueenSide;
+        mask[MakeSquare(4, 0)] &= ~(WhiteKingSide | WhiteQueenSide);
+        mask[MakeSquare(7, 0)] &= ~WhiteKingSide;
+        mask[MakeSquare(0, 7)] &= ~BlackQueenSide;
+        mask[MakeSquare(4, 7)] &= ~(BlackKingSide | BlackQueenSide);
+        mask[MakeSquare(7, 7)] &= ~BlackKingSide;
+        return mask;
+        }();
+    }
+
+    Position::Position()
+    {
+      m_Board.fill(NoPiece);
+      std::fill(std::begin(m_ByType), std::end(m_ByType), 0ULL);
+      std::fill(std::begin(m_ByColor), std::end(m_ByColor), 0ULL);
+
+      m_States.reserve(MaxPly * 4);
+      m_States.emplace_back();
+    }
+
+    Position Position::StartPosition()
+    {
+      Position position;
+      position.SetFEN(StartFEN);
+      return position;
+    }
+
+    bool Position::SetFEN(std::string_view fen)
+    {
+      Position position;
+      std::istringstream stream{ std::string(fen) };
+      std::string board, side, castling, enPassant;
+      int32_t halfmove = 0, fullmove = 1;
+
+      stream >> board >> side >> castling >> enPassant;
+      if (board.empty() || side.empty())
+        return false;
+      if (!(stream >> halfmove))
+        halfmove = 0;
+      if (!(stream >> fullmove))
+        fullmove = 1;
+
+      int32_t file = 0, rank = 7;
+      for (char c : board)
+      {
+        if (c == '/')
+        {
+          if (file != 8 || rank == 0)
+            return false;
+          file = 0;
+          rank--;
+        }
+        else if (c >= '1' && c <= '8')
+          file += c - '0';
+        else
+        {
+          size_t index = PieceChars.find(c);
+          if (index == std::string_view::npos || c == ' ' || file > 7)
+            return false;
+          position.PutPiece(static_cast<Piece>(index), MakeSquare(file, rank));
+          file++;
+        }
+
+        if (file > 8)
+          return false;
+      }
+
+      if (rank != 0 || file != 8 || position.Count(White, King) != 1 || position.Count(Black, King) != 1)
+        return false;
+      if (side != "w" && side != "b")
+        return false;
+      position.m_SideToMove = (side == "w") ? White : Black;
+
+      StateInfo& state = position.State();
+      for (char c : castling)
+      {
+        switch (c)
+        {
+        case 'K': state.CastlingRights |= WhiteKingSide; break;
+        case 'Q': state.CastlingRights |= WhiteQueenSide; break;
+        case 'k': state.CastlingRights |= BlackKingSide; break;
+        case 'q': state.CastlingRights |= BlackQueenSide; break;
+        case '-': break;
+        default: return false;
+        }
+      }
+
+      // Drop castling rights that the placement cannot support, FENs in the wild are sloppy
+      const std::array<std::tuple<CastlingRight, Piece, Square, Square>, 4> castlingPieces = { {
+        { WhiteKingSide, WhiteRook, MakeSquare(7, 0), MakeSquare(4, 0) },
+        { WhiteQueenSide, WhiteRook, MakeSquare(0, 0), MakeSquare(4, 0) },
+        { BlackKingSide, BlackRook, MakeSquare(7, 7), MakeSquare(4, 7) },
+        { BlackQueenSide, BlackRook, MakeSquare(0, 7), MakeSquare(4, 7) }
+      } };
+      for (const auto& [right, rook, rookSquare, kingSquare] : castlingPieces)
+        if (position.PieceOn(rookSquare) != rook || TypeOf(position.PieceOn(kingSquare)) != King)
+          state.CastlingRights &= ~right;
+
+      // The en passant square is only kept when a pawn can actually capture there
+      if (enPassant.size() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h' && (enPassant[1] == '3' || enPassant[1] == '6'))
+      {
+        Square square = MakeSquare(enPassant[0] - 'a', enPassant[1] - '1');
+        Color us = position.m_SideToMove;
+        if (Bitboards::PawnAttacks(~us, square) & position.Pieces(us, Pawn))
+          state.EnPassant = square;
+      }
+
+      state.HalfmoveClock = halfmove;
+      position.m_GamePly = std::max(2 * (fullmove - 1), 0) + (position.m_SideToMove == Black);
+      state.Key = position.ComputeKey();
+      state.PawnKey = position.ComputePawnKey();
+      position.UpdateCheckInfo();
+
+      // The side not to move must not be in check
+      if (position.IsAttacked(position.KingSquare(~position.m_SideToMove), position.m_SideToMove))
+        return false;
+
+      *this = std::move(position);
+      return true;
+    }
+
+    std::string Position::GetFEN() const
+    {
+      std::string fen;
+
+      for (int32_t rank = 7; rank >= 0; rank--)
+      {
+        int32_t empty = 0;
+        for (int32_t file = 0; file < 8; file++)
+        {
+          Piece piece = PieceOn(MakeSquare(file, rank));
+          if (piece == NoPiece)
+          {
+            empty++;
+            continue;
+          }
+          if (empty)
+            fen += static_cast<char>('0' + empty);
+          fen += PieceChars[piece];
+          empty = 0;
+        }
+        if (empty)
+          fen += static_cast<char>('0' + empty);
+        if (rank > 0)
+          fen += '/';
+      }
+
+      fen += (m_SideToMove == White) ? " w " : " b ";
+
+      uint8_t rights = CastlingRights();
+      if (rights & WhiteKingSide)  fen += 'K';
+      if (rights & WhiteQueenSide) fen += 'Q';
+      if (rights & BlackKingSide)  fen += 'k';
+      if (rights & BlackQueenSide) fen += 'q';
+      if (!rights)
+        fen += '-';
+
+      if (EnPassantSquare() != NoSquare)
+      {
+        fen += ' ';
+        fen += static_cast<char>('a' + FileOf(EnPassantSquare()));
+        fen += static_cast<char>('1' + RankOf(EnPassantSquare()));
+      }
+      else
+        fen += " -";
+
+      fen += ' ' + std::to_string(HalfmoveClock()) + ' ' + std::to_string(1 + (m_GamePly - (m_SideToMove == Black)) / 2);
+      return fen;
+    }
+
+    Bitboard Position::AttackersTo(Square square, Bitboard occupied) const
+    {
+      return (Bitboards::PawnAttacks(Black, square) & Pieces(White, Pawn))
+        | (Bitboards::PawnAttacks(White, square) & Pieces(Black, Pawn))
+        | (Bitboards::KnightAttacks(square) & Pieces(Knight))
+        | (Bitboards::BishopAttacks(square, occupied) & Pieces(Bishop, Queen))
+        | (Bitboards::RookAttacks(square, occupied) & Pieces(Rook, Queen))
+        | (Bitboards::KingAttacks(square) & Pieces(King));
+    }
+
+    bool Position::IsAttacked(Square square, Color attacker) const
+    {
+      return AttackersTo(square, Pieces()) & Pieces(attacker);
+    }
+
+    bool Position::IsPseudoLegal(Move move) const
+    {
+      const Color us = m_SideToMove;
+      const Square from = move.From();
+      const Square to = move.To();
+      const Piece piece = PieceOn(from);
+      const Piece target = PieceOn(to);
+
+      // Flags 6 and 7 are not used by the encoding
+      if (!move.IsValid() || (move.IsCapture() && !move.IsPromotion() && (static_cast<uint8_t>(move.Flag()) & 2)))
+        return false;
+      if (piece == NoPiece || ColorOf(piece) != us)
+        return false;
+      if (target != NoPiece && (ColorOf(target) == us || TypeOf(target) == King))
+        return false;
+
+      if (move.IsCastling())
+      {
+        if (TypeOf(piece) != King || from != RelativeSquare(us, MakeSquare(4, 0)))
+          return false;
+
+        const bool kingSide = move.Flag() == MoveFlag::KingCastle;
+        const uint8_t right = kingSide ? (us == White ? WhiteKingSide : BlackKingSide) : (us == White ? WhiteQueenSide : BlackQueenSide);
+        const Square rookSquare = RelativeSquare(us, MakeSquare(kingSide ? 7 : 0, 0));
+
+        return (CastlingRights() & right)
+          && to == RelativeSquare(us, MakeSquare(kingSide ? 6 : 2, 0))
+          && !(Bitboards::Between(from, rookSquare) & Pieces());
+      }
+
+      if (move.IsEnPassant())
+        return TypeOf(piece) == Pawn && to == EnPassantSquare() && (Bitboards::PawnAttacks(us, from) & SquareBB(to));
+
+      // The capture flag has to agree with the board, otherwise the move came from another position
+      if (move.IsCapture() != (target != NoPiece))
+        return false;
+
+      if (TypeOf(piece) == Pawn)
+      {
+        if (move.IsPromotion() != (RelativeRank(us, to) == 7))
+          return false;
+
+        if (move.IsCapture())
+          return Bitboards::PawnAttacks(us, from) & SquareBB(to);
+
+        if (move.Flag() == MoveFlag::DoublePawnPush)
+          return RelativeRank(us, from) == 1 && to == from + 2 * PawnPush(us) && !(Pieces() & (SquareBB(from + PawnPush(us)) | SquareBB(to)));
+
+        return to == from + PawnPush(us);
+      }
+
+      if (move.Flag() != MoveFlag::Quiet && move.Flag() != MoveFlag::Capture)
+        return false;
+
+      return Bitboards::Attacks(TypeOf(piece), from, Pieces()) & SquareBB(to);
+    }
+
+    bool Position::IsLegal(Move move) const
+    {
+      const Color us = m_SideToMove;
+      const Color them = ~us;
+      const Square from = move.From();
+      const Square to = move.To();
+      const Square kingSquare = KingSquare(us);
+
+      if (move.IsEnPassant())
+      {
+        const Square captured = to - PawnPush(us);
+        const Bitboard occupied = (Pieces() ^ SquareBB(from) ^ SquareBB(captured)) | SquareBB(to);
+        return !(AttackersTo(kingSquare, occupied) & Pieces(them) & ~SquareBB(captured));
+      }
+
+      if (move.IsCastling())
+      {
+        if (InCheck())
+          return false;
+
+        const Square step = (to > from) ? 1 : -1;
+        for (Square square = from + step; square != to + step; square += step)
+          if (IsAttacked(square, them))
+            return false;
+        return true;
+      }
+
+      if (from == kingSquare)
+        return !(AttackersTo(to, Pieces() ^ SquareBB(from)) & Pieces(them));
+
+      const Bitboard checkers = Checkers();
+      if (checkers)
+      {
+        if (MoreThanOne(checkers))
+          return false;
+        if (!((Bitboards::Between(kingSquare, LSB(checkers)) | checkers) & SquareBB(to)))
+          return false;
+      }
+
+      return !(BlockersForKing(us) & SquareBB(from)) || Bitboards::Aligned(from, to, kingSquare);
+    }
+
+    bool Position::GivesCheck(Move move) const
+    {
+      const Color us = m_SideToMove;
+      const Square from = move.From();
+      const Square to = move.To();
+      const Square kingSquare = KingSquare(~us);
+      const PieceType type = move.IsPromotion() ? move.PromotionType() : TypeOf(PieceOn(from));
+
+      Bitboard occupied = (Pieces() ^ SquareBB(from)) | SquareBB(to);
+
+      // Direct check
+      if (type == Pawn)
+      {
+        if (Bitboards::PawnAttacks(us, to) & SquareBB(kingSquare))
+          return true;
+      }
+      else if (type != King && (Bitboards::Attacks(type, to, occupied) & SquareBB(kingSquare)))
+        return true;
+
+      // Discovered check
+      if ((BlockersForKing(~us) & SquareBB(from)) && !Bitboards::Aligned(from, to, kingSquare))
+        return true;
+
+      if (move.IsEnPassant())
+      {
+        occupied ^= SquareBB(to - PawnPush(us));
+        return (Bitboards::RookAttacks(kingSquare, occupied) & Pieces(us, Rook, Queen))
+          || (Bitboards::BishopAttacks(kingSquare, occupied) & Pieces(us, Bishop, Queen));
+      }
+
+      if (move.IsCastling())
+      {
+        const bool kingSide = move.Flag() == MoveFlag::KingCastle;
+        const Square rookFrom = kingSide ? to + 1 : to - 2;
+        const Square rookTo = kingSide ? to - 1 : to + 1;
+        occupied = (Pieces() ^ SquareBB(from) ^ SquareBB(rookFrom)) | SquareBB(to) | SquareBB(rookTo);
+        return Bitboards::RookAttacks(rookTo, occupied) & SquareBB(kingSquare);
+      }
+
+      return false;
+    }
+
+    bool Position::SEEGreaterEqual(Move move, int32_t threshold) const
+    {
+      if (move.IsCastling() || move.IsEnPassant() || move.IsPromotion())
+        return 0 >= threshold;
+
+      const Square from = move.From();
+      const Square to = move.To();
+
+      int32_t swap = SEEValue[TypeOf(PieceOn(to))] - threshold;
+      if (swap < 0)
+        return false;
+
+      swap = SEEValue[TypeOf(PieceOn(from))] - swap;
+      if (swap <= 0)
+        return true;
+
+      Bitboard occupied = Pieces() ^ SquareBB(from) ^ SquareBB(to);
+      Bitboard attackers = AttackersTo(to, occupied);
+      Color side = m_SideToMove;
+      int32_t result = 1;
+
+      while (true)
+      {
+        side = ~side;
+        attackers &= occupied;
+
+        Bitboard sideAttackers = attackers & Pieces(side);
+        if (!sideAttackers)
+          break;
+
+        // Pinned pieces cannot recapture while their pinner is still on the board
+        if (State().Pinners[~side] & occupied)
+        {
+          sideAttackers &= ~BlockersForKing(side);
+          if (!sideAttackers)
+            break;
+        }
+
+        result ^= 1;
+
+        Bitboard least;
+        if ((least = sideAttackers & Pieces(Pawn)))
+        {
+          if ((swap = SEEValue[Pawn] - swap) < result)
+            break;
+          occupied ^= least & (~least + 1);
+          attackers |= Bitboards::BishopAttacks(to, occupied) & Pieces(Bishop, Queen);
+        }
+        else if ((least = sideAttackers & Pieces(Knight)))
+        {
+          if ((swap = SEEValue[Knight] - swap) < result)
+            break;
+          occupied ^= least & (~least + 1);
+        }
+        else if ((least = sideAttackers & Pieces(Bishop)))
+        {
+          if ((swap = SEEValue[Bishop] - swap) < result)
+            break;
+          occupied ^= least & (~least + 1);
+          attackers |= Bitboards::BishopAttacks(to, occupied) & Pieces(Bishop, Queen);
+        }
+        else if ((least = sideAttackers & Pieces(Rook)))
+        {
+          if ((swap = SEEValue[Rook] - swap) < result)
+            break;
+          occupied ^= least & (~least + 1);
+          attackers |= Bitboards::RookAttacks(to, occupied) & Pieces(Rook, Queen);
+        }
+        else if ((least = sideAttackers & Pieces(Queen)))
+        {
+          if ((swap = SEEValue[Queen] - swap) < result)
+            break;
+          occupied ^= least & (~least + 1);
+          attackers |= (Bitboards::BishopAttacks(to, occupied) & Pieces(Bishop, Queen)) | (Bitboards::RookAttacks(to, occupied) & Pieces(Rook, Queen));
+        }
+        else
+          // The king can only recapture when the opponent has nothing left to attack with
+          return (attackers & ~Pieces(side)) ? result ^ 1 : result;
+      }
+
+      return result;
+    }
+
+    bool Position::IsDraw(int32_t ply) const
+    {
+      const StateInfo& state = State();
+
+      if (state.HalfmoveClock >= 100)
+        return true;
+
+      // Bare kings, or a single minor piece against a bare king
+      if (!Pieces(Pawn, Rook) && !Pieces(Queen) && PopCount(Pieces()) <= 3)
+        return true;
+
+      // A repetition inside the search tree is a draw, one before the root needs a second occurrence
+      const int32_t end = std::min(state.HalfmoveClock, state.PliesFromNull);
+      const int32_t size = static_cast<int32_t>(m_States.size());
+      int32_t repetitions = 0;
+      for (int32_t distance = 4; distance <= end && distance < size; distance += 2)
+      {
+        if (m_States[size - 1 - distance].Key == state.Key)
+        {
+          if (distance < ply || ++repetitions == 2)
+            return true;
+        }
+      }
+
+      return false;
+    }
+
+    uint64_t Position::KeyAfter(Move move) const
+    {
+      const StateInfo& state = State();
+      const Color us = m_SideToMove;
+      const Square from = move.From();
+      const Square to = move.To();
+      const Piece piece = PieceOn(from);
+
+      uint64_t key = state.Key ^ Zobrist::SideToMove() ^ Zobrist::PieceSquare(piece, from);
+      if (state.EnPassant != NoSquare)
+        key ^= Zobrist::EnPassant(state.EnPassant);
+
+      if (move.IsCastling())
+      {
+        const bool kingSide = move.Flag() == MoveFlag::KingCastle;
+        const Piece rook = MakePiece(us, Rook);
+        key ^= Zobrist::PieceSquare(rook, kingSide ? to + 1 : to - 2) ^ Zobrist::PieceSquare(rook, kingSide ? to - 1 : to + 1);
+      }
+      else if (move.IsEnPassant())
+        key ^= Zobrist::PieceSquare(MakePiece(~us, Pawn), to - PawnPush(us));
+      else if (PieceOn(to) != NoPiece)
+        key ^= Zobrist::PieceSquare(PieceOn(to), to);
+
+      key ^= Zobrist::PieceSquare(move.IsPromotion() ? MakePiece(us, move.PromotionType()) : piece, to);
+
+      const uint8_t rights = state.CastlingRights & CastlingMask[from] & CastlingMask[to];
+      if (rights != state.CastlingRights)
+        key ^= Zobrist::Castling(state.CastlingRights) ^ Zobrist::Castling(rights);
+      return key;
+    }
+
+    uint64_t Position::PawnKeyAfter(Move move) const
+    {
+      const Color us = m_SideToMove;
+      const Square from = move.From();
+      const Square to = move.To();
+      const Piece piece = PieceOn(from);
+
+      uint64_t key = State().PawnKey;
+      if (TypeOf(piece) == Pawn)
+        key ^= Zobrist::PieceSquare(piece, from) ^ (move.IsPromotion() ? 0ULL : Zobrist::PieceSquare(piece, to));
+
+      if (move.IsEnPassant())
+        key ^= Zobrist::PieceSquare(MakePiece(~us, Pawn), to - PawnPush(us));
+      else if (!move.IsCastling() && TypeOf(PieceOn(to)) == Pawn)
+        key ^= Zobrist::PieceSquare(PieceOn(to), to);
+      return key;
+    }
+
+    void Position::MakeMove(Move move)
+    {
+      m_States.emplace_back(m_States.back());
+      StateInfo& state = m_States.back();
+
+      const Color us = m_SideToMove;
+      const Color them = ~us;
+      const Square from = move.From();
+      const Square to = move.To();
+      const Piece piece = PieceOn(from);
+      Piece captured = move.IsEnPassant() ? MakePiece(them, Pawn) : PieceOn(to);
+
+      uint64_t key = state.Key ^ Zobrist::SideToMove();
+
+      state.LastMove = move;
+      state.Dirty.Count = 0;
+      state.HalfmoveClock++;
+      state.PliesFromNull++;
+      m_GamePly++;
+
+      if (state.EnPassant != NoSquare)
+      {
+        key ^= Zobrist::EnPassant(state.EnPassant);
+        state.EnPassant = NoSquare;
+      }
+
+      if (move.IsCastling())
+      {
+        const bool kingSide = move.Flag() == MoveFlag::KingCastle;
+        const Square rookFrom = kingSide ? to + 1 : to - 2;
+        const Square rookTo = kingSide ? to - 1 : to + 1;
+        const Piece rook = MakePiece(us, Rook);
+
+        Position::MovePieceOnBoard(rookFrom, rookTo);
+        state.Dirty.Add(rook, rookFrom, rookTo);
+        key ^= Zobrist::PieceSquare(rook, rookFrom) ^ Zobrist::PieceSquare(rook, rookTo);
+        captured = NoPiece;
+      }
+
+      if (captured != NoPiece)
+      {
+        const Square capturedSquare = move.IsEnPassant() ? to - PawnPush(us) : to;
+        Position::RemovePiece(capturedSquare);
+        state.Dirty.Add(captured, capturedSquare, NoSquare);
+        key ^= Zobrist::PieceSquare(captured, capturedSquare);
+        state.HalfmoveClock = 0;
+
+        if (TypeOf(captured) == Pawn)
+          state.PawnKey ^= Zobrist::PieceSquare(captured, capturedSquare);
+      }
+
+      Position::MovePieceOnBoard(from, to);
+      state.Dirty.Add(piece, from, to);
+      key ^= Zobrist::PieceSquare(piece, from) ^ Zobrist::PieceSquare(piece, to);
+
+      if (TypeOf(piece) == Pawn)
+      {
+        state.HalfmoveClock = 0;
+        state.PawnKey ^= Zobrist::PieceSquare(piece, from) ^ Zobrist::PieceSquare(piece, to);
+
+        if (move.Flag() == MoveFlag::DoublePawnPush)
+        {
+          const Square enPassant = from + PawnPush(us);
+          if (Bitboards::PawnAttacks(us, enPassant) & Pieces(them, Pawn))
+          {
+            state.EnPassant = enPassant;
+            key ^= Zobrist::EnPassant(enPassant);
+          }
+        }
+        else if (move.IsPromotion())
+        {
+          const Piece promoted = MakePiece(us, move.PromotionType());
+          Position::RemovePiece(to);
+          Position::PutPiece(promoted, to);
+          state.Dirty.To[state.Dirty.Count - 1] = NoSquare;
+          state.Dirty.Add(promoted, NoSquare, to);
+          key ^= Zobrist::PieceSquare(piece, to) ^ Zobrist::PieceSquare(promoted, to);
+          state.PawnKey ^= Zobrist::PieceSquare(piece, to);
+        }
+      }
+
+      const uint8_t rights = state.CastlingRights & CastlingMask[from] & CastlingMask[to];
+      if (rights != state.CastlingRights)
+      {
+        key ^= Zobrist::Castling(state.CastlingRights) ^ Zobrist::Castling(rights);
+        state.CastlingRights = rights;
+      }
+
+      state.CapturedPiece = captured;
+      state.Key = key;
+      m_SideToMove = them;
+
+      Position::UpdateCheckInfo();
+    }
+
+    void Position::UnmakeMove()
+    {
+      const StateInfo& state = State();
+      const Move move = state.LastMove;
+      const Color us = ~m_SideToMove;
+      const Square from = move.From();
+      const Square to = move.To();
+
+      m_SideToMove = us;
+
+      if (move.IsPromotion())
+      {
+        Position::RemovePiece(to);
+        Position::PutPiece(MakePiece(us, Pawn), to);
+      }
+
+      Position::MovePieceOnBoard(to, from);
+
+      if (move.IsCastling())
+      {
+        const bool kingSide = move.Flag() == MoveFlag::KingCastle;
+        Position::MovePieceOnBoard(kingSide ? to - 1 : to + 1, kingSide ? to + 1 : to - 2);
+      }
+      else if (state.CapturedPiece != NoPiece)
+        Position::PutPiece(state.CapturedPiece, move.IsEnPassant() ? to - PawnPush(us) : to);
+
+      m_States.pop_back();
+      m_GamePly--;
+    }
+
+    void Position::MakeNullMove()
+    {
+      YK_ASSERT(!InCheck(), "Null move made while in check");
+
+      m_States.emplace_back(m_States.back());
+      StateInfo& state = m_States.back();
+
+      state.Key ^= Zobrist::SideToMove();
+      if (state.EnPassant != NoSquare)
+      {
+        state.Key ^= Zobrist::EnPassant(state.EnPassant);
+        state.EnPassant = NoSquare;
+      }
+
+      state.LastMove = Move::Null();
+      state.CapturedPiece = NoPiece;
+      state.Dirty.Count = 0;
+      state.HalfmoveClock++;
+      state.PliesFromNull = 0;
+      m_SideToMove = ~m_SideToMove;
+      m_GamePly++;
+
+      Position::UpdateCheckInfo();
+    }
+
+    void Position::UnmakeNullMove()
+    {
+      m_States.pop_back();
+      m_SideToMove = ~m_SideToMove;
+      m_GamePly--;
+    }
+
+    std::string Position::MoveToUCI(Move move)
+    {
+      if (!move)
+        return "0000";
+
+      std::string text;
+      text += static_cast<char>('a' + FileOf(move.From()));
+      text += static_cast<char>('1' + RankOf(move.From()));
+      text += static_cast<char>('a' + FileOf(move.To()));
+      text += static_cast<char>('1' + RankOf(move.To()));
+      if (move.IsPromotion())
+        text += PieceChars[8 + move.PromotionType()];
+      return text;
+    }
+
+    Move Position::ParseUCIMove(std::string_view text) const
+    {
+      MoveList moves;
+      MoveGen::GenerateLegal(*this, moves);
+
+      for (const ScoredMove& move : moves)
+        if (Position::MoveToUCI(move) == text)
+          return move;
+
+      return Move::None();
+    }
+
+    Move Position::ParseSANMove(std::string_view text) const
+    {
+      while (!text.empty() && std::string_view("+#!?").find(text.back()) != std::string_view::npos)
+        text.remove_suffix(1);
+
+      MoveList moves;
+      MoveGen::GenerateLegal(*this, moves);
+
+      if (text == "O-O" || text == "0-0" || text == "O-O-O" || text == "0-0-0")
+      {
+        const MoveFlag flag = (text.size() == 3) ? MoveFlag::KingCastle : MoveFlag::QueenCastle;
+        for (const ScoredMove& move : moves)
+          if (move.Flag() == flag)
+            return move;
+        return Move::None();
+      }
+
+      PieceType promotion = NoPieceType;
+      if (text.size() > 2 && std::string_view("NBRQ").find(text.back()) != std::string_view::npos)
+      {
+        promotion = static_cast<PieceType>(PieceChars.find(text.back()));
+        text.remove_suffix(1);
+        if (!text.empty() && text.back() == '=')
+          text.remove_suffix(1);
+      }
+
+      if (text.size() < 2)
+        return Move::None();
+
+      const char file = text[text.size() - 2];
+      const char rank = text[text.size() - 1];
+      if (file < 'a' || file > 'h' || rank < '1' || rank > '8')
+        return Move::None();
+      const Square to = MakeSquare(file - 'a', rank - '1');
+      text.remove_suffix(2);
+
+      PieceType type = Pawn;
+      if (!text.empty() && std::string_view("NBRQK").find(text.front()) != std::string_view::npos)
+      {
+        type = static_cast<PieceType>(PieceChars.find(text.front()));
+        text.remove_prefix(1);
+      }
+
+      // What is left is the disambiguation, possibly followed by the capture mark
+      if (!text.empty() && text.back() == 'x')
+        text.remove_suffix(1);
+
+      int32_t fromFile = -1;
+      int32_t fromRank = -1;
+      for (const char c : text)
+      {
+        if (c >= 'a' && c <= 'h')
+          fromFile = c - 'a';
+        else if (c >= '1' && c <= '8')
+          fromRank = c - '1';
+        else
+          return Move::None();
+      }
+
+      Move found = Move::None();
+      for (const ScoredMove& move : moves)
+      {
+        if (move.To() != to || TypeOf(PieceOn(move.From())) != type)
+          continue;
+        if ((fromFile >= 0 && FileOf(move.From()) != fromFile) || (fromRank >= 0 && RankOf(move.From()) != fromRank))
+          continue;
+        if ((move.IsPromotion() ? move.PromotionType() : NoPieceType) != promotion)
+          continue;
+
+        // Ambiguous text matches nothing rather than a guess
+        if (found)
+          return Move::None();
+        found = move;
+      }
+
+      return found;
+    }
+
+    void Position::PutPiece(Piece piece, Square square)
+    {
+      const Bitboard bit = SquareBB(square);
+      m_Board[square] = piece;
+      m_ByType[NoPieceType] |= bit;
+      m_ByType[TypeOf(piece)] |= bit;
+      m_ByColor[ColorOf(piece)] |= bit;
+      m_PSQT += PSQT::PieceSquare[piece][square];
+      m_Phase += PSQT::PhaseWeight[TypeOf(piece)];
+    }
+
+    void Position::RemovePiece(Square square)
+    {
+      const Piece piece = m_Board[square];
+      const Bitboard bit = SquareBB(square);
+      m_ByType[NoPieceType] ^= bit;
+      m_ByType[TypeOf(piece)] ^= bit;
+      m_ByColor[ColorOf(piece)] ^= bit;
+      m_Board[square] = NoPiece;
+      m_PSQT -= PSQT::PieceSquare[piece][square];
+      m_Phase -= PSQT::PhaseWeight[TypeOf(piece)];
+    }
+
+    void Position::MovePieceOnBoard(Square from, Square to)
+    {
+      const Piece piece = m_Board[from];
+      const Bitboard fromTo = SquareBB(from) | SquareBB(to);
+      m_ByType[NoPieceType] ^= fromTo;
+      m_ByType[TypeOf(piece)] ^= fromTo;
+      m_ByColor[ColorOf(piece)] ^= fromTo;
+      m_Board[from] = NoPiece;
+      m_Board[to] = piece;
+      m_PSQT += PSQT::PieceSquare[piece][to] - PSQT::PieceSquare[piece][from];
+    }
+
+    void Position::UpdateCheckInfo()
+    {
+      StateInfo& state = State();
+      const Color us = m_SideToMove;
+
+      state.Checkers = AttackersTo(KingSquare(us), Pieces()) & Pieces(~us);
+      state.Blockers[White] = SliderBlockers(Pieces(Black), KingSquare(White), state.Pinners[Black]);
+      state.Blockers[Black] = SliderBlockers(Pieces(White), KingSquare(Black), state.Pinners[White]);
+    }
+
+    Bitboard Position::SliderBlockers(Bitboard sliders, Square square, Bitboard& pinners) const
+    {
+      Bitboard blockers = 0ULL;
+      pinners = 0ULL;
+
+      Bitboard snipers = ((Bitboards::RookAttacks(square, 0ULL) & Pieces(Queen, Rook)) | (Bitboards::BishopAttacks(square, 0ULL) & Pieces(Queen, Bishop))) & sliders;
+      const Bitboard occupancy = Pieces() ^ snipers;
+
+      while (snipers)
+      {
+        const Square sniper = PopLSB(snipers);
+        const Bitboard between = Bitboards::Between(square, sniper) & occupancy;
+
+        if (between && !MoreThanOne(between))
+        {
+          blockers |= between;
+          if (between & Pieces(ColorOf(PieceOn(square))))
+            pinners |= SquareBB(sniper);
+        }
+      }
+
+      return blockers;
+    }
+
+    uint64_t Position::ComputeKey() const
+    {
+      uint64_t key = 0ULL;
+
+      for (Bitboard pieces = Pieces(); pieces;)
+      {
+        const Square square = PopLSB(pieces);
+        key ^= Zobrist::PieceSquare(PieceOn(square), square);
+      }
+
+      key ^= Zobrist::Castling(CastlingRights());
+      if (EnPassantSquare() != NoSquare)
+        key ^= Zobrist::EnPassant(EnPassantSquare());
+      if (m_SideToMove == Black)
+        key ^= Zobrist::SideToMove();
+
+      return key;
+    }
+
+    uint64_t Position::ComputePawnKey() const
+    {
+      uint64_t key = 0ULL;
+
+      for (Bitboard pawns = Pieces(Pawn); pawns;)
+      {
+        const Square square = PopLSB(pawns);
+        key ^= Zobrist::PieceSquare(PieceOn(square), square);
+      }
+
+      return key;
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "GameLogic/Chess/Engine/Bitboards.h"
+#include "GameLogic/Chess/Engine/Types.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    constexpr std::string_view StartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    constexpr std::array<int32_t, PieceTypeCount> SEEValue = { 0, 100, 300, 300, 500, 900, 0 };
+
+    // Pieces changed by the move that led to a position, what the network accumulators need to follow it
+    struct DirtyPieces
+    {
+      int32_t Count = 0;
+      Piece Pieces[3] = { NoPiece, NoPiece, NoPiece };
+      Square From[3] = { NoSquare, NoSquare, NoSquare }; // NoSquare when the piece was added
+      Square To[3] = { NoSquare, NoSquare, NoSquare };   // NoSquare when the piece was removed
+
+      void Add(Piece piece, Square from, Square to) { Pieces[Count] = piece; From[Count] = from; To[Count] = to; Count++; }
+    };
+
+    // Everything needed to take a move back, plus data derived once per position
+    struct StateInfo
+    {
+      uint64_t Key = 0ULL;
+      uint64_t PawnKey = 0ULL;
+      uint8_t CastlingRights = NoCastling;
+      Square EnPassant = NoSquare;
+      int32_t HalfmoveClock = 0;
+      int32_t PliesFromNull = 0;
+
+      Move LastMove;
+      Piece CapturedPiece = NoPiece;
+      DirtyPieces Dirty;
+
+      Bitboard Checkers = 0ULL;
+      Bitboard Blockers[ColorCount] = { 0ULL, 0ULL };
+      Bitboard Pinners[ColorCount] = { 0ULL, 0ULL };
+    };
+
+    class Position
+    {
+    public:
+      Position();
+
+      static Position StartPosition();
+
+      bool SetFEN(std::string_view fen);
+      std::string GetFEN() const;
+
+      Bitboard Pieces() const { return m_ByType[NoPieceType]; }
+      Bitboard Pieces(Color color) const { return m_ByColor[color]; }
+      Bitboard Pieces(PieceType type) const { return m_ByType[type]; }
+      Bitboard Pieces(PieceType first, PieceType second) const { return m_ByType[first] | m_ByType[second]; }
+      Bitboard Pieces(Color color, PieceType type) const { return m_ByColor[color] & m_ByType[type]; }
+      Bitboard Pieces(Color color, PieceType first, PieceType second) const { return m_ByColor[color] & (m_ByType[first] | m_ByType[second]); }
+
+      Piece PieceOn(Square square) const { return m_Board[square]; }
+      Piece MovedPiece(Move move) const { return m_Board[move.From()]; }
+      Square KingSquare(Color color) const { return LSB(Pieces(color, King)); }
+      int32_t Count(Color color, PieceType type) const { return PopCount(Pieces(color, type)); }
+      bool HasNonPawnMaterial(Color color) const { return Pieces(color) & ~Pieces(Pawn, King); }
+
+      // Kept up to date by every piece placement, the evaluation only has to blend the two halves
+      Score PSQT() const { return m_PSQT; }
+      int32_t Phase() const { return m_Phase; }
+
+      Color SideToMove() const { return m_SideToMove; }
+      int32_t GamePly() const { return m_GamePly; }
+      uint64_t Key() const { return State().Key; }
+      uint64_t PawnKey() const { return State().PawnKey; }
+      uint8_t CastlingRights() const { return State().CastlingRights; }
+      Square EnPassantSquare() const { return State().EnPassant; }
+      int32_t HalfmoveClock() const { return State().HalfmoveClock; }
+      Move LastMove() const { return State().LastMove; }
+      Piece CapturedPiece() const { return State().CapturedPiece; }
+
+      // States of the moves played so far, index 0 is the position set by SetFEN
+      int32_t StateIndex() const { return static_cast<int32_t>(m_States.size()) - 1; }
+      const StateInfo& StateAt(int32_t index) const { return m_States[index]; }
+
+      Bitboard Checkers() const { return State().Checkers; }
+      bool InCheck() const { return State().Checkers != 0ULL; }
+      Bitboard BlockersForKing(Color color) const { return State().Blockers[color]; }
+
+      Bitboard AttackersTo(Square square, Bitboard occupied) const;
+      bool IsAttacked(Square square, Color attacker) const;
+
+      bool IsPseudoLegal(Move move) const;
+      bool IsLegal(Move move) const;
+      bool GivesCheck(Move move) const;
+      bool SEEGreaterEqual(Move move, int32_t threshold) const;
+
+      // The keys after the move without making it, to prefetch with. Only an en passant square the move would create is left out
+      uint64_t KeyAfter(Move move) const;
+      uint64_t PawnKeyAfter(Move move) const;
+      bool IsDraw(int32_t ply) const;
+
+      void MakeMove(Move move);
+      void UnmakeMove();
+      void MakeNullMove();
+      void UnmakeNullMove();
+
+      static std::string MoveToUCI(Move move);
+      Move ParseUCIMove(std::string_view text) const;
+      // Standard algebraic notation as found in PGN files, check marks and annotations are ignored
+      Move ParseSANMove(std::string_view text) const;
+
+    private:
+      void PutPiece(Piece piece, Square square);
+      void RemovePiece(Square square);
+      void MovePieceOnBoard(Square from, Square to);
+
+      void UpdateCheckInfo();
+      Bitboard SliderBlockers(Bitboard sliders, Square square, Bitboard& pinners) const;
+      uint64_t ComputeKey() const;
+      uint64_t ComputePawnKey() const;
+
+      StateInfo& State() { return m_States.back(); }
+      const StateInfo& State() const { return m_States.back(); }
+
+    private:
+      std::array<Piece, 64> m_Board;
+      Bitboard m_ByType[PieceTypeCount];
+      Bitboard m_ByColor[ColorCount];
+
+      Color m_SideToMove = White;
+      int32_t m_GamePly = 0;
+
+      Score m_PSQT = 0;
+      int32_t m_Phase = 0;
+
+      std::vector<StateInfo> m_States;
+    };
+  }
+}
\ No newline at end of file
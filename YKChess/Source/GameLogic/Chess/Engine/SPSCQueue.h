@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace yk
+{
+  namespace Chess
+  {
+    // Bounded lock-free queue for exactly one producer thread and one consumer thread.
+    // Each side keeps a cached copy of the other side's index and only touches the shared one when it runs out
+    template<typename T, size_t Capacity>
+    class SPSCQueue
+    {
+      static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+      // Producer only, false when the queue is full
+      bool TryPush(T&& value)
+      {
+        const size_t head = m_Head.load(std::memory_order_relaxed);
+        if (head - m_CachedTail == Capacity)
+        {
+          m_CachedTail = m_Tail.load(std::memory_order_acquire);
+          if (head - m_CachedTail == Capacity)
+            return false;
+        }
+
+        m_Slots[head & (Capacity - 1)] = std::move(value);
+        m_Head.store(head + 1, std::memory_order_release);
+        return true;
+      }
+
+      // Consumer only, false when the queue is empty
+      bool TryPop(T& value)
+      {
+        const size_t tail = m_Tail.load(std::memory_order_relaxed);
+        if (tail == m_CachedHead)
+        {
+          m_CachedHead = m_Head.load(std::memory_order_acquire);
+          if (tail == m_CachedHead)
+            return false;
+        }
+
+        value = std::move(m_Slots[tail & (Capacity - 1)]);
+        m_Tail.store(tail + 1, std::memory_order_release);
+        return true;
+      }
+
+    private:
+      alignas(64) std::atomic<size_t> m_Head = 0;
+      size_t m_CachedTail = 0;
+
+      alignas(64) std::atomic<size_t> m_Tail = 0;
+      size_t m_CachedHead = 0;
+
+      alignas(64) std::array<T, Capacity> m_Slots;
+    };
+  }
+}
\ No newline at end of file
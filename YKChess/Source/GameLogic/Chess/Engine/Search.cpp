@@ -0,0 +1,1147 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/Bitbases.h"
+#include "GameLogic/Chess/Engine/Evaluation.h"
+#include "GameLogic/Chess/Engine/Search.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      // Shallowest null move verification, the reduced depth often leaves nothing but the quiescence search which
+      // stands pat and verifies nothing. Never deeper than one ply below the node
+      constexpr int32_t NullVerificationDepth = 3;
+
+      // Logarithmic late move reductions in plies, indexed by depth and move number
+      const std::array<std::array<int8_t, 64>, 64> Reductions = []()
+        {
+        std::array<std::array<int8_t, 64>, 64> table = {};
+        for (int32_t depth = 1; depth < 64; depth++)
+          for (int32_t moveCount = 1; moveCount < 64; moveCount++)
+            table[depth][moveCount] = static_cast<int8_t>(0.75 + std::log(depth) * std::log(moveCount) / 2.25);
+        return table;
+        }();
+    }
+
+    void SearchStats::Clear()
+    {
+      Nodes.store(0, std::memory_order_relaxed);
+      QNodes = 0;
+      TTProbes = 0;
+      TTHits = 0;
+      TTCutoffs = 0;
+      BetaCutoffs = 0;
+      FirstMoveCutoffs = 0;
+      PawnProbes = 0;
+      PawnHits = 0;
+      TablebaseHits = 0;
+      BitbaseHits = 0;
+      NullMoveTries = 0;
+      NullMoveCutoffs = 0;
+      ReducedSearches = 0;
+      ReducedResearches = 0;
+      CutoffsBySource.fill(0);
+    }
+
+    void SearchStats::Accumulate(const SearchStats& other)
+    {
+      Nodes.store(Nodes.load(std::memory_order_relaxed) + other.Nodes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      QNodes += other.QNodes;
+      TTProbes += other.TTProbes;
+      TTHits += other.TTHits;
+      TTCutoffs += other.TTCutoffs;
+      BetaCutoffs += other.BetaCutoffs;
+      FirstMoveCutoffs += other.FirstMoveCutoffs;
+      PawnProbes += other.PawnProbes;
+      PawnHits += other.PawnHits;
+      TablebaseHits += other.TablebaseHits;
+      BitbaseHits += other.BitbaseHits;
+      NullMoveTries += other.NullMoveTries;
+      NullMoveCutoffs += other.NullMoveCutoffs;
+      ReducedSearches += other.ReducedSearches;
+      ReducedResearches += other.ReducedResearches;
+      for (size_t i = 0; i < CutoffsBySource.size(); i++)
+        CutoffsBySource[i] += other.CutoffsBySource[i];
+    }
+
+    double SearchReport::EffectiveBranchingFactor() const
+    {
+      // Iterations of a few nodes are dominated by the transposition table, they say little about the tree
+      constexpr size_t Window = 4;
+      if (Iterations.size() < 3)
+        return 0.0;
+
+      const size_t last = Iterations.size() - 1;
+      const size_t first = std::max(last - std::min(last - 1, Window), size_t(1));
+      auto iterationNodes = [this](size_t index) { return static_cast<double>(Iterations[index].Nodes - Iterations[index - 1].Nodes); };
+
+      const double firstNodes = iterationNodes(first);
+      if (firstNodes <= 0.0 || last == first)
+        return 0.0;
+      return std::pow(iterationNodes(last) / firstNodes, 1.0 / static_cast<double>(last - first));
+    }
+
+    std::string SearchReport::ToJSON() const
+    {
+      auto rate = [](uint64_t part, uint64_t whole) { return whole ? static_cast<double>(part) / static_cast<double>(whole) : 0.0; };
+      auto writeStats = [&rate](std::ostringstream& out, const SearchStats& stats)
+        {
+        const uint64_t nodes = stats.Nodes.load(std::memory_order_relaxed);
+        out << "{\"nodes\":" << nodes << ",\"qnodes\":" << stats.QNodes
+          << ",\"tt_probes\":" << stats.TTProbes << ",\"tt_hits\":" << stats.TTHits << ",\"tt_cutoffs\":" << stats.TTCutoffs
+          << ",\"tt_hit_rate\":" << rate(stats.TTHits, stats.TTProbes)
+          << ",\"beta_cutoffs\":" << stats.BetaCutoffs << ",\"first_move_cutoff_rate\":" << rate(stats.FirstMoveCutoffs, stats.BetaCutoffs)
+          << ",\"null_move_tries\":" << stats.NullMoveTries << ",\"null_move_success_rate\":" << rate(stats.NullMoveCutoffs, stats.NullMoveTries)
+          << ",\"reduced_searches\":" << stats.ReducedSearches << ",\"lmr_success_rate\":" << 1.0 - rate(stats.ReducedResearches, stats.ReducedSearches)
+          << ",\"pawn_hit_rate\":" << rate(stats.PawnHits, stats.PawnProbes)
+          << ",\"tablebase_hits\":" << stats.TablebaseHits << ",\"bitbase_hits\":" << stats.BitbaseHits
+          << ",\"cutoffs_by_source\":[";
+        for (size_t i = 0; i < stats.CutoffsBySource.size(); i++)
+          out << (i ? "," : "") << stats.CutoffsBySource[i];
+        out << "]}";
+        };
+
+      std::ostringstream out;
+      out << "{\"best_move\":\"" << Position::MoveToUCI(Result.BestMove) << "\",\"score\":" << Result.Score << ",\"depth\":" << Result.Depth
+        << ",\"nodes\":" << Result.Nodes << ",\"time_ms\":" << Result.Time << ",\"nps\":" << NodesPerSecond()
+        << ",\"effective_branching_factor\":" << EffectiveBranchingFactor() << ",\"total\":";
+      writeStats(out, Total);
+
+      out << ",\"threads\":[";
+      for (size_t i = 0; i < Threads.size(); i++)
+      {
+        out << (i ? "," : "");
+        writeStats(out, Threads[i]);
+      }
+
+      out << "],\"iterations\":[";
+      for (size_t i = 0; i < Iterations.size(); i++)
+      {
+        const IterationStats& iteration = Iterations[i];
+        const IterationStats previous = i ? Iterations[i - 1] : IterationStats();
+        out << (i ? "," : "") << "{\"depth\":" << iteration.Depth << ",\"nodes\":" << iteration.Nodes - previous.Nodes
+          << ",\"time_ms\":" << iteration.Time - previous.Time << "}";
+      }
+      out << "]}";
+      return out.str();
+    }
+
+    SearchWorker::SearchWorker(Search& search, int32_t index)
+      : m_Search(search), m_Index(index), m_Ordering(std::make_unique<MoveOrdering>()), m_PawnTable(std::make_unique<PawnTable>()),
+        m_Accumulators(std::make_unique<NNUE::AccumulatorStack>())
+    {
+    }
+
+    void SearchWorker::Prepare(const Position& position, const std::vector<Move>& root_moves)
+    {
+      m_Position = position;
+      m_Stats.Clear();
+      m_Ordering->ClearKillers();
+      m_PawnTable->ClearStats();
+
+      // Accumulators are keyed by position only, they cannot tell which network filled them
+      if (m_Search.m_Network.get() != m_AccumulatorNetwork)
+      {
+        m_Accumulators->Clear();
+        m_AccumulatorNetwork = m_Search.m_Network.get();
+      }
+
+      m_BestMove = Move::None();
+      m_BestScore = 0;
+      m_CompletedDepth = 0;
+      m_BestExact = false;
+      m_BestPV.clear();
+      m_Iterations.clear();
+
+      m_RootMoves.clear();
+      for (const Move move : root_moves)
+        m_RootMoves.emplace_back(move);
+      m_PVIndex = 0;
+
+      m_NullMoveMinPly = 0;
+      m_ThrottleMark = std::chrono::steady_clock::now();
+
+      // Two sentinel entries in front of the root so that ss - 2 is always valid
+      for (size_t i = 0; i < m_Stack.size(); i++)
+      {
+        m_Stack[i] = SearchStackEntry();
+        m_Stack[i].ContinuationHistory = m_Ordering->GetSentinelTable();
+        m_Stack[i].Ply = static_cast<int32_t>(i) - 2;
+      }
+    }
+
+    void SearchWorker::Clear()
+    {
+      m_Ordering->Clear();
+      m_PawnTable->Clear();
+    }
+
+    void SearchWorker::IterativeDeepening()
+    {
+      SearchStackEntry* ss = &m_Stack[2];
+      const bool rootBounds = m_Search.m_Options.RootBounds;
+
+      for (int32_t depth = 1; depth <= m_Search.m_Limits.Depth && !m_RootMoves.empty() && !m_Search.ShouldStop(); depth++)
+      {
+        // Helpers skip some depths so that they spread over the tree instead of shadowing the main worker
+        if (!IsMain() && depth > 1 && (depth + m_Index) % 3 == 0)
+          continue;
+
+        if (rootBounds && !SearchWorker::WaitForRootBound(depth))
+          break;
+
+        for (RootMove& rootMove : m_RootMoves)
+          rootMove.PreviousScore = rootMove.Score;
+        bool exact = true;
+
+        const size_t multiPV = std::min(static_cast<size_t>(std::max(m_Search.m_Options.MultiPV, 1)), m_RootMoves.size());
+
+        for (m_PVIndex = 0; m_PVIndex < multiPV && !m_Search.ShouldStop(); m_PVIndex++)
+        {
+          const uint64_t lineStartNodes = m_Stats.Nodes.load(std::memory_order_relaxed);
+          const int32_t previous = m_RootMoves[m_PVIndex].PreviousScore;
+
+          int32_t delta = 25;
+          int32_t alpha = -ScoreInfinite;
+          int32_t beta = ScoreInfinite;
+
+          if (depth >= 5 && previous != -ScoreInfinite)
+          {
+            alpha = std::max(previous - delta, -ScoreInfinite);
+            beta = std::min(previous + delta, ScoreInfinite);
+          }
+
+          // Aspiration window, widened on every fail
+          while (true)
+          {
+            // A bound found elsewhere is where alpha starts, nothing below it can be the best move
+            const int32_t shared = rootBounds ? m_Search.m_RootBounds[depth].load(std::memory_order_relaxed) : -ScoreInfinite;
+            if (shared > alpha)
+            {
+              alpha = shared;
+              beta = std::max(beta, std::min(shared + delta, ScoreInfinite));
+            }
+
+            const int32_t score = AlphaBeta<true>(alpha, beta, depth, ss);
+            std::stable_sort(m_RootMoves.begin() + m_PVIndex, m_RootMoves.end());
+
+            if (m_Search.ShouldStop())
+              break;
+
+            // Every move here loses to one searched elsewhere, widening would only prove that again
+            if (rootBounds && score <= m_Search.m_RootBounds[depth].load(std::memory_order_relaxed))
+            {
+              exact = false;
+              break;
+            }
+
+            if (score <= alpha)
+            {
+              beta = (alpha + beta) / 2;
+              alpha = std::max(score - delta, -ScoreInfinite);
+            }
+            else if (score >= beta)
+              beta = std::min(score + delta, ScoreInfinite);
+            else
+              break;
+
+            delta += delta / 2;
+          }
+
+          m_RootMoves[m_PVIndex].LineNodes = m_Stats.Nodes.load(std::memory_order_relaxed) - lineStartNodes;
+          std::stable_sort(m_RootMoves.begin(), m_RootMoves.begin() + m_PVIndex + 1);
+        }
+
+        // An interrupted iteration is not trusted, the previous one stands
+        if (m_Search.ShouldStop())
+          break;
+
+        m_CompletedDepth = depth;
+        m_BestExact = exact;
+        m_BestScore = m_RootMoves[0].Score;
+        m_BestMove = m_RootMoves[0].PV[0];
+        m_BestPV = m_RootMoves[0].PV;
+
+        if (IsMain())
+        {
+          AnalysisUpdate update;
+          update.Depth = depth;
+          update.Nodes = m_Search.GetTotalNodes();
+          update.Time = m_Search.GetElapsed();
+          m_Iterations.push_back({ depth, update.Nodes, update.Time });
+          for (size_t i = 0; i < multiPV; i++)
+            update.Lines.push_back({ m_RootMoves[i].Score, m_RootMoves[i].LineNodes, m_RootMoves[i].PV, exact ? Bound::Exact : Bound::Upper });
+
+          // Nobody is reading when the queue is full, dropping the update is fine
+          m_Search.m_Analysis.TryPush(std::move(update));
+
+          if (!m_Search.IsPondering() && !m_Search.m_Time.ShouldContinue(m_BestMove, m_BestScore, m_Search.GetTotalNodes() - m_Search.m_PonderHitNodes,
+            m_Search.GetElapsed()))
+            m_Search.m_Stop = true;
+        }
+      }
+    }
+
+    template<bool PVNode>
+    int32_t SearchWorker::AlphaBeta(int32_t alpha, int32_t beta, int32_t depth, SearchStackEntry* ss)
+    {
+      if (depth <= 0)
+        return Quiescence<PVNode>(alpha, beta, ss);
+
+      const int32_t ply = ss->Ply;
+      const bool rootNode = PVNode && ply == 0;
+      m_PVLength[ply] = ply;
+
+      SearchWorker::CountNode();
+      if (m_Search.ShouldStop())
+        return 0;
+
+      const bool inCheck = m_Position.InCheck();
+
+      if (!rootNode)
+      {
+        if (m_Position.IsDraw(ply))
+          return ScoreDraw;
+        if (ply >= MaxPly)
+          return inCheck ? ScoreDraw : SearchWorker::Evaluate();
+
+        // Mate distance pruning, no line from here can beat a shorter mate already found
+        alpha = std::max(MatedIn(ply), alpha);
+        beta = std::min(MateIn(ply + 1), beta);
+        if (alpha >= beta)
+          return alpha;
+      }
+
+      TranspositionTable& table = *m_Search.m_Table;
+      const uint64_t key = m_Position.Key();
+      bool found = false;
+      TTEntry* entry = table.Probe(key, found);
+      m_Stats.TTProbes++;
+      m_Stats.TTHits += found;
+
+      const Move ttMove = rootNode ? m_RootMoves[m_PVIndex].PV[0] : (found ? entry->GetMove() : Move::None());
+      const int32_t ttScore = found ? TranspositionTable::ScoreFromTT(entry->GetScore(), ply, m_Position.HalfmoveClock()) : ScoreNone;
+
+      if (!PVNode && found && entry->GetDepth() >= depth && ttScore != ScoreNone)
+      {
+        const uint8_t needed = static_cast<uint8_t>(ttScore >= beta ? Bound::Lower : Bound::Upper);
+        if (static_cast<uint8_t>(entry->GetBound()) & needed)
+        {
+          m_Stats.TTCutoffs++;
+          return ttScore;
+        }
+      }
+
+      const SearchOptions& options = m_Search.m_Options;
+
+      int32_t bestScore = -ScoreInfinite;
+      int32_t maxScore = ScoreInfinite;
+
+      // Tablebase probe, only right after a capture or pawn move since the tables know nothing of the fifty move counter
+      const int32_t tablebasePieces = m_Search.m_TablebasePieces;
+      if (!rootNode && tablebasePieces)
+      {
+        const int32_t pieceCount = PopCount(m_Position.Pieces());
+        if (pieceCount <= tablebasePieces && (pieceCount < tablebasePieces || depth >= options.TablebaseProbeDepth)
+          && m_Position.HalfmoveClock() == 0 && !m_Position.CastlingRights())
+        {
+          ProbeState state;
+          const WDLScore wdl = Tablebases::ProbeWDL(m_Position, state);
+          if (state != ProbeState::Fail)
+          {
+            m_Stats.TablebaseHits++;
+
+            const int32_t drawScore = options.TablebaseRule50 ? 1 : 0;
+            const int32_t score = (wdl < -drawScore) ? -ScoreTablebaseWin + ply
+              : (wdl > drawScore) ? ScoreTablebaseWin - ply : ScoreDraw + 2 * wdl * drawScore;
+            const Bound tablebaseBound = (wdl < -drawScore) ? Bound::Upper : ((wdl > drawScore) ? Bound::Lower : Bound::Exact);
+
+            if (tablebaseBound == Bound::Exact || (tablebaseBound == Bound::Lower ? score >= beta : score <= alpha))
+            {
+              entry->Save(key, TranspositionTable::ScoreToTT(score, ply), ScoreNone, tablebaseBound, std::min(MaxPly - 1, depth + 6), Move::None(), PVNode, table.GetGeneration());
+              return score;
+            }
+
+            // Only a bound, the search goes on to find the actual line
+            if (PVNode)
+            {
+              if (tablebaseBound == Bound::Lower)
+              {
+                bestScore = score;
+                alpha = std::max(alpha, bestScore);
+              }
+              else
+                maxScore = score;
+            }
+          }
+        }
+      }
+
+      int32_t staticEval = ScoreNone;
+      if (!inCheck)
+        staticEval = (found && entry->GetEval() != ScoreNone) ? entry->GetEval() : SearchWorker::Evaluate();
+      ss->StaticEval = staticEval;
+
+      // Whether the position got better since our previous move, selective margins are tighter when it did not
+      const bool improving = !inCheck && (ss - 2)->StaticEval != ScoreNone && staticEval > (ss - 2)->StaticEval;
+
+      if (!PVNode && !inCheck)
+      {
+        // Razoring, hopeless positions near the horizon go straight to quiescence
+        if (options.Razoring && depth <= 3 && staticEval + 200 + 250 * depth * depth <= alpha)
+        {
+          const int32_t score = Quiescence<false>(alpha - 1, alpha, ss);
+          if (score < alpha)
+            return score;
+        }
+
+        // Reverse futility, the static eval is so far above beta that a shallow search will not bring it back
+        if (options.ReverseFutility && depth <= 8 && staticEval - 80 * (depth - improving) >= beta && staticEval < ScoreMateInMaxPly)
+          return staticEval;
+
+        // Null move, if passing still fails high the position is good enough to cut
+        if (options.NullMove && depth >= 3 && staticEval >= beta && (ss - 1)->CurrentMove != Move::Null()
+          && m_Position.HasNonPawnMaterial(m_Position.SideToMove())
+          && (ply >= m_NullMoveMinPly || m_Position.SideToMove() != m_NullMoveColor))
+        {
+          const int32_t reduction = 3 + depth / 3 + std::min((staticEval - beta) / 200, 3);
+
+          ss->CurrentMove = Move::Null();
+          ss->MovedPiece = NoPiece;
+          ss->ContinuationHistory = m_Ordering->GetSentinelTable();
+
+          m_Stats.NullMoveTries++;
+          m_Position.MakeNullMove();
+          int32_t score = -AlphaBeta<false>(-beta, -beta + 1, depth - reduction, ss + 1);
+          m_Position.UnmakeNullMove();
+
+          if (m_Search.ShouldStop())
+            return 0;
+
+          if (score >= beta)
+          {
+            if (score >= ScoreTablebaseWinInMaxPly)
+              score = beta;
+
+            // A lone minor piece or a deep node is where zugzwang fools the null move, verify with a reduced
+            // search that cannot use the null move itself for the next few plies
+            const Color us = m_Position.SideToMove();
+            const bool zugzwangProne = !MoreThanOne(m_Position.Pieces(us) & ~m_Position.Pieces(Pawn, King));
+            if (!options.NullMoveVerification || m_NullMoveMinPly || (depth < 12 && !zugzwangProne))
+            {
+              m_Stats.NullMoveCutoffs++;
+              return score;
+            }
+
+            const int32_t verificationDepth = std::min(std::max(depth - reduction, NullVerificationDepth), depth - 1);
+            m_NullMoveMinPly = ply + 3 * verificationDepth / 4;
+            m_NullMoveColor = us;
+            const int32_t verified = AlphaBeta<false>(beta - 1, beta, verificationDepth, ss);
+            m_NullMoveMinPly = 0;
+
+            if (verified >= beta)
+            {
+              m_Stats.NullMoveCutoffs++;
+              return score;
+            }
+          }
+        }
+      }
+
+      PieceToHistory* continuation[2] = { (ss - 1)->ContinuationHistory, (ss - 2)->ContinuationHistory };
+      const Move previousMove = (ss - 1)->CurrentMove;
+      const Piece previousPiece = (ss - 1)->MovedPiece;
+      const Move counterMove = (previousPiece != NoPiece) ? m_Ordering->GetCounterMove(previousPiece, previousMove.To()) : Move::None();
+
+      MovePicker picker(m_Position, *m_Ordering, ttMove, ply, continuation, counterMove);
+
+      Move quietsTried[64];
+      Piece quietPieces[64];
+      int32_t quietCount = 0;
+
+      Move bestMove;
+      int32_t moveCount = 0;
+      bool skipQuiets = false;
+      Move move;
+
+      while ((move = picker.Next(skipQuiets)))
+      {
+        if (rootNode && std::find(m_RootMoves.begin() + m_PVIndex, m_RootMoves.end(), move) == m_RootMoves.end())
+          continue;
+
+        // A bound arriving from elsewhere mid-iteration applies to the moves still to come
+        if (rootNode && options.RootBounds)
+        {
+          const int32_t shared = m_Search.m_RootBounds[depth].load(std::memory_order_relaxed);
+          if (shared > alpha && shared < beta)
+            alpha = shared;
+        }
+
+        SearchWorker::PrefetchChild(move);
+        if (!m_Position.IsLegal(move))
+          continue;
+
+        moveCount++;
+
+        const Piece piece = m_Position.MovedPiece(move);
+        const bool givesCheck = m_Position.GivesCheck(move);
+        const bool quiet = move.IsQuiet();
+        const int32_t history = quiet ? m_Ordering->QuietScore(m_Position.SideToMove(), piece, move, continuation) : 0;
+
+        // Pruning at shallow depth, only once something not losing has been found
+        if (!rootNode && bestScore > ScoreMatedInMaxPly && m_Position.HasNonPawnMaterial(m_Position.SideToMove()))
+        {
+          // Late move pruning, enough quiets have been tried that the rest are very unlikely to matter
+          if (options.LateMovePruning && !skipQuiets && moveCount >= (3 + depth * depth) / (2 - improving))
+            skipQuiets = true;
+
+          if (quiet && !givesCheck && !inCheck)
+          {
+            const int32_t lmrDepth = std::max(depth - 1 - Reduction(improving, depth, moveCount), 0);
+
+            // Futility, even a generous margin over the static eval does not reach alpha
+            if (options.Futility && lmrDepth <= 7 && staticEval + 100 + 120 * lmrDepth <= alpha)
+              continue;
+
+            if (skipQuiets)
+              continue;
+          }
+        }
+
+        ss->CurrentMove = move;
+        ss->MovedPiece = piece;
+        ss->ContinuationHistory = m_Ordering->GetContinuationTable(piece, move.To());
+
+        m_Position.MakeMove(move);
+
+        // Check extension
+        const int32_t newDepth = depth - 1 + (givesCheck ? 1 : 0);
+
+        int32_t score = 0;
+        bool fullDepthSearch = !PVNode || moveCount > 1;
+
+        // Late move reductions, later moves are searched shallower and only re-searched if they beat alpha
+        if (options.LateMoveReductions && depth >= 3 && moveCount > 1 + rootNode && (quiet || picker.GetLastSource() == MoveSource::BadCapture))
+        {
+          int32_t reduction = Reduction(improving, depth, moveCount);
+          reduction -= PVNode;
+          reduction -= (picker.GetLastSource() == MoveSource::Killer || picker.GetLastSource() == MoveSource::CounterMove);
+          reduction += (ttMove && ttMove.IsCapture());
+          reduction -= givesCheck;
+          reduction -= history / 8192;
+
+          const int32_t reducedDepth = std::clamp(newDepth - reduction, 1, newDepth);
+          m_Stats.ReducedSearches++;
+          score = -AlphaBeta<false>(-alpha - 1, -alpha, reducedDepth, ss + 1);
+
+          fullDepthSearch = score > alpha && reducedDepth < newDepth;
+          m_Stats.ReducedResearches += fullDepthSearch;
+        }
+
+        if (fullDepthSearch)
+          score = -AlphaBeta<false>(-alpha - 1, -alpha, newDepth, ss + 1);
+
+        if (PVNode && (moveCount == 1 || (score > alpha && score < beta)))
+          score = -AlphaBeta<true>(-beta, -alpha, newDepth, ss + 1);
+
+        m_Position.UnmakeMove();
+
+        if (m_Search.ShouldStop())
+          return 0;
+
+        if (rootNode)
+        {
+          // Moves that did not beat alpha only have an upper bound, they sort behind every exact score
+          RootMove& rootMove = *std::find(m_RootMoves.begin() + m_PVIndex, m_RootMoves.end(), move);
+          if (moveCount == 1 || score > alpha)
+          {
+            // However the other moves turn out, the best one scores at least this at this depth
+            if (options.RootBounds && score > alpha)
+            {
+              std::lock_guard<std::mutex> lock(m_Search.m_SharedMutex);
+              if (score > m_Search.m_CollectedBounds[depth])
+              {
+                m_Search.m_CollectedBounds[depth] = score;
+                m_Search.m_PendingBounds.push_back({ depth, score });
+              }
+            }
+
+            rootMove.Score = score;
+            rootMove.PV.assign(1, move);
+            rootMove.PV.insert(rootMove.PV.end(), m_PVTable[1].begin() + 1, m_PVTable[1].begin() + m_PVLength[1]);
+          }
+          else
+            rootMove.Score = -ScoreInfinite;
+        }
+
+        if (score > bestScore)
+        {
+          bestScore = score;
+
+          if (score > alpha)
+          {
+            bestMove = move;
+            if (PVNode)
+              SearchWorker::UpdatePV(ply, move);
+
+            if (score >= beta)
+            {
+              m_Stats.BetaCutoffs++;
+              m_Stats.FirstMoveCutoffs += (moveCount == 1);
+              m_Stats.CutoffsBySource[static_cast<size_t>(picker.GetLastSource())]++;
+              break;
+            }
+
+            alpha = score;
+          }
+        }
+
+        if (move != bestMove && quiet && quietCount < 64)
+        {
+          quietsTried[quietCount] = move;
+          quietPieces[quietCount++] = piece;
+        }
+      }
+
+      if (!moveCount)
+        return inCheck ? MatedIn(ply) : ScoreDraw;
+
+      if (bestScore >= beta && bestMove.IsQuiet())
+        m_Ordering->UpdateQuietStats(m_Position.SideToMove(), ply, depth, m_Position.MovedPiece(bestMove), bestMove, quietsTried, quietPieces, quietCount, continuation, previousPiece, previousMove.To());
+
+      if (PVNode)
+        bestScore = std::min(bestScore, maxScore);
+
+      const Bound bound = (bestScore >= beta) ? Bound::Lower : ((PVNode && bestMove) ? Bound::Exact : Bound::Upper);
+      entry->Save(key, TranspositionTable::ScoreToTT(bestScore, ply), staticEval, bound, depth, bestMove, PVNode, table.GetGeneration());
+      if (options.ShareDepth && depth >= options.ShareDepth)
+      {
+        std::lock_guard<std::mutex> lock(m_Search.m_SharedMutex);
+        m_Search.m_SharedEntries.push_back({ key, static_cast<int16_t>(TranspositionTable::ScoreToTT(bestScore, ply)), bestMove.Data,
+          static_cast<uint8_t>(depth), bound });
+      }
+
+      return bestScore;
+    }
+
+    template<bool PVNode>
+    int32_t SearchWorker::Quiescence(int32_t alpha, int32_t beta, SearchStackEntry* ss)
+    {
+      const int32_t ply = ss->Ply;
+      m_PVLength[ply] = ply;
+
+      SearchWorker::CountNode();
+      m_Stats.QNodes++;
+      if (m_Search.ShouldStop())
+        return 0;
+
+      if (m_Position.IsDraw(ply))
+        return ScoreDraw;
+
+      const bool inCheck = m_Position.InCheck();
+      if (ply >= MaxPly)
+        return inCheck ? ScoreDraw : SearchWorker::Evaluate();
+
+      TranspositionTable& table = *m_Search.m_Table;
+      const uint64_t key = m_Position.Key();
+      bool found = false;
+      TTEntry* entry = table.Probe(key, found);
+      m_Stats.TTProbes++;
+      m_Stats.TTHits += found;
+
+      const Move ttMove = found ? entry->GetMove() : Move::None();
+      const int32_t ttScore = found ? TranspositionTable::ScoreFromTT(entry->GetScore(), ply, m_Position.HalfmoveClock()) : ScoreNone;
+
+      if (!PVNode && found && ttScore != ScoreNone)
+      {
+        const uint8_t needed = static_cast<uint8_t>(ttScore >= beta ? Bound::Lower : Bound::Upper);
+        if (static_cast<uint8_t>(entry->GetBound()) & needed)
+        {
+          m_Stats.TTCutoffs++;
+          return ttScore;
+        }
+      }
+
+      int32_t staticEval = ScoreNone;
+      int32_t bestScore = -ScoreInfinite;
+
+      if (!inCheck)
+      {
+        staticEval = (found && entry->GetEval() != ScoreNone) ? entry->GetEval() : SearchWorker::Evaluate();
+        bestScore = staticEval;
+
+        // Stand pat
+        if (bestScore >= beta)
+        {
+          if (!found)
+            entry->Save(key, TranspositionTable::ScoreToTT(bestScore, ply), staticEval, Bound::Lower, 0, Move::None(), false, table.GetGeneration());
+          return bestScore;
+        }
+        alpha = std::max(alpha, bestScore);
+      }
+
+      const PieceToHistory* continuation[2] = { (ss - 1)->ContinuationHistory, (ss - 2)->ContinuationHistory };
+      MovePicker picker(m_Position, *m_Ordering, ttMove, continuation);
+
+      Move bestMove;
+      int32_t moveCount = 0;
+      Move move;
+
+      while ((move = picker.Next()))
+      {
+        SearchWorker::PrefetchChild(move);
+        if (!m_Position.IsLegal(move))
+          continue;
+
+        moveCount++;
+
+        if (!inCheck && !m_Position.SEEGreaterEqual(move, 0))
+          continue;
+
+        const Piece piece = m_Position.MovedPiece(move);
+        ss->CurrentMove = move;
+        ss->MovedPiece = piece;
+        ss->ContinuationHistory = m_Ordering->GetContinuationTable(piece, move.To());
+
+        m_Position.MakeMove(move);
+        const int32_t score = -Quiescence<PVNode>(-beta, -alpha, ss + 1);
+        m_Position.UnmakeMove();
+
+        if (m_Search.ShouldStop())
+          return 0;
+
+        if (score > bestScore)
+        {
+          bestScore = score;
+
+          if (score > alpha)
+          {
+            bestMove = move;
+            if (PVNode)
+              SearchWorker::UpdatePV(ply, move);
+
+            if (score >= beta)
+              break;
+
+            alpha = score;
+          }
+        }
+      }
+
+      if (inCheck && !moveCount)
+        return MatedIn(ply);
+
+      entry->Save(key, TranspositionTable::ScoreToTT(bestScore, ply), staticEval, (bestScore >= beta) ? Bound::Lower : Bound::Upper, 0, bestMove, PVNode, table.GetGeneration());
+      return bestScore;
+    }
+
+    void SearchWorker::PrefetchChild(Move move)
+    {
+      if (!m_Search.m_Options.Prefetch)
+        return;
+
+      m_Search.m_Table->Prefetch(m_Position.KeyAfter(move));
+      // The network never looks at the pawn table
+      if (!m_Search.m_Network)
+        m_PawnTable->Prefetch(m_Position.PawnKeyAfter(move));
+    }
+
+    int32_t SearchWorker::Evaluate()
+    {
+      const NNUE::Network* network = m_Search.m_Network.get();
+      const int32_t score = network ? network->Evaluate(m_Position, *m_Accumulators) : Evaluation::Evaluate(m_Position, *m_PawnTable);
+
+      // Small endgames are scored by their bitbase result, the evaluation only steers a won one towards the mate
+      if (PopCount(m_Position.Pieces()) <= Bitbases::MaxPieces)
+      {
+        const BitbaseResult result = Bitbases::Probe(m_Position);
+        if (result != BitbaseResult::Unknown)
+        {
+          m_Stats.BitbaseHits++;
+          if (result == BitbaseResult::Draw)
+            return ScoreDraw;
+          return (result == BitbaseResult::Win) ? ScoreKnownWin + score : -ScoreKnownWin + score;
+        }
+      }
+
+      return score;
+    }
+
+    int32_t SearchWorker::Reduction(bool improving, int32_t depth, int32_t move_count) const
+    {
+      const int32_t reduction = Reductions[std::min(depth, 63)][std::min(move_count, 63)];
+      return reduction + (!improving && reduction > 1);
+    }
+
+    void SearchWorker::CountNode()
+    {
+      const uint64_t nodes = m_Stats.Nodes.load(std::memory_order_relaxed) + 1;
+      m_Stats.Nodes.store(nodes, std::memory_order_relaxed);
+
+      if ((nodes & 1023) == 0)
+      {
+        if (IsMain())
+          m_Search.CheckLimits(*this);
+        if (m_Search.IsPondering())
+          SearchWorker::Throttle();
+      }
+    }
+
+    void SearchWorker::Throttle()
+    {
+      const double share = m_Search.m_Options.PonderShare;
+      const auto now = std::chrono::steady_clock::now();
+      if (share >= 1.0)
+      {
+        m_ThrottleMark = now;
+        return;
+      }
+
+      // Sleep in proportion to the time just spent searching, so that over time the worker only uses its share
+      const auto worked = now - m_ThrottleMark;
+      if (worked >= std::chrono::milliseconds(2))
+      {
+        std::this_thread::sleep_for(std::chrono::duration_cast<std::chrono::microseconds>(worked * ((1.0 - std::max(share, 0.05)) / std::max(share, 0.05))));
+        m_ThrottleMark = std::chrono::steady_clock::now();
+      }
+    }
+
+    bool SearchWorker::WaitForRootBound(int32_t depth)
+    {
+      // The first depth is cheap, and a worker whose last score beat every bound likely holds the best move, it goes first
+      if (depth == 1 || (m_BestExact && m_BestScore >= m_Search.m_RootBounds[depth - 1].load(std::memory_order_relaxed)))
+        return true;
+
+      if (IsMain())
+        m_Search.m_RootGateWait = depth;
+      while (m_Search.m_RootBounds[depth].load(std::memory_order_relaxed) == -ScoreInfinite && m_Search.m_RootGate.load(std::memory_order_relaxed) < depth &&
+        !m_Search.ShouldStop())
+      {
+        if (IsMain())
+          m_Search.CheckLimits(*this);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      if (IsMain())
+        m_Search.m_RootGateWait = 0;
+
+      m_ThrottleMark = std::chrono::steady_clock::now();
+      return !m_Search.ShouldStop();
+    }
+
+    void SearchWorker::UpdatePV(int32_t ply, Move move)
+    {
+      m_PVTable[ply][ply] = move;
+      for (int32_t i = ply + 1; i < m_PVLength[ply + 1]; i++)
+        m_PVTable[ply][i] = m_PVTable[ply + 1][i];
+      m_PVLength[ply] = std::max(m_PVLength[ply + 1], ply + 1);
+    }
+
+    Search::~Search()
+    {
+      Search::Stop();
+      Search::Wait();
+    }
+
+    std::shared_ptr<Search> Search::Create(std::shared_ptr<TranspositionTable> table, int32_t threads)
+    {
+      std::shared_ptr<Search> search(new Search());
+      search->m_Table = table;
+      search->SetThreadCount(threads);
+      return search;
+    }
+
+    void Search::Start(const Position& position, const SearchLimits& limits)
+    {
+      Search::Stop();
+      Search::Wait();
+
+      m_RootPosition = position;
+      m_Limits = limits;
+      m_Options = m_PendingOptions;
+      // Bounds on the best score say nothing about the later lines
+      m_Options.RootBounds = m_Options.RootBounds && m_Options.MultiPV <= 1;
+      for (std::atomic<int32_t>& bound : m_RootBounds)
+        bound = -ScoreInfinite;
+      m_CollectedBounds.fill(-ScoreInfinite);
+      m_PendingBounds.clear();
+      m_RootGate = 0;
+      m_RootGateWait = 0;
+      // The checksum is left for the first search using the network, loading stays a bare mapping
+      m_Network = (m_PendingNetwork && m_PendingNetwork->Verify()) ? m_PendingNetwork : nullptr;
+      m_Time.Init(limits, position.SideToMove(), position.GamePly());
+      m_StartTime = std::chrono::steady_clock::now();
+      m_PonderHitNodes = 0;
+      m_Stop = false;
+      m_Pondering = limits.Ponder;
+      m_Searching = true;
+      if (m_Options.AgeTable)
+        m_Table->NewSearch();
+
+      MoveList moves;
+      MoveGen::GenerateLegal(position, moves);
+      m_RootMoves.assign(moves.begin(), moves.end());
+      auto asked = [&limits](Move move) { return std::find(limits.SearchMoves.begin(), limits.SearchMoves.end(), move) != limits.SearchMoves.end(); };
+      if (std::any_of(m_RootMoves.begin(), m_RootMoves.end(), asked))
+        std::erase_if(m_RootMoves, [&asked](Move move) { return !asked(move); });
+
+      // Only the moves keeping the best tablebase result are searched. With distance to zeroing behind them the
+      // tree would only find the same result again, with bare WDL it still helps to probe for the conversions
+      m_TablebasePieces = std::min(m_Options.TablebasePieces, Tablebases::GetMaxPieces());
+      m_RootTablebaseHits = 0;
+      if (m_TablebasePieces >= PopCount(position.Pieces()) && !position.CastlingRights())
+      {
+        Position root = position;
+        const size_t legalCount = m_RootMoves.size();
+        bool usedDTZ = false;
+        if (Tablebases::FilterRootMoves(root, m_RootMoves, m_Options.TablebaseRule50, usedDTZ))
+        {
+          m_RootTablebaseHits = legalCount;
+          if (usedDTZ)
+            m_TablebasePieces = 0;
+        }
+      }
+
+      // Neither go searchmoves nor a share of the root moves splitting them between searches says what the position is worth
+      m_CacheResult = m_RootMoves.size() == moves.size() && !m_Options.RootBounds;
+      m_Cache = m_PendingCache;
+      if (m_Cache)
+        Search::WarmFromCache(position);
+
+      for (auto& worker : m_Workers)
+        worker->Prepare(position, m_RootMoves);
+
+      m_MainThread = std::thread([this]()
+        {
+        std::vector<std::thread> helpers;
+        for (size_t i = 1; i < m_Workers.size(); i++)
+          helpers.emplace_back([this, i]() { m_Workers[i]->IterativeDeepening(); });
+
+        m_Workers[0]->IterativeDeepening();
+
+        // The result of a ponder search is only wanted once the opponent has moved
+        m_Pondering.wait(true);
+
+        m_Stop = true;
+        for (std::thread& helper : helpers)
+          helper.join();
+
+        const SearchWorker& main = *m_Workers[0];
+        SearchResult result;
+        result.BestMove = main.GetBestMove();
+        result.Score = main.GetBestScore();
+        result.Depth = main.GetCompletedDepth();
+        result.PV = main.GetBestPV();
+        result.Nodes = GetTotalNodes();
+        result.Time = GetElapsed();
+
+        // Stopped before the first iteration completed, any legal move beats none
+        if (!result.BestMove && !m_RootMoves.empty())
+          result.BestMove = m_RootMoves[0];
+        if (result.PV.size() > 1)
+          result.PonderMove = result.PV[1];
+
+        m_Result = result;
+        if (m_Cache && m_CacheResult && result.Depth >= m_Options.AnalysisCacheDepth && !result.PV.empty())
+          m_Cache->Store(m_RootPosition.Key(), { result.Depth, result.Score, Bound::Exact, result.PV });
+        // Only held while searching, a cache replaced in between is closed as soon as it is let go
+        m_Cache.reset();
+        if (!m_Options.StatsFile.empty())
+        {
+          std::ofstream file(m_Options.StatsFile, std::ios::trunc);
+          file << GetReport().ToJSON() << '\n';
+          if (!file)
+            YK_ERROR("[ENGINE] Cannot write search statistics to '{}'", m_Options.StatsFile.string());
+        }
+        m_Searching = false;
+        });
+    }
+
+    void Search::TakeSharedEntries(std::vector<SharedEntry>& entries)
+    {
+      std::lock_guard<std::mutex> lock(m_SharedMutex);
+      entries.insert(entries.end(), m_SharedEntries.begin(), m_SharedEntries.end());
+      m_SharedEntries.clear();
+    }
+
+    void Search::ImportEntries(const std::vector<SharedEntry>& entries)
+    {
+      for (const SharedEntry& shared : entries)
+      {
+        bool found = false;
+        TTEntry* entry = m_Table->Probe(shared.Key, found);
+        entry->Save(shared.Key, shared.Score, ScoreNone, shared.Bound, shared.Depth, Move(shared.Move), false, m_Table->GetGeneration());
+      }
+    }
+
+    void Search::TakeRootBounds(std::vector<RootBound>& bounds)
+    {
+      std::lock_guard<std::mutex> lock(m_SharedMutex);
+      bounds.insert(bounds.end(), m_PendingBounds.begin(), m_PendingBounds.end());
+      m_PendingBounds.clear();
+    }
+
+    void Search::SetRootBound(const RootBound& bound)
+    {
+      if (bound.Depth < 1 || bound.Depth >= MaxPly)
+        return;
+
+      std::atomic<int32_t>& current = m_RootBounds[bound.Depth];
+      int32_t previous = current.load();
+      while (bound.Score > previous && !current.compare_exchange_weak(previous, bound.Score));
+    }
+
+    void Search::OpenRootGate(int32_t depth)
+    {
+      int32_t previous = m_RootGate.load();
+      while (depth > previous && !m_RootGate.compare_exchange_weak(previous, depth));
+    }
+
+    void Search::WarmFromCache(const Position& position)
+    {
+      // The line is searched as PV nodes, which never cut on the table, so no iteration is saved and the moves are only
+      // ordered. In fresh processes about a tenth fewer nodes over a set of positions, single ones up to a third either
+      // way. Centring the aspiration window on the cached score or starting at the cached depth did no better
+      CachedAnalysis root;
+      if (!m_Cache->Probe(position.Key(), root))
+        return;
+
+      // The first iteration searches the root moves in the order given
+      const auto best = std::find(m_RootMoves.begin(), m_RootMoves.end(), root.PV[0]);
+      if (best != m_RootMoves.end())
+        std::rotate(m_RootMoves.begin(), best, best + 1);
+
+      // Positions of the line with a result of their own get it, with its bound, the others only their move
+      Position line = position;
+      for (size_t i = 0; i < root.PV.size(); i++)
+      {
+        const Move move = root.PV[i];
+        if (!line.IsPseudoLegal(move) || !line.IsLegal(move))
+          break;
+
+        CachedAnalysis known;
+        bool found = false;
+        TTEntry* entry = m_Table->Probe(line.Key(), found);
+        if (i == 0 || m_Cache->Probe(line.Key(), known))
+        {
+          const CachedAnalysis& analysis = (i == 0) ? root : known;
+          entry->Save(line.Key(), analysis.Score, ScoreNone, analysis.Bound, analysis.Depth, move, true, m_Table->GetGeneration());
+        }
+        else
+          entry->Save(line.Key(), ScoreNone, ScoreNone, Bound::None, 0, move, true, m_Table->GetGeneration());
+        line.MakeMove(move);
+      }
+    }
+
+    void Search::Stop()
+    {
+      m_Stop = true;
+      m_Pondering = false;
+      m_Pondering.notify_all();
+    }
+
+    void Search::PonderHit()
+    {
+      // The main worker leaves the time manager alone until it sees the pondering end, which is published last
+      if (m_Pondering)
+      {
+        m_Time.PonderHit();
+        m_PonderHitNodes = GetTotalNodes();
+      }
+      m_StartTime = std::chrono::steady_clock::now();
+      m_Pondering = false;
+      m_Pondering.notify_all();
+    }
+
+    void Search::Wait()
+    {
+      if (m_MainThread.joinable())
+        m_MainThread.join();
+    }
+
+    void Search::NewGame()
+    {
+      Search::Stop();
+      Search::Wait();
+
+      m_Table->Clear();
+      for (auto& worker : m_Workers)
+        worker->Clear();
+    }
+
+    void Search::SetThreadCount(int32_t threads)
+    {
+      Search::Stop();
+      Search::Wait();
+
+      m_Workers.clear();
+      for (int32_t i = 0; i < std::max(threads, 1); i++)
+        m_Workers.push_back(std::make_unique<SearchWorker>(*this, i));
+    }
+
+    SearchResult Search::GetResult() const
+    {
+      return m_Result;
+    }
+
+    SearchStats Search::GetStats() const
+    {
+      SearchStats stats;
+      stats.TablebaseHits = m_RootTablebaseHits;
+      for (const auto& worker : m_Workers)
+      {
+        stats.Accumulate(worker->GetStats());
+        stats.PawnProbes += worker->GetPawnTable().GetProbes();
+        stats.PawnHits += worker->GetPawnTable().GetHits();
+      }
+      return stats;
+    }
+
+    SearchReport Search::GetReport() const
+    {
+      SearchReport report;
+      report.Result = m_Result;
+      report.Total = Search::GetStats();
+      for (const auto& worker : m_Workers)
+      {
+        SearchStats& stats = report.Threads.emplace_back(worker->GetStats());
+        stats.PawnProbes += worker->GetPawnTable().GetProbes();
+        stats.PawnHits += worker->GetPawnTable().GetHits();
+      }
+      if (!m_Workers.empty())
+        report.Iterations = m_Workers[0]->GetIterations();
+      return report;
+    }
+
+    void Search::CheckLimits(const SearchWorker& main)
+    {
+      // Never stop before one iteration is complete, a move has to come out of the search
+      if (main.GetCompletedDepth() < 1 || IsPondering())
+        return;
+
+      if (m_Limits.Nodes && GetTotalNodes() >= m_Limits.Nodes)
+        m_Stop = true;
+      if (m_Time.IsTimed() && GetElapsed() >= m_Time.GetMaximum())
+        m_Stop = true;
+    }
+
+    uint64_t Search::GetTotalNodes() const
+    {
+      uint64_t nodes = 0;
+      for (const auto& worker : m_Workers)
+        nodes += worker->GetStats().Nodes.load(std::memory_order_relaxed);
+      return nodes;
+    }
+
+    int64_t Search::GetElapsed() const
+    {
+      return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_StartTime.load()).count();
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,393 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GameLogic/Chess/Engine/AnalysisCache.h"
+#include "GameLogic/Chess/Engine/MovePicker.h"
+#include "GameLogic/Chess/Engine/NNUE.h"
+#include "GameLogic/Chess/Engine/PawnTable.h"
+#include "GameLogic/Chess/Engine/Position.h"
+#include "GameLogic/Chess/Engine/SPSCQueue.h"
+#include "GameLogic/Chess/Engine/Tablebases.h"
+#include "GameLogic/Chess/Engine/TimeManager.h"
+#include "GameLogic/Chess/Engine/TranspositionTable.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    struct SearchLimits
+    {
+      int32_t Depth = MaxPly - 1;
+      uint64_t Nodes = 0;
+      int64_t MoveTime = 0; // Milliseconds, 0 means no limit
+
+      // Clock in milliseconds, used when MoveTime is not set
+      int64_t Time[ColorCount] = { 0, 0 };
+      int64_t Increment[ColorCount] = { 0, 0 };
+      int32_t MovesToGo = 0;
+
+      // Searching the expected reply on the opponent's time, limits only apply after PonderHit
+      bool Ponder = false;
+
+      // Only these root moves are searched, all of them when none of these is legal
+      std::vector<Move> SearchMoves;
+    };
+
+    // Every selective technique can be switched off on its own so that its gain can be measured
+    struct SearchOptions
+    {
+      bool NullMove = true;
+      bool NullMoveVerification = true;
+      bool LateMoveReductions = true;
+      bool ReverseFutility = true;
+      bool Futility = true;
+      bool LateMovePruning = true;
+      bool Razoring = true;
+
+      // Number of best root moves searched with their own window, each later one excluding the ones before it
+      int32_t MultiPV = 1;
+
+      // Fraction of each worker's time spent searching while pondering, the rest is slept away
+      double PonderShare = 1.0;
+
+      // Tablebases are probed inside the tree with at most this many pieces, with exactly this many only from the probe depth up
+      int32_t TablebasePieces = Tablebases::MaxPieces;
+      int32_t TablebaseProbeDepth = 1;
+      // Cursed wins and blessed losses are draws under the fifty move rule
+      bool TablebaseRule50 = true;
+
+      // Every search ages the table so that the entries of earlier ones are replaced first. Searches running at the
+      // same time on one table turn it off, whoever owns the table ages it once for all of them
+      bool AgeTable = true;
+
+      // Finished searches at least this deep are written back to the analysis cache
+      int32_t AnalysisCacheDepth = 12;
+
+      // Table entries stored at least this deep are also collected for TakeSharedEntries, none when 0
+      int32_t ShareDepth = 0;
+
+      // For searches splitting the root moves between them: every root score beating alpha is collected for TakeRootBounds,
+      // and bounds given to SetRootBound raise alpha at the root. A depth is only started once a bound for it is known,
+      // unless the last one ended with an exact score at least as good as every bound, or the gate is opened
+      bool RootBounds = false;
+
+      // The table and pawn entries of a child are fetched while its move is still being checked, does not change the search
+      bool Prefetch = true;
+
+      // The report of every finished search is written there as JSON, nowhere when empty
+      std::filesystem::path StatsFile;
+    };
+
+    // A table entry with its whole key, as handed between searches that do not share a table
+    struct SharedEntry
+    {
+      uint64_t Key = 0ULL;
+      int16_t Score = 0; // As stored in the table
+      uint16_t Move = 0;
+      uint8_t Depth = 0;
+      Chess::Bound Bound = Chess::Bound::None;
+    };
+
+    // Some root move scores at least this at the depth, found by one of the searches sharing the root
+    struct RootBound
+    {
+      int32_t Depth = 0;
+      int32_t Score = -ScoreInfinite;
+    };
+
+    struct SearchResult
+    {
+      Move BestMove;
+      Move PonderMove;
+      int32_t Score = 0;
+      int32_t Depth = 0;
+      uint64_t Nodes = 0;
+      int64_t Time = 0;
+      std::vector<Move> PV;
+    };
+
+    struct AnalysisLine
+    {
+      int32_t Score = 0;
+      uint64_t Nodes = 0; // Spent finding this line at the last completed depth
+      std::vector<Move> PV;
+      // Upper when every move lost to a root bound, see SearchOptions::RootBounds
+      Chess::Bound Bound = Chess::Bound::Exact;
+    };
+
+    // Ranked lines of one completed depth, streamed from the main worker to whoever displays them
+    struct AnalysisUpdate
+    {
+      int32_t Depth = 0;
+      uint64_t Nodes = 0;
+      int64_t Time = 0;
+      std::vector<AnalysisLine> Lines;
+    };
+
+    struct RootMove
+    {
+      int32_t Score = -ScoreInfinite;
+      int32_t PreviousScore = -ScoreInfinite;
+      uint64_t LineNodes = 0;
+      std::vector<Move> PV;
+
+      explicit RootMove(Move move) : PV(1, move) {}
+
+      bool operator==(Move move) const { return PV[0] == move; }
+      bool operator<(const RootMove& other) const { return (Score != other.Score) ? Score > other.Score : PreviousScore > other.PreviousScore; }
+    };
+
+    // Padded to a cache line so that workers never write to a line another worker reads
+    struct alignas(64) SearchStats
+    {
+      std::atomic<uint64_t> Nodes = 0;
+      uint64_t QNodes = 0;
+      uint64_t TTProbes = 0;
+      uint64_t TTHits = 0;
+      uint64_t TTCutoffs = 0;
+      uint64_t BetaCutoffs = 0;
+      uint64_t FirstMoveCutoffs = 0;
+      uint64_t PawnProbes = 0;
+      uint64_t PawnHits = 0;
+      uint64_t TablebaseHits = 0;
+      uint64_t BitbaseHits = 0;
+      uint64_t NullMoveTries = 0;
+      uint64_t NullMoveCutoffs = 0;
+      uint64_t ReducedSearches = 0;
+      uint64_t ReducedResearches = 0;
+      std::array<uint64_t, static_cast<size_t>(MoveSource::Count)> CutoffsBySource = {};
+
+      SearchStats() = default;
+      SearchStats(const SearchStats& other) { Accumulate(other); }
+      SearchStats& operator=(const SearchStats& other) { Clear(); Accumulate(other); return *this; }
+
+      void Clear();
+      void Accumulate(const SearchStats& other);
+    };
+
+    // Totals at the end of one completed depth of the main worker
+    struct IterationStats
+    {
+      int32_t Depth = 0;
+      uint64_t Nodes = 0;
+      int64_t Time = 0;
+    };
+
+    // Everything known about a finished search, gathered only when asked for so that the counters stay plain per thread increments
+    struct SearchReport
+    {
+      SearchResult Result;
+      SearchStats Total;
+      std::vector<SearchStats> Threads;
+      std::vector<IterationStats> Iterations;
+
+      uint64_t NodesPerSecond() const { return Result.Nodes * 1000 / std::max<int64_t>(Result.Time, 1); }
+      // Geometric mean of the node growth over the last few iterations
+      double EffectiveBranchingFactor() const;
+      std::string ToJSON() const;
+    };
+
+    struct SearchStackEntry
+    {
+      PieceToHistory* ContinuationHistory = nullptr;
+      Move CurrentMove;
+      Piece MovedPiece = NoPiece;
+      int32_t StaticEval = ScoreNone;
+      int32_t Ply = 0;
+    };
+
+    class Search;
+
+    class SearchWorker
+    {
+    public:
+      SearchWorker(Search& search, int32_t index);
+
+      void Prepare(const Position& position, const std::vector<Move>& root_moves);
+      void IterativeDeepening();
+      void Clear();
+
+      bool IsMain() const { return m_Index == 0; }
+      const SearchStats& GetStats() const { return m_Stats; }
+      const PawnTable& GetPawnTable() const { return *m_PawnTable; }
+      Move GetBestMove() const { return m_BestMove; }
+      int32_t GetBestScore() const { return m_BestScore; }
+      int32_t GetCompletedDepth() const { return m_CompletedDepth; }
+      const std::vector<Move>& GetBestPV() const { return m_BestPV; }
+      const std::vector<IterationStats>& GetIterations() const { return m_Iterations; }
+
+    private:
+      template<bool PVNode>
+      int32_t AlphaBeta(int32_t alpha, int32_t beta, int32_t depth, SearchStackEntry* ss);
+      template<bool PVNode>
+      int32_t Quiescence(int32_t alpha, int32_t beta, SearchStackEntry* ss);
+
+      // The network when one is set, the hand written evaluation otherwise
+      int32_t Evaluate();
+      // Loads the entries the child will probe first while the move is still being checked and pruned
+      void PrefetchChild(Move move);
+      int32_t Reduction(bool improving, int32_t depth, int32_t move_count) const;
+
+      void CountNode();
+      void Throttle();
+      // Blocks at the start of a depth until it may be searched, see SearchOptions::RootBounds. False when stopped meanwhile
+      bool WaitForRootBound(int32_t depth);
+      void UpdatePV(int32_t ply, Move move);
+
+    private:
+      Search& m_Search;
+      int32_t m_Index;
+
+      Position m_Position;
+      std::unique_ptr<MoveOrdering> m_Ordering;
+      std::unique_ptr<PawnTable> m_PawnTable;
+      std::unique_ptr<NNUE::AccumulatorStack> m_Accumulators;
+      const NNUE::Network* m_AccumulatorNetwork = nullptr;
+      SearchStats m_Stats;
+
+      std::array<SearchStackEntry, MaxPly + 4> m_Stack;
+      std::array<std::array<Move, MaxPly + 1>, MaxPly + 1> m_PVTable;
+      std::array<int32_t, MaxPly + 1> m_PVLength;
+
+      // Root moves below m_PVIndex already have their line at this depth and are skipped at the root
+      std::vector<RootMove> m_RootMoves;
+      size_t m_PVIndex = 0;
+
+      // Null move is disabled for one side below this ply while a verification search runs
+      int32_t m_NullMoveMinPly = 0;
+      Color m_NullMoveColor = White;
+
+      std::chrono::steady_clock::time_point m_ThrottleMark;
+
+      Move m_BestMove;
+      int32_t m_BestScore = 0;
+      int32_t m_CompletedDepth = 0;
+      bool m_BestExact = false; // The last completed depth ended with a score, not below a root bound
+      std::vector<Move> m_BestPV;
+      std::vector<IterationStats> m_Iterations;
+    };
+
+    class Search
+    {
+    public:
+      ~Search();
+
+      static std::shared_ptr<Search> Create(std::shared_ptr<TranspositionTable> table, int32_t threads = 1);
+
+      void Start(const Position& position, const SearchLimits& limits);
+      void Stop();
+      void Wait();
+      bool IsSearching() const { return m_Searching.load(); }
+
+      // The expected reply was played, the ponder search becomes a normal timed search from this moment on
+      void PonderHit();
+      // Acquire, so that once it reads false the clock rebased by PonderHit is seen as well
+      bool IsPondering() const { return m_Pondering.load(std::memory_order_acquire); }
+
+      void NewGame();
+      void SetThreadCount(int32_t threads);
+
+      // Applies from the next Start
+      void SetOptions(const SearchOptions& options) { m_PendingOptions = options; }
+      const SearchOptions& GetOptions() const { return m_PendingOptions; }
+
+      // Evaluates with the network instead of the hand written terms, nullptr switches back. Applies from the next Start
+      void SetNetwork(std::shared_ptr<const NNUE::Network> network) { m_PendingNetwork = std::move(network); }
+      const std::shared_ptr<const NNUE::Network>& GetNetwork() const { return m_PendingNetwork; }
+
+      // Results kept across sessions warm the table at the root, deep ones are stored back. Applies from the next Start
+      void SetAnalysisCache(std::shared_ptr<AnalysisCache> cache) { m_PendingCache = std::move(cache); }
+      const std::shared_ptr<AnalysisCache>& GetAnalysisCache() const { return m_PendingCache; }
+
+      // Only meaningful once the search has finished
+      SearchResult GetResult() const;
+      SearchStats GetStats() const;
+      SearchReport GetReport() const;
+
+      // Entries collected since the last call, see SearchOptions::ShareDepth
+      void TakeSharedEntries(std::vector<SharedEntry>& entries);
+      // Stores entries of another search in the table, also while searching
+      void ImportEntries(const std::vector<SharedEntry>& entries);
+
+      // Root scores collected since the last call, see SearchOptions::RootBounds
+      void TakeRootBounds(std::vector<RootBound>& bounds);
+      // From another search of the same root, raises alpha at that depth. Bounds only rise
+      void SetRootBound(const RootBound& bound);
+      // Lets the search start that depth and every one before it without a bound
+      void OpenRootGate(int32_t depth);
+      // The depth the search is waiting for a bound at, 0 while it is not
+      int32_t GetRootGateWait() const { return m_RootGateWait.load(std::memory_order_relaxed); }
+
+      // Consumer side of the analysis stream, one update per completed depth
+      bool PollAnalysis(AnalysisUpdate& update) { return m_Analysis.TryPop(update); }
+
+    private:
+      friend class SearchWorker;
+
+      bool ShouldStop() const { return m_Stop.load(std::memory_order_relaxed); }
+      void CheckLimits(const SearchWorker& main);
+      uint64_t GetTotalNodes() const;
+      // Puts the cached best move first and the cached line into the table. Only an ordering hint, see the definition
+      void WarmFromCache(const Position& position);
+      int64_t GetElapsed() const;
+
+    private:
+      Search() = default;
+      Search(const Search&) = delete;
+      Search& operator=(const Search&) = delete;
+      Search(Search&&) = delete;
+      Search& operator=(Search&&) = delete;
+
+    private:
+      std::shared_ptr<TranspositionTable> m_Table;
+      std::vector<std::unique_ptr<SearchWorker>> m_Workers;
+      std::thread m_MainThread;
+
+      std::atomic<bool> m_Stop = false;
+      std::atomic<bool> m_Searching = false;
+      std::atomic<bool> m_Pondering = false;
+
+      Position m_RootPosition;
+      std::vector<Move> m_RootMoves;
+      SearchLimits m_Limits;
+      SearchOptions m_Options;
+      TimeManager m_Time;
+      SearchOptions m_PendingOptions;
+      std::shared_ptr<const NNUE::Network> m_Network;
+      std::shared_ptr<const NNUE::Network> m_PendingNetwork;
+      std::shared_ptr<AnalysisCache> m_Cache;
+      std::shared_ptr<AnalysisCache> m_PendingCache;
+      bool m_CacheResult = false; // Every legal root move is searched, a narrower search is no result of the position
+      std::atomic<std::chrono::steady_clock::time_point> m_StartTime;
+      std::atomic<uint64_t> m_PonderHitNodes = 0; // Searched before the ponder hit, not counted by the time manager
+
+      // 0 once the root moves are filtered by distance to zeroing, the tree has nothing left to learn from the tables
+      int32_t m_TablebasePieces = 0;
+      uint64_t m_RootTablebaseHits = 0;
+      SearchResult m_Result;
+
+      SPSCQueue<AnalysisUpdate, 64> m_Analysis;
+
+      // Deep stores are rare enough for a lock
+      std::mutex m_SharedMutex;
+      std::vector<SharedEntry> m_SharedEntries;
+
+      // By depth, see SearchOptions::RootBounds. Collected ones are guarded by the same lock
+      std::array<std::atomic<int32_t>, MaxPly> m_RootBounds;
+      std::array<int32_t, MaxPly> m_CollectedBounds;
+      std::vector<RootBound> m_PendingBounds;
+      std::atomic<int32_t> m_RootGate = 0;
+      std::atomic<int32_t> m_RootGateWait = 0;
+    };
+  }
+}
\ No newline at end of file
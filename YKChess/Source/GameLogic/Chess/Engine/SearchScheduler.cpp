@@ -0,0 +1,395 @@
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/Evaluation.h"
+#include "GameLogic/Chess/Engine/MoveGen.h"
+#include "GameLogic/Chess/Engine/SearchScheduler.h"
+#include "GameLogic/Chess/Engine/Task.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      using Clock = std::chrono::steady_clock;
+
+      constexpr size_t ArenaSize = 128 << 10; // Bytes of coroutine frames per search, a few dozen plies deep
+
+      constexpr int32_t TTMoveScore = 1 << 20;
+      constexpr int32_t CaptureScore = 1 << 16;
+
+      // Most valuable victim first, the least valuable attacker breaking ties
+      int32_t CaptureOrder(const Position& position, Move move)
+      {
+        return 8 * SEEValue[TypeOf(position.PieceOn(move.To()))] - SEEValue[TypeOf(position.MovedPiece(move))];
+      }
+
+      // Selection sort step, most nodes cut off long before the list would be fully sorted
+      ScoredMove NextMove(ScoredMove* current, ScoredMove* end)
+      {
+        std::swap(*current, *std::max_element(current, end, [](const ScoredMove& a, const ScoredMove& b) { return a.Score < b.Score; }));
+        return *current;
+      }
+    }
+
+    // A plain alpha-beta search with a quiescence search, every node a coroutine. Counting a node may suspend the whole
+    // search, the innermost coroutine is then remembered so the next slice continues right where this one stopped
+    class ScheduledSearch
+    {
+    public:
+      ScheduledSearch(const Position& position, const ScheduledLimits& limits, SearchScheduler::Callback callback, TranspositionTable& table, uint64_t slice_nodes)
+        : m_Arena(ArenaSize), m_Position(position), m_Limits(limits), m_Callback(std::move(callback)), m_Table(table), m_SliceNodes(slice_nodes)
+      {
+        m_Submitted = Clock::now();
+        m_Deadline = m_Submitted + std::chrono::milliseconds(limits.MoveTime);
+      }
+
+      ~ScheduledSearch()
+      {
+        // An unfinished search unwinds its frames into its own arena
+        FrameArena*& current = FrameArena::Current();
+        FrameArena* previous = current;
+        current = &m_Arena;
+        m_Root.reset();
+        current = previous;
+      }
+
+      Clock::time_point GetDeadline() const { return m_Deadline; }
+
+      // Runs one slice on the calling thread, true once the search is over
+      bool Resume(PawnTable& pawns)
+      {
+        FrameArena*& current = FrameArena::Current();
+        current = &m_Arena;
+        m_Pawns = &pawns;
+
+        if (!m_Root)
+        {
+          m_Root.emplace(ScheduledSearch::Run());
+          m_Resume = m_Root->GetHandle();
+        }
+        m_Resume.resume();
+
+        current = nullptr;
+        return m_Root->IsDone();
+      }
+
+      ScheduledResult TakeResult(SearchScheduler::Callback& callback)
+      {
+        m_Result.Nodes = m_Nodes;
+        m_Result.Latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - m_Submitted).count();
+        callback = std::move(m_Callback);
+        return m_Result;
+      }
+
+      bool MissedDeadline() const { return Clock::now() > m_Deadline; }
+
+    private:
+      struct NodeAwaiter
+      {
+        ScheduledSearch& Search;
+
+        bool await_ready() { return ++Search.m_Nodes % Search.m_SliceNodes != 0; }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+          Search.m_Resume = handle;
+          if (Search.m_Nodes >= Search.m_Limits.Nodes || Clock::now() >= Search.m_Deadline)
+            Search.m_Stop = true;
+        }
+        void await_resume() {}
+      };
+
+      NodeAwaiter CountNode() { return NodeAwaiter{ *this }; }
+
+      Task<int32_t> Run()
+      {
+        MoveList legal;
+        MoveGen::GenerateLegal(m_Position, legal);
+        if (legal.empty())
+        {
+          m_Result.Score = m_Position.InCheck() ? MatedIn(0) : ScoreDraw;
+          co_return m_Result.Score;
+        }
+
+        // Whatever happens the search answers with a legal move
+        m_Result.BestMove = legal[0];
+        std::vector<ScoredMove> rootMoves(legal.begin(), legal.end());
+
+        for (int32_t depth = 1; depth <= std::min(m_Limits.Depth, MaxPly - 1) && !m_Stop; depth++)
+        {
+          int32_t alpha = -ScoreInfinite;
+          Move best = Move::None();
+
+          for (ScoredMove& move : rootMoves)
+          {
+            m_Position.MakeMove(move);
+            const int32_t score = -co_await ScheduledSearch::AlphaBeta(-ScoreInfinite, -alpha, depth - 1, 1);
+            m_Position.UnmakeMove();
+
+            if (m_Stop)
+              break;
+            move.Score = score;
+            if (score > alpha)
+            {
+              alpha = score;
+              best = move;
+            }
+          }
+
+          // An iteration cut short is thrown away, its first moves were searched with a worse bound than the rest
+          if (m_Stop)
+            break;
+          m_Result.BestMove = best;
+          m_Result.Score = alpha;
+          m_Result.Depth = depth;
+          std::stable_sort(rootMoves.begin(), rootMoves.end(), [](const ScoredMove& a, const ScoredMove& b) { return a.Score > b.Score; });
+
+          if (alpha >= ScoreMateInMaxPly || alpha <= ScoreMatedInMaxPly)
+            break;
+        }
+        co_return m_Result.Score;
+      }
+
+      Task<int32_t> AlphaBeta(int32_t alpha, int32_t beta, int32_t depth, int32_t ply)
+      {
+        const bool inCheck = m_Position.InCheck();
+        if (depth <= 0 && !inCheck)
+          co_return co_await ScheduledSearch::Quiescence(alpha, beta, ply);
+
+        co_await ScheduledSearch::CountNode();
+        if (m_Stop)
+          co_return 0;
+        if (m_Position.IsDraw(ply))
+          co_return ScoreDraw;
+        if (ply >= MaxPly - 1)
+          co_return Evaluation::Evaluate(m_Position, *m_Pawns);
+        depth = std::max(depth, 1);
+
+        const uint64_t key = m_Position.Key();
+        bool found = false;
+        TTEntry* entry = m_Table.Probe(key, found);
+        const Move ttMove = found ? entry->GetMove() : Move::None();
+        if (found && entry->GetDepth() >= depth)
+        {
+          const int32_t ttScore = TranspositionTable::ScoreFromTT(entry->GetScore(), ply, m_Position.HalfmoveClock());
+          const uint8_t needed = static_cast<uint8_t>(ttScore >= beta ? Bound::Lower : Bound::Upper);
+          if (static_cast<uint8_t>(entry->GetBound()) & needed)
+            co_return ttScore;
+        }
+
+        ScoredMove moves[MaxMoves];
+        ScoredMove* end = MoveGen::Generate<GenType::All>(m_Position, moves);
+        for (ScoredMove* move = moves; move != end; move++)
+        {
+          if (*move == ttMove)
+            move->Score = TTMoveScore;
+          else if (m_Position.PieceOn(move->To()) != NoPiece)
+            move->Score = CaptureScore + CaptureOrder(m_Position, *move);
+          else
+            move->Score = 0;
+        }
+
+        const int32_t originalAlpha = alpha;
+        int32_t bestScore = -ScoreInfinite;
+        Move bestMove = Move::None();
+        for (ScoredMove* current = moves; current != end; current++)
+        {
+          const Move move = NextMove(current, end);
+          if (!m_Position.IsLegal(move))
+            continue;
+
+          // Checks are extended instead of ever reaching the quiescence search
+          m_Position.MakeMove(move);
+          const int32_t score = -co_await ScheduledSearch::AlphaBeta(-beta, -alpha, depth - 1 + m_Position.InCheck(), ply + 1);
+          m_Position.UnmakeMove();
+
+          if (m_Stop)
+            co_return 0;
+          if (score > bestScore)
+          {
+            bestScore = score;
+            bestMove = move;
+            alpha = std::max(alpha, score);
+            if (score >= beta)
+              break;
+          }
+        }
+
+        if (bestScore == -ScoreInfinite)
+          co_return inCheck ? MatedIn(ply) : ScoreDraw;
+
+        const Bound bound = (bestScore >= beta) ? Bound::Lower : (bestScore > originalAlpha) ? Bound::Exact : Bound::Upper;
+        entry->Save(key, TranspositionTable::ScoreToTT(bestScore, ply), ScoreNone, bound, depth, bestMove, false, m_Table.GetGeneration());
+        co_return bestScore;
+      }
+
+      Task<int32_t> Quiescence(int32_t alpha, int32_t beta, int32_t ply)
+      {
+        co_await ScheduledSearch::CountNode();
+        if (m_Stop)
+          co_return 0;
+
+        const int32_t standPat = Evaluation::Evaluate(m_Position, *m_Pawns);
+        if (standPat >= beta || ply >= MaxPly - 1)
+          co_return standPat;
+        alpha = std::max(alpha, standPat);
+
+        ScoredMove moves[MaxMoves];
+        ScoredMove* end = MoveGen::Generate<GenType::Captures>(m_Position, moves);
+        for (ScoredMove* move = moves; move != end; move++)
+          move->Score = CaptureOrder(m_Position, *move);
+
+        int32_t bestScore = standPat;
+        for (ScoredMove* current = moves; current != end; current++)
+        {
+          const Move move = NextMove(current, end);
+          if (!m_Position.IsLegal(move) || !m_Position.SEEGreaterEqual(move, 0))
+            continue;
+
+          m_Position.MakeMove(move);
+          const int32_t score = -co_await ScheduledSearch::Quiescence(-beta, -alpha, ply + 1);
+          m_Position.UnmakeMove();
+
+          if (m_Stop)
+            co_return 0;
+          if (score > bestScore)
+          {
+            bestScore = score;
+            alpha = std::max(alpha, score);
+            if (score >= beta)
+              break;
+          }
+        }
+        co_return bestScore;
+      }
+
+    private:
+      // First, so the frames are all gone before it is
+      FrameArena m_Arena;
+      std::optional<Task<int32_t>> m_Root;
+      std::coroutine_handle<> m_Resume;
+
+      Position m_Position;
+      ScheduledLimits m_Limits;
+      SearchScheduler::Callback m_Callback;
+      TranspositionTable& m_Table;
+      PawnTable* m_Pawns = nullptr; // Of the thread running the current slice
+
+      uint64_t m_SliceNodes = 0;
+      uint64_t m_Nodes = 0;
+      bool m_Stop = false;
+      Clock::time_point m_Submitted;
+      Clock::time_point m_Deadline;
+      ScheduledResult m_Result;
+    };
+
+    namespace
+    {
+      // For the heap, the earliest deadline on top
+      bool LaterDeadline(const std::unique_ptr<ScheduledSearch>& a, const std::unique_ptr<ScheduledSearch>& b)
+      {
+        return a->GetDeadline() > b->GetDeadline();
+      }
+    }
+
+    SearchScheduler::~SearchScheduler()
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Quit = true;
+      }
+      m_Ready.notify_all();
+      for (std::thread& worker : m_Workers)
+        worker.join();
+    }
+
+    std::shared_ptr<SearchScheduler> SearchScheduler::Create(int32_t threads, size_t hash_mb, uint64_t slice_nodes)
+    {
+      std::shared_ptr<SearchScheduler> scheduler(new SearchScheduler());
+      scheduler->m_Table = TranspositionTable::Create(hash_mb);
+      scheduler->m_SliceNodes = std::max<uint64_t>(slice_nodes, 1);
+      for (int32_t i = 0; i < std::max(threads, 1); i++)
+        scheduler->m_Workers.emplace_back([scheduler = scheduler.get()]() { scheduler->Work(); });
+      return scheduler;
+    }
+
+    void SearchScheduler::Submit(const Position& position, const ScheduledLimits& limits, Callback callback)
+    {
+      std::unique_ptr<ScheduledSearch> search = std::make_unique<ScheduledSearch>(position, limits, std::move(callback), *m_Table, m_SliceNodes);
+      {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Queue.push_back(std::move(search));
+        std::push_heap(m_Queue.begin(), m_Queue.end(), LaterDeadline);
+      }
+      m_Ready.notify_one();
+    }
+
+    size_t SearchScheduler::GetPending() const
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      return m_Queue.size() + m_Running;
+    }
+
+    SchedulerStats SearchScheduler::GetStats() const
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      SchedulerStats stats = m_Stats;
+      stats.MeanLatency = stats.Searches ? static_cast<double>(m_TotalLatency) / static_cast<double>(stats.Searches) : 0.0;
+      return stats;
+    }
+
+    void SearchScheduler::Work()
+    {
+      // Per thread, whichever search runs a slice here borrows it
+      std::unique_ptr<PawnTable> pawns = std::make_unique<PawnTable>();
+
+      while (true)
+      {
+        std::unique_ptr<ScheduledSearch> search;
+        {
+          std::unique_lock<std::mutex> lock(m_Mutex);
+          m_Ready.wait(lock, [this]() { return m_Quit || !m_Queue.empty(); });
+          if (m_Quit)
+            return;
+
+          std::pop_heap(m_Queue.begin(), m_Queue.end(), LaterDeadline);
+          search = std::move(m_Queue.back());
+          m_Queue.pop_back();
+          m_Running++;
+        }
+
+        if (!search->Resume(*pawns))
+        {
+          std::lock_guard<std::mutex> lock(m_Mutex);
+          m_Stats.Slices++;
+          m_Running--;
+          m_Queue.push_back(std::move(search));
+          std::push_heap(m_Queue.begin(), m_Queue.end(), LaterDeadline);
+          continue;
+        }
+
+        Callback callback;
+        const ScheduledResult result = search->TakeResult(callback);
+        const bool missed = search->MissedDeadline();
+        search.reset();
+        {
+          std::lock_guard<std::mutex> lock(m_Mutex);
+          m_Stats.Slices++;
+          m_Stats.Searches++;
+          m_Stats.Nodes += result.Nodes;
+          m_Stats.MissedDeadlines += missed;
+          m_Stats.WorstLatency = std::max(m_Stats.WorstLatency, result.Latency);
+          m_TotalLatency += result.Latency;
+          m_Running--;
+        }
+
+        if (callback)
+          callback(result);
+      }
+    }
+  }
+}
\ No newline at end of file
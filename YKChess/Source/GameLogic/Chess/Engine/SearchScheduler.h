@@ -0,0 +1,92 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "GameLogic/Chess/Engine/Position.h"
+#include "GameLogic/Chess/Engine/TranspositionTable.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    struct ScheduledLimits
+    {
+      uint64_t Nodes = 20000; // For the whole search, this is what keeps a casual opponent weak
+      int64_t MoveTime = 100; // Milliseconds from submission, the deadline searches are scheduled by
+      int32_t Depth = MaxPly - 1;
+    };
+
+    struct ScheduledResult
+    {
+      Move BestMove; // None when there is no legal move
+      int32_t Score = 0;
+      int32_t Depth = 0; // Last completed iteration
+      uint64_t Nodes = 0;
+      int64_t Latency = 0; // Microseconds from submission to the result
+    };
+
+    struct SchedulerStats
+    {
+      uint64_t Searches = 0;
+      uint64_t Nodes = 0;
+      uint64_t Slices = 0;
+      uint64_t MissedDeadlines = 0;
+      int64_t WorstLatency = 0; // Microseconds
+      double MeanLatency = 0.0;
+    };
+
+    class ScheduledSearch;
+
+    // Runs many small searches on a few threads. Each search is a coroutine that suspends itself every slice of nodes,
+    // the threads then resume whichever waiting search has the earliest deadline, so hundreds of games share a handful
+    // of cores and none of them waits behind a long think. One transposition table is shared by all of them
+    class SearchScheduler
+    {
+    public:
+      using Callback = std::function<void(const ScheduledResult&)>;
+
+      static constexpr uint64_t DefaultSliceNodes = 256;
+
+      ~SearchScheduler();
+
+      static std::shared_ptr<SearchScheduler> Create(int32_t threads, size_t hash_mb, uint64_t slice_nodes = DefaultSliceNodes);
+
+      // The callback runs on a scheduler thread once the search is done, and may submit the next one
+      void Submit(const Position& position, const ScheduledLimits& limits, Callback callback);
+
+      size_t GetPending() const;
+      SchedulerStats GetStats() const;
+      int32_t GetThreadCount() const { return static_cast<int32_t>(m_Workers.size()); }
+
+    private:
+      void Work();
+
+    private:
+      SearchScheduler() = default;
+      SearchScheduler(const SearchScheduler&) = delete;
+      SearchScheduler& operator=(const SearchScheduler&) = delete;
+      SearchScheduler(SearchScheduler&&) = delete;
+      SearchScheduler& operator=(SearchScheduler&&) = delete;
+
+    private:
+      std::shared_ptr<TranspositionTable> m_Table;
+      uint64_t m_SliceNodes = DefaultSliceNodes;
+      std::vector<std::thread> m_Workers;
+
+      // Searches waiting for a thread, a heap on their deadlines
+      mutable std::mutex m_Mutex;
+      std::condition_variable m_Ready;
+      std::vector<std::unique_ptr<ScheduledSearch>> m_Queue;
+      size_t m_Running = 0;
+      bool m_Quit = false;
+
+      SchedulerStats m_Stats;
+      int64_t m_TotalLatency = 0;
+    };
+  }
+}
\ No newline at end of file
@@ -0,0 +1,1165 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/MappedFile.h"
+#include "GameLogic/Chess/Engine/MoveGen.h"
+#include "GameLogic/Chess/Engine/Tablebases.h"
+#include "GameLogic/Chess/Engine/Zobrist.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    int32_t Tablebases::s_MaxPieces = 0;
+
+    namespace
+    {
+      enum TableType
+      {
+        WDLTable,
+        DTZTable
+      };
+
+      // Per table flags stored in the file
+      constexpr uint8_t FlagSideToMove = 1;
+      constexpr uint8_t FlagMapped = 2;
+      constexpr uint8_t FlagWinPlies = 4;
+      constexpr uint8_t FlagLossPlies = 8;
+      constexpr uint8_t FlagWide = 16;
+      constexpr uint8_t FlagSingleValue = 128;
+
+      constexpr uint8_t WDLMagic[4] = { 0x71, 0xE8, 0x23, 0x5D };
+      constexpr uint8_t DTZMagic[4] = { 0xD7, 0x66, 0x0C, 0xA5 };
+
+      // Root move ranks, wins the fifty move rule cannot spoil all share the top rank
+      constexpr int32_t MaxDTZ = 1 << 18;
+
+      constexpr char PieceChars[] = " PNBRQK";
+
+      // The files are little endian except for the Huffman coded blocks, which are read as big endian words
+      template<typename T>
+      T ReadLittle(const uint8_t* data)
+      {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+      }
+
+      template<typename T>
+      T ReadBig(const uint8_t* data)
+      {
+        T value = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+          value = static_cast<T>((value << 8) | data[i]);
+        return value;
+      }
+
+      using Symbol = uint16_t;
+
+      struct SparseEntry
+      {
+        uint8_t Block[4];
+        uint8_t Offset[2];
+      };
+      static_assert(sizeof(SparseEntry) == 6);
+
+      // Two 12 bit symbols a recursive pairing symbol expands into
+      struct SymbolPair
+      {
+        uint8_t Data[3];
+
+        Symbol Left() const { return static_cast<Symbol>(((Data[1] & 0xF) << 8) | Data[0]); }
+        Symbol Right() const { return static_cast<Symbol>((Data[2] << 4) | (Data[1] >> 4)); }
+      };
+      static_assert(sizeof(SymbolPair) == 3);
+
+      // One compressed table, a file has one per side to move and, with pawns, per file of the leading pawn
+      struct PairsData
+      {
+        uint8_t Flags = 0;
+        uint8_t MaxSymbolLength = 0;
+        uint8_t MinSymbolLength = 0; // The value itself when every position stores the same one
+        uint32_t BlockCount = 0;
+        size_t BlockSize = 0;
+        size_t Span = 0;
+        const uint8_t* LowestSymbols = nullptr;
+        const SymbolPair* Pairs = nullptr;
+        const uint8_t* BlockLengths = nullptr;
+        uint32_t BlockLengthCount = 0;
+        const SparseEntry* SparseIndex = nullptr;
+        size_t SparseIndexCount = 0;
+        const uint8_t* Blocks = nullptr;
+        std::vector<uint64_t> Base64;
+        std::vector<uint8_t> SymbolLengths;
+        Piece Pieces[Tablebases::MaxPieces] = {};
+        uint64_t GroupIndex[Tablebases::MaxPieces + 1] = {};
+        int32_t GroupLength[Tablebases::MaxPieces + 1] = {};
+        uint16_t MapIndex[4] = {}; // DTZ value maps for wins, losses, cursed wins and blessed losses
+      };
+
+      template<TableType Type>
+      struct Table
+      {
+        static constexpr int32_t Sides = (Type == WDLTable) ? 2 : 1;
+
+        std::string Name; // Like "KRPvKR", white has the first group of pieces
+        uint64_t Key = 0;
+        uint64_t MirrorKey = 0; // Same material with the colors swapped
+        int32_t PieceCount = 0;
+        bool HasPawns = false;
+        bool HasUniquePieces = false;
+        uint8_t PawnCount[2] = {}; // Leading color first, the one with fewer pawns
+
+        // Set once under the mapping lock, read without it afterwards
+        std::atomic<bool> Ready = false;
+        std::shared_ptr<MappedFile> File;
+        const uint8_t* Map = nullptr;
+        PairsData Items[Sides][4];
+
+        PairsData* Get(int32_t side, int32_t file) { return &Items[side % Sides][HasPawns ? file : 0]; }
+      };
+
+      struct TableEntry
+      {
+        uint64_t Key = 0;
+        Table<WDLTable>* WDL = nullptr;
+        Table<DTZTable>* DTZ = nullptr;
+      };
+
+      // Open addressing with linear probing, big enough to stay sparse with every 7 piece table present
+      constexpr size_t EntryCount = 1 << 14;
+
+      std::deque<Table<WDLTable>> s_WDLTables;
+      std::deque<Table<DTZTable>> s_DTZTables;
+      std::vector<TableEntry> s_Entries(EntryCount);
+      std::vector<std::filesystem::path> s_Paths;
+
+      // Index tables of the position encoding
+      int32_t MapPawns[64];
+      int32_t MapB1H1H7[64];
+      int32_t MapA1D1D4[64];
+      int32_t MapKK[10][64];
+      uint64_t Binomial[6][64];
+      uint64_t LeadPawnIndex[6][64];
+      uint64_t LeadPawnsSize[6][4];
+
+      constexpr int32_t OffDiagonal(Square square) { return RankOf(square) - FileOf(square); }
+      constexpr Square FlipFile(Square square) { return square ^ 7; }
+      constexpr int32_t SignOf(int32_t value) { return (0 < value) - (value < 0); }
+
+      uint64_t MaterialKey(const int32_t counts[PieceCount])
+      {
+        uint64_t key = 0;
+        for (int32_t piece = WhitePawn; piece <= BlackKing; piece++)
+          for (int32_t i = 0; i < counts[piece]; i++)
+            key ^= Zobrist::PieceSquare(static_cast<Piece>(piece), i);
+        return key;
+      }
+
+      uint64_t MaterialKey(const Position& position)
+      {
+        int32_t counts[PieceCount] = {};
+        for (Color color : { White, Black })
+          for (int32_t type = Pawn; type <= King; type++)
+            counts[MakePiece(color, static_cast<PieceType>(type))] = position.Count(color, static_cast<PieceType>(type));
+        return MaterialKey(counts);
+      }
+
+      void InitIndexTables()
+      {
+        // Squares below the a1-h8 diagonal to 0..27
+        int32_t code = 0;
+        for (Square square = 0; square < 64; square++)
+          if (OffDiagonal(square) < 0)
+            MapB1H1H7[square] = code++;
+
+        // The a1-d1-d4 triangle to 0..9, the diagonal squares last
+        std::vector<Square> diagonal;
+        code = 0;
+        for (Square square = 0; square <= MakeSquare(3, 3); square++)
+        {
+          if (OffDiagonal(square) < 0 && FileOf(square) <= 3)
+            MapA1D1D4[square] = code++;
+          else if (!OffDiagonal(square) && FileOf(square) <= 3)
+            diagonal.push_back(square);
+        }
+        for (const Square square : diagonal)
+          MapA1D1D4[square] = code++;
+
+        // The 462 legal placements of two kings with the first one in the triangle, a first king on the
+        // diagonal keeps the second one on or below it. Both on the diagonal are encoded last
+        std::vector<std::pair<int32_t, Square>> bothOnDiagonal;
+        code = 0;
+        for (int32_t index = 0; index < 10; index++)
+        {
+          for (Square first = 0; first <= MakeSquare(3, 3); first++)
+          {
+            // Squares outside the triangle are left at 0 as well, b1 is the only real 0
+            if (MapA1D1D4[first] != index || (!index && first != MakeSquare(1, 0)))
+              continue;
+
+            for (Square second = 0; second < 64; second++)
+            {
+              if ((Bitboards::KingAttacks(first) | SquareBB(first)) & SquareBB(second))
+                continue;
+              if (!OffDiagonal(first) && OffDiagonal(second) > 0)
+                continue;
+              if (!OffDiagonal(first) && !OffDiagonal(second))
+                bothOnDiagonal.emplace_back(index, second);
+              else
+                MapKK[index][second] = code++;
+            }
+          }
+        }
+        for (const auto& [index, square] : bothOnDiagonal)
+          MapKK[index][square] = code++;
+
+        // Binomial[k][n] ways to choose k of n
+        Binomial[0][0] = 1;
+        for (int32_t n = 1; n < 64; n++)
+          for (int32_t k = 0; k < 6 && k <= n; k++)
+            Binomial[k][n] = (k > 0 ? Binomial[k - 1][n - 1] : 0) + (k < n ? Binomial[k][n - 1] : 0);
+
+        // MapPawns numbers a2-h7 so that the leading pawn, nearest the edge and lowest, gets the highest value. Up
+        // to 5 leading pawns with 7 pieces
+        int32_t availableSquares = 47;
+        for (int32_t leadPawns = 1; leadPawns <= 5; leadPawns++)
+        {
+          for (int32_t file = 0; file < 4; file++)
+          {
+            uint64_t index = 0;
+            for (int32_t rank = 1; rank <= 6; rank++)
+            {
+              const Square square = MakeSquare(file, rank);
+              if (leadPawns == 1)
+              {
+                MapPawns[square] = availableSquares--;
+                MapPawns[FlipFile(square)] = availableSquares--;
+              }
+              LeadPawnIndex[leadPawns][square] = index;
+              index += Binomial[leadPawns - 1][MapPawns[square]];
+            }
+            LeadPawnsSize[leadPawns][file] = index;
+          }
+        }
+      }
+
+      std::shared_ptr<MappedFile> OpenTableFile(const std::string& name, const uint8_t (&magic)[4])
+      {
+        for (const std::filesystem::path& directory : s_Paths)
+        {
+          std::shared_ptr<MappedFile> file = MappedFile::Open(directory / name);
+          if (!file)
+            continue;
+
+          const uint8_t* data = reinterpret_cast<const uint8_t*>(file->GetData());
+          if (file->GetSize() % 64 != 16 || std::memcmp(data, magic, 4) != 0)
+          {
+            YK_ERROR("[ENGINE] Corrupted tablebase file {}", (directory / name).string());
+            return nullptr;
+          }
+          return file;
+        }
+        return nullptr;
+      }
+
+      uint8_t SetSymbolLength(PairsData& d, Symbol symbol, std::vector<bool>& visited)
+      {
+        // The pairing tree is acyclic, marking before recursing is safe
+        visited[symbol] = true;
+
+        const Symbol right = d.Pairs[symbol].Right();
+        if (right == 0xFFF)
+          return 0;
+
+        const Symbol left = d.Pairs[symbol].Left();
+        if (!visited[left])
+          d.SymbolLengths[left] = SetSymbolLength(d, left, visited);
+        if (!visited[right])
+          d.SymbolLengths[right] = SetSymbolLength(d, right, visited);
+
+        return static_cast<uint8_t>(d.SymbolLengths[left] + d.SymbolLengths[right] + 1);
+      }
+
+      template<TableType Type>
+      void SetGroups(Table<Type>& table, PairsData& d, const int32_t order[2], int32_t file)
+      {
+        // Groups of pieces encoded together, the first one holds the kings or the leading pawns
+        int32_t n = 0;
+        int32_t firstLength = table.HasPawns ? 0 : (table.HasUniquePieces ? 3 : 2);
+        d.GroupLength[n] = 1;
+        for (int32_t i = 1; i < table.PieceCount; i++)
+        {
+          if (--firstLength > 0 || d.Pieces[i] == d.Pieces[i - 1])
+            d.GroupLength[n]++;
+          else
+            d.GroupLength[++n] = 1;
+        }
+        d.GroupLength[++n] = 0;
+
+        // The index is g1 * N(g2) * N(g3) + g2 * N(g3) + g3 in an order stored per table, the leading group is at
+        // order[0] and the remaining pawns at order[1]
+        const bool pawnsOnBothSides = table.HasPawns && table.PawnCount[1];
+        int32_t next = pawnsOnBothSides ? 2 : 1;
+        int32_t freeSquares = 64 - d.GroupLength[0] - (pawnsOnBothSides ? d.GroupLength[1] : 0);
+        uint64_t index = 1;
+
+        for (int32_t k = 0; next < n || k == order[0] || k == order[1]; k++)
+        {
+          if (k == order[0])
+          {
+            d.GroupIndex[0] = index;
+            index *= table.HasPawns ? LeadPawnsSize[d.GroupLength[0]][file] : (table.HasUniquePieces ? 31332 : 462);
+          }
+          else if (k == order[1])
+          {
+            d.GroupIndex[1] = index;
+            index *= Binomial[d.GroupLength[1]][48 - d.GroupLength[0]];
+          }
+          else
+          {
+            d.GroupIndex[next] = index;
+            index *= Binomial[d.GroupLength[next]][freeSquares];
+            freeSquares -= d.GroupLength[next++];
+          }
+        }
+        d.GroupIndex[n] = index;
+      }
+
+      const uint8_t* SetSizes(PairsData& d, const uint8_t* data)
+      {
+        d.Flags = *data++;
+        if (d.Flags & FlagSingleValue)
+        {
+          d.BlockCount = 0;
+          d.Span = 0;
+          d.BlockLengthCount = 0;
+          d.SparseIndexCount = 0;
+          d.MinSymbolLength = *data++;
+          return data;
+        }
+
+        // The last group index is the number of positions in the table
+        const uint64_t tableSize = d.GroupIndex[std::find(d.GroupLength, d.GroupLength + Tablebases::MaxPieces, 0) - d.GroupLength];
+
+        d.BlockSize = size_t(1) << *data++;
+        d.Span = size_t(1) << *data++;
+        d.SparseIndexCount = static_cast<size_t>((tableSize + d.Span - 1) / d.Span);
+        const uint8_t padding = *data++;
+        d.BlockCount = ReadLittle<uint32_t>(data);
+        data += sizeof(uint32_t);
+        // Padded so that the sparse index never points past the end
+        d.BlockLengthCount = d.BlockCount + padding;
+        d.MaxSymbolLength = *data++;
+        d.MinSymbolLength = *data++;
+        d.LowestSymbols = data;
+
+        // Canonical Huffman code, longer codes have lower values. Base64[i] is the lowest code of length
+        // MinSymbolLength + i left aligned in 64 bits, so a code of that length lies between Base64[i] and Base64[i - 1]
+        d.Base64.assign(d.MaxSymbolLength - d.MinSymbolLength + 1, 0);
+        for (int32_t i = static_cast<int32_t>(d.Base64.size()) - 2; i >= 0; i--)
+          d.Base64[i] = (d.Base64[i + 1] + ReadLittle<Symbol>(d.LowestSymbols + 2 * i) - ReadLittle<Symbol>(d.LowestSymbols + 2 * (i + 1))) / 2;
+        for (size_t i = 0; i < d.Base64.size(); i++)
+          d.Base64[i] <<= 64 - i - d.MinSymbolLength;
+        data += d.Base64.size() * sizeof(Symbol);
+
+        // Recursive pairing, every symbol above the literals expands into a pair of earlier ones
+        d.SymbolLengths.assign(ReadLittle<uint16_t>(data), 0);
+        data += sizeof(uint16_t);
+        d.Pairs = reinterpret_cast<const SymbolPair*>(data);
+
+        std::vector<bool> visited(d.SymbolLengths.size());
+        for (size_t symbol = 0; symbol < d.SymbolLengths.size(); symbol++)
+          if (!visited[symbol])
+            d.SymbolLengths[symbol] = SetSymbolLength(d, static_cast<Symbol>(symbol), visited);
+
+        return data + d.SymbolLengths.size() * sizeof(SymbolPair) + (d.SymbolLengths.size() & 1);
+      }
+
+      const uint8_t* SetDTZMap(Table<WDLTable>&, const uint8_t* data, int32_t)
+      {
+        return data;
+      }
+
+      const uint8_t* SetDTZMap(Table<DTZTable>& table, const uint8_t* data, int32_t max_file)
+      {
+        table.Map = data;
+        for (int32_t file = 0; file <= max_file; file++)
+        {
+          PairsData& d = *table.Get(0, file);
+          if (!(d.Flags & FlagMapped))
+            continue;
+
+          if (d.Flags & FlagWide)
+          {
+            data += reinterpret_cast<uintptr_t>(data) & 1;
+            for (int32_t i = 0; i < 4; i++)
+            {
+              d.MapIndex[i] = static_cast<uint16_t>((data - table.Map) / 2 + 1);
+              data += 2 * ReadLittle<uint16_t>(data) + 2;
+            }
+          }
+          else
+          {
+            for (int32_t i = 0; i < 4; i++)
+            {
+              d.MapIndex[i] = static_cast<uint16_t>(data - table.Map + 1);
+              data += *data + 1;
+            }
+          }
+        }
+        return data + (reinterpret_cast<uintptr_t>(data) & 1);
+      }
+
+      // Points every table of the file into the mapping, data starts right after the magic
+      template<TableType Type>
+      bool SetTable(Table<Type>& table, const uint8_t* data)
+      {
+        constexpr uint8_t Split = 1;
+        constexpr uint8_t HasPawns = 2;
+        if (table.HasPawns != static_cast<bool>(*data & HasPawns) || (table.Key != table.MirrorKey) != static_cast<bool>(*data & Split))
+          return false;
+        data++;
+
+        const int32_t sides = (Table<Type>::Sides == 2 && table.Key != table.MirrorKey) ? 2 : 1;
+        const int32_t maxFile = table.HasPawns ? 3 : 0;
+        const bool pawnsOnBothSides = table.HasPawns && table.PawnCount[1];
+
+        for (int32_t file = 0; file <= maxFile; file++)
+        {
+          const int32_t order[2][2] =
+          {
+            { *data & 0xF, pawnsOnBothSides ? *(data + 1) & 0xF : 0xF },
+            { *data >> 4, pawnsOnBothSides ? *(data + 1) >> 4 : 0xF }
+          };
+          data += 1 + pawnsOnBothSides;
+
+          for (int32_t k = 0; k < table.PieceCount; k++, data++)
+            for (int32_t side = 0; side < sides; side++)
+              table.Get(side, file)->Pieces[k] = static_cast<Piece>(side ? *data >> 4 : *data & 0xF);
+
+          for (int32_t side = 0; side < sides; side++)
+            SetGroups(table, *table.Get(side, file), order[side], file);
+        }
+
+        data += reinterpret_cast<uintptr_t>(data) & 1;
+
+        for (int32_t file = 0; file <= maxFile; file++)
+          for (int32_t side = 0; side < sides; side++)
+            data = SetSizes(*table.Get(side, file), data);
+
+        data = SetDTZMap(table, data, maxFile);
+
+        for (int32_t file = 0; file <= maxFile; file++)
+        {
+          for (int32_t side = 0; side < sides; side++)
+          {
+            PairsData& d = *table.Get(side, file);
+            d.SparseIndex = reinterpret_cast<const SparseEntry*>(data);
+            data += d.SparseIndexCount * sizeof(SparseEntry);
+          }
+        }
+
+        for (int32_t file = 0; file <= maxFile; file++)
+        {
+          for (int32_t side = 0; side < sides; side++)
+          {
+            PairsData& d = *table.Get(side, file);
+            d.BlockLengths = data;
+            data += d.BlockLengthCount * sizeof(uint16_t);
+          }
+        }
+
+        for (int32_t file = 0; file <= maxFile; file++)
+        {
+          for (int32_t side = 0; side < sides; side++)
+          {
+            data = reinterpret_cast<const uint8_t*>((reinterpret_cast<uintptr_t>(data) + 0x3F) & ~uintptr_t(0x3F));
+            PairsData& d = *table.Get(side, file);
+            d.Blocks = data;
+            data += d.BlockCount * d.BlockSize;
+          }
+        }
+
+        return true;
+      }
+
+      // Maps the file on the first probe, the lock is only taken until every thread has seen the table ready
+      template<TableType Type>
+      bool EnsureMapped(Table<Type>& table)
+      {
+        if (table.Ready.load(std::memory_order_acquire))
+          return table.File != nullptr;
+
+        static std::mutex s_Mutex;
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        if (table.Ready.load(std::memory_order_relaxed))
+          return table.File != nullptr;
+
+        table.File = OpenTableFile(table.Name + ((Type == WDLTable) ? ".rtbw" : ".rtbz"), (Type == WDLTable) ? WDLMagic : DTZMagic);
+        if (table.File && !SetTable(table, reinterpret_cast<const uint8_t*>(table.File->GetData()) + 4))
+        {
+          YK_ERROR("[ENGINE] Tablebase {} does not match its material", table.Name);
+          table.File = nullptr;
+        }
+
+        table.Ready.store(true, std::memory_order_release);
+        return table.File != nullptr;
+      }
+
+      int32_t DecompressPairs(const PairsData& d, uint64_t index)
+      {
+        if (d.Flags & FlagSingleValue)
+          return d.MinSymbolLength;
+
+        // Block n holds BlockLengths[n] + 1 values. Sparse entry k gives the block and the offset in it of value
+        // k * Span + Span / 2, from there the right block is a few steps away
+        const uint32_t k = static_cast<uint32_t>(index / d.Span);
+        uint32_t block = ReadLittle<uint32_t>(d.SparseIndex[k].Block);
+        int32_t offset = ReadLittle<uint16_t>(d.SparseIndex[k].Offset);
+        offset += static_cast<int32_t>(index % d.Span) - static_cast<int32_t>(d.Span / 2);
+
+        while (offset < 0)
+          offset += ReadLittle<uint16_t>(d.BlockLengths + 2 * --block) + 1;
+        while (offset > ReadLittle<uint16_t>(d.BlockLengths + 2 * block))
+          offset -= ReadLittle<uint16_t>(d.BlockLengths + 2 * block++) + 1;
+
+        // Walk the Huffman coded symbols of the block until the one covering the offset
+        const uint8_t* pointer = d.Blocks + static_cast<uint64_t>(block) * d.BlockSize;
+        uint64_t buffer = ReadBig<uint64_t>(pointer);
+        pointer += 8;
+        int32_t bufferSize = 64;
+        Symbol symbol;
+
+        while (true)
+        {
+          size_t length = 0;
+          while (buffer < d.Base64[length])
+            length++;
+
+          // Codes of one length are consecutive, the lowest one is stored per length
+          symbol = static_cast<Symbol>((buffer - d.Base64[length]) >> (64 - length - d.MinSymbolLength));
+          symbol = static_cast<Symbol>(symbol + ReadLittle<Symbol>(d.LowestSymbols + 2 * length));
+
+          if (offset < d.SymbolLengths[symbol] + 1)
+            break;
+
+          offset -= d.SymbolLengths[symbol] + 1;
+          length += d.MinSymbolLength;
+          buffer <<= length;
+          bufferSize -= static_cast<int32_t>(length);
+
+          if (bufferSize <= 32)
+          {
+            bufferSize += 32;
+            buffer |= static_cast<uint64_t>(ReadBig<uint32_t>(pointer)) << (64 - bufferSize);
+            pointer += 4;
+          }
+        }
+
+        // Expand the pair tree down to the literal at the offset
+        while (d.SymbolLengths[symbol])
+        {
+          const Symbol left = d.Pairs[symbol].Left();
+          if (offset < d.SymbolLengths[left] + 1)
+            symbol = left;
+          else
+          {
+            offset -= d.SymbolLengths[left] + 1;
+            symbol = d.Pairs[symbol].Right();
+          }
+        }
+
+        return d.Pairs[symbol].Left();
+      }
+
+      // DTZ files only hold one side to move, except for symmetric material without pawns
+      bool HasSideToMove(Table<WDLTable>&, int32_t, int32_t)
+      {
+        return true;
+      }
+
+      bool HasSideToMove(Table<DTZTable>& table, int32_t side, int32_t file)
+      {
+        return (table.Get(side, file)->Flags & FlagSideToMove) == side || (table.Key == table.MirrorKey && !table.HasPawns);
+      }
+
+      int32_t MapScore(Table<WDLTable>&, int32_t, int32_t value, WDLScore)
+      {
+        return value - 2;
+      }
+
+      int32_t MapScore(Table<DTZTable>& table, int32_t file, int32_t value, WDLScore wdl)
+      {
+        constexpr int32_t WDLMap[] = { 1, 3, 0, 2, 0 };
+
+        const PairsData& d = *table.Get(0, file);
+        if (d.Flags & FlagMapped)
+        {
+          const size_t index = d.MapIndex[WDLMap[wdl + 2]] + value;
+          value = (d.Flags & FlagWide) ? ReadLittle<uint16_t>(table.Map + 2 * index) : table.Map[index];
+        }
+
+        // Stored in moves unless the flags say plies, cursed results always in moves
+        if ((wdl == WDLWin && !(d.Flags & FlagWinPlies)) || (wdl == WDLLoss && !(d.Flags & FlagLossPlies)) || wdl == WDLCursedWin || wdl == WDLBlessedLoss)
+          value *= 2;
+
+        return value + 1;
+      }
+
+      template<TableType Type>
+      int32_t ProbeTable(const Position& position, Table<Type>& table, WDLScore wdl, ProbeState& state)
+      {
+        Square squares[Tablebases::MaxPieces];
+        Piece pieces[Tablebases::MaxPieces];
+        int32_t size = 0;
+        int32_t leadPawnCount = 0;
+        Bitboard leadPawns = 0ULL;
+        int32_t tableFile = 0;
+        uint64_t index;
+
+        // Tables are stored with the stronger side as white, and symmetric ones with white to move only. Anything
+        // else is looked up with the colors swapped and the board flipped
+        const bool symmetricBlackToMove = table.Key == table.MirrorKey && position.SideToMove() == Black;
+        const bool blackStronger = MaterialKey(position) != table.Key;
+        const bool flip = symmetricBlackToMove || blackStronger;
+        const int32_t flipColor = flip ? 8 : 0;
+        const int32_t flipSquares = flip ? 56 : 0;
+        const int32_t side = flip ^ (position.SideToMove() == Black);
+
+        // Pawn tables are split by the file of the leading pawn, the one with the highest MapPawns value
+        if (table.HasPawns)
+        {
+          const Piece pawn = static_cast<Piece>(table.Get(0, 0)->Pieces[0] ^ flipColor);
+          Bitboard board = leadPawns = position.Pieces(ColorOf(pawn), Pawn);
+          while (board)
+            squares[size++] = PopLSB(board) ^ flipSquares;
+          leadPawnCount = size;
+
+          std::swap(squares[0], *std::max_element(squares, squares + leadPawnCount, [](Square a, Square b) { return MapPawns[a] < MapPawns[b]; }));
+          tableFile = std::min(FileOf(squares[0]), 7 - FileOf(squares[0]));
+        }
+
+        if (!HasSideToMove(table, side, tableFile))
+        {
+          state = ProbeState::ChangeSideToMove;
+          return 0;
+        }
+
+        Bitboard board = position.Pieces() ^ leadPawns;
+        while (board)
+        {
+          const Square square = PopLSB(board);
+          squares[size] = square ^ flipSquares;
+          pieces[size++] = static_cast<Piece>(position.PieceOn(square) ^ flipColor);
+        }
+
+        const PairsData& d = *table.Get(side, tableFile);
+
+        // Same piece order as the table, the one that compressed best
+        for (int32_t i = leadPawnCount; i < size - 1; i++)
+        {
+          for (int32_t j = i + 1; j < size; j++)
+          {
+            if (d.Pieces[i] == pieces[j])
+            {
+              std::swap(pieces[i], pieces[j]);
+              std::swap(squares[i], squares[j]);
+              break;
+            }
+          }
+        }
+
+        // The leading piece goes to the a-d files
+        if (FileOf(squares[0]) > 3)
+          for (int32_t i = 0; i < size; i++)
+            squares[i] = FlipFile(squares[i]);
+
+        if (table.HasPawns)
+        {
+          index = LeadPawnIndex[leadPawnCount][squares[0]];
+          std::stable_sort(squares + 1, squares + leadPawnCount, [](Square a, Square b) { return MapPawns[a] < MapPawns[b]; });
+          for (int32_t i = 1; i < leadPawnCount; i++)
+            index += Binomial[i][MapPawns[squares[i]]];
+        }
+        else
+        {
+          // Without pawns the leading piece also goes to the lower half and then below the a1-h8 diagonal
+          if (RankOf(squares[0]) > 3)
+            for (int32_t i = 0; i < size; i++)
+              squares[i] = FlipRank(squares[i]);
+
+          for (int32_t i = 0; i < d.GroupLength[0]; i++)
+          {
+            if (!OffDiagonal(squares[i]))
+              continue;
+            if (OffDiagonal(squares[i]) > 0)
+              for (int32_t j = i; j < size; j++)
+                squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+            break;
+          }
+
+          // Three unique pieces, kings included, are encoded together, otherwise only the two kings
+          if (table.HasUniquePieces)
+          {
+            const int32_t adjust1 = squares[1] > squares[0];
+            const int32_t adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+            if (OffDiagonal(squares[0]))
+              index = (MapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            else if (OffDiagonal(squares[1]))
+              index = (6 * 63 + RankOf(squares[0]) * 28 + MapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+            else if (OffDiagonal(squares[2]))
+              index = 6 * 63 * 62 + 4 * 28 * 62 + RankOf(squares[0]) * 7 * 28 + (RankOf(squares[1]) - adjust1) * 28 + MapB1H1H7[squares[2]];
+            else
+              index = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + RankOf(squares[0]) * 7 * 6 + (RankOf(squares[1]) - adjust1) * 6 + (RankOf(squares[2]) - adjust2);
+          }
+          else
+            index = MapKK[MapA1D1D4[squares[0]]][squares[1]];
+        }
+
+        index *= d.GroupIndex[0];
+
+        // The other groups in ascending square order, each square shifted down past the earlier groups' squares
+        Square* group = squares + d.GroupLength[0];
+        bool remainingPawns = table.HasPawns && table.PawnCount[1];
+        for (int32_t next = 1; d.GroupLength[next]; next++)
+        {
+          std::stable_sort(group, group + d.GroupLength[next]);
+
+          uint64_t n = 0;
+          for (int32_t i = 0; i < d.GroupLength[next]; i++)
+          {
+            const int32_t adjust = static_cast<int32_t>(std::count_if(squares, group, [&](Square square) { return group[i] > square; }));
+            n += Binomial[i + 1][group[i] - adjust - 8 * remainingPawns];
+          }
+
+          remainingPawns = false;
+          index += n * d.GroupIndex[next];
+          group += d.GroupLength[next];
+        }
+
+        return MapScore(table, tableFile, DecompressPairs(d, index), wdl);
+      }
+
+      const TableEntry* FindEntry(uint64_t key)
+      {
+        for (size_t i = key & (EntryCount - 1); s_Entries[i].WDL; i = (i + 1) & (EntryCount - 1))
+          if (s_Entries[i].Key == key)
+            return &s_Entries[i];
+        return nullptr;
+      }
+
+      void InsertEntry(uint64_t key, Table<WDLTable>* wdl, Table<DTZTable>* dtz)
+      {
+        size_t i = key & (EntryCount - 1);
+        while (s_Entries[i].WDL && s_Entries[i].Key != key)
+          i = (i + 1) & (EntryCount - 1);
+        s_Entries[i] = { key, wdl, dtz };
+      }
+
+      template<TableType Type>
+      int32_t Probe(const Position& position, ProbeState& state, WDLScore wdl = WDLDraw)
+      {
+        // Bare kings have no file
+        if (PopCount(position.Pieces()) == 2)
+          return WDLDraw;
+
+        const TableEntry* entry = FindEntry(MaterialKey(position));
+        if (!entry)
+        {
+          state = ProbeState::Fail;
+          return 0;
+        }
+
+        if constexpr (Type == WDLTable)
+        {
+          if (!EnsureMapped(*entry->WDL))
+          {
+            state = ProbeState::Fail;
+            return 0;
+          }
+          return ProbeTable(position, *entry->WDL, wdl, state);
+        }
+        else
+        {
+          if (!EnsureMapped(*entry->DTZ))
+          {
+            state = ProbeState::Fail;
+            return 0;
+          }
+          return ProbeTable(position, *entry->DTZ, wdl, state);
+        }
+      }
+
+      // The tables know nothing of en passant and store "don't care" values where a capture or pawn move is best,
+      // so those moves are searched first. CheckPawnMoves also tries the pawn moves, which the DTZ probe needs
+      template<bool CheckPawnMoves>
+      WDLScore SearchZeroing(Position& position, ProbeState& state)
+      {
+        MoveList moves;
+        MoveGen::GenerateLegal(position, moves);
+
+        WDLScore bestScore = WDLLoss;
+        size_t moveCount = 0;
+        for (const ScoredMove& move : moves)
+        {
+          if (!move.IsCapture() && (!CheckPawnMoves || TypeOf(position.MovedPiece(move)) != Pawn))
+            continue;
+
+          moveCount++;
+          position.MakeMove(move);
+          const WDLScore score = static_cast<WDLScore>(-SearchZeroing<false>(position, state));
+          position.UnmakeMove();
+
+          if (state == ProbeState::Fail)
+            return WDLDraw;
+
+          if (score > bestScore)
+          {
+            bestScore = score;
+            if (score >= WDLWin)
+            {
+              state = ProbeState::ZeroingBestMove;
+              return score;
+            }
+          }
+        }
+
+        // With every legal move already tried the table is not needed, and could even be wrong
+        const bool noMoreMoves = moveCount && moveCount == moves.size();
+        WDLScore score;
+        if (noMoreMoves)
+          score = bestScore;
+        else
+        {
+          score = static_cast<WDLScore>(Probe<WDLTable>(position, state));
+          if (state == ProbeState::Fail)
+            return WDLDraw;
+        }
+
+        if (bestScore >= score)
+        {
+          state = (bestScore > WDLDraw || noMoreMoves) ? ProbeState::ZeroingBestMove : ProbeState::Ok;
+          return bestScore;
+        }
+
+        state = ProbeState::Ok;
+        return score;
+      }
+
+      // The DTZ of the move that zeroes, one ply before the zeroing result
+      int32_t DTZBeforeZeroing(WDLScore wdl)
+      {
+        switch (wdl)
+        {
+          case WDLWin: return 1;
+          case WDLCursedWin: return 101;
+          case WDLBlessedLoss: return -101;
+          case WDLLoss: return -1;
+          default: return 0;
+        }
+      }
+
+      bool IsMate(const Position& position)
+      {
+        if (!position.InCheck())
+          return false;
+        MoveList moves;
+        MoveGen::GenerateLegal(position, moves);
+        return moves.empty();
+      }
+
+      // Ranks of the root moves from the DTZ tables, wins within the fifty move budget all share the top rank and
+      // losses the bottom one unless a fifty move draw is within reach
+      bool RankRootMovesDTZ(Position& position, const std::vector<Move>& moves, std::vector<int32_t>& ranks)
+      {
+        const int32_t halfmoveClock = position.HalfmoveClock();
+        ProbeState state = ProbeState::Ok;
+
+        ranks.clear();
+        for (const Move move : moves)
+        {
+          position.MakeMove(move);
+
+          int32_t dtz;
+          if (position.HalfmoveClock() == 0)
+            dtz = DTZBeforeZeroing(static_cast<WDLScore>(-Tablebases::ProbeWDL(position, state)));
+          else if (position.IsDraw(1))
+            dtz = 0;
+          else
+          {
+            dtz = -Tablebases::ProbeDTZ(position, state);
+            dtz += SignOf(dtz);
+          }
+
+          if (dtz == 2 && IsMate(position))
+            dtz = 1;
+
+          position.UnmakeMove();
+          if (state == ProbeState::Fail)
+            return false;
+
+          int32_t rank = 0;
+          if (dtz > 0)
+            rank = (dtz + halfmoveClock <= 99) ? MaxDTZ : MaxDTZ - (dtz + halfmoveClock);
+          else if (dtz < 0)
+            rank = (-dtz * 2 + halfmoveClock < 100) ? -MaxDTZ : -MaxDTZ + (-dtz + halfmoveClock);
+          ranks.push_back(rank);
+        }
+        return true;
+      }
+
+      bool RankRootMovesWDL(Position& position, const std::vector<Move>& moves, std::vector<int32_t>& ranks)
+      {
+        constexpr int32_t WDLToRank[] = { -MaxDTZ, -MaxDTZ + 101, 0, MaxDTZ - 101, MaxDTZ };
+        ProbeState state = ProbeState::Ok;
+
+        ranks.clear();
+        for (const Move move : moves)
+        {
+          position.MakeMove(move);
+          const WDLScore wdl = static_cast<WDLScore>(-Tablebases::ProbeWDL(position, state));
+          position.UnmakeMove();
+
+          if (state == ProbeState::Fail)
+            return false;
+          ranks.push_back(WDLToRank[wdl + 2]);
+        }
+        return true;
+      }
+    }
+
+    void Tablebases::Init(const std::string& paths)
+    {
+      static std::once_flag s_IndexTablesOnce;
+      std::call_once(s_IndexTablesOnce, InitIndexTables);
+
+      s_Entries.assign(EntryCount, TableEntry());
+      s_WDLTables.clear();
+      s_DTZTables.clear();
+      s_Paths.clear();
+      s_MaxPieces = 0;
+
+#if defined(PLATFORM_WINDOWS)
+      constexpr char Separator = ';';
+#else
+      constexpr char Separator = ':';
+#endif
+
+      for (size_t begin = 0; begin < paths.size();)
+      {
+        size_t end = paths.find(Separator, begin);
+        if (end == std::string::npos)
+          end = paths.size();
+        if (end > begin)
+          s_Paths.emplace_back(paths.substr(begin, end - begin));
+        begin = end + 1;
+      }
+
+      std::error_code error;
+      std::erase_if(s_Paths, [&](const std::filesystem::path& path) { return !std::filesystem::is_directory(path, error); });
+      if (s_Paths.empty())
+        return;
+
+      // Pieces of each side strongest first, the order of the file names
+      const auto add = [](std::vector<PieceType> white, std::vector<PieceType> black)
+        {
+        std::string name = "K";
+        int32_t counts[PieceCount] = {};
+        counts[WhiteKing] = counts[BlackKing] = 1;
+        for (const PieceType type : white)
+        {
+          name += PieceChars[type];
+          counts[MakePiece(White, type)]++;
+        }
+        name += "vK";
+        for (const PieceType type : black)
+        {
+          name += PieceChars[type];
+          counts[MakePiece(Black, type)]++;
+        }
+
+        const bool found = std::any_of(s_Paths.begin(), s_Paths.end(), [&](const std::filesystem::path& path)
+          {
+          std::error_code error;
+          return std::filesystem::exists(path / (name + ".rtbw"), error);
+          });
+        if (!found)
+          return;
+
+        Table<WDLTable>& wdl = s_WDLTables.emplace_back();
+        wdl.Name = name;
+        wdl.Key = MaterialKey(counts);
+        wdl.PieceCount = 2 + static_cast<int32_t>(white.size() + black.size());
+        wdl.HasPawns = counts[WhitePawn] || counts[BlackPawn];
+        for (int32_t piece = WhitePawn; piece <= BlackQueen; piece++)
+          wdl.HasUniquePieces |= (TypeOf(static_cast<Piece>(piece)) != King && counts[piece] == 1);
+
+        // The side with fewer pawns leads, it compresses better
+        const bool whiteLeads = !counts[BlackPawn] || (counts[WhitePawn] && counts[BlackPawn] >= counts[WhitePawn]);
+        wdl.PawnCount[0] = static_cast<uint8_t>(whiteLeads ? counts[WhitePawn] : counts[BlackPawn]);
+        wdl.PawnCount[1] = static_cast<uint8_t>(whiteLeads ? counts[BlackPawn] : counts[WhitePawn]);
+
+        for (int32_t type = Pawn; type <= King; type++)
+          std::swap(counts[MakePiece(White, static_cast<PieceType>(type))], counts[MakePiece(Black, static_cast<PieceType>(type))]);
+        wdl.MirrorKey = MaterialKey(counts);
+
+        Table<DTZTable>& dtz = s_DTZTables.emplace_back();
+        dtz.Name = wdl.Name;
+        dtz.Key = wdl.Key;
+        dtz.MirrorKey = wdl.MirrorKey;
+        dtz.PieceCount = wdl.PieceCount;
+        dtz.HasPawns = wdl.HasPawns;
+        dtz.HasUniquePieces = wdl.HasUniquePieces;
+        dtz.PawnCount[0] = wdl.PawnCount[0];
+        dtz.PawnCount[1] = wdl.PawnCount[1];
+
+        InsertEntry(wdl.Key, &wdl, &dtz);
+        InsertEntry(wdl.MirrorKey, &wdl, &dtz);
+        s_MaxPieces = std::max(s_MaxPieces, wdl.PieceCount);
+        };
+
+      for (int32_t a = Pawn; a < King; a++)
+      {
+        const PieceType p1 = static_cast<PieceType>(a);
+        add({ p1 }, {});
+
+        for (int32_t b = Pawn; b <= a; b++)
+        {
+          const PieceType p2 = static_cast<PieceType>(b);
+          add({ p1, p2 }, {});
+          add({ p1 }, { p2 });
+
+          for (int32_t c = Pawn; c < King; c++)
+            add({ p1, p2 }, { static_cast<PieceType>(c) });
+
+          for (int32_t c = Pawn; c <= b; c++)
+          {
+            const PieceType p3 = static_cast<PieceType>(c);
+            add({ p1, p2, p3 }, {});
+
+            for (int32_t d = Pawn; d <= c; d++)
+            {
+              const PieceType p4 = static_cast<PieceType>(d);
+              add({ p1, p2, p3, p4 }, {});
+
+              for (int32_t e = Pawn; e <= d; e++)
+                add({ p1, p2, p3, p4, static_cast<PieceType>(e) }, {});
+              for (int32_t e = Pawn; e < King; e++)
+                add({ p1, p2, p3, p4 }, { static_cast<PieceType>(e) });
+            }
+
+            for (int32_t d = Pawn; d < King; d++)
+            {
+              const PieceType p4 = static_cast<PieceType>(d);
+              add({ p1, p2, p3 }, { p4 });
+
+              for (int32_t e = Pawn; e <= d; e++)
+                add({ p1, p2, p3 }, { p4, static_cast<PieceType>(e) });
+            }
+          }
+
+          for (int32_t c = Pawn; c <= a; c++)
+            for (int32_t d = Pawn; d <= ((a == c) ? b : c); d++)
+              add({ p1, p2 }, { static_cast<PieceType>(c), static_cast<PieceType>(d) });
+        }
+      }
+
+      YK_INFO("[ENGINE] Found {} tablebases, up to {} pieces", s_WDLTables.size(), s_MaxPieces);
+    }
+
+    size_t Tablebases::GetTableCount()
+    {
+      return s_WDLTables.size();
+    }
+
+    WDLScore Tablebases::ProbeWDL(Position& position, ProbeState& state)
+    {
+      state = ProbeState::Ok;
+      return SearchZeroing<false>(position, state);
+    }
+
+    int32_t Tablebases::ProbeDTZ(Position& position, ProbeState& state)
+    {
+      state = ProbeState::Ok;
+      const WDLScore wdl = SearchZeroing<true>(position, state);
+
+      // Draws are not stored
+      if (state == ProbeState::Fail || wdl == WDLDraw)
+        return 0;
+
+      if (state == ProbeState::ZeroingBestMove)
+        return DTZBeforeZeroing(wdl);
+
+      int32_t dtz = Probe<DTZTable>(position, state, wdl);
+      if (state == ProbeState::Fail)
+        return 0;
+
+      if (state != ProbeState::ChangeSideToMove)
+        return (dtz + 100 * (wdl == WDLBlessedLoss || wdl == WDLCursedWin)) * SignOf(wdl);
+
+      // The table holds the other side to move, one ply of search finds the move with the best DTZ
+      MoveList moves;
+      MoveGen::GenerateLegal(position, moves);
+
+      int32_t minDTZ = 0xFFFF;
+      for (const ScoredMove& move : moves)
+      {
+        const bool zeroing = move.IsCapture() || TypeOf(position.MovedPiece(move)) == Pawn;
+
+        position.MakeMove(move);
+        // A zeroing move's own DTZ is wanted, not the one of the sequence after it
+        dtz = zeroing ? -DTZBeforeZeroing(SearchZeroing<false>(position, state)) : -Tablebases::ProbeDTZ(position, state);
+
+        if (dtz == 1 && IsMate(position))
+          minDTZ = 1;
+
+        if (!zeroing)
+          dtz += SignOf(dtz);
+
+        // Draws are skipped, and only wins count when winning
+        if (dtz < minDTZ && SignOf(dtz) == SignOf(wdl))
+          minDTZ = dtz;
+        position.UnmakeMove();
+
+        if (state == ProbeState::Fail)
+          return 0;
+      }
+
+      // No legal move means mate
+      return (minDTZ == 0xFFFF) ? -1 : minDTZ;
+    }
+
+    bool Tablebases::FilterRootMoves(Position& position, std::vector<Move>& moves, bool rule50, bool& used_dtz)
+    {
+      if (moves.empty() || PopCount(position.Pieces()) > s_MaxPieces || position.CastlingRights())
+        return false;
+
+      std::vector<int32_t> ranks;
+      used_dtz = RankRootMovesDTZ(position, moves, ranks);
+      if (!used_dtz && !RankRootMovesWDL(position, moves, ranks))
+        return false;
+
+      // Without the fifty move rule a cursed win is as good as any other, and a blessed loss as bad
+      const int32_t bound = rule50 ? MaxDTZ - 100 : 1;
+      for (int32_t& rank : ranks)
+        rank = (rank >= bound) ? MaxDTZ : ((rank <= -bound) ? -MaxDTZ : rank);
+
+      const int32_t best = *std::max_element(ranks.begin(), ranks.end());
+      std::vector<Move> kept;
+      for (size_t i = 0; i < moves.size(); i++)
+        if (ranks[i] == best)
+          kept.push_back(moves[i]);
+      moves = std::move(kept);
+      return true;
+    }
+  }
+}
\ No newline at end of file
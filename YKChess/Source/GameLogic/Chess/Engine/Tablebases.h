@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "GameLogic/Chess/Engine/Position.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    // Results from the side to move's point of view, cursed wins and blessed losses are decided by the fifty move rule
+    enum WDLScore : int32_t
+    {
+      WDLLoss = -2,
+      WDLBlessedLoss = -1,
+      WDLDraw = 0,
+      WDLCursedWin = 1,
+      WDLWin = 2
+    };
+
+    enum class ProbeState : int8_t
+    {
+      Fail,
+      Ok,
+      ChangeSideToMove, // The DTZ table only stores the other side to move
+      ZeroingBestMove   // The best move is a capture or a pawn move, the stored value cannot be trusted
+    };
+
+    // Syzygy endgame tablebases. Files are found when the paths are set and mapped on their first probe,
+    // after that probing takes no lock and can be done by every search thread at once
+    class Tablebases
+    {
+    public:
+      static constexpr int32_t MaxPieces = 7;
+
+      // Directories separated by ';' on Windows and ':' elsewhere. Not to be called while a search is running
+      static void Init(const std::string& paths);
+
+      // Most pieces of any table found, 0 when there are none
+      static int32_t GetMaxPieces() { return s_MaxPieces; }
+      static size_t GetTableCount();
+
+      // The position must have no castling rights. Fail leaves the result meaningless
+      static WDLScore ProbeWDL(Position& position, ProbeState& state);
+
+      // Plies to the next capture or pawn move, signed like the WDL result and off by 100 for cursed wins and
+      // blessed losses. 0 is a draw
+      static int32_t ProbeDTZ(Position& position, ProbeState& state);
+
+      // Keeps the root moves that best preserve the tablebase result, using DTZ when its tables are there and WDL
+      // otherwise. Returns false and leaves the moves alone when the root is not covered
+      static bool FilterRootMoves(Position& position, std::vector<Move>& moves, bool rule50, bool& used_dtz);
+
+    private:
+      Tablebases() = delete;
+      Tablebases(const Tablebases&) = delete;
+      Tablebases& operator=(const Tablebases&) = delete;
+      Tablebases(Tablebases&&) = delete;
+      Tablebases& operator=(Tablebases&&) = delete;
+
+    private:
+      static int32_t s_MaxPieces;
+    };
+  }
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <new>
+
+namespace yk
+{
+  namespace Chess
+  {
+    // Coroutine frames of one search nest like a call stack, so they come from a bump allocator freed in reverse order.
+    // Frames that do not fit, or are made with no arena current, fall back to the heap
+    class FrameArena
+    {
+    public:
+      explicit FrameArena(size_t size) : m_Buffer(new std::byte[size]), m_Size(size) {}
+
+      void* Allocate(size_t size)
+      {
+        size = (size + Alignment - 1) & ~(Alignment - 1);
+        if (m_Top + size > m_Size)
+          return ::operator new(size);
+        void* frame = m_Buffer.get() + m_Top;
+        m_Top += size;
+        return frame;
+      }
+
+      void Free(void* frame)
+      {
+        std::byte* bytes = static_cast<std::byte*>(frame);
+        if (bytes >= m_Buffer.get() && bytes < m_Buffer.get() + m_Size)
+          m_Top = static_cast<size_t>(bytes - m_Buffer.get());
+        else
+          ::operator delete(frame);
+      }
+
+      // The arena of the search running on this thread, set by whoever resumes it
+      static FrameArena*& Current()
+      {
+        thread_local FrameArena* current = nullptr;
+        return current;
+      }
+
+    private:
+      static constexpr size_t Alignment = alignof(std::max_align_t);
+
+      std::unique_ptr<std::byte[]> m_Buffer;
+      size_t m_Size = 0;
+      size_t m_Top = 0;
+    };
+
+    // Lazily started coroutine returning a value to the one awaiting it, which resumes through symmetric transfer so a
+    // recursive search never grows the thread's stack
+    template<typename T>
+    class Task
+    {
+    public:
+      struct promise_type
+      {
+        T Value = {};
+        std::coroutine_handle<> Continuation = std::noop_coroutine();
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        auto final_suspend() noexcept
+        {
+          struct Awaiter
+          {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept { return handle.promise().Continuation; }
+            void await_resume() noexcept {}
+          };
+          return Awaiter();
+        }
+
+        void return_value(T value) { Value = value; }
+        void unhandled_exception() { std::terminate(); }
+
+        static void* operator new(size_t size)
+        {
+          FrameArena* arena = FrameArena::Current();
+          return arena ? arena->Allocate(size) : ::operator new(size);
+        }
+
+        static void operator delete(void* frame)
+        {
+          FrameArena* arena = FrameArena::Current();
+          if (arena)
+            arena->Free(frame);
+          else
+            ::operator delete(frame);
+        }
+      };
+
+      Task(Task&& other) noexcept : m_Handle(other.m_Handle) { other.m_Handle = nullptr; }
+      Task& operator=(Task&& other) noexcept
+      {
+        if (this != &other)
+        {
+          if (m_Handle)
+            m_Handle.destroy();
+          m_Handle = other.m_Handle;
+          other.m_Handle = nullptr;
+        }
+        return *this;
+      }
+      ~Task()
+      {
+        if (m_Handle)
+          m_Handle.destroy();
+      }
+
+      bool IsDone() const { return !m_Handle || m_Handle.done(); }
+      std::coroutine_handle<> GetHandle() const { return m_Handle; }
+      T GetValue() const { return m_Handle.promise().Value; }
+
+      bool await_ready() const noexcept { return false; }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+      {
+        m_Handle.promise().Continuation = continuation;
+        return m_Handle;
+      }
+      T await_resume() const { return m_Handle.promise().Value; }
+
+    private:
+      explicit Task(std::coroutine_handle<promise_type> handle) : m_Handle(handle) {}
+      Task(const Task&) = delete;
+      Task& operator=(const Task&) = delete;
+
+    private:
+      std::coroutine_handle<promise_type> m_Handle;
+    };
+  }
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include <algorithm>
+
+#include "GameLogic/Chess/Engine/Search.h"
+#include "GameLogic/Chess/Engine/TimeManager.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    void TimeManager::Init(const SearchLimits& limits, Color us, int32_t game_ply)
+    {
+      *this = TimeManager();
+
+      if (limits.MoveTime)
+      {
+        // Fixed time per move, used in full
+        m_Timed = true;
+        m_Optimum = m_Maximum = std::max<int64_t>(limits.MoveTime - MoveOverhead, 1);
+        return;
+      }
+
+      const int64_t time = limits.Time[us];
+      const int64_t increment = limits.Increment[us];
+      if (!time)
+        return;
+
+      m_Timed = true;
+      m_Adaptive = true;
+
+      // Sudden death assumes fewer moves remain the longer the game goes on
+      const int32_t movesToGo = limits.MovesToGo ? std::min(limits.MovesToGo, 50) : std::clamp(50 - game_ply / 4, 20, 50);
+      const int64_t available = std::max<int64_t>(time + increment * (movesToGo - 1) - MoveOverhead * movesToGo, 1);
+
+      m_Maximum = std::max<int64_t>(std::min<int64_t>(available / movesToGo * 5, time * 4 / 5 - MoveOverhead), 1);
+      m_Optimum = std::min(available / movesToGo, m_Maximum);
+    }
+
+    void TimeManager::PonderHit()
+    {
+      m_LastNodes = 0;
+      m_LastIterationNodes = 0;
+    }
+
+    bool TimeManager::ShouldContinue(Move best_move, int32_t score, uint64_t nodes, int64_t elapsed)
+    {
+      if (!m_Timed)
+        return true;
+      if (!m_Adaptive)
+        return elapsed < m_Maximum;
+
+      // Best move changes count for a few iterations and then fade away
+      m_Instability *= 0.5;
+      if (m_LastBestMove && best_move != m_LastBestMove)
+        m_Instability += 1.0;
+      m_LastBestMove = best_move;
+
+      const double stabilityScale = 0.7 + 0.8 * m_Instability;
+      const double scoreScale = (m_LastScore == ScoreNone) ? 1.0 : std::clamp(1.0 + (m_LastScore - score) / 150.0, 0.8, 1.8);
+      m_LastScore = score;
+
+      const int64_t soft = std::min(static_cast<int64_t>(m_Optimum * stabilityScale * scoreScale), m_Maximum);
+
+      // The next iteration costs about this one times the branching factor, at the rate measured so far
+      const uint64_t iterationNodes = nodes - m_LastNodes;
+      const double branching = m_LastIterationNodes ? std::clamp(static_cast<double>(iterationNodes) / m_LastIterationNodes, 1.5, 10.0) : 4.0;
+      const double nodesPerMs = static_cast<double>(nodes) / std::max<int64_t>(elapsed, 1);
+      const int64_t predicted = static_cast<int64_t>(iterationNodes * branching / std::max(nodesPerMs, 1.0));
+
+      m_LastNodes = nodes;
+      m_LastIterationNodes = iterationNodes;
+
+      if (elapsed >= soft)
+        return false;
+
+      // An iteration cut by the hard limit is thrown away, starting one that cannot finish only burns the clock
+      return elapsed + predicted <= m_Maximum && elapsed + predicted / 2 <= soft * 2;
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "GameLogic/Chess/Engine/Types.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    struct SearchLimits;
+
+    // Splits the clock into a soft limit, checked between iterations and scaled by how settled the search
+    // looks, and a hard limit the search is stopped at no matter what
+    class TimeManager
+    {
+    public:
+      void Init(const SearchLimits& limits, Color us, int32_t game_ply);
+
+      bool IsTimed() const { return m_Timed; }
+      int64_t GetOptimum() const { return m_Optimum; }
+      int64_t GetMaximum() const { return m_Maximum; }
+
+      // Called by the main worker after every completed iteration, false means the next one should not start
+      // Nodes and time are counted from the ponder hit on
+      bool ShouldContinue(Move best_move, int32_t score, uint64_t nodes, int64_t elapsed);
+      // The ponder tree was searched at another pace and must not count towards the rate or the iteration sizes
+      void PonderHit();
+
+    public:
+      // Lag between the engine deciding and the move showing up on the clock
+      static constexpr int64_t MoveOverhead = 30;
+
+    private:
+      bool m_Timed = false;
+      bool m_Adaptive = false;
+      int64_t m_Optimum = 0;
+      int64_t m_Maximum = 0;
+
+      Move m_LastBestMove;
+      double m_Instability = 0.0;
+      int32_t m_LastScore = ScoreNone;
+
+      uint64_t m_LastNodes = 0;
+      uint64_t m_LastIterationNodes = 0;
+    };
+  }
+}
\ No newline at end of file
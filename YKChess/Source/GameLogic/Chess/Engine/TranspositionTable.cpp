@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cstring>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/TranspositionTable.h"
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      inline uint64_t MulHi64(uint64_t a, uint64_t b)
+      {
+#if defined(__SIZEOF_INT128__)
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#elif defined(_MSC_VER)
+        return __umulh(a, b);
+#else
+        uint64_t aLow = static_cast<uint32_t>(a), aHigh = a >> 32;
+        uint64_t bLow = static_cast<uint32_t>(b), bHigh = b >> 32;
+        uint64_t cross = aHigh * bLow + ((aLow * bLow) >> 32);
+        return aHigh * bHigh + (cross >> 32) + ((aLow * bHigh + static_cast<uint32_t>(cross)) >> 32);
+#endif
+      }
+    }
+
+    void TTEntry::Save(uint64_t key, int32_t score, int32_t eval, Bound bound, int32_t depth, Move move, bool pv, uint8_t generation)
+    {
+      const uint16_t key16 = static_cast<uint16_t>(key);
+
+      // Keep the old move when the new search has none for the same position
+      if (move || key16 != m_Key)
+        m_Move = move.Data;
+
+      // Overwrite less valuable entries, shallow results of the same position don't replace deep ones
+      if (bound == Bound::Exact || key16 != m_Key || depth - DepthOffset + 2 * pv > m_Depth - 4)
+      {
+        m_Key = key16;
+        m_Score = static_cast<int16_t>(score);
+        m_Eval = static_cast<int16_t>(eval);
+        m_Depth = static_cast<uint8_t>(depth - DepthOffset);
+        m_GenerationBound = static_cast<uint8_t>(generation | (static_cast<uint8_t>(pv) << 2) | static_cast<uint8_t>(bound));
+      }
+    }
+
+    TranspositionTable::~TranspositionTable()
+    {
+      LargePages::Free(m_Allocation);
+    }
+
+    std::shared_ptr<TranspositionTable> TranspositionTable::Create(size_t megabytes)
+    {
+      std::shared_ptr<TranspositionTable> table(new TranspositionTable());
+      table->Resize(megabytes);
+      return table;
+    }
+
+    void TranspositionTable::Resize(size_t megabytes)
+    {
+      LargePages::Free(m_Allocation);
+
+      m_ClusterCount = std::max<size_t>(megabytes, 1) * 1024 * 1024 / sizeof(Cluster);
+      m_Allocation = LargePages::Allocate(m_ClusterCount * sizeof(Cluster));
+      m_Clusters = static_cast<Cluster*>(m_Allocation.Memory);
+      YK_ASSERT(m_Clusters, "[SYSTEM] Failed to allocate {}MB for the transposition table", megabytes);
+
+      // Clearing touches every page, only then does the kernel know how much of it got huge pages
+      TranspositionTable::Clear();
+      YK_INFO("[ENGINE] Transposition table of {}MB on {} pages, {}MB of them huge", megabytes, LargePages::GetKindName(m_Allocation.Kind),
+        LargePages::GetHugeBytes(m_Allocation) >> 20);
+    }
+
+    void TranspositionTable::Clear()
+    {
+      std::memset(static_cast<void*>(m_Clusters), 0, m_ClusterCount * sizeof(Cluster));
+      m_Generation = 0;
+    }
+
+    TTEntry* TranspositionTable::Probe(uint64_t key, bool& found) const
+    {
+      TTEntry* const entries = GetCluster(key)->Entries;
+      const uint16_t key16 = static_cast<uint16_t>(key);
+
+      for (int32_t i = 0; i < ClusterSize; i++)
+      {
+        if (entries[i].m_Key == key16 || !entries[i].m_Depth)
+        {
+          // Refresh the generation so the entry survives this search
+          entries[i].m_GenerationBound = static_cast<uint8_t>(m_Generation | (entries[i].m_GenerationBound & 0x7));
+          found = entries[i].m_Depth != 0;
+          return &entries[i];
+        }
+      }
+
+      // Replace the entry with the lowest depth, aged entries count as shallower
+      auto worth = [this](const TTEntry& entry)
+        {
+        const int32_t age = static_cast<uint8_t>(m_Generation - (entry.m_GenerationBound & 0xF8)) / GenerationStep;
+        return entry.m_Depth - 8 * age;
+        };
+
+      TTEntry* replace = &entries[0];
+      for (int32_t i = 1; i < ClusterSize; i++)
+        if (worth(entries[i]) < worth(*replace))
+          replace = &entries[i];
+
+      found = false;
+      return replace;
+    }
+
+    int32_t TranspositionTable::Hashfull() const
+    {
+      const size_t sample = std::min<size_t>(1000, m_ClusterCount);
+      int32_t count = 0;
+
+      for (size_t i = 0; i < sample; i++)
+        for (int32_t j = 0; j < ClusterSize; j++)
+          count += m_Clusters[i].Entries[j].m_Depth && (m_Clusters[i].Entries[j].m_GenerationBound & 0xF8) == m_Generation;
+
+      return static_cast<int32_t>(count * 1000 / (sample * ClusterSize));
+    }
+
+    int32_t TranspositionTable::ScoreToTT(int32_t score, int32_t ply)
+    {
+      if (score == ScoreNone)
+        return score;
+      if (score >= ScoreTablebaseWinInMaxPly)
+        return score + ply;
+      if (score <= -ScoreTablebaseWinInMaxPly)
+        return score - ply;
+      return score;
+    }
+
+    int32_t TranspositionTable::ScoreFromTT(int32_t score, int32_t ply, int32_t halfmove_clock)
+    {
+      if (score == ScoreNone)
+        return score;
+
+      // A stored mate may be out of reach once the fifty move rule is about to trigger
+      if (score >= ScoreMateInMaxPly)
+        return (ScoreMate - score > 99 - halfmove_clock) ? ScoreMateInMaxPly - 1 : score - ply;
+      if (score <= ScoreMatedInMaxPly)
+        return (ScoreMate + score > 99 - halfmove_clock) ? ScoreMatedInMaxPly + 1 : score + ply;
+      if (score >= ScoreTablebaseWinInMaxPly)
+        return (ScoreTablebaseWin - score > 99 - halfmove_clock) ? ScoreTablebaseWinInMaxPly - 1 : score - ply;
+      if (score <= -ScoreTablebaseWinInMaxPly)
+        return (ScoreTablebaseWin + score > 99 - halfmove_clock) ? -ScoreTablebaseWinInMaxPly + 1 : score + ply;
+      return score;
+    }
+
+    void TranspositionTable::Prefetch(uint64_t key) const
+    {
+      Chess::Prefetch(GetCluster(key));
+    }
+
+    TranspositionTable::Cluster* TranspositionTable::GetCluster(uint64_t key) const
+    {
+      return &m_Clusters[MulHi64(key, m_ClusterCount)];
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <memory>
+
+#include "GameLogic/Chess/Engine/LargePages.h"
+#include "GameLogic/Chess/Engine/Types.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    enum class Bound : uint8_t
+    {
+      None = 0,
+      Upper = 1,
+      Lower = 2,
+      Exact = Upper | Lower
+    };
+
+    // 10 bytes, three of them share a 32 byte cluster
+    class TTEntry
+    {
+    public:
+      Move GetMove() const { return Move(m_Move); }
+      int32_t GetScore() const { return m_Score; }
+      int32_t GetEval() const { return m_Eval; }
+      int32_t GetDepth() const { return static_cast<int32_t>(m_Depth) + DepthOffset; }
+      Bound GetBound() const { return static_cast<Bound>(m_GenerationBound & 0x3); }
+      bool IsPV() const { return m_GenerationBound & 0x4; }
+
+      void Save(uint64_t key, int32_t score, int32_t eval, Bound bound, int32_t depth, Move move, bool pv, uint8_t generation);
+
+    private:
+      friend class TranspositionTable;
+
+      static constexpr int32_t DepthOffset = -8;
+
+      uint16_t m_Key = 0;
+      uint16_t m_Move = 0;
+      int16_t m_Score = 0;
+      int16_t m_Eval = 0;
+      uint8_t m_Depth = 0;
+      uint8_t m_GenerationBound = 0;
+    };
+
+    class TranspositionTable
+    {
+    public:
+      ~TranspositionTable();
+
+      static std::shared_ptr<TranspositionTable> Create(size_t megabytes);
+
+      void Resize(size_t megabytes);
+      void Clear();
+      void NewSearch() { m_Generation += GenerationStep; }
+      uint8_t GetGeneration() const { return m_Generation; }
+
+      // Returns the matching entry when found, otherwise the entry that should be replaced
+      TTEntry* Probe(uint64_t key, bool& found) const;
+      // Starts loading the cluster of the key, to be probed a little later
+      void Prefetch(uint64_t key) const;
+
+      // Permille of the first thousand clusters written during the current search
+      int32_t Hashfull() const;
+
+      size_t GetSizeMB() const { return (m_ClusterCount * sizeof(Cluster)) >> 20; }
+      const PageAllocation& GetAllocation() const { return m_Allocation; }
+
+      static int32_t ScoreToTT(int32_t score, int32_t ply);
+      static int32_t ScoreFromTT(int32_t score, int32_t ply, int32_t halfmove_clock);
+
+    private:
+      static constexpr int32_t ClusterSize = 3;
+      static constexpr uint8_t GenerationStep = 0x8;
+
+      struct Cluster
+      {
+        TTEntry Entries[ClusterSize];
+        char Padding[2];
+      };
+      static_assert(sizeof(Cluster) == 32, "Clusters must stay 32 bytes so two of them share a cache line");
+
+      Cluster* GetCluster(uint64_t key) const;
+
+    private:
+      TranspositionTable() = default;
+      TranspositionTable(const TranspositionTable&) = delete;
+      TranspositionTable& operator=(const TranspositionTable&) = delete;
+      TranspositionTable(TranspositionTable&&) = delete;
+      TranspositionTable& operator=(TranspositionTable&&) = delete;
+
+    private:
+      PageAllocation m_Allocation;
+      Cluster* m_Clusters = nullptr;
+      size_t m_ClusterCount = 0;
+      uint8_t m_Generation = 0;
+    };
+  }
+}
\ No newline at end of file
@@ -0,0 +1,485 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <YKLib.h>
+
+#include "GameLogic/Chess/Engine/MappedFile.h"
+#include "GameLogic/Chess/Engine/MoveGen.h"
+#include "GameLogic/Chess/Engine/PSQT.h"
+#include "GameLogic/Chess/Engine/Tuner.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    namespace
+    {
+      constexpr size_t ChunkSize = 1 << 20; // Bytes of dataset per work item
+      constexpr size_t BlockSize = 1024;    // Positions scored together before their errors are reduced
+      constexpr int32_t QuiescencePly = 32;
+      constexpr int32_t ReportInterval = 100; // Epochs
+
+      // Search for the sigmoid scale, in the natural exponent per centipawn
+      constexpr double MinimumK = 0.0005;
+      constexpr double MaximumK = 0.05;
+      constexpr int32_t KIterations = 40;
+
+      constexpr double Beta1 = 0.9;
+      constexpr double Beta2 = 0.999;
+      constexpr double Epsilon = 1e-8;
+
+      struct Coefficient
+      {
+        uint16_t Index = 0;
+        int16_t Value = 0;
+      };
+
+      // Structure of arrays, every epoch streams through them in order
+      struct TuningSet
+      {
+        std::vector<float> Results;        // 1 for a White win, 0.5 for a draw and 0 for a loss
+        std::vector<float> MidgameWeights; // Phase over MaxPhase
+        std::vector<float> Tempo;          // From White's point of view
+        std::vector<uint32_t> Ends;        // One past the last coefficient of each position
+        std::vector<Coefficient> Coefficients;
+        uint64_t Skipped = 0;
+
+        size_t GetSize() const { return Results.size(); }
+
+        void Append(const TuningSet& other)
+        {
+          const uint32_t base = static_cast<uint32_t>(Coefficients.size());
+          Results.insert(Results.end(), other.Results.begin(), other.Results.end());
+          MidgameWeights.insert(MidgameWeights.end(), other.MidgameWeights.begin(), other.MidgameWeights.end());
+          Tempo.insert(Tempo.end(), other.Tempo.begin(), other.Tempo.end());
+          for (const uint32_t end : other.Ends)
+            Ends.push_back(base + end);
+          Coefficients.insert(Coefficients.end(), other.Coefficients.begin(), other.Coefficients.end());
+          Skipped += other.Skipped;
+        }
+      };
+
+      std::string_view NextToken(std::string_view& text)
+      {
+        const size_t begin = text.find_first_not_of(" \t");
+        if (begin == std::string_view::npos)
+        {
+          text = {};
+          return {};
+        }
+
+        const size_t end = std::min(text.find_first_of(" \t", begin), text.size());
+        const std::string_view token = text.substr(begin, end - begin);
+        text.remove_prefix(end);
+        return token;
+      }
+
+      bool IsNumber(std::string_view token)
+      {
+        return !token.empty() && std::all_of(token.begin(), token.end(), [](char c) { return c >= '0' && c <= '9'; });
+      }
+
+      // The position with its move counters, when it has them, and White's result from whatever follows
+      bool ParseLine(std::string_view line, std::string& fen, float& result)
+      {
+        std::string_view fields[4];
+        for (std::string_view& field : fields)
+          if ((field = NextToken(line)).empty())
+            return false;
+        fen = std::string(fields[0]) + " " + std::string(fields[1]) + " " + std::string(fields[2]) + " " + std::string(fields[3]);
+
+        std::string_view rest = line;
+        const std::string_view halfmove = NextToken(rest);
+        const std::string_view fullmove = NextToken(rest);
+        if (IsNumber(halfmove) && IsNumber(fullmove))
+        {
+          fen += " " + std::string(halfmove) + " " + std::string(fullmove);
+          line = rest;
+        }
+        else
+          fen += " 0 1";
+
+        if (line.find("1/2-1/2") != std::string_view::npos)
+          result = 0.5f;
+        else if (line.find("1-0") != std::string_view::npos)
+          result = 1.0f;
+        else if (line.find("0-1") != std::string_view::npos)
+          result = 0.0f;
+        else
+        {
+          const size_t open = line.find('[');
+          if (open == std::string_view::npos)
+            return false;
+          const char* first = line.data() + open + 1;
+          if (std::from_chars(first, line.data() + line.size(), result).ec != std::errc() || result < 0.0f || result > 1.0f)
+            return false;
+        }
+        return true;
+      }
+
+      // Quiescence search on the static evaluation that remembers its principal variation, playing it out leaves the
+      // quiet position whose score the search actually returns
+      class Resolver
+      {
+      public:
+        void Resolve(Position& position)
+        {
+          Resolver::Quiescence(position, -ScoreInfinite, ScoreInfinite, 0);
+          for (int32_t i = 0; i < m_PVLength[0]; i++)
+            position.MakeMove(m_PV[0][i]);
+        }
+
+      private:
+        int32_t Quiescence(Position& position, int32_t alpha, int32_t beta, int32_t ply)
+        {
+          m_PVLength[ply] = 0;
+
+          const int32_t standPat = Evaluation::Evaluate(position, m_Pawns);
+          if (standPat >= beta || ply == QuiescencePly - 1)
+            return standPat;
+          alpha = std::max(alpha, standPat);
+
+          // Most valuable victim first, losing captures are not worth resolving
+          ScoredMove moves[MaxMoves];
+          ScoredMove* end = MoveGen::Generate<GenType::Captures>(position, moves);
+          for (ScoredMove* move = moves; move != end; move++)
+            move->Score = 8 * SEEValue[TypeOf(position.PieceOn(move->To()))] - SEEValue[TypeOf(position.MovedPiece(*move))];
+          std::sort(moves, end, [](const ScoredMove& a, const ScoredMove& b) { return a.Score > b.Score; });
+
+          int32_t bestScore = standPat;
+          for (ScoredMove* move = moves; move != end; move++)
+          {
+            if (!position.IsLegal(*move) || !position.SEEGreaterEqual(*move, 0))
+              continue;
+
+            position.MakeMove(*move);
+            const int32_t score = -Resolver::Quiescence(position, -beta, -alpha, ply + 1);
+            position.UnmakeMove();
+
+            if (score <= bestScore)
+              continue;
+            bestScore = score;
+            if (score > alpha)
+            {
+              alpha = score;
+              m_PV[ply][0] = *move;
+              std::copy(m_PV[ply + 1], m_PV[ply + 1] + m_PVLength[ply + 1], m_PV[ply] + 1);
+              m_PVLength[ply] = m_PVLength[ply + 1] + 1;
+              if (score >= beta)
+                break;
+            }
+          }
+          return bestScore;
+        }
+
+      private:
+        PawnTable m_Pawns;
+        Move m_PV[QuiescencePly][QuiescencePly];
+        int32_t m_PVLength[QuiescencePly] = {};
+      };
+
+      TuningSet LoadChunk(std::string_view text, Resolver& resolver)
+      {
+        TuningSet set;
+        std::string fen;
+        Position position;
+
+        while (!text.empty())
+        {
+          const size_t end = std::min(text.find('\n'), text.size());
+          std::string_view line = text.substr(0, end);
+          text.remove_prefix(std::min(end + 1, text.size()));
+          if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+          if (line.find_first_not_of(" \t") == std::string_view::npos)
+            continue;
+
+          float result = 0.0f;
+          if (!ParseLine(line, fen, result) || !position.SetFEN(fen) || position.InCheck())
+          {
+            set.Skipped++;
+            continue;
+          }
+
+          resolver.Resolve(position);
+          const EvalTrace trace = Evaluation::Trace(position);
+
+          set.Results.push_back(result);
+          set.MidgameWeights.push_back(static_cast<float>(trace.Phase) / PSQT::MaxPhase);
+          set.Tempo.push_back(static_cast<float>((position.SideToMove() == White) ? Evaluation::GetTempo() : -Evaluation::GetTempo()));
+          for (int32_t index = 0; index < EvalParameterCount; index++)
+            if (trace.Coefficients[index])
+              set.Coefficients.push_back({ static_cast<uint16_t>(index), trace.Coefficients[index] });
+          set.Ends.push_back(static_cast<uint32_t>(set.Coefficients.size()));
+        }
+        return set;
+      }
+
+      // Chunks end on a line boundary and are resolved on every thread, then joined back in file order
+      TuningSet LoadDatasets(const std::vector<std::filesystem::path>& datasets, int32_t threads)
+      {
+        std::vector<std::shared_ptr<MappedFile>> files;
+        std::vector<std::string_view> chunks;
+        for (const std::filesystem::path& path : datasets)
+        {
+          std::shared_ptr<MappedFile> file = MappedFile::Open(path);
+          if (!file)
+          {
+            YK_WARN("[ENGINE] Tuning dataset '{}' not found", path.string());
+            continue;
+          }
+
+          const std::string_view text(reinterpret_cast<const char*>(file->GetData()), file->GetSize());
+          for (size_t begin = 0; begin < text.size();)
+          {
+            const size_t end = std::min(text.find('\n', std::min(begin + ChunkSize, text.size())), text.size());
+            chunks.push_back(text.substr(begin, end - begin));
+            begin = end + 1;
+          }
+          files.push_back(std::move(file));
+        }
+
+        std::vector<TuningSet> sets(chunks.size());
+        std::atomic<size_t> next = 0;
+        auto work = [&]()
+          {
+          std::unique_ptr<Resolver> resolver = std::make_unique<Resolver>();
+          for (size_t chunk = next++; chunk < chunks.size(); chunk = next++)
+            sets[chunk] = LoadChunk(chunks[chunk], *resolver);
+          };
+
+        std::vector<std::thread> workers;
+        for (int32_t i = 0; i < threads; i++)
+          workers.emplace_back(work);
+        for (std::thread& worker : workers)
+          worker.join();
+
+        TuningSet set;
+        for (TuningSet& chunk : sets)
+        {
+          set.Append(chunk);
+          chunk = TuningSet();
+        }
+        return set;
+      }
+
+      // Mean squared error of the sigmoid of every score against its result, with the gradient over the interleaved
+      // midgame and endgame weights when asked for. Threads take contiguous ranges and reduce their own sums.
+      double ComputeError(const TuningSet& set, const std::vector<float>& weights, double k, int32_t threads, std::vector<double>* gradient)
+      {
+        const size_t count = set.GetSize();
+        if (!count)
+          return 0.0;
+
+        std::vector<double> errors(threads, 0.0);
+        std::vector<std::vector<double>> gradients(gradient ? threads : 0, std::vector<double>(weights.size(), 0.0));
+        const float scale = static_cast<float>(k);
+
+        auto work = [&](int32_t thread)
+          {
+          const size_t first = count * thread / threads;
+          const size_t last = count * (thread + 1) / threads;
+          float scores[BlockSize];
+          float squares[BlockSize];
+          float factors[BlockSize];
+          double error = 0.0;
+
+          for (size_t base = first; base < last; base += BlockSize)
+          {
+            const size_t size = std::min(BlockSize, last - base);
+
+            // Sparse gather, a few dozen weights per position
+            for (size_t i = 0; i < size; i++)
+            {
+              const size_t position = base + i;
+              float midgame = 0.0f;
+              float endgame = 0.0f;
+              for (uint32_t c = (position ? set.Ends[position - 1] : 0); c < set.Ends[position]; c++)
+              {
+                const Coefficient coefficient = set.Coefficients[c];
+                midgame += coefficient.Value * weights[2 * coefficient.Index];
+                endgame += coefficient.Value * weights[2 * coefficient.Index + 1];
+              }
+              const float weight = set.MidgameWeights[position];
+              scores[i] = weight * midgame + (1.0f - weight) * endgame + set.Tempo[position];
+            }
+
+            // Dense and branch free over contiguous arrays, the part the compiler vectorizes
+            const float* results = set.Results.data() + base;
+            for (size_t i = 0; i < size; i++)
+            {
+              const float sigmoid = 1.0f / (1.0f + std::exp(-scale * scores[i]));
+              const float difference = results[i] - sigmoid;
+              squares[i] = difference * difference;
+              factors[i] = difference * sigmoid * (1.0f - sigmoid);
+            }
+            float blockError = 0.0f;
+            for (size_t i = 0; i < size; i++)
+              blockError += squares[i];
+            error += blockError;
+
+            if (!gradient)
+              continue;
+
+            double* local = gradients[thread].data();
+            for (size_t i = 0; i < size; i++)
+            {
+              const size_t position = base + i;
+              const float midgame = factors[i] * set.MidgameWeights[position];
+              const float endgame = factors[i] - midgame;
+              for (uint32_t c = (position ? set.Ends[position - 1] : 0); c < set.Ends[position]; c++)
+              {
+                const Coefficient coefficient = set.Coefficients[c];
+                local[2 * coefficient.Index] += coefficient.Value * midgame;
+                local[2 * coefficient.Index + 1] += coefficient.Value * endgame;
+              }
+            }
+          }
+          errors[thread] = error;
+          };
+
+        std::vector<std::thread> workers;
+        for (int32_t i = 1; i < threads; i++)
+          workers.emplace_back(work, i);
+        work(0);
+        for (std::thread& worker : workers)
+          worker.join();
+
+        double error = 0.0;
+        for (const double threadError : errors)
+          error += threadError;
+
+        if (gradient)
+        {
+          // The derivative of the squared difference through the sigmoid, for the mean
+          const double factor = -2.0 * k / static_cast<double>(count);
+          gradient->assign(weights.size(), 0.0);
+          for (const std::vector<double>& local : gradients)
+          {
+            double* total = gradient->data();
+            const double* part = local.data();
+            for (size_t i = 0; i < local.size(); i++)
+              total[i] += factor * part[i];
+          }
+        }
+        return error / static_cast<double>(count);
+      }
+
+      // Golden section search, the error is close enough to unimodal in the scale
+      double FitK(const TuningSet& set, const std::vector<float>& weights, int32_t threads)
+      {
+        constexpr double Ratio = 0.6180339887498949;
+        double low = MinimumK;
+        double high = MaximumK;
+        double left = high - Ratio * (high - low);
+        double right = low + Ratio * (high - low);
+        double leftError = ComputeError(set, weights, left, threads, nullptr);
+        double rightError = ComputeError(set, weights, right, threads, nullptr);
+
+        for (int32_t i = 0; i < KIterations; i++)
+        {
+          if (leftError < rightError)
+          {
+            high = right;
+            right = left;
+            rightError = leftError;
+            left = high - Ratio * (high - low);
+            leftError = ComputeError(set, weights, left, threads, nullptr);
+          }
+          else
+          {
+            low = left;
+            left = right;
+            leftError = rightError;
+            right = low + Ratio * (high - low);
+            rightError = ComputeError(set, weights, right, threads, nullptr);
+          }
+        }
+        return (low + high) / 2.0;
+      }
+    }
+
+    TunerReport Tuner::Tune(const std::vector<std::filesystem::path>& datasets, const TunerOptions& options)
+    {
+      TunerReport report;
+      const int32_t threads = std::max(options.Threads, 1);
+
+      auto start = std::chrono::steady_clock::now();
+      const TuningSet set = LoadDatasets(datasets, threads);
+      report.Positions = set.GetSize();
+      report.Skipped = set.Skipped;
+      report.LoadTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+      report.Parameters = Evaluation::GetParameters();
+
+      if (!report.Positions)
+      {
+        YK_WARN("[ENGINE] No positions to tune on");
+        return report;
+      }
+      YK_INFO("[ENGINE] Loaded {} tuning positions ({} skipped, {} coefficients) in {}ms", report.Positions, report.Skipped,
+        set.Coefficients.size(), report.LoadTime);
+
+      start = std::chrono::steady_clock::now();
+      std::vector<float> weights(2 * EvalParameterCount);
+      for (int32_t index = 0; index < EvalParameterCount; index++)
+      {
+        weights[2 * index] = static_cast<float>(MidgameValue(report.Parameters[index].Value));
+        weights[2 * index + 1] = static_cast<float>(EndgameValue(report.Parameters[index].Value));
+      }
+
+      report.K = (options.K > 0.0) ? options.K : FitK(set, weights, threads);
+      report.InitialError = ComputeError(set, weights, report.K, threads, nullptr);
+      YK_INFO("[ENGINE] Tuning with K {:.6f}, initial error {:.6f}", report.K, report.InitialError);
+
+      // Adam, weights that no position uses keep a zero gradient and never move
+      std::vector<double> gradient;
+      std::vector<double> moment(weights.size(), 0.0);
+      std::vector<double> velocity(weights.size(), 0.0);
+      double beta1Power = 1.0;
+      double beta2Power = 1.0;
+
+      for (int32_t epoch = 1; epoch <= options.Epochs; epoch++)
+      {
+        const double error = ComputeError(set, weights, report.K, threads, &gradient);
+        beta1Power *= Beta1;
+        beta2Power *= Beta2;
+
+        for (size_t i = 0; i < weights.size(); i++)
+        {
+          moment[i] = Beta1 * moment[i] + (1.0 - Beta1) * gradient[i];
+          velocity[i] = Beta2 * velocity[i] + (1.0 - Beta2) * gradient[i] * gradient[i];
+          const double corrected = moment[i] / (1.0 - beta1Power);
+          weights[i] -= static_cast<float>(options.LearningRate * corrected / (std::sqrt(velocity[i] / (1.0 - beta2Power)) + Epsilon));
+        }
+
+        if (epoch % ReportInterval == 0)
+          YK_INFO("[ENGINE] Epoch {}, error {:.6f}", epoch, error);
+      }
+
+      report.FinalError = ComputeError(set, weights, report.K, threads, nullptr);
+      report.TuneTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+      for (int32_t index = 0; index < EvalParameterCount; index++)
+        report.Parameters[index].Value = MakeScore(static_cast<int32_t>(std::lround(weights[2 * index])), static_cast<int32_t>(std::lround(weights[2 * index + 1])));
+
+      YK_INFO("[ENGINE] Tuned {} epochs in {}ms, error {:.6f} -> {:.6f}", options.Epochs, report.TuneTime, report.InitialError, report.FinalError);
+
+      if (!options.Output.empty())
+      {
+        std::ofstream file(options.Output, std::ios::trunc);
+        for (const EvalParameter& parameter : report.Parameters)
+          file << parameter.Name << ' ' << MidgameValue(parameter.Value) << ' ' << EndgameValue(parameter.Value) << '\n';
+        if (!file)
+          YK_ERROR("[ENGINE] Cannot write tuned weights to '{}'", options.Output.string());
+      }
+      return report;
+    }
+  }
+}
\ No newline at end of file
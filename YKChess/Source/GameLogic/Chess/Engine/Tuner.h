@@ -0,0 +1,51 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "GameLogic/Chess/Engine/Evaluation.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    struct TunerOptions
+    {
+      int32_t Threads = 1;
+      int32_t Epochs = 1000;
+      double LearningRate = 1.0; // Adam step in centipawns
+      double K = 0.0;            // Scale of the sigmoid turning scores into expected results, fitted to the data when 0
+      std::filesystem::path Output; // Tuned weights are written there, one per line, when set
+    };
+
+    struct TunerReport
+    {
+      uint64_t Positions = 0;
+      uint64_t Skipped = 0; // Lines without a position and a result, or in check
+      double K = 0.0;
+      double InitialError = 0.0;
+      double FinalError = 0.0;
+      int64_t LoadTime = 0; // Milliseconds
+      int64_t TuneTime = 0;
+      std::vector<EvalParameter> Parameters; // Tuned, rounded to whole centipawns
+    };
+
+    // Texel tuning of the hand written evaluation. Every dataset line holds a FEN or EPD position and the game result, as
+    // 1-0, 0-1 and 1/2-1/2 or as a number in brackets. Positions are resolved once to the end of their quiescence search
+    // and kept only as the sparse trace of their quiet leaf, so each epoch is a linear evaluation of all of them in
+    // parallel, the mean squared error of the sigmoid against the results and one Adam step on its gradient.
+    // The network and the endgame tables are not involved
+    class Tuner
+    {
+    public:
+      static TunerReport Tune(const std::vector<std::filesystem::path>& datasets, const TunerOptions& options);
+
+    private:
+      Tuner() = delete;
+      Tuner(const Tuner&) = delete;
+      Tuner& operator=(const Tuner&) = delete;
+      Tuner(Tuner&&) = delete;
+      Tuner& operator=(Tuner&&) = delete;
+    };
+  }
+}
\ No newline at end of file
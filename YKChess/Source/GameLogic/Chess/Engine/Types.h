@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+  #include <xmmintrin.h>
+#endif
+
+namespace yk
+{
+  namespace Chess
+  {
+    using Bitboard = uint64_t;
+    using Square = int32_t;
+
+    // Squares are numbered a1 = 0, b1 = 1, ..., h8 = 63
+    constexpr Square NoSquare = 64;
+
+    constexpr int32_t MaxPly = 128;
+    constexpr int32_t MaxMoves = 256;
+
+    constexpr int32_t ScoreDraw = 0;
+    constexpr int32_t ScoreMate = 32000;
+    constexpr int32_t ScoreInfinite = 32001;
+    constexpr int32_t ScoreNone = 32002;
+    constexpr int32_t ScoreMateInMaxPly = ScoreMate - MaxPly;
+    constexpr int32_t ScoreMatedInMaxPly = -ScoreMateInMaxPly;
+
+    // Tablebase wins sit right below the mates so that a found mate is still preferred
+    constexpr int32_t ScoreTablebaseWin = ScoreMateInMaxPly - 1;
+    constexpr int32_t ScoreTablebaseWinInMaxPly = ScoreTablebaseWin - MaxPly;
+
+    // An endgame known to be won without a known mate, above any evaluation
+    constexpr int32_t ScoreKnownWin = 10000;
+
+    enum Color : uint8_t
+    {
+      White,
+      Black,
+      ColorCount
+    };
+
+    enum PieceType : uint8_t
+    {
+      NoPieceType,
+      Pawn,
+      Knight,
+      Bishop,
+      Rook,
+      Queen,
+      King,
+      PieceTypeCount
+    };
+
+    enum Piece : uint8_t
+    {
+      NoPiece,
+      WhitePawn = Pawn, WhiteKnight, WhiteBishop, WhiteRook, WhiteQueen, WhiteKing,
+      BlackPawn = Pawn + 8, BlackKnight, BlackBishop, BlackRook, BlackQueen, BlackKing,
+      PieceCount = 16
+    };
+
+    enum CastlingRight : uint8_t
+    {
+      NoCastling = 0,
+      WhiteKingSide = 1,
+      WhiteQueenSide = 2,
+      BlackKingSide = 4,
+      BlackQueenSide = 8,
+      AllCastling = 15
+    };
+
+    enum class MoveFlag : uint8_t
+    {
+      Quiet = 0,
+      DoublePawnPush = 1,
+      KingCastle = 2,
+      QueenCastle = 3,
+      Capture = 4,
+      EnPassant = 5,
+      KnightPromotion = 8,
+      BishopPromotion = 9,
+      RookPromotion = 10,
+      QueenPromotion = 11,
+      KnightPromotionCapture = 12,
+      BishopPromotionCapture = 13,
+      RookPromotionCapture = 14,
+      QueenPromotionCapture = 15
+    };
+
+    constexpr Color operator~(Color color) { return static_cast<Color>(color ^ Black); }
+
+    constexpr Piece MakePiece(Color color, PieceType type) { return static_cast<Piece>((color << 3) | type); }
+    constexpr PieceType TypeOf(Piece piece) { return static_cast<PieceType>(piece & 7); }
+    constexpr Color ColorOf(Piece piece) { return static_cast<Color>(piece >> 3); }
+
+    constexpr int32_t FileOf(Square square) { return square & 7; }
+    constexpr int32_t RankOf(Square square) { return square >> 3; }
+    constexpr Square MakeSquare(int32_t file, int32_t rank) { return (rank << 3) | file; }
+    constexpr Square FlipRank(Square square) { return square ^ 56; }
+    constexpr Square RelativeSquare(Color color, Square square) { return color == White ? square : FlipRank(square); }
+    constexpr int32_t RelativeRank(Color color, Square square) { return color == White ? RankOf(square) : 7 - RankOf(square); }
+    constexpr Square PawnPush(Color color) { return color == White ? 8 : -8; }
+
+    // Midgame and endgame values packed in one integer so that both are updated with a single add,
+    // the endgame half sits in the upper 16 bits
+    using Score = int32_t;
+
+    constexpr Score MakeScore(int32_t midgame, int32_t endgame) { return static_cast<Score>(static_cast<uint32_t>(endgame) << 16) + midgame; }
+    constexpr int32_t MidgameValue(Score score) { return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(score))); }
+    constexpr int32_t EndgameValue(Score score) { return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(score + 0x8000) >> 16)); }
+
+    constexpr int32_t MateIn(int32_t ply) { return ScoreMate - ply; }
+    constexpr int32_t MatedIn(int32_t ply) { return -ScoreMate + ply; }
+
+    // Starts loading the cache line holding the address without waiting for it
+    inline void Prefetch(const void* address)
+    {
+#if defined(_MSC_VER)
+      _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+      __builtin_prefetch(address);
+#endif
+    }
+
+    // Moves are packed into 16 bits: 6 bits origin, 6 bits destination, 4 bits MoveFlag
+    struct Move
+    {
+      uint16_t Data = 0;
+
+      constexpr Move() = default;
+      constexpr explicit Move(uint16_t data) : Data(data) {}
+      constexpr Move(Square from, Square to, MoveFlag flag = MoveFlag::Quiet)
+        : Data(static_cast<uint16_t>(from | (to << 6) | (static_cast<uint16_t>(flag) << 12))) {}
+
+      constexpr Square From() const { return Data & 0x3F; }
+      constexpr Square To() const { return (Data >> 6) & 0x3F; }
+      constexpr MoveFlag Flag() const { return static_cast<MoveFlag>(Data >> 12); }
+      constexpr uint16_t FromTo() const { return Data & 0xFFF; }
+
+      constexpr bool IsCapture() const { return (Data >> 12) & 4; }
+      constexpr bool IsPromotion() const { return (Data >> 12) & 8; }
+      constexpr bool IsCastling() const { return Flag() == MoveFlag::KingCastle || Flag() == MoveFlag::QueenCastle; }
+      constexpr bool IsEnPassant() const { return Flag() == MoveFlag::EnPassant; }
+      constexpr bool IsQuiet() const { return !IsCapture() && !IsPromotion(); }
+      constexpr PieceType PromotionType() const { return static_cast<PieceType>(Knight + ((Data >> 12) & 3)); }
+
+      constexpr bool IsValid() const { return From() != To(); }
+      constexpr explicit operator bool() const { return Data != 0; }
+      constexpr bool operator==(const Move& other) const { return Data == other.Data; }
+      constexpr bool operator!=(const Move& other) const { return Data != other.Data; }
+
+      static constexpr Move None() { return Move(); }
+      static constexpr Move Null() { return Move(1, 1); }
+    };
+
+    struct ScoredMove : public Move
+    {
+      int32_t Score = 0;
+
+      ScoredMove() = default;
+      ScoredMove(Move move, int32_t score = 0) : Move(move), Score(score) {}
+    };
+  }
+}
\ No newline at end of file
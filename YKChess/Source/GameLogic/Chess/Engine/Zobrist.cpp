@@ -0,0 +1,47 @@
+#include "GameLogic/Chess/Engine/Zobrist.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    uint64_t Zobrist::s_PieceSquare[PieceCount][64];
+    uint64_t Zobrist::s_Castling[16];
+    uint64_t Zobrist::s_EnPassantFile[8];
+    uint64_t Zobrist::s_SideToMove;
+
+    void Zobrist::Init()
+    {
+      // SplitMix64 with a fixed seed, keys must be identical across runs and builds
+      uint64_t state = 0x59B1C7E3A2D40F15ULL;
+      auto next = [&state]()
+        {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+        };
+
+      for (int32_t piece = 0; piece < PieceCount; piece++)
+        for (Square square = 0; square < 64; square++)
+          s_PieceSquare[piece][square] = (TypeOf(static_cast<Piece>(piece)) == NoPieceType) ? 0ULL : next();
+
+      // Castling keys are combined per right so that any subset hashes consistently
+      uint64_t rightKeys[4];
+      for (uint64_t& key : rightKeys)
+        key = next();
+
+      for (int32_t rights = 0; rights < 16; rights++)
+      {
+        s_Castling[rights] = 0ULL;
+        for (int32_t bit = 0; bit < 4; bit++)
+          if (rights & (1 << bit))
+            s_Castling[rights] ^= rightKeys[bit];
+      }
+
+      for (uint64_t& key : s_EnPassantFile)
+        key = next();
+
+      s_SideToMove = next();
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "GameLogic/Chess/Engine/Types.h"
+
+namespace yk
+{
+  namespace Chess
+  {
+    class Zobrist
+    {
+    public:
+      static void Init();
+
+      static uint64_t PieceSquare(Piece piece, Square square) { return s_PieceSquare[piece][square]; }
+      static uint64_t Castling(uint8_t rights) { return s_Castling[rights]; }
+      static uint64_t EnPassant(Square square) { return s_EnPassantFile[FileOf(square)]; }
+      static uint64_t SideToMove() { return s_SideToMove; }
+
+    private:
+      Zobrist() = delete;
+      Zobrist(const Zobrist&) = delete;
+      Zobrist& operator=(const Zobrist&) = delete;
+      Zobrist(Zobrist&&) = delete;
+      Zobrist& operator=(Zobrist&&) = delete;
+
+    private:
+      static uint64_t s_PieceSquare[PieceCount][64];
+      static uint64_t s_Castling[16];
+      static uint64_t s_EnPassantFile[8];
+      static uint64_t s_SideToMove;
+    };
+  }
+}
\ No newline at end of file
@@ -1,9 +1,15 @@
-﻿#include <bit>
+﻿#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <string>
+#include <thread>
 
 #include <YKLib.h>
 #include <glm/glm.hpp>
+#include <imgui.h>
 
 #include "Core/WindowManager.h"
+#include "GameLogic/Chess/Engine/Zobrist.h"
 #include "GameLogic/Chess/Game.h"
 #include "Rendering/Renderer.h"
 
@@ -31,8 +37,29 @@ namespace yk
   {
     std::shared_ptr<Game> Game::Create()
     {
+      Bitboards::Init();
+      Zobrist::Init();
+
       std::shared_ptr<Game> game(new Game());
       game->SetPiecesDefaultPositions();
+      game->m_Position = Position::StartPosition();
+      game->m_Table = TranspositionTable::Create(64);
+      game->m_Search = Search::Create(game->m_Table, std::max(static_cast<int32_t>(std::thread::hardware_concurrency()) - 1, 1));
+
+      // Pondering runs while the human is thinking, leave room for the render thread on small machines
+      SearchOptions options;
+      options.PonderShare = 0.5;
+      options.StatsFile = "SearchStats.json";
+      game->m_Search->SetOptions(options);
+
+      // The network is optional, without one the engine keeps its hand written evaluation
+      game->m_Search->SetNetwork(NNUE::Network::Load("Assets/Networks/YKChess.nnue"));
+      // Tablebases are optional too, a missing directory is silently skipped
+      Tablebases::Init("Assets/Syzygy");
+      Bitbases::Load("Assets/Bitbases");
+      // So is the opening book
+      game->m_Book = Book::Open("Assets/Books/Book.bin");
+      game->m_BookRandom.seed(std::random_device()());
       game->m_ChessAtlas = ImageResource::Create("Assets/Textures/ChessAtlas.png", 1, 24, 24);
       game->m_ChessBoard = ImageResource::Create("Assets/Textures/ChessBoard.png", 2);
       game->DrawGame();
@@ -700,6 +727,486 @@ namespace yk
       }
     }
 
+    void Game::DrawMoveResult() const
+    {
+      Renderer::ResetBatch();
+      Game::DrawGame();
+
+      if (m_NextMoveTile)
+      {
+        auto [row, col] = Game::GetPosition(m_NextMoveTile);
+        Game::Draw(DrawElement::ActionTile, -0.7f + (0.2f * col), -0.7f + (0.2f * row), row * 8 + col + 1);
+      }
+      if (m_GameStatus.BlackCheck)
+      {
+        auto [rowk, colk] = Game::GetPosition(m_BoardStatus.BlackKing);
+        Game::Draw(DrawElement::ActionTile, -0.7f + (0.2f * colk), -0.7f + (0.2f * rowk), rowk * 8 + colk + 1);
+      }
+      if (m_GameStatus.WhiteCheck)
+      {
+        auto [rowk, colk] = Game::GetPosition(m_BoardStatus.WhiteKing);
+        Game::Draw(DrawElement::ActionTile, -0.7f + (0.2f * colk), -0.7f + (0.2f * rowk), rowk * 8 + colk + 1);
+      }
+
+      Renderer::EndBatch();
+    }
+
+    void Game::Update(Timestep timestep)
+    {
+      // Only the newest depth is shown, older updates still queued are skipped
+      AnalysisUpdate update;
+      while (m_Search->PollAnalysis(update))
+        m_Analysis = std::move(update);
+      Game::DrawAnalysisOverlay();
+      Game::DrawStatisticsOverlay();
+
+      if (m_GameStatus.Mate || m_GameStatus.Draw || m_GameStatus.TimeOut)
+        return;
+
+      const Color toMove = m_Position.SideToMove();
+
+      if (m_Turn != m_EngineSide)
+      {
+        // The human clock runs on frame time, the engine measures its own time inside the search
+        m_ClockMs[toMove] -= timestep.GetMilliseconds();
+        if (m_ClockMs[toMove] <= 0.0)
+        {
+          // The engine may be pondering on the move the human never made
+          Game::StopPonderSearch();
+          m_GameStatus.TimeOut = true;
+          YK_INFO("{} side has lost on time", (toMove == White) ? "White" : "Black");
+        }
+        return;
+      }
+
+      if (!m_EngineThinking)
+      {
+        if (!Game::PlayBookMove())
+          Game::StartEngineSearch();
+        return;
+      }
+
+      // Never blocks the frame, the result is picked up on the first frame after the search is done
+      if (m_Search->IsSearching())
+        return;
+
+      m_Search->Wait();
+      m_EngineThinking = false;
+
+      const SearchResult result = m_Search->GetResult();
+      m_SearchReport = m_Search->GetReport();
+      m_ClockMs[toMove] -= static_cast<double>(result.Time);
+      if (m_ClockMs[toMove] <= 0.0)
+      {
+        m_GameStatus.TimeOut = true;
+        YK_INFO("{} side has lost on time", (toMove == White) ? "White" : "Black");
+        return;
+      }
+
+      m_SelectedTile = 0ULL;
+      m_SelectedTileMoves = 0ULL;
+      m_NextMoveTile = Game::SquareToTile(result.BestMove.To());
+      Game::PlayMove(result.BestMove);
+      Game::StartPonderSearch(result.PonderMove);
+    }
+
+    Square Game::TileToSquare(BoardBitField tile)
+    {
+      const int32_t index = static_cast<int32_t>(std::countr_zero(tile));
+      return MakeSquare(7 - (index % 8), index / 8);
+    }
+
+    Game::BoardBitField Game::SquareToTile(Square square)
+    {
+      return 1ULL << (RankOf(square) * 8 + (7 - FileOf(square)));
+    }
+
+    Move Game::FindMove(BoardBitField src_tile, BoardBitField dst_tile) const
+    {
+      const Square from = Game::TileToSquare(src_tile);
+      const Square to = Game::TileToSquare(dst_tile);
+
+      // Promotions come queen first, which is what a click on the last rank means
+      MoveList moves;
+      MoveGen::GenerateLegal(m_Position, moves);
+      for (const ScoredMove& move : moves)
+        if (move.From() == from && move.To() == to)
+          return move;
+
+      return Move::None();
+    }
+
+    void Game::PlayMove(Move move)
+    {
+      const Color us = m_Position.SideToMove();
+
+      m_BoardStatusHistory.push_back(m_BoardStatus);
+      m_Position.MakeMove(move);
+      m_ClockMs[us] += ClockIncrementMs;
+
+      Game::SyncBoardWithPosition();
+      m_Turn = (m_Turn == Side::Black) ? Side::White : Side::Black;
+      Game::UpdateGameStatus(m_Turn);
+
+      MoveList replies;
+      MoveGen::GenerateLegal(m_Position, replies);
+      m_GameStatus.Mate = replies.empty() && m_Position.InCheck();
+      m_GameStatus.Draw = !m_GameStatus.Mate && (replies.empty() || m_Position.IsDraw(0));
+
+      if (m_GameStatus.Mate)
+      {
+        if (m_GameStatus.BlackCheck)
+          YK_INFO("White side has won");
+        if (m_GameStatus.WhiteCheck)
+          YK_INFO("Black side has won");
+      }
+      else if (m_GameStatus.Draw)
+        YK_INFO("The game is drawn");
+
+      Game::DrawMoveResult();
+    }
+
+    void Game::SyncBoardWithPosition()
+    {
+      m_BoardStatus = BoardStatus();
+
+      for (Square square = 0; square < 64; square++)
+      {
+        const Chess::Piece piece = m_Position.PieceOn(square);
+        if (piece == NoPiece)
+          continue;
+
+        const bool black = ColorOf(piece) == Black;
+        BoardBitField* board = nullptr;
+        switch (TypeOf(piece))
+        {
+        case Chess::Pawn:   board = black ? &m_BoardStatus.BlackPawns : &m_BoardStatus.WhitePawns; break;
+        case Chess::Knight: board = black ? &m_BoardStatus.BlackKnights : &m_BoardStatus.WhiteKnights; break;
+        case Chess::Bishop: board = black ? &m_BoardStatus.BlackBishops : &m_BoardStatus.WhiteBishops; break;
+        case Chess::Rook:   board = black ? &m_BoardStatus.BlackRooks : &m_BoardStatus.WhiteRooks; break;
+        case Chess::Queen:  board = black ? &m_BoardStatus.BlackQueens : &m_BoardStatus.WhiteQueens; break;
+        case Chess::King:   board = black ? &m_BoardStatus.BlackKing : &m_BoardStatus.WhiteKing; break;
+        default:
+          YK_ASSERT(false, "Should not happend");
+          continue;
+        }
+
+        *board |= Game::SquareToTile(square);
+      }
+    }
+
+    bool Game::PlayBookMove()
+    {
+      if (!m_Book)
+        return false;
+
+      const Move move = m_Book->PickMove(m_Position, m_BookRandom());
+      if (!move)
+        return false;
+
+      // A ponder search may still be running on the human's last move, book moves take no clock time
+      Game::StopPonderSearch();
+
+      m_SelectedTile = 0ULL;
+      m_SelectedTileMoves = 0ULL;
+      m_NextMoveTile = Game::SquareToTile(move.To());
+      Game::PlayMove(move);
+      return true;
+    }
+
+    void Game::StartEngineSearch()
+    {
+      if (m_PonderMove)
+      {
+        const bool hit = m_Position.LastMove() == m_PonderMove;
+        m_PonderMove = Move::None();
+
+        if (hit)
+        {
+          m_Search->PonderHit();
+          m_EngineThinking = true;
+          return;
+        }
+
+        // Searched the wrong position, start over right away, the hash table is kept
+        m_Search->Stop();
+        m_Search->Wait();
+      }
+
+      SearchLimits limits;
+      limits.Time[White] = static_cast<int64_t>(m_ClockMs[White]);
+      limits.Time[Black] = static_cast<int64_t>(m_ClockMs[Black]);
+      limits.Increment[White] = limits.Increment[Black] = static_cast<int64_t>(ClockIncrementMs);
+
+      m_Search->Start(m_Position, limits);
+      m_EngineThinking = true;
+    }
+
+    void Game::StartPonderSearch(Move ponder_move)
+    {
+      if (!ponder_move || m_GameStatus.Mate || m_GameStatus.Draw || !m_Position.IsPseudoLegal(ponder_move) || !m_Position.IsLegal(ponder_move))
+        return;
+
+      Position position = m_Position;
+      position.MakeMove(ponder_move);
+
+      MoveList replies;
+      MoveGen::GenerateLegal(position, replies);
+      if (replies.empty())
+        return;
+
+      // The engine clock is known exactly, it does not run until the ponder move is actually played
+      SearchLimits limits;
+      limits.Time[White] = static_cast<int64_t>(m_ClockMs[White]);
+      limits.Time[Black] = static_cast<int64_t>(m_ClockMs[Black]);
+      limits.Increment[White] = limits.Increment[Black] = static_cast<int64_t>(ClockIncrementMs);
+      limits.Ponder = true;
+
+      m_Search->Start(position, limits);
+      m_PonderMove = ponder_move;
+    }
+
+    void Game::StopPonderSearch()
+    {
+      if (!m_PonderMove)
+        return;
+
+      m_PonderMove = Move::None();
+      m_Search->Stop();
+      m_Search->Wait();
+    }
+
+    void Game::DrawAnalysisOverlay()
+    {
+      ImGui::Begin("Analysis");
+
+      if (ImGui::SliderInt("Lines", &m_MultiPV, 1, 8))
+      {
+        SearchOptions options = m_Search->GetOptions();
+        options.MultiPV = m_MultiPV;
+        m_Search->SetOptions(options);
+      }
+
+      ImGui::Text("Depth %d  Nodes %llu  Time %lld ms", m_Analysis.Depth, static_cast<unsigned long long>(m_Analysis.Nodes), static_cast<long long>(m_Analysis.Time));
+      ImGui::Separator();
+
+      for (size_t i = 0; i < m_Analysis.Lines.size(); i++)
+      {
+        const AnalysisLine& line = m_Analysis.Lines[i];
+
+        std::string score;
+        if (std::abs(line.Score) >= ScoreMateInMaxPly)
+          score = "#" + std::to_string((line.Score > 0) ? (ScoreMate - line.Score + 1) / 2 : -(ScoreMate + line.Score) / 2);
+        else if (std::abs(line.Score) >= ScoreTablebaseWinInMaxPly)
+          score = (line.Score > 0) ? "TB win" : "TB loss";
+        else
+          score = std::to_string(line.Score);
+
+        std::string pv;
+        for (const Move move : line.PV)
+          pv += Position::MoveToUCI(move) + " ";
+
+        ImGui::Text("%zu. %s  (%llu nodes)  %s", i + 1, score.c_str(), static_cast<unsigned long long>(line.Nodes), pv.c_str());
+      }
+
+      if (m_Book)
+      {
+        ImGui::Separator();
+        std::string moves;
+        for (const BookMove& move : m_Book->GetMoves(m_Position))
+          moves += Position::MoveToUCI(move.Move) + " (" + std::to_string(move.Weight) + ") ";
+        ImGui::Text("Book: %s", moves.empty() ? "out of book" : moves.c_str());
+      }
+
+      // The book is closed while its file is rebuilt from every collection in the games folder, then opened again
+      if (m_BookBuild.valid())
+      {
+        if (m_BookBuild.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+          m_BookReport = m_BookBuild.get();
+          m_Book = Book::Open("Assets/Books/Book.bin");
+        }
+        else
+          ImGui::Text("Building book...");
+      }
+      else if (ImGui::Button("Build book"))
+      {
+        std::vector<std::filesystem::path> collections;
+        std::error_code error;
+        for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator("Assets/Books/Games", error))
+          if (entry.path().extension() == ".pgn")
+            collections.push_back(entry.path());
+
+        BookBuildOptions options;
+        options.Threads = std::max(static_cast<int32_t>(std::thread::hardware_concurrency()), 1);
+        m_Book = nullptr;
+        m_BookBuild = std::async(std::launch::async, [collections, options]() { return BookBuilder::Build(collections, "Assets/Books/Book.bin", options); });
+      }
+
+      if (m_BookReport && !m_BookReport->Written)
+        ImGui::Text("Book build failed after %llu games, see the log", static_cast<unsigned long long>(m_BookReport->Games));
+      else if (m_BookReport)
+        ImGui::Text("Book built from %llu games: %llu entries, %.0f games/s, %zu runs spilled", static_cast<unsigned long long>(m_BookReport->Games),
+          static_cast<unsigned long long>(m_BookReport->Entries), m_BookReport->GamesPerSecond, m_BookReport->Runs);
+
+      // Proof-number search on a copy of the board, the result stays until the next request
+      ImGui::Separator();
+      if (m_MateSearch.valid())
+      {
+        if (m_MateSearch.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+          m_MateResult = m_MateSearch.get();
+        else
+          ImGui::Text("Looking for a mate...");
+      }
+      else if (ImGui::Button("Find mate"))
+      {
+        const Position position = m_Position;
+        m_MateResult.reset();
+        m_MateSearch = std::async(std::launch::async, [position]() { return MateSolver::Create(64)->Solve(position); });
+      }
+
+      if (m_MateResult)
+      {
+        std::string pv;
+        for (const Move move : m_MateResult->PV)
+          pv += Position::MoveToUCI(move) + " ";
+
+        if (m_MateResult->Found)
+          ImGui::Text("Mate in %d (%llu nodes, %lld ms): %s", m_MateResult->MateIn, static_cast<unsigned long long>(m_MateResult->Nodes),
+            static_cast<long long>(m_MateResult->Time), pv.c_str());
+        else
+          ImGui::Text("%s (%llu nodes, %lld ms)", m_MateResult->Disproven ? "No mate in range" : "No mate found", static_cast<unsigned long long>(m_MateResult->Nodes),
+            static_cast<long long>(m_MateResult->Time));
+      }
+
+      // Every move so far judged on all cores at once, from the last position backwards
+      ImGui::Separator();
+      if (m_GameAnalysis.valid())
+      {
+        if (m_GameAnalysis.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+          m_GameAnalysisReport = m_GameAnalysis.get();
+        else
+          ImGui::Text("Analyzing the game...");
+      }
+      else if (m_Position.StateIndex() > 0 && ImGui::Button("Analyze game"))
+      {
+        const Position position = m_Position;
+        GameAnalysisOptions options;
+        options.Threads = std::max(static_cast<int32_t>(std::thread::hardware_concurrency()), 1);
+        options.Limits.Depth = GameAnalysisDepth;
+        options.Network = m_Search->GetNetwork();
+        m_GameAnalysisReport.reset();
+        m_GameAnalysis = std::async(std::launch::async, [position, options]() { return GameAnalysis::Analyze(position, options); });
+      }
+
+      if (m_GameAnalysisReport)
+      {
+        ImGui::Text("Analyzed %zu moves at depth %d on %d threads in %lld ms", m_GameAnalysisReport->Moves.size(), GameAnalysisDepth,
+          m_GameAnalysisReport->Threads, static_cast<long long>(m_GameAnalysisReport->Time));
+        for (Color color : { White, Black })
+        {
+          const int32_t* counts = m_GameAnalysisReport->Counts[color];
+          ImGui::Text("%s: %d inaccuracies, %d mistakes, %d blunders, %.0f cp average loss", (color == White) ? "White" : "Black",
+            counts[static_cast<size_t>(MoveClassification::Inaccuracy)], counts[static_cast<size_t>(MoveClassification::Mistake)],
+            counts[static_cast<size_t>(MoveClassification::Blunder)], m_GameAnalysisReport->AverageLoss[color]);
+        }
+        for (size_t i = 0; i < m_GameAnalysisReport->Moves.size(); i++)
+        {
+          const MoveAnnotation& annotation = m_GameAnalysisReport->Moves[i];
+          if (annotation.Classification < MoveClassification::Inaccuracy)
+            continue;
+          ImGui::Text("%zu. %s%s, %s was best (%d cp lost)", i / 2 + 1, Position::MoveToUCI(annotation.Played).c_str(),
+            GameAnalysis::GetClassificationSymbol(annotation.Classification), Position::MoveToUCI(m_GameAnalysisReport->Positions[i].BestMove).c_str(),
+            annotation.Loss);
+        }
+      }
+
+      ImGui::Separator();
+      ImGui::Text("Evaluation: %s", m_Search->GetNetwork() ? "network" : "hand written");
+      // Takes seconds, every kernel is timed in turn
+      if (m_NetworkBenchmarkRun.valid())
+      {
+        if (m_NetworkBenchmarkRun.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+          m_NetworkBenchmark = m_NetworkBenchmarkRun.get();
+        else
+          ImGui::Text("Benchmarking the network...");
+      }
+      else if (ImGui::Button("Benchmark network"))
+      {
+        // Only speed is measured, so untrained weights do when no network is loaded
+        std::shared_ptr<const NNUE::Network> network = m_Search->GetNetwork();
+        if (!network)
+          network = NNUE::Network::CreateRandom(1);
+        m_NetworkBenchmark.clear();
+        m_NetworkBenchmarkRun = std::async(std::launch::async, [network]() { return NNUE::RunBenchmark(*network); });
+      }
+
+      for (const NNUE::BenchmarkResult& result : m_NetworkBenchmark)
+        ImGui::Text("%s: %.0f evals/s  update %.0f ns  refresh %.0f ns  layers %.0f ns", result.Kernel, result.EvaluationsPerSecond,
+          result.UpdateNanoseconds, result.RefreshNanoseconds, result.PropagateNanoseconds);
+
+      ImGui::Separator();
+      // Generation takes minutes on the largest endgames, it runs beside the game and the search keeps probing meanwhile
+      if (m_BitbaseGeneration.valid())
+      {
+        if (m_BitbaseGeneration.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+          m_BitbaseReports = m_BitbaseGeneration.get();
+        else
+          ImGui::Text("Generating bitbases...");
+      }
+      else if (ImGui::Button("Generate bitbases"))
+      {
+        const int32_t threads = std::max(static_cast<int32_t>(std::thread::hardware_concurrency()), 1);
+        m_BitbaseGeneration = std::async(std::launch::async, [threads]() { return Bitbases::Generate("Assets/Bitbases", threads); });
+      }
+
+      for (const BitbaseReport& report : m_BitbaseReports)
+        ImGui::Text("%s: %llu positions, %d bit(s) each, %zu KB, %lld ms", report.Name.c_str(), static_cast<unsigned long long>(report.Positions),
+          report.BitsPerPosition, report.Bytes >> 10, static_cast<long long>(report.Time));
+
+      ImGui::End();
+    }
+
+    void Game::DrawStatisticsOverlay() const
+    {
+      ImGui::Begin("Search statistics");
+
+      if (!m_SearchReport)
+      {
+        ImGui::Text("No search finished yet");
+        ImGui::End();
+        return;
+      }
+
+      const SearchReport& report = *m_SearchReport;
+      const SearchStats& total = report.Total;
+      auto percent = [](uint64_t part, uint64_t whole) { return whole ? 100.0 * static_cast<double>(part) / static_cast<double>(whole) : 0.0; };
+
+      const uint64_t nodes = total.Nodes.load(std::memory_order_relaxed);
+      ImGui::Text("Depth %d  Nodes %llu  Time %lld ms  NPS %llu", report.Result.Depth, static_cast<unsigned long long>(report.Result.Nodes),
+        static_cast<long long>(report.Result.Time), static_cast<unsigned long long>(report.NodesPerSecond()));
+      ImGui::Text("Quiescence nodes %.1f%%  Effective branching factor %.2f", percent(total.QNodes, nodes), report.EffectiveBranchingFactor());
+      ImGui::Text("TT hits %.1f%%  TT cutoffs %llu  Pawn hits %.1f%%", percent(total.TTHits, total.TTProbes),
+        static_cast<unsigned long long>(total.TTCutoffs), percent(total.PawnHits, total.PawnProbes));
+      ImGui::Text("First move cutoffs %.1f%%  Null move success %.1f%%  LMR success %.1f%%", percent(total.FirstMoveCutoffs, total.BetaCutoffs),
+        percent(total.NullMoveCutoffs, total.NullMoveTries), 100.0 - percent(total.ReducedResearches, total.ReducedSearches));
+
+      ImGui::Separator();
+      for (size_t i = 0; i < report.Threads.size(); i++)
+        ImGui::Text("Thread %zu: %llu nodes", i, static_cast<unsigned long long>(report.Threads[i].Nodes.load(std::memory_order_relaxed)));
+
+      ImGui::Separator();
+      for (size_t i = 0; i < report.Iterations.size(); i++)
+      {
+        const IterationStats& iteration = report.Iterations[i];
+        const IterationStats previous = i ? report.Iterations[i - 1] : IterationStats();
+        ImGui::Text("Depth %d: %llu nodes, %lld ms", iteration.Depth, static_cast<unsigned long long>(iteration.Nodes - previous.Nodes),
+          static_cast<long long>(iteration.Time - previous.Time));
+      }
+
+      ImGui::End();
+    }
+
     void Game::OnMouseMove(double xpos, double ypos)
     {
       uint32_t id = Renderer::GetPositionID(EventManager::MouseNormalizedToPixel(xpos, ypos));
@@ -798,52 +1305,22 @@ namespace yk
       {
       case Mouse::ButtonLeft:
       {
-        if (m_HoveringTile)
+        if (m_HoveringTile && m_Turn != m_EngineSide && !m_GameStatus.Mate && !m_GameStatus.Draw && !m_GameStatus.TimeOut)
         {
           if (m_SelectedTile)
           {
             if (m_HoveringTile & m_SelectedTileMoves)
             {
-              m_NextMoveTile = m_HoveringTile;
-
-              Game::MovePiece(m_BoardStatus, m_SelectedTile, m_NextMoveTile);
-              Game::UpdateGameStatus((m_Turn == Side::Black) ? Side::White : Side::Black);
-              if ((m_Turn == Side::Black) ? m_GameStatus.BlackCheck : m_GameStatus.WhiteCheck)
+              // No matching legal move means the king would be left in check
+              const Move move = Game::FindMove(m_SelectedTile, m_HoveringTile);
+              if (!move)
               {
-                m_BoardStatus = m_BoardStatusHistory.back();
-                m_BoardStatusHistory.pop_back();
                 m_NextMoveTile = 0ULL;
                 break;
               }
 
-              auto [row, col] = Game::GetPosition(m_NextMoveTile);
-              Renderer::ResetBatch();
-              Game::DrawGame();
-              Game::Draw(DrawElement::ActionTile, -0.7f + (0.2f * col), -0.7f + (0.2f * row), row * 8 + col + 1);
-
-              if (m_GameStatus.Mate)
-              {
-                if (m_GameStatus.BlackCheck)
-                  YK_INFO("White side has won");
-                if (m_GameStatus.WhiteCheck)
-                  YK_INFO("Black side has won");
-              }
-
-              if (m_GameStatus.BlackCheck)
-              {
-                auto [rowk, colk] = Game::GetPosition(m_BoardStatus.BlackKing);
-                Game::Draw(DrawElement::ActionTile, -0.7f + (0.2f * colk), -0.7f + (0.2f * rowk), rowk * 8 + colk + 1);
-              }
-
-              if (m_GameStatus.WhiteCheck)
-              {
-                auto [rowk, colk] = Game::GetPosition(m_BoardStatus.WhiteKing);
-                Game::Draw(DrawElement::ActionTile, -0.7f + (0.2f * colk), -0.7f + (0.2f * rowk), rowk * 8 + colk + 1);
-              }
-
-              Renderer::EndBatch();
-
-              m_Turn = (m_Turn == Side::Black) ? Side::White : Side::Black;
+              m_NextMoveTile = m_HoveringTile;
+              Game::PlayMove(move);
               m_SelectedTile = 0ULL;
             }
             else
@@ -1,12 +1,21 @@
 #pragma once
 
+#include <future>
 #include <optional>
 #include <memory>
+#include <random>
 #include <tuple>
 
 #include <glm/glm.hpp>
 
 #include "Core/EventManager.h"
+#include "Core/Timestep.h"
+#include "GameLogic/Chess/Engine/Bitbases.h"
+#include "GameLogic/Chess/Engine/Book.h"
+#include "GameLogic/Chess/Engine/BookBuilder.h"
+#include "GameLogic/Chess/Engine/GameAnalysis.h"
+#include "GameLogic/Chess/Engine/MateSolver.h"
+#include "GameLogic/Chess/Engine/Search.h"
 #include "Rendering/ImageResource.h"
 
 namespace yk
@@ -24,6 +33,8 @@ namespace yk
       struct GameStatus
       {
         bool Mate = false;
+        bool Draw = false;
+        bool TimeOut = false;
         bool WhiteCheck = false;
         bool BlackCheck = false;
       };
@@ -72,6 +83,8 @@ namespace yk
     public:
       static std::shared_ptr<Game> Create();
 
+      void Update(Timestep timestep);
+
     private:
       void SetPiecesDefaultPositions();
 
@@ -103,6 +116,20 @@ namespace yk
       void Draw(DrawElement element, float x, float y, int32_t id = 0) const;
 
       void DrawGame() const;
+      void DrawMoveResult() const;
+
+      static Square TileToSquare(BoardBitField tile);
+      static BoardBitField SquareToTile(Square square);
+
+      Move FindMove(BoardBitField src_tile, BoardBitField dst_tile) const;
+      void PlayMove(Move move);
+      void SyncBoardWithPosition();
+      bool PlayBookMove();
+      void StartEngineSearch();
+      void StartPonderSearch(Move ponder_move);
+      void StopPonderSearch();
+      void DrawAnalysisOverlay();
+      void DrawStatisticsOverlay() const;
 
       void OnMouseMove(double xpos, double ypos) final;
       void OnMouseButtonPress(MouseCode button) final;
@@ -128,6 +155,35 @@ namespace yk
 
       GameStatus m_GameStatus;
       Side m_Turn = Side::White;
+
+      // Engine opponent, the GUI board is rebuilt from its position after every move
+      static constexpr double ClockStartMs = 300000.0;
+      static constexpr double ClockIncrementMs = 3000.0;
+      static constexpr int32_t GameAnalysisDepth = 12;
+
+      Position m_Position;
+      std::shared_ptr<TranspositionTable> m_Table;
+      std::shared_ptr<Search> m_Search;
+      Side m_EngineSide = Side::Black;
+      bool m_EngineThinking = false;
+      Move m_PonderMove;
+      std::shared_ptr<Book> m_Book;
+      std::mt19937_64 m_BookRandom;
+
+      AnalysisUpdate m_Analysis;
+      std::optional<SearchReport> m_SearchReport;
+      int32_t m_MultiPV = 1;
+      std::future<std::vector<NNUE::BenchmarkResult>> m_NetworkBenchmarkRun;
+      std::vector<NNUE::BenchmarkResult> m_NetworkBenchmark;
+      std::future<std::vector<BitbaseReport>> m_BitbaseGeneration;
+      std::vector<BitbaseReport> m_BitbaseReports;
+      std::future<BookBuildReport> m_BookBuild;
+      std::optional<BookBuildReport> m_BookReport;
+      std::future<MateResult> m_MateSearch;
+      std::optional<MateResult> m_MateResult;
+      std::future<GameAnalysisReport> m_GameAnalysis;
+      std::optional<GameAnalysisReport> m_GameAnalysisReport;
+      double m_ClockMs[ColorCount] = { ClockStartMs, ClockStartMs };
     };
   }
 }
\ No newline at end of file
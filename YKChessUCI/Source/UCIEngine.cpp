@@ -0,0 +1,779 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include "GameLogic/Chess/Engine/Benchmark.h"
+#include "GameLogic/Chess/Engine/Bitbases.h"
+#include "GameLogic/Chess/Engine/GameAnalysis.h"
+#include "GameLogic/Chess/Engine/LargePages.h"
+#include "GameLogic/Chess/Engine/MateSolver.h"
+#include "GameLogic/Chess/Engine/MoveGen.h"
+#include "GameLogic/Chess/Engine/NNUE.h"
+#include "GameLogic/Chess/Engine/Tablebases.h"
+#include "GameLogic/Chess/Engine/Tuner.h"
+#include "GameLogic/Chess/Engine/Zobrist.h"
+#include "UCIEngine.h"
+
+namespace yk
+{
+  namespace
+  {
+    constexpr size_t DefaultHashMB = 64;
+    constexpr int32_t DefaultAnalysisDepth = 12;
+    constexpr int32_t DefaultClusterDepth = 12;
+    // Far beyond the caches, where a probe is most often a miss
+    constexpr size_t DefaultPrefetchHashMB = 1024;
+    constexpr size_t MaxHashMB = 65536;
+    constexpr int64_t DefaultHashBenchmarkTime = 1000;
+    constexpr int32_t MaxThreads = 256;
+
+    // Commands are rarely longer than a line of a few hundred moves, the reader waits when the queue is full
+    constexpr auto PollInterval = std::chrono::milliseconds(1);
+    constexpr auto MatchReportInterval = std::chrono::seconds(5);
+
+    std::string ScoreToUCI(int32_t score)
+    {
+      if (score >= Chess::ScoreMateInMaxPly)
+        return "mate " + std::to_string((Chess::ScoreMate - score + 1) / 2);
+      if (score <= Chess::ScoreMatedInMaxPly)
+        return "mate " + std::to_string(-(Chess::ScoreMate + score) / 2);
+      return "cp " + std::to_string(score);
+    }
+
+    // Everything after the keyword up to the next one of the given keywords, spaces inside kept
+    std::string_view Section(std::string_view text, std::string_view keyword, std::initializer_list<std::string_view> ends)
+    {
+      size_t start = text.find(keyword);
+      if (start == std::string_view::npos)
+        return {};
+      start += keyword.size();
+
+      size_t end = text.size();
+      for (const std::string_view next : ends)
+      {
+        const size_t found = text.find(next, start);
+        if (found != std::string_view::npos)
+          end = std::min(end, found);
+      }
+
+      std::string_view section = text.substr(start, end - start);
+      while (!section.empty() && section.front() == ' ')
+        section.remove_prefix(1);
+      while (!section.empty() && section.back() == ' ')
+        section.remove_suffix(1);
+      return section;
+    }
+
+    // Case insensitive, as GUIs send combo values the way they were listed
+    bool ParsePolicy(std::string_view text, Chess::HugePagePolicy& policy)
+    {
+      auto same = [](char first, char second) { return std::tolower(static_cast<unsigned char>(first)) == std::tolower(static_cast<unsigned char>(second)); };
+      for (const Chess::HugePagePolicy candidate : { Chess::HugePagePolicy::Off, Chess::HugePagePolicy::Transparent, Chess::HugePagePolicy::Explicit })
+      {
+        const std::string_view name = Chess::LargePages::GetPolicyName(candidate);
+        if (std::equal(text.begin(), text.end(), name.begin(), name.end(), same))
+        {
+          policy = candidate;
+          return true;
+        }
+      }
+      return false;
+    }
+  }
+
+  UCIEngine::UCIEngine()
+  {
+    Chess::Bitboards::Init();
+    Chess::Zobrist::Init();
+
+    m_Position = Chess::Position::StartPosition();
+    m_Table = Chess::TranspositionTable::Create(DefaultHashMB);
+    m_Search = Chess::Search::Create(m_Table, 1);
+  }
+
+  UCIEngine::~UCIEngine()
+  {
+    m_Search->Stop();
+    m_Search->Wait();
+    if (m_Reader.joinable())
+      m_Reader.join();
+  }
+
+  void UCIEngine::Run()
+  {
+    m_Reader = std::thread([this]() { UCIEngine::ReadInput(); });
+
+    while (!m_Quit)
+    {
+      std::string line;
+      bool idle = true;
+      while (!m_Quit && m_Lines.TryPop(line))
+      {
+        UCIEngine::Execute(line);
+        idle = false;
+      }
+
+      UCIEngine::PollSearch();
+      UCIEngine::PollMatch();
+      if (idle)
+        std::this_thread::sleep_for(PollInterval);
+    }
+  }
+
+  void UCIEngine::ReadInput()
+  {
+    std::string line;
+    while (true)
+    {
+      // A closed input is a quit, the GUI is gone
+      const bool open = static_cast<bool>(std::getline(std::cin, line));
+      if (!open)
+        line = "quit";
+
+      const bool quit = line == "quit";
+      while (!m_Lines.TryPush(std::move(line)))
+        std::this_thread::sleep_for(PollInterval);
+      if (quit)
+        return;
+    }
+  }
+
+  void UCIEngine::Execute(std::string_view line)
+  {
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+      line.remove_suffix(1);
+
+    const size_t split = line.find(' ');
+    const std::string_view command = line.substr(0, split);
+    const std::string_view arguments = (split == std::string_view::npos) ? std::string_view() : line.substr(split + 1);
+
+    if (command == "uci")
+      UCIEngine::OnUCI();
+    else if (command == "isready")
+      std::printf("readyok\n");
+    else if (command == "setoption")
+      UCIEngine::OnSetOption(arguments);
+    else if (command == "ucinewgame")
+    {
+      m_Search->NewGame();
+      m_Searching = false;
+    }
+    else if (command == "position")
+      UCIEngine::OnPosition(arguments);
+    else if (command == "go")
+      UCIEngine::OnGo(arguments);
+    else if (command == "stop")
+      UCIEngine::OnStop();
+    else if (command == "ponderhit")
+      m_Search->PonderHit();
+    else if (command == "quit")
+    {
+      UCIEngine::OnStop();
+      m_Search->Wait();
+      m_Quit = true;
+    }
+    else if (command == "match")
+      UCIEngine::OnMatch(arguments);
+    else if (command == "bench" && !m_Searching)
+    {
+      const int32_t depth = arguments.empty() ? Chess::Benchmark::DefaultBenchDepth : std::max(std::atoi(std::string(arguments).c_str()), 1);
+      const Chess::BenchResult result = Chess::Benchmark::Run(depth);
+      std::printf("info string bench depth %d nodes %llu time %lld nps %.0f\n", depth, static_cast<unsigned long long>(result.Nodes),
+        static_cast<long long>(result.Time), result.NodesPerSecond);
+    }
+    else if (command == "analyze" && !m_Searching)
+      UCIEngine::OnAnalyze(arguments);
+    else if (command == "solve" && !m_Searching)
+      UCIEngine::OnSolve(arguments);
+    else if (command == "serve" && !m_Searching)
+      UCIEngine::OnServe(arguments);
+    else if (command == "tune" && !m_Searching)
+      UCIEngine::OnTune(arguments);
+    else if (command == "cluster" && !m_Searching)
+      UCIEngine::OnCluster(arguments);
+    else if (command == "prefetch" && !m_Searching)
+      UCIEngine::OnPrefetch(arguments);
+    else if (command == "hash" && !m_Searching)
+      UCIEngine::OnHash(arguments);
+    else if (!command.empty())
+      std::printf("info string unknown command '%.*s'\n", static_cast<int>(command.size()), command.data());
+
+    std::fflush(stdout);
+  }
+
+  void UCIEngine::OnUCI()
+  {
+    const Chess::SearchOptions& options = m_Search->GetOptions();
+
+    std::printf("id name YKChess\n");
+    std::printf("id author KaleniG\n");
+    std::printf("option name Hash type spin default %zu min 1 max %zu\n", DefaultHashMB, MaxHashMB);
+    std::printf("option name Clear Hash type button\n");
+    std::printf("option name LargePages type combo default %s var Off var Transparent var Explicit\n", Chess::LargePages::GetPolicyName(Chess::LargePages::GetPolicy()));
+    std::printf("option name Threads type spin default 1 min 1 max %d\n", MaxThreads);
+    std::printf("option name MultiPV type spin default %d min 1 max %d\n", options.MultiPV, Chess::MaxMoves);
+    std::printf("option name Ponder type check default false\n");
+    std::printf("option name EvalFile type string default <empty>\n");
+    std::printf("option name SyzygyPath type string default <empty>\n");
+    std::printf("option name SyzygyProbeDepth type spin default %d min 1 max 100\n", options.TablebaseProbeDepth);
+    std::printf("option name SyzygyProbeLimit type spin default %d min 0 max %d\n", options.TablebasePieces, Chess::Tablebases::MaxPieces);
+    std::printf("option name Syzygy50MoveRule type check default %s\n", options.TablebaseRule50 ? "true" : "false");
+    std::printf("option name BitbasePath type string default <empty>\n");
+    std::printf("option name OwnBook type check default false\n");
+    std::printf("option name BookFile type string default <empty>\n");
+    std::printf("option name AnalysisCache type string default <empty>\n");
+    std::printf("option name AnalysisCacheDepth type spin default %d min 1 max %d\n", options.AnalysisCacheDepth, Chess::MaxPly - 1);
+    std::printf("uciok\n");
+  }
+
+  void UCIEngine::OnSetOption(std::string_view arguments)
+  {
+    std::string name(Section(arguments, "name ", { " value" }));
+    const std::string value(Section(arguments, " value ", {}));
+    std::transform(name.begin(), name.end(), name.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+    // Options are never changed by a GUI while a search runs, but a stray one must not race it. A match probes the
+    // same tablebases and bitbases from its own threads
+    if (m_Searching || (m_Match && m_Match->IsRunning()))
+    {
+      std::printf("info string option '%s' ignored while searching\n", name.c_str());
+      return;
+    }
+
+    Chess::SearchOptions options = m_Search->GetOptions();
+    const bool enabled = value == "true";
+
+    if (name == "hash")
+      m_Table->Resize(std::clamp<size_t>(std::strtoull(value.c_str(), nullptr, 10), 1, MaxHashMB));
+    else if (name == "largepages")
+    {
+      // Only later allocations follow the policy, the table is allocated again at once
+      Chess::HugePagePolicy policy;
+      if (ParsePolicy(value, policy))
+      {
+        Chess::LargePages::SetPolicy(policy);
+        m_Table->Resize(m_Table->GetSizeMB());
+      }
+      else
+        std::printf("info string unknown large page policy '%s'\n", value.c_str());
+    }
+    else if (name == "clear hash")
+      m_Search->NewGame();
+    else if (name == "threads")
+      m_Search->SetThreadCount(std::clamp(std::atoi(value.c_str()), 1, MaxThreads));
+    else if (name == "multipv")
+      options.MultiPV = std::clamp(std::atoi(value.c_str()), 1, Chess::MaxMoves);
+    else if (name == "ponder")
+    {
+      // Pondering is driven by "go ponder", the option only tells that the GUI may send it
+    }
+    else if (name == "evalfile")
+      m_Search->SetNetwork((value.empty() || value == "<empty>") ? nullptr : Chess::NNUE::Network::Load(value));
+    else if (name == "syzygypath")
+      Chess::Tablebases::Init((value == "<empty>") ? std::string() : value);
+    else if (name == "syzygyprobedepth")
+      options.TablebaseProbeDepth = std::max(std::atoi(value.c_str()), 1);
+    else if (name == "syzygyprobelimit")
+      options.TablebasePieces = std::clamp(std::atoi(value.c_str()), 0, Chess::Tablebases::MaxPieces);
+    else if (name == "syzygy50moverule")
+      options.TablebaseRule50 = enabled;
+    else if (name == "bitbasepath")
+    {
+      if (!value.empty() && value != "<empty>")
+        std::printf("info string %zu bitbases loaded\n", Chess::Bitbases::Load(value));
+    }
+    else if (name == "ownbook")
+      m_OwnBook = enabled;
+    else if (name == "bookfile")
+      m_Book = Chess::Book::Open(value);
+    else if (name == "analysiscache")
+    {
+      // The previous cache finishes its writes before the new one is opened, it may be the same file
+      m_Search->SetAnalysisCache(nullptr);
+      if (!value.empty() && value != "<empty>")
+        m_Search->SetAnalysisCache(Chess::AnalysisCache::Open(value));
+    }
+    else if (name == "analysiscachedepth")
+      options.AnalysisCacheDepth = std::clamp(std::atoi(value.c_str()), 1, Chess::MaxPly - 1);
+    else
+      std::printf("info string unknown option '%s'\n", name.c_str());
+
+    m_Search->SetOptions(options);
+  }
+
+  void UCIEngine::OnPosition(std::string_view arguments)
+  {
+    Chess::Position position;
+    if (arguments.starts_with("startpos"))
+      position = Chess::Position::StartPosition();
+    else if (arguments.starts_with("fen "))
+    {
+      if (!position.SetFEN(Section(arguments, "fen ", { " moves" })))
+      {
+        std::printf("info string invalid fen\n");
+        return;
+      }
+    }
+    else
+      return;
+
+    std::istringstream moves(std::string(Section(arguments, " moves", {})));
+    std::string text;
+    while (moves >> text)
+    {
+      const Chess::Move move = position.ParseUCIMove(text);
+      if (!move)
+      {
+        std::printf("info string illegal move %s\n", text.c_str());
+        return;
+      }
+      position.MakeMove(move);
+    }
+
+    m_Position = position;
+  }
+
+  void UCIEngine::OnGo(std::string_view arguments)
+  {
+    if (m_Searching)
+      return;
+
+    Chess::SearchLimits limits;
+    bool infinite = false;
+
+    std::istringstream stream{ std::string(arguments) };
+    std::string token;
+    while (stream >> token)
+    {
+      if (token == "wtime")
+        stream >> limits.Time[Chess::White];
+      else if (token == "btime")
+        stream >> limits.Time[Chess::Black];
+      else if (token == "winc")
+        stream >> limits.Increment[Chess::White];
+      else if (token == "binc")
+        stream >> limits.Increment[Chess::Black];
+      else if (token == "movestogo")
+        stream >> limits.MovesToGo;
+      else if (token == "depth")
+        stream >> limits.Depth;
+      else if (token == "nodes")
+        stream >> limits.Nodes;
+      else if (token == "movetime")
+        stream >> limits.MoveTime;
+      else if (token == "ponder")
+        limits.Ponder = true;
+      else if (token == "infinite")
+        infinite = true;
+      else if (token == "searchmoves")
+      {
+        // Runs to the end of the line, every remaining token a move
+        while (stream >> token)
+          if (const Chess::Move move = m_Position.ParseUCIMove(token))
+            limits.SearchMoves.push_back(move);
+      }
+    }
+    limits.Depth = std::clamp(limits.Depth, 1, Chess::MaxPly - 1);
+
+    // Book moves are played at once, a ponder or infinite search is what the GUI asked for and runs anyway
+    if (m_OwnBook && m_Book && !limits.Ponder && !infinite)
+    {
+      if (const Chess::Move move = m_Book->PickMove(m_Position, static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count())))
+      {
+        std::printf("bestmove %s\n", Chess::Position::MoveToUCI(move).c_str());
+        return;
+      }
+    }
+
+    m_Infinite = infinite;
+    m_StopRequested = false;
+    m_Searching = true;
+    m_Search->Start(m_Position, limits);
+  }
+
+  void UCIEngine::OnStop()
+  {
+    m_StopRequested = true;
+    m_Search->Stop();
+    if (m_Match)
+      m_Match->Stop();
+  }
+
+  // match [games N] [concurrency N] [time ms] [inc ms] [openings file] [elo0 x] [elo1 x] [base Option=value]...
+  // The baseline starts from the default options, each base token changes one of them
+  void UCIEngine::OnMatch(std::string_view arguments)
+  {
+    if (m_Searching || (m_Match && m_Match->IsRunning()))
+      return;
+
+    Chess::MatchEngine first;
+    first.Name = "current";
+    first.Options = m_Search->GetOptions();
+    first.Network = m_Search->GetNetwork();
+
+    Chess::MatchEngine second;
+    second.Name = "base";
+
+    Chess::MatchSettings settings;
+    settings.Concurrency = std::max(static_cast<int32_t>(std::thread::hardware_concurrency()), 1);
+
+    std::istringstream stream{ std::string(arguments) };
+    std::string token;
+    while (stream >> token)
+    {
+      if (token == "games")
+        stream >> settings.Games;
+      else if (token == "concurrency")
+        stream >> settings.Concurrency;
+      else if (token == "time")
+        stream >> settings.Time;
+      else if (token == "inc")
+        stream >> settings.Increment;
+      else if (token == "elo0")
+        stream >> settings.Elo0;
+      else if (token == "elo1")
+        stream >> settings.Elo1;
+      else if (token == "openings" && stream >> token)
+        settings.Openings = Chess::Match::LoadOpenings(token);
+      else if (token == "base" && stream >> token)
+      {
+        const size_t split = token.find('=');
+        const std::string name = token.substr(0, split);
+        const std::string value = (split == std::string::npos) ? std::string() : token.substr(split + 1);
+        const bool enabled = value == "true";
+
+        Chess::SearchOptions& options = second.Options;
+        if (name == "NullMove")
+          options.NullMove = enabled;
+        else if (name == "NullMoveVerification")
+          options.NullMoveVerification = enabled;
+        else if (name == "LateMoveReductions")
+          options.LateMoveReductions = enabled;
+        else if (name == "ReverseFutility")
+          options.ReverseFutility = enabled;
+        else if (name == "Futility")
+          options.Futility = enabled;
+        else if (name == "LateMovePruning")
+          options.LateMovePruning = enabled;
+        else if (name == "Razoring")
+          options.Razoring = enabled;
+        else if (name == "Prefetch")
+          options.Prefetch = enabled;
+        else if (name == "EvalFile")
+          second.Network = Chess::NNUE::Network::Load(value);
+        else
+          std::printf("info string unknown base option '%s'\n", name.c_str());
+      }
+    }
+
+    m_Match = Chess::Match::Create(first, second, settings);
+    m_Match->Start();
+    m_MatchReport = std::chrono::steady_clock::now();
+    std::printf("info string match started, %d games on %d threads\n", settings.Games, std::max(settings.Concurrency, 1));
+  }
+
+  // analyze [depth N] [threads N] [hash MB] [compare], every move of the game set with the last position command
+  void UCIEngine::OnAnalyze(std::string_view arguments)
+  {
+    Chess::GameAnalysisOptions options;
+    options.Threads = std::max(static_cast<int32_t>(std::thread::hardware_concurrency()), 1);
+    options.Limits.Depth = DefaultAnalysisDepth;
+    options.HashMB = DefaultHashMB;
+    options.Network = m_Search->GetNetwork();
+
+    std::istringstream stream{ std::string(arguments) };
+    std::string token;
+    while (stream >> token)
+    {
+      if (token == "depth")
+        stream >> options.Limits.Depth;
+      else if (token == "threads")
+        stream >> options.Threads;
+      else if (token == "hash")
+        stream >> options.HashMB;
+      else if (token == "compare")
+        options.CompareSequential = true;
+    }
+
+    const Chess::GameAnalysisReport report = Chess::GameAnalysis::Analyze(m_Position, options);
+    for (size_t i = 0; i < report.Moves.size(); i++)
+    {
+      const Chess::MoveAnnotation& annotation = report.Moves[i];
+      const Chess::PositionAnalysis& before = report.Positions[i];
+      std::printf("info string move %zu %s%s score %s best %s loss %d %s\n", i + 1, Chess::Position::MoveToUCI(annotation.Played).c_str(),
+        Chess::GameAnalysis::GetClassificationSymbol(annotation.Classification), ScoreToUCI(before.Score).c_str(),
+        Chess::Position::MoveToUCI(before.BestMove).c_str(), annotation.Loss, Chess::GameAnalysis::GetClassificationName(annotation.Classification));
+    }
+    for (Chess::Color color : { Chess::White, Chess::Black })
+    {
+      const int32_t* counts = report.Counts[color];
+      std::printf("info string analyze %s inaccuracies %d mistakes %d blunders %d average loss %.1f\n", (color == Chess::White) ? "white" : "black",
+        counts[static_cast<size_t>(Chess::MoveClassification::Inaccuracy)], counts[static_cast<size_t>(Chess::MoveClassification::Mistake)],
+        counts[static_cast<size_t>(Chess::MoveClassification::Blunder)], report.AverageLoss[color]);
+    }
+    std::printf("info string analyze moves %zu threads %d nodes %llu time %lld sequential %lld\n", report.Moves.size(), report.Threads,
+      static_cast<unsigned long long>(report.Nodes), static_cast<long long>(report.Time), static_cast<long long>(report.SequentialTime));
+  }
+
+  // solve [threads N] [nodes N] [hash MB] file, mate puzzles with the proof-number solver
+  void UCIEngine::OnSolve(std::string_view arguments)
+  {
+    int32_t threads = std::max(static_cast<int32_t>(std::thread::hardware_concurrency()), 1);
+    uint64_t nodes = Chess::MateSolver::DefaultMaxNodes;
+    size_t hashMB = DefaultHashMB;
+    std::string path;
+
+    std::istringstream stream{ std::string(arguments) };
+    std::string token;
+    while (stream >> token)
+    {
+      if (token == "threads")
+        stream >> threads;
+      else if (token == "nodes")
+        stream >> nodes;
+      else if (token == "hash")
+        stream >> hashMB;
+      else
+        path = token;
+    }
+
+    const Chess::MatePuzzleReport report = Chess::MateSolver::SolveFile(path, threads, hashMB, nodes);
+    for (size_t i = 0; i < report.Puzzles.size(); i++)
+    {
+      const Chess::MatePuzzle& puzzle = report.Puzzles[i];
+      std::string pv;
+      for (const Chess::Move move : puzzle.Result.PV)
+        pv += " " + Chess::Position::MoveToUCI(move);
+      std::printf("info string puzzle %zu expected %d mate %d nodes %llu time %lld pv%s\n", i + 1, puzzle.ExpectedMate, puzzle.Result.MateIn,
+        static_cast<unsigned long long>(puzzle.Result.Nodes), static_cast<long long>(puzzle.Result.Time), pv.c_str());
+    }
+    std::printf("info string solve %d of %zu nodes %llu time %lld\n", report.Solved, report.Puzzles.size(),
+      static_cast<unsigned long long>(report.Nodes), static_cast<long long>(report.Time));
+  }
+
+  // serve [games N] [threads N] [nodes N] [movetime ms]
+  void UCIEngine::OnServe(std::string_view arguments)
+  {
+    int32_t games = 100;
+    int32_t threads = std::max(static_cast<int32_t>(std::thread::hardware_concurrency()), 1);
+    Chess::ScheduledLimits limits;
+
+    std::istringstream stream{ std::string(arguments) };
+    std::string token;
+    while (stream >> token)
+    {
+      if (token == "games")
+        stream >> games;
+      else if (token == "threads")
+        stream >> threads;
+      else if (token == "nodes")
+        stream >> limits.Nodes;
+      else if (token == "movetime")
+        stream >> limits.MoveTime;
+    }
+
+    const Chess::ServingBenchmarkResult result = Chess::Benchmark::RunServing(games, threads, limits);
+    std::printf("info string serve games %d threads %d moves %llu time %lld games per core minute %.1f latency mean %.0fus worst %lldus missed %llu\n",
+      result.Games, result.Threads, static_cast<unsigned long long>(result.Moves), static_cast<long long>(result.Time), result.GamesPerCoreMinute,
+      result.MeanLatency, static_cast<long long>(result.WorstLatency), static_cast<unsigned long long>(result.MissedDeadlines));
+  }
+
+  // cluster [workers N...] [depth N] [hash MB] [share N] [address A], measures the speedup of worker processes on this host
+  void UCIEngine::OnCluster(std::string_view arguments)
+  {
+    std::vector<int32_t> workers;
+    int32_t depth = DefaultClusterDepth;
+    Chess::ClusterSettings settings;
+
+    std::istringstream stream{ std::string(arguments) };
+    std::string token;
+    while (stream >> token)
+    {
+      if (token == "workers")
+      {
+        int32_t count = 0;
+        while (stream.peek() == ' ' && stream >> count)
+          workers.push_back(count);
+        stream.clear();
+      }
+      else if (token == "depth")
+        stream >> depth;
+      else if (token == "hash")
+        stream >> settings.HashMB;
+      else if (token == "share")
+        stream >> settings.ShareDepth;
+      else if (token == "address")
+        stream >> settings.Address;
+    }
+    if (workers.empty())
+      workers = { 1, 2, 4, 8 };
+
+    for (const Chess::ClusterBenchmarkResult& result : Chess::Benchmark::RunCluster(workers, depth, settings))
+      std::printf("info string cluster workers %d depth %d nodes %llu time %lld speedup %.2f entries %llu bounds %llu releases %llu sent %llu received %llu\n",
+        result.Workers, depth, static_cast<unsigned long long>(result.Nodes), static_cast<long long>(result.Time), result.Speedup,
+        static_cast<unsigned long long>(result.EntriesShared), static_cast<unsigned long long>(result.BoundsShared),
+        static_cast<unsigned long long>(result.Releases), static_cast<unsigned long long>(result.BytesSent),
+        static_cast<unsigned long long>(result.BytesReceived));
+  }
+
+  // prefetch [depth N] [hash MB] [rounds N], the bench with make-move prefetching off and on
+  void UCIEngine::OnPrefetch(std::string_view arguments)
+  {
+    int32_t depth = Chess::Benchmark::DefaultBenchDepth;
+    size_t hashMB = DefaultPrefetchHashMB;
+    int32_t rounds = 3;
+
+    std::istringstream stream{ std::string(arguments) };
+    std::string token;
+    while (stream >> token)
+    {
+      if (token == "depth")
+        stream >> depth;
+      else if (token == "hash")
+        stream >> hashMB;
+      else if (token == "rounds")
+        stream >> rounds;
+    }
+
+    for (const Chess::PrefetchBenchmarkResult& result : Chess::Benchmark::RunPrefetch(depth, hashMB, rounds))
+      std::printf("info string prefetch %s depth %d hash %zu nodes %llu time %lld nps %.0f\n", result.Prefetch ? "on" : "off", depth, hashMB,
+        static_cast<unsigned long long>(result.Nodes), static_cast<long long>(result.Time), result.NodesPerSecond);
+  }
+
+  // hash [sizes MB...] [movetime ms] [threads N] [policy Off|Transparent|Explicit], the nps of each table size on normal pages
+  // and with the policy. Sizes not fitting in the physical memory are skipped
+  void UCIEngine::OnHash(std::string_view arguments)
+  {
+    std::vector<size_t> sizes;
+    int64_t moveTime = DefaultHashBenchmarkTime;
+    int32_t threads = 1;
+    Chess::HugePagePolicy policy = Chess::HugePagePolicy::Transparent;
+
+    std::istringstream stream{ std::string(arguments) };
+    std::string token;
+    while (stream >> token)
+    {
+      if (token == "sizes")
+      {
+        size_t size = 0;
+        while (stream.peek() == ' ' && stream >> size)
+          sizes.push_back(size);
+        stream.clear();
+      }
+      else if (token == "movetime")
+        stream >> moveTime;
+      else if (token == "threads")
+        stream >> threads;
+      else if (token == "policy" && stream >> token && !ParsePolicy(token, policy))
+        std::printf("info string unknown large page policy '%s'\n", token.c_str());
+    }
+    if (sizes.empty())
+      sizes = { 64, 1024, 8192 };
+
+    for (const Chess::HashBenchmarkResult& result : Chess::Benchmark::RunHash(sizes, moveTime, std::clamp(threads, 1, MaxThreads), policy))
+      std::printf("info string hash %zu policy %s pages %s huge %zu nodes %llu time %lld nps %.0f\n", result.SizeMB,
+        Chess::LargePages::GetPolicyName(result.Policy), Chess::LargePages::GetKindName(result.Kind), result.HugeMB,
+        static_cast<unsigned long long>(result.Nodes), static_cast<long long>(result.Time), result.NodesPerSecond);
+  }
+
+  // tune [threads N] [epochs N] [rate x] [k x] [output file] dataset...
+  void UCIEngine::OnTune(std::string_view arguments)
+  {
+    Chess::TunerOptions options;
+    options.Threads = std::max(static_cast<int32_t>(std::thread::hardware_concurrency()), 1);
+    options.Output = "TunedWeights.txt";
+    std::vector<std::filesystem::path> datasets;
+
+    std::istringstream stream{ std::string(arguments) };
+    std::string token;
+    while (stream >> token)
+    {
+      if (token == "threads")
+        stream >> options.Threads;
+      else if (token == "epochs")
+        stream >> options.Epochs;
+      else if (token == "rate")
+        stream >> options.LearningRate;
+      else if (token == "k")
+        stream >> options.K;
+      else if (token == "output" && stream >> token)
+        options.Output = token;
+      else
+        datasets.push_back(token);
+    }
+
+    const Chess::TunerReport report = Chess::Tuner::Tune(datasets, options);
+    std::printf("info string tune positions %llu skipped %llu k %.6f error %.6f -> %.6f load %lld time %lld\n",
+      static_cast<unsigned long long>(report.Positions), static_cast<unsigned long long>(report.Skipped), report.K,
+      report.InitialError, report.FinalError, static_cast<long long>(report.LoadTime), static_cast<long long>(report.TuneTime));
+  }
+
+  void UCIEngine::PollSearch()
+  {
+    Chess::AnalysisUpdate update;
+    while (m_Search->PollAnalysis(update))
+      UCIEngine::PrintAnalysis(update);
+
+    if (!m_Searching || m_Search->IsSearching() || (m_Infinite && !m_StopRequested))
+      return;
+
+    m_Search->Wait();
+    m_Searching = false;
+
+    // The last depth may have been queued right before the search ended
+    while (m_Search->PollAnalysis(update))
+      UCIEngine::PrintAnalysis(update);
+
+    const Chess::SearchResult result = m_Search->GetResult();
+    if (result.PonderMove)
+      std::printf("bestmove %s ponder %s\n", Chess::Position::MoveToUCI(result.BestMove).c_str(), Chess::Position::MoveToUCI(result.PonderMove).c_str());
+    else
+      std::printf("bestmove %s\n", Chess::Position::MoveToUCI(result.BestMove).c_str());
+    std::fflush(stdout);
+  }
+
+  void UCIEngine::PollMatch()
+  {
+    if (!m_Match)
+      return;
+
+    const Chess::MatchStatus status = m_Match->GetStatus();
+    const auto now = std::chrono::steady_clock::now();
+    if (!status.Finished && now - m_MatchReport < MatchReportInterval)
+      return;
+    m_MatchReport = now;
+
+    const char* sprt = (status.SPRT == Chess::SPRTResult::AcceptH1) ? "H1 accepted" : (status.SPRT == Chess::SPRTResult::AcceptH0) ? "H0 accepted" : "running";
+    std::printf("info string match %s games %d +%d -%d =%d elo %.1f +- %.1f llr %.2f (%.2f, %.2f) sprt %s time losses %d\n",
+      status.Finished ? "finished" : "running", status.GetGames(), status.Wins, status.Losses, status.Draws, status.Elo, status.EloError,
+      status.LLR, status.LowerBound, status.UpperBound, sprt, status.TimeLosses);
+    std::fflush(stdout);
+
+    if (status.Finished)
+    {
+      m_Match->Wait();
+      m_Match = nullptr;
+    }
+  }
+
+  void UCIEngine::PrintAnalysis(const Chess::AnalysisUpdate& update) const
+  {
+    const uint64_t nps = update.Nodes * 1000 / static_cast<uint64_t>(std::max<int64_t>(update.Time, 1));
+
+    for (size_t i = 0; i < update.Lines.size(); i++)
+    {
+      const Chess::AnalysisLine& line = update.Lines[i];
+      std::string pv;
+      for (const Chess::Move move : line.PV)
+        pv += " " + Chess::Position::MoveToUCI(move);
+
+      std::printf("info depth %d multipv %zu score %s nodes %llu nps %llu time %lld pv%s\n", update.Depth, i + 1, ScoreToUCI(line.Score).c_str(),
+        static_cast<unsigned long long>(update.Nodes), static_cast<unsigned long long>(nps), static_cast<long long>(update.Time), pv.c_str());
+    }
+    std::fflush(stdout);
+  }
+}
\ No newline at end of file
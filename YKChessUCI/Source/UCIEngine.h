@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "GameLogic/Chess/Engine/Book.h"
+#include "GameLogic/Chess/Engine/Match.h"
+#include "GameLogic/Chess/Engine/Search.h"
+#include "GameLogic/Chess/Engine/SPSCQueue.h"
+
+namespace yk
+{
+  // Universal Chess Interface over stdin and stdout. A reader thread only collects lines, every command runs on the thread
+  // calling Run, which also streams the search output, so a stop is seen within a millisecond whatever the search is doing
+  class UCIEngine
+  {
+  public:
+    UCIEngine();
+    ~UCIEngine();
+
+    void Run();
+
+  private:
+    void ReadInput();
+    void Execute(std::string_view line);
+
+    void OnUCI();
+    void OnSetOption(std::string_view arguments);
+    void OnPosition(std::string_view arguments);
+    void OnGo(std::string_view arguments);
+    void OnStop();
+    void OnMatch(std::string_view arguments);
+    void OnAnalyze(std::string_view arguments);
+    void OnServe(std::string_view arguments);
+    void OnSolve(std::string_view arguments);
+    void OnTune(std::string_view arguments);
+    void OnCluster(std::string_view arguments);
+    void OnPrefetch(std::string_view arguments);
+    void OnHash(std::string_view arguments);
+
+    void PollSearch();
+    void PollMatch();
+    void PrintAnalysis(const Chess::AnalysisUpdate& update) const;
+
+  private:
+    UCIEngine(const UCIEngine&) = delete;
+    UCIEngine& operator=(const UCIEngine&) = delete;
+    UCIEngine(UCIEngine&&) = delete;
+    UCIEngine& operator=(UCIEngine&&) = delete;
+
+  private:
+    std::thread m_Reader;
+    Chess::SPSCQueue<std::string, 256> m_Lines;
+    bool m_Quit = false;
+
+    Chess::Position m_Position;
+    std::shared_ptr<Chess::TranspositionTable> m_Table;
+    std::shared_ptr<Chess::Search> m_Search;
+    std::shared_ptr<Chess::Book> m_Book;
+    bool m_OwnBook = false;
+
+    // The best move of an infinite search is held back until the GUI asks for it
+    bool m_Searching = false;
+    bool m_Infinite = false;
+    bool m_StopRequested = false;
+
+    // Self-play against a baseline configuration, the current options playing the first engine
+    std::shared_ptr<Chess::Match> m_Match;
+    std::chrono::steady_clock::time_point m_MatchReport;
+  };
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#include <cstdlib>
+#include <string_view>
+
+#include "GameLogic/Chess/Engine/Cluster.h"
+#include "UCIEngine.h"
+
+int main(int argc, char** argv)
+{
+  // Started by a cluster coordinator: "worker <address> [hash MB]"
+  if (argc >= 3 && std::string_view(argv[1]) == "worker")
+    return yk::Chess::Cluster::RunWorker(argv[2], (argc >= 4) ? std::strtoull(argv[3], nullptr, 10) : 16);
+
+  yk::UCIEngine engine;
+  engine.Run();
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+project "YKChessUCI"
+  location "."
+  kind "ConsoleApp"
+  language "C++"
+  cppdialect "C++latest"
+  staticruntime "On"
+
+  targetdir "%{wks.location}/Bin/%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
+  objdir "%{wks.location}/Bin-Int/%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
+
+  -- Only the engine is shared with the game, nothing here opens a window or a device
+  files
+  {
+    "Source/**.cpp",
+    "Source/**.h",
+    "%{wks.location}/YKChess/Source/GameLogic/Chess/Engine/**.cpp",
+    "%{wks.location}/YKChess/Source/GameLogic/Chess/Engine/**.h",
+    "*.lua"
+  }
+
+  includedirs
+  {
+    "Source",
+    "%{wks.location}/YKChess/Source",
+    "%{wks.location}/Deps/YKLib/YKLib/Source"
+  }
+
+  links
+  {
+    "YKLib"
+  }
+
+  filter {}
\ No newline at end of file
@@ -59,4 +59,5 @@ group ""
 
 group "Impl"
   include "YKChess"
+  include "YKChessUCI"
 group ""